@@ -162,7 +162,7 @@ int audio_play_sound(int id, float volume, float panning, float pitch) {
         return -1;
 
     // Load sample (8000Hz, mono, 8bit)
-    char *src_buf;
+    const char *src_buf;
     int src_len;
     if(!sounds_loader_get(id, &src_buf, &src_len)) {
         log_error("Requested sound sample %d not found", id);
@@ -177,7 +177,7 @@ int audio_play_sound(int id, float volume, float panning, float pitch) {
     return current_backend.play_sound(current_backend.ctx, src_buf, src_len, volume, panning, pitch, 0);
 }
 
-int audio_play_sound_buf(char *src_buf, int src_len, float volume, float panning, float pitch, int fade) {
+int audio_play_sound_buf(const char *src_buf, int src_len, float volume, float panning, float pitch, int fade) {
     // Tell the backend to play it.
     return current_backend.play_sound(current_backend.ctx, src_buf, src_len, volume, panning, pitch, fade);
 }
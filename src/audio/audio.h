@@ -51,7 +51,7 @@ int audio_play_sound(int id, float volume, float panning, float pitch);
  * @param fade How many milliseconds to fade in the playback over
  * @return backend specific reference ID to the playing sound for later use with audio_fade_out or -1 on failure
  */
-int audio_play_sound_buf(char *src_buf, int src_len, float volume, float panning, float pitch, int fade);
+int audio_play_sound_buf(const char *src_buf, int src_len, float volume, float panning, float pitch, int fade);
 
 /**
  * Fade out audio already playing
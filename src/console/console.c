@@ -397,7 +397,7 @@ void console_remove_cmd(const char *name) {
 }
 
 bool console_window_is_open(void) {
-    return con->is_open;
+    return con != NULL && con->is_open;
 }
 
 void console_window_open(void) {
@@ -1,10 +1,15 @@
 #include "audio/audio.h"
 #include "console/console.h"
 #include "console/console_type.h"
+#include "game/gui/component.h"
 #include "game/scenes/arena.h"
 #include "game/scenes/mechlab.h"
+#include "game/utils/input_latency.h"
+#include "game/utils/profiler.h"
+#include "game/utils/rec_keyframes.h"
 #include "resources/ids.h"
 #include "utils/allocator.h"
+#include "utils/miscmath.h"
 #include <stdio.h>
 
 // utils
@@ -102,6 +107,52 @@ int console_toggle_warp(game_state *gs, int argc, char **argv) {
     return 0;
 }
 
+int console_toggle_latency(game_state *gs, int argc, char **argv) {
+    if(input_latency_toggle_overlay()) {
+        console_output_addline("Input latency overlay ON");
+    } else {
+        console_output_addline("Input latency overlay OFF");
+    }
+    return 0;
+}
+
+int console_cmd_profile(game_state *gs, int argc, char **argv) {
+    // toggle the frame time overlay, or capture a trace of the next n frames
+    if(argc == 1) {
+        if(profiler_toggle_overlay()) {
+            console_output_addline("Profiler overlay ON");
+        } else {
+            console_output_addline("Profiler overlay OFF");
+        }
+        return 0;
+    }
+    if(strcmp(argv[1], "trace") == 0 && argc <= 3) {
+        int frames = 300;
+        if(argc == 3 && !strtoint(argv[2], &frames)) {
+            return 1;
+        }
+        if(profiler_capture(frames)) {
+            console_output_addline("Capturing a trace");
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int console_cmd_guicache(game_state *gs, int argc, char **argv) {
+    // toggle reuse of the cached gui draws and layouts, for comparing the cost of the menus
+    if(argc == 1) {
+        component_set_retained_mode(!component_get_retained_mode());
+        if(component_get_retained_mode()) {
+            console_output_addline("GUI cache ON");
+        } else {
+            console_output_addline("GUI cache OFF");
+        }
+        return 0;
+    }
+    return 1;
+}
+
 int console_cmd_har(game_state *gs, int argc, char **argv) {
     // change har
     if(argc == 2) {
@@ -281,6 +332,25 @@ int console_cmd_rank(game_state *gs, int argc, char **argv) {
     return 1;
 }
 
+int console_cmd_seek(game_state *gs, int argc, char **argv) {
+    // jump to a tick of the recording being played back, or by +n/-n ticks from the current one
+    if(argc == 2 && gs->keyframes != NULL && gs->new_state == NULL) {
+        int i;
+        if(strtoint(argv[1], &i)) {
+            if(argv[1][0] == '+' || argv[1][0] == '-') {
+                i += gs->int_tick;
+            }
+            game_state *new_state = rec_keyframes_seek(gs->keyframes, gs, max2(i, 0));
+            if(new_state != NULL) {
+                // The engine swaps this in on the next static tick
+                gs->new_state = new_state;
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
 void console_init_cmd(void) {
     // Add console commands
     console_add_cmd("h", &console_cmd_history, "show command history");
@@ -300,6 +370,11 @@ void console_init_cmd(void) {
     console_add_cmd("kreissack", &console_kreissack, "Fight Kreissack");
     console_add_cmd("ez-destruct", &console_cmd_ez_destruct, "Punch = destruction, kick = scrap");
     console_add_cmd("warp", &console_toggle_warp, "Toggle warp speed");
+    console_add_cmd("latency", &console_toggle_latency, "Toggle the input latency overlay");
+    console_add_cmd("profile", &console_cmd_profile,
+                    "Toggle the frame time overlay. usage: profile, profile trace [frames] to write a Chrome trace");
+    console_add_cmd("guicache", &console_cmd_guicache, "Toggle reuse of cached GUI draws and layouts");
     console_add_cmd("money", &console_cmd_money, "Set tournament mode money");
     console_add_cmd("rank", &console_cmd_rank, "Set tournament mode rank");
+    console_add_cmd("seek", &console_cmd_seek, "Seek in recording playback. usage: seek 1000, seek +50, seek -1");
 }
@@ -11,6 +11,7 @@
 #include "utils/allocator.h"
 #include "utils/c_array_util.h"
 #include "utils/log.h"
+#include "utils/miscmath.h"
 #include "utils/random.h"
 #include "utils/vec.h"
 #include <math.h>
@@ -91,6 +92,9 @@ typedef struct {
 
     // all projectiles currently on screen (vector of projectile object*)
     vector active_projectiles;
+
+    // private generator, so AI decisions do not disturb the match random stream
+    struct random_t rand;
 } ai;
 
 enum
@@ -241,11 +245,11 @@ int char_to_act(str *ch, int direction, int *position) {
  * \param ctrl Controller instance.
  * \param commands An array of controller commands to chain.
  * \param n_commands Number of elements in commands array.
- * \param ev The current controller event.
+ * \param ev The controller event queue.
  *
  * \return Void.
  */
-void chain_controller_cmd(controller *ctrl, int commands[], size_t n_commands, ctrl_event **ev) {
+void chain_controller_cmd(controller *ctrl, int commands[], size_t n_commands, ctrl_events *ev) {
     for(size_t i = 0; i < n_commands; i++) {
         controller_cmd(ctrl, commands[i], ev);
     }
@@ -254,23 +258,25 @@ void chain_controller_cmd(controller *ctrl, int commands[], size_t n_commands, c
 /**
  * \brief Convenience method to roll '1 in x' chance.
  *
+ * \param a The AI instance.
  * \param roll_x An integer indicating number of numbers in roll.
  *
  * \return A boolean indicating whether the roll passed.
  */
-bool roll_chance(int roll_x) {
-    return roll_x <= 1 ? true : rand_int(roll_x) == 1;
+bool roll_chance(ai *a, int roll_x) {
+    return roll_x <= 1 ? true : random_int(&a->rand, roll_x) == 1;
 }
 
 /**
  * \brief Roll chance for pilot preference.
  *
+ * \param a The AI instance.
  * \param pref_val The value of the pilot preference (-100 to 100)
  *
  * \return A boolean indicating whether the preference is confirmed.
  */
-bool roll_pref(int pref_val) {
-    int rand_roll = rand_int(200);
+bool roll_pref(ai *a, int pref_val) {
+    int rand_roll = random_int(&a->rand, 200);
     int pref_thresh = pref_val + 100;
     return rand_roll <= pref_thresh;
 }
@@ -282,12 +288,12 @@ bool roll_pref(int pref_val) {
  *
  * \return A boolean indicating whether the AI is smart enough.
  */
-bool smart_usually(const ai *a) {
+bool smart_usually(ai *a) {
     if(a->difficulty >= 6) {
         // at highest difficulty 92% chance to be smart
-        return !roll_chance(12);
+        return !roll_chance(a, 12);
     } else if(a->difficulty >= 3) {
-        return roll_chance(7 - a->difficulty);
+        return roll_chance(a, 7 - a->difficulty);
     } else {
         return false;
     }
@@ -300,13 +306,13 @@ bool smart_usually(const ai *a) {
  *
  * \return A boolean indicating whether the AI is dumb enough.
  */
-bool dumb_usually(const ai *a) {
+bool dumb_usually(ai *a) {
     if(a->difficulty == 1) {
         // at lowest difficulty 92% chance to be dumb
-        return !roll_chance(12);
+        return !roll_chance(a, 12);
     }
     if(a->difficulty <= 2) {
-        return roll_chance(a->difficulty + 1);
+        return roll_chance(a, a->difficulty + 1);
     } else {
         return false;
     }
@@ -319,9 +325,9 @@ bool dumb_usually(const ai *a) {
  *
  * \return A boolean indicating whether the AI is smart enough.
  */
-bool smart_sometimes(const ai *a) {
+bool smart_sometimes(ai *a) {
     if(a->difficulty >= 2) {
-        return roll_chance(10 - a->difficulty);
+        return roll_chance(a, 10 - a->difficulty);
     } else {
         return false;
     }
@@ -334,9 +340,9 @@ bool smart_sometimes(const ai *a) {
  *
  * \return A boolean indicating whether the AI is dumb enough.
  */
-bool dumb_sometimes(const ai *a) {
+bool dumb_sometimes(ai *a) {
     if(a->difficulty <= 2) {
-        return roll_chance(a->difficulty + 2);
+        return roll_chance(a, a->difficulty + 2);
     } else {
         return false;
     }
@@ -349,8 +355,8 @@ bool dumb_sometimes(const ai *a) {
  *
  * \return A boolean indicating whether the AI should proceed with an action.
  */
-bool diff_scale(const ai *a) {
-    int roll = rand_int(36);
+bool diff_scale(ai *a) {
+    int roll = random_int(&a->rand, 36);
     return roll <= (a->difficulty * a->difficulty);
 }
 
@@ -361,8 +367,8 @@ bool diff_scale(const ai *a) {
  *
  * \return A boolean indicating whether the AI should learn.
  */
-bool learning_moment(const ai *a) {
-    float roll = (float)rand_int(diff_scale(a) ? 8 : 15);
+bool learning_moment(ai *a) {
+    float roll = (float)random_int(&a->rand, diff_scale(a) ? 8 : 15);
     return roll <= a->pilot->learning;
 }
 
@@ -373,8 +379,8 @@ bool learning_moment(const ai *a) {
  *
  * \return A boolean indicating whether the AI should forget.
  */
-bool forgetful(const ai *a) {
-    float roll = (float)rand_int(diff_scale(a) ? 3 : 2);
+bool forgetful(ai *a) {
+    float roll = (float)random_int(&a->rand, diff_scale(a) ? 3 : 2);
     return roll <= a->pilot->forget;
 }
 
@@ -517,7 +523,7 @@ bool likes_tactic(const controller *ctrl, int tactic_type) {
     har *h = object_get_userdata(o);
     sd_pilot *pilot = a->pilot;
 
-    if((a->tactic->last_tactic == tactic_type && roll_chance(2)) || h->state == STATE_JUMPING) {
+    if((a->tactic->last_tactic == tactic_type && roll_chance(a, 2)) || h->state == STATE_JUMPING) {
         return false;
     }
 
@@ -527,7 +533,7 @@ bool likes_tactic(const controller *ctrl, int tactic_type) {
 
     switch(tactic_type) {
         case TACTIC_SHOOT:
-            if(har_has_projectiles(h->id) && roll_pref(pilot->att_sniper) && enemy_range > RANGE_CRAMPED &&
+            if(har_has_projectiles(h->id) && roll_pref(a, pilot->att_sniper) && enemy_range > RANGE_CRAMPED &&
                (h->id != HAR_SHREDDER || ((enemy_range <= RANGE_MID && smart_usually(a)) ||
                                           dumb_sometimes(a)) // shredder prefers to be close-mid range
                 )) {
@@ -535,44 +541,46 @@ bool likes_tactic(const controller *ctrl, int tactic_type) {
             }
             break;
         case TACTIC_CLOSE:
-            if(enemy_range > RANGE_CRAMPED && (har_has_charge(h->id) || roll_chance(4)) &&
-               roll_pref(pilot->att_hyper)) {
+            if(enemy_range > RANGE_CRAMPED && (har_has_charge(h->id) || roll_chance(a, 4)) &&
+               roll_pref(a, pilot->att_hyper)) {
                 return true;
             }
             break;
         case TACTIC_QUICK:
             if(enemy_range > RANGE_CRAMPED && enemy_range < RANGE_FAR &&
-               ((roll_pref(pilot->att_sniper) && roll_chance(3)) || (roll_pref(pilot->att_hyper) && roll_chance(6)) ||
-                (roll_pref(pilot->att_normal) && roll_chance(8)))) {
+               ((roll_pref(a, pilot->att_sniper) && roll_chance(a, 3)) ||
+                (roll_pref(a, pilot->att_hyper) && roll_chance(a, 6)) ||
+                (roll_pref(a, pilot->att_normal) && roll_chance(a, 8)))) {
                 return true;
             }
             break;
         case TACTIC_GRAB:
-            if((a->thrown <= MAX_TIMES_THROWN || roll_chance(2)) &&
-               ((roll_pref(pilot->att_hyper) && roll_chance(3)) ||
-                ((h->id == HAR_FLAIL || h->id == HAR_THORN) && roll_chance(3)))) {
+            if((a->thrown <= MAX_TIMES_THROWN || roll_chance(a, 2)) &&
+               ((roll_pref(a, pilot->att_hyper) && roll_chance(a, 3)) ||
+                ((h->id == HAR_FLAIL || h->id == HAR_THORN) && roll_chance(a, 3)))) {
                 return true;
             }
             break;
         case TACTIC_TURTLE:
-            if(a->thrown <= MAX_TIMES_THROWN && ((roll_pref(pilot->att_def) && roll_chance(3)))) {
+            if(a->thrown <= MAX_TIMES_THROWN && ((roll_pref(a, pilot->att_def) && roll_chance(a, 3)))) {
                 return true;
             }
             break;
         case TACTIC_COUNTER:
-            if(a->thrown < MAX_TIMES_THROWN && roll_pref(pilot->att_def) && roll_chance(3)) {
+            if(a->thrown < MAX_TIMES_THROWN && roll_pref(a, pilot->att_def) && roll_chance(a, 3)) {
                 return true;
             }
             break;
         case TACTIC_ESCAPE:
-            if((roll_pref(pilot->att_jump) && roll_chance(3)) || (roll_pref(pilot->att_def) && roll_chance(5))) {
+            if((roll_pref(a, pilot->att_jump) && roll_chance(a, 3)) ||
+               (roll_pref(a, pilot->att_def) && roll_chance(a, 5))) {
                 return true;
             }
             break;
         case TACTIC_FLY:
-            if((roll_pref(a->pilot->att_jump) || (a->shot > MAX_TIMES_SHOT && learning_moment(a)) ||
+            if((roll_pref(a, a->pilot->att_jump) || (a->shot > MAX_TIMES_SHOT && learning_moment(a)) ||
                 (h->id == HAR_GARGOYLE || h->id == HAR_PYROS)) &&
-               ((wall_close && roll_chance(2)) || roll_chance(4))) {
+               ((wall_close && roll_chance(a, 2)) || roll_chance(a, 4))) {
                 return true;
             }
             break;
@@ -580,19 +588,21 @@ bool likes_tactic(const controller *ctrl, int tactic_type) {
             if((enemy_range <= RANGE_CLOSE ||
                 ((h->id == HAR_THORN || h->id == HAR_KATANA) && enemy_range <= RANGE_MID)) &&
                ((har_has_push(h->id) && smart_usually(a)) &&
-                ((roll_pref(pilot->att_hyper) && roll_chance(2)) || (roll_pref(pilot->att_def) && roll_chance(4)) ||
-                 (wall_close && roll_chance(5))))) {
+                ((roll_pref(a, pilot->att_hyper) && roll_chance(a, 2)) ||
+                 (roll_pref(a, pilot->att_def) && roll_chance(a, 4)) || (wall_close && roll_chance(a, 5))))) {
                 return true;
             }
             break;
         case TACTIC_TRIP:
             if(enemy_range <= RANGE_MID &&
-               ((roll_pref(pilot->att_def) && roll_chance(4)) || (roll_pref(pilot->att_sniper) && roll_chance(6)))) {
+               ((roll_pref(a, pilot->att_def) && roll_chance(a, 4)) ||
+                (roll_pref(a, pilot->att_sniper) && roll_chance(a, 6)))) {
                 return true;
             }
             break;
         case TACTIC_SPAM:
-            if((enemy_close || dumb_usually(a)) && (wall_close || roll_chance(6)) && roll_pref(pilot->att_normal)) {
+            if((enemy_close || dumb_usually(a)) && (wall_close || roll_chance(a, 6)) &&
+               roll_pref(a, pilot->att_normal)) {
                 return true;
             }
             break;
@@ -669,12 +679,12 @@ void queue_tactic(controller *ctrl, int tactic_type) {
         case TACTIC_CLOSE:
             if(enemy_close) {
                 a->tactic->move_type = 0;
-            } else if((tactic_type == TACTIC_CLOSE || (tactic_type == TACTIC_QUICK && roll_chance(3))) &&
+            } else if((tactic_type == TACTIC_CLOSE || (tactic_type == TACTIC_QUICK && roll_chance(a, 3))) &&
                       smart_usually(a) && har_has_charge(h->id)) {
                 // smart AI will try to use charge attacks
                 a->tactic->move_type = 0;
                 do_charge = true;
-            } else if(smart_usually(a) && roll_pref(a->pilot->pref_jump)) {
+            } else if(smart_usually(a) && roll_pref(a, a->pilot->pref_jump)) {
                 // smart AI that likes to jump will close via jump
                 a->tactic->move_type = MOVE_JUMP;
             } else {
@@ -768,7 +778,7 @@ void queue_tactic(controller *ctrl, int tactic_type) {
                 }
                 break;
             case TACTIC_COUNTER:
-                a->tactic->attack_type = roll_chance(3) ? ATTACK_TRIP : ATTACK_HEAVY;
+                a->tactic->attack_type = roll_chance(a, 3) ? ATTACK_TRIP : ATTACK_HEAVY;
                 // we only wait for block if they're not in range to grab/throw
                 if(enemy_range > RANGE_CRAMPED) {
                     a->tactic->attack_on = HAR_EVENT_BLOCK;
@@ -1031,7 +1041,7 @@ void reset_pilot_personality(sd_pilot *pilot) {
  * \return Void.
  */
 void reset_act_timer(ai *a) {
-    a->act_timer = BASE_ACT_TIMER - (a->difficulty * 2) - rand_int(3);
+    a->act_timer = BASE_ACT_TIMER - (a->difficulty * 2) - random_int(&a->rand, 3);
 }
 
 /**
@@ -1042,35 +1052,35 @@ void reset_act_timer(ai *a) {
  *
  * \return A boolean indicating whether move was disliked.
  */
-bool dislikes_move(const ai *a, const af_move *move) {
+bool dislikes_move(ai *a, const af_move *move) {
     // check for non-projectile special moves
     if(is_special_move(move)) {
         // pilots with bad special ability dislike special moves
-        return !roll_pref(a->pilot->ap_special);
+        return !roll_pref(a, a->pilot->ap_special);
     }
 
     switch(move->category) {
         case CAT_BASIC:
             // smart AI dislike basic moves
-            return !roll_pref(a->pilot->att_normal) && smart_usually(a);
+            return !roll_pref(a, a->pilot->att_normal) && smart_usually(a);
         case CAT_LOW:
             // pilots with bad low ability dislike low moves
-            return !roll_pref(a->pilot->att_normal) && !roll_pref(a->pilot->ap_low);
+            return !roll_pref(a, a->pilot->att_normal) && !roll_pref(a, a->pilot->ap_low);
         case CAT_MEDIUM:
             // pilots with bad middle ability dislike middle moves
-            return !roll_pref(a->pilot->att_normal) && !roll_pref(a->pilot->ap_middle);
+            return !roll_pref(a, a->pilot->att_normal) && !roll_pref(a, a->pilot->ap_middle);
         case CAT_HIGH:
             // pilots with bad high ability dislike high moves
-            return !roll_pref(a->pilot->att_normal) && !roll_pref(a->pilot->ap_high);
+            return !roll_pref(a, a->pilot->att_normal) && !roll_pref(a, a->pilot->ap_high);
         case CAT_CLOSE:
             // non-hyper pilots with bad throw ability dislike throw moves
-            return !roll_pref(a->pilot->att_hyper) && !roll_pref(a->pilot->ap_throw);
+            return !roll_pref(a, a->pilot->att_hyper) && !roll_pref(a, a->pilot->ap_throw);
         case CAT_JUMPING:
             // non-jumper pilots with bad jump ability dislike jump moves
-            return !roll_pref(a->pilot->att_jump) && !roll_pref(a->pilot->ap_jump);
+            return !roll_pref(a, a->pilot->att_jump) && !roll_pref(a, a->pilot->ap_jump);
         case CAT_PROJECTILE:
             // non-sniper pilots with bad special ability dislike projectile moves
-            return !roll_pref(a->pilot->att_sniper) && !roll_pref(a->pilot->ap_special);
+            return !roll_pref(a, a->pilot->att_sniper) && !roll_pref(a, a->pilot->ap_special);
     }
 
     return false;
@@ -1084,7 +1094,7 @@ bool dislikes_move(const ai *a, const af_move *move) {
  *
  * \return A boolean indicating whether move is considered too powerful.
  */
-bool move_too_powerful(const ai *a, const af_move *move) {
+bool move_too_powerful(ai *a, const af_move *move) {
     return is_special_move(move) && dumb_usually(a);
 }
 
@@ -1104,7 +1114,7 @@ int ai_har_event(controller *ctrl, har_event event) {
                 if(a->tactic->tactic_type != TACTIC_COUNTER && a->tactic->tactic_type != TACTIC_TURTLE &&
                    a->tactic->tactic_type != TACTIC_TRIP && a->tactic->tactic_type != TACTIC_PUSH &&
                    a->tactic->tactic_type != TACTIC_SPAM && a->tactic->tactic_type != TACTIC_FLY &&
-                   (a->tactic->tactic_type != TACTIC_GRAB || roll_chance(2)) &&
+                   (a->tactic->tactic_type != TACTIC_GRAB || roll_chance(a, 2)) &&
                    (a->tactic->chain_hit_on == 0 || a->tactic->chain_hit_on != event.move->category)) {
                     reset_tactic_state(a);
                     has_queued_tactic = false;
@@ -1150,7 +1160,7 @@ int ai_har_event(controller *ctrl, har_event event) {
             ms = &a->move_stats[event.move->id];
 
             // in the heat of the moment they might forget what they have learnt
-            if(roll_chance(2) && forgetful(a)) {
+            if(roll_chance(a, 2) && forgetful(a)) {
                 reset_pilot_personality(pilot);
                 a->blocked = 0;
                 a->thrown = 0;
@@ -1516,7 +1526,7 @@ bool assign_move_by_cat(controller *ctrl, int category, bool highest_damage) {
                     value = (int)move->damage * 10;
                 } else {
                     // evaluate the move based on learning reinforcement
-                    value = ms->value + rand_int(10);
+                    value = ms->value + random_int(&a->rand, 10);
                     if(learning_moment(a) && ms->min_hit_dist != -1) {
                         if(ms->last_dist < ms->max_hit_dist + 5 && ms->last_dist > ms->min_hit_dist + 5) {
                             value += 2;
@@ -1592,11 +1602,11 @@ bool assign_move_by_id(controller *ctrl, int move_id) {
  * \brief Make AI attempt to block attack.
  *
  * \param ctrl Controller instance.
- * \param ev The current controller event.
+ * \param ev The controller event queue.
  *
  * \return A boolean indicating whether the attack was blocked.
  */
-int ai_block_har(controller *ctrl, ctrl_event **ev) {
+int ai_block_har(controller *ctrl, ctrl_events *ev) {
     ai *a = ctrl->data;
     object *o = game_state_find_object(ctrl->gs, ctrl->har_obj_id);
     har *h = object_get_userdata(o);
@@ -1622,11 +1632,11 @@ int ai_block_har(controller *ctrl, ctrl_event **ev) {
  * \brief Make AI attempt to block projectile.
  *
  * \param ctrl Controller instance.
- * \param ev The current controller event.
+ * \param ev The controller event queue.
  *
  * \return A boolean indicating whether the projectile was blocked.
  */
-int ai_block_projectile(controller *ctrl, ctrl_event **ev) {
+int ai_block_projectile(controller *ctrl, ctrl_events *ev) {
     ai *a = ctrl->data;
     object *o = game_state_find_object(ctrl->gs, ctrl->har_obj_id);
 
@@ -1664,11 +1674,11 @@ int ai_block_projectile(controller *ctrl, ctrl_event **ev) {
  * \brief Process the current selected move.
  *
  * \param ctrl Controller instance.
- * \param ev The current controller event.
+ * \param ev The controller event queue.
  *
  * \return Void.
  */
-void process_selected_move(controller *ctrl, ctrl_event **ev) {
+void process_selected_move(controller *ctrl, ctrl_events *ev) {
     ai *a = ctrl->data;
     object *o = game_state_find_object(ctrl->gs, ctrl->har_obj_id);
 
@@ -1693,34 +1703,34 @@ void process_selected_move(controller *ctrl, ctrl_event **ev) {
  * \brief Handle the AI's movement.
  *
  * \param ctrl Controller instance.
- * \param ev The current controller event.
+ * \param ev The controller event queue.
  *
  * \return Void.
  */
-void handle_movement(controller *ctrl, ctrl_event **ev) {
+void handle_movement(controller *ctrl, ctrl_events *ev) {
     ai *a = ctrl->data;
     object *o = game_state_find_object(ctrl->gs, ctrl->har_obj_id);
     har *h = object_get_userdata(o);
 
     // default mid-action jump chance
     int jump_chance = 100;
-    if(roll_pref(a->pilot->pref_jump))
+    if(roll_pref(a, a->pilot->pref_jump))
         jump_chance -= 10;
     if(diff_scale(a))
         jump_chance -= 10;
 
     // Change action after act_timer runs out
-    if(a->act_timer <= 0 && (roll_chance(BASE_ACT_CHANCE) || diff_scale(a))) {
+    if(a->act_timer <= 0 && (roll_chance(a, BASE_ACT_CHANCE) || diff_scale(a))) {
         int enemy_range = get_enemy_range(ctrl);
 
         int move_dir = MOVE_DIR_STILL;
         if(!h->is_wallhugging && enemy_range == RANGE_CRAMPED) {
             // we are face-hugging already so no need to go forward
-            move_dir = roll_pref(a->pilot->pref_back) ? MOVE_DIR_BACK : MOVE_DIR_STILL;
-        } else if(roll_pref(a->pilot->pref_fwd)) {
+            move_dir = roll_pref(a, a->pilot->pref_back) ? MOVE_DIR_BACK : MOVE_DIR_STILL;
+        } else if(roll_pref(a, a->pilot->pref_fwd)) {
             // pilot prefers forward
             move_dir = MOVE_DIR_FWD;
-        } else if(!h->is_wallhugging && roll_pref(a->pilot->pref_back)) {
+        } else if(!h->is_wallhugging && roll_pref(a, a->pilot->pref_back)) {
             // pilot prefers backward
             move_dir = MOVE_DIR_BACK;
         } else if((h->id == HAR_FLAIL || h->id == HAR_THORN || h->id == HAR_NOVA) && smart_usually(a)) {
@@ -1745,7 +1755,7 @@ void handle_movement(controller *ctrl, ctrl_event **ev) {
                 break;
             case MOVE_DIR_STILL:
             default:
-                if(smart_usually(a) || roll_pref(a->pilot->att_def)) {
+                if(smart_usually(a) || roll_pref(a, a->pilot->att_def)) {
                     // crouch and block
                     a->cur_act = DOWNBACK;
                     jump_chance = 0;
@@ -1764,9 +1774,9 @@ void handle_movement(controller *ctrl, ctrl_event **ev) {
     }
 
     // Jump once in a while if they like to jump
-    if(jump_chance > 0 && roll_chance(jump_chance) && roll_pref(a->pilot->pref_jump)) {
+    if(jump_chance > 0 && roll_chance(a, jump_chance) && roll_pref(a, a->pilot->pref_jump)) {
         // log_debug("Jump chance %d", jump_chance);
-        if(smart_usually(a) && roll_pref(a->pilot->att_jump)) {
+        if(smart_usually(a) && roll_pref(a, a->pilot->att_jump)) {
             // double jump
             controller_cmd(ctrl, ACT_DOWN, ev);
         }
@@ -1819,7 +1829,7 @@ bool attempt_attack(controller *ctrl, bool highest_damage) {
                     value = (int)move->damage * 10;
                 } else {
                     // evaluate the move based on learning reinforcement
-                    value = ms->value + rand_int(10);
+                    value = ms->value + random_int(&a->rand, 10);
                     if(learning_moment(a) && ms->min_hit_dist != -1) {
                         if(ms->last_dist < ms->max_hit_dist + 5 && ms->last_dist > ms->min_hit_dist + 5) {
                             value += 2;
@@ -1830,7 +1840,7 @@ bool attempt_attack(controller *ctrl, bool highest_damage) {
 
                     // AI is less likely to use exact same move as last attack
                     if(a->last_move_id > 0 && a->last_move_id == move->id) {
-                        value -= rand_int(10);
+                        value -= random_int(&a->rand, 10);
                     }
 
                     // smart AI will slightly favor high damage moves
@@ -1840,7 +1850,7 @@ bool attempt_attack(controller *ctrl, bool highest_damage) {
 
                     // AI is less likely to use disliked moves
                     if(dislikes_move(a, move)) {
-                        value -= rand_int(10);
+                        value -= random_int(&a->rand, 10);
                     }
 
                     value -= ms->attempts / 2;
@@ -1881,11 +1891,11 @@ bool attempt_attack(controller *ctrl, bool highest_damage) {
  * \brief Attempt to initiate a charge atack using direct keyboard combinations.
  *
  * \param ctrl Controller instance.
- * \param ev The current controller event.
+ * \param ev The controller event queue.
  *
  * \return Boolean indicating whether an attack was initiated.
  */
-bool attempt_charge_attack(controller *ctrl, ctrl_event **ev) {
+bool attempt_charge_attack(controller *ctrl, ctrl_events *ev) {
     ai *a = ctrl->data;
     object *o = game_state_find_object(ctrl->gs, ctrl->har_obj_id);
     har *h = object_get_userdata(o);
@@ -1909,7 +1919,7 @@ bool attempt_charge_attack(controller *ctrl, ctrl_event **ev) {
     switch(h->id) {
         case HAR_JAGUAR: {
             // log_debug("Jaguar move: Leap");
-            if(enemy_range >= RANGE_MID && roll_pref(a->pilot->ap_special) && diff_scale(a)) {
+            if(enemy_range >= RANGE_MID && roll_pref(a, a->pilot->ap_special) && diff_scale(a)) {
                 // Shadow Leap : B,D,F+P
                 int cmds[] = {BACK, DOWNBACK};
                 chain_controller_cmd(ctrl, cmds, N_ELEMENTS(cmds), ev);
@@ -1925,20 +1935,20 @@ bool attempt_charge_attack(controller *ctrl, ctrl_event **ev) {
             chain_controller_cmd(ctrl, cmds, N_ELEMENTS(cmds), ev);
         } break;
         case HAR_KATANA: {
-            if(roll_chance(2) && roll_pref(a->pilot->ap_low)) {
+            if(roll_chance(a, 2) && roll_pref(a, a->pilot->ap_low)) {
                 // log_debug("Katana move: Trip-slide");
                 // Trip-Slide attack : D+B+K
                 int cmds[] = {DOWNBACK | ACT_KICK};
                 chain_controller_cmd(ctrl, cmds, N_ELEMENTS(cmds), ev);
             } else {
-                if(enemy_range >= RANGE_MID && roll_chance(2)) {
+                if(enemy_range >= RANGE_MID && roll_chance(a, 2)) {
                     // log_debug("Katana move: Foward Razor Spin");
                     // Foward Razor Spin : D,F+K
                     int cmds[] = {ACT_DOWN, DOWNFORWARD, FORWARD | ACT_KICK};
                     chain_controller_cmd(ctrl, cmds, N_ELEMENTS(cmds), ev);
                 } else {
                     // log_debug("Katana move: Rising Blade ");
-                    if(enemy_range >= RANGE_CLOSE && roll_pref(a->pilot->ap_special) && diff_scale(a)) {
+                    if(enemy_range >= RANGE_CLOSE && roll_pref(a, a->pilot->ap_special) && diff_scale(a)) {
                         // Triple Blade : B,D,F+P
                         int cmds[] = {BACK, DOWNBACK};
                         chain_controller_cmd(ctrl, cmds, N_ELEMENTS(cmds), ev);
@@ -1951,7 +1961,7 @@ bool attempt_charge_attack(controller *ctrl, ctrl_event **ev) {
         } break;
         case HAR_FLAIL: {
             // log_debug("Flail move: Charging Punch");
-            if(enemy_range > RANGE_MID && roll_pref(a->pilot->ap_special) && diff_scale(a)) {
+            if(enemy_range > RANGE_MID && roll_pref(a, a->pilot->ap_special) && diff_scale(a)) {
                 // Shadow Punch : D,B,B,P
                 int cmds[] = {ACT_DOWN, DOWNBACK, BACK, ACT_STOP, BACK | ACT_PUNCH};
                 chain_controller_cmd(ctrl, cmds, N_ELEMENTS(cmds), ev);
@@ -1969,7 +1979,7 @@ bool attempt_charge_attack(controller *ctrl, ctrl_event **ev) {
         } break;
         case HAR_PYROS: {
             // log_debug("Pyros move: Thrust");
-            if(enemy_range > RANGE_MID && roll_pref(a->pilot->ap_special) && diff_scale(a)) {
+            if(enemy_range > RANGE_MID && roll_pref(a, a->pilot->ap_special) && diff_scale(a)) {
                 // Shadow Thrust : F,F,F+P
                 int cmds[] = {FORWARD, ACT_STOP};
                 chain_controller_cmd(ctrl, cmds, N_ELEMENTS(cmds), ev);
@@ -1980,7 +1990,7 @@ bool attempt_charge_attack(controller *ctrl, ctrl_event **ev) {
         } break;
         case HAR_ELECTRA: {
             // log_debug("Electra move: Rolling Thunder");
-            if(enemy_range >= RANGE_MID && roll_pref(a->pilot->ap_special) && diff_scale(a)) {
+            if(enemy_range >= RANGE_MID && roll_pref(a, a->pilot->ap_special) && diff_scale(a)) {
                 // Super R.T. : B,D,F,F+P
                 int cmds[] = {ACT_DOWN, DOWNFORWARD};
                 chain_controller_cmd(ctrl, cmds, N_ELEMENTS(cmds), ev);
@@ -1990,7 +2000,7 @@ bool attempt_charge_attack(controller *ctrl, ctrl_event **ev) {
             chain_controller_cmd(ctrl, cmds, N_ELEMENTS(cmds), ev);
         } break;
         case HAR_CHRONOS: {
-            if(enemy_range >= RANGE_MID && roll_pref(a->pilot->ap_special) && diff_scale(a)) {
+            if(enemy_range >= RANGE_MID && roll_pref(a, a->pilot->ap_special) && diff_scale(a)) {
                 // log_debug("Chronos move: Teleport");
                 // Teleportation : D,P
                 int cmds[] = {ACT_DOWN, ACT_PUNCH};
@@ -2006,14 +2016,14 @@ bool attempt_charge_attack(controller *ctrl, ctrl_event **ev) {
             }
         } break;
         case HAR_SHREDDER: {
-            if(enemy_range > RANGE_MID && roll_pref(a->pilot->att_jump) && diff_scale(a)) {
+            if(enemy_range > RANGE_MID && roll_pref(a, a->pilot->att_jump) && diff_scale(a)) {
                 // log_debug("Shredder move: Flip-kick");
                 // Flip Kick : D,D+K
                 int cmds[] = {ACT_DOWN, ACT_STOP, ACT_DOWN | ACT_KICK};
                 chain_controller_cmd(ctrl, cmds, N_ELEMENTS(cmds), ev);
             } else {
                 // log_debug("Shredder move: Head-butt");
-                if(enemy_range >= RANGE_MID && roll_pref(a->pilot->ap_special) && diff_scale(a)) {
+                if(enemy_range >= RANGE_MID && roll_pref(a, a->pilot->ap_special) && diff_scale(a)) {
                     // Shadow Head-Butt : B,D,F+P
                     int cmds[] = {BACK, DOWNBACK};
                     chain_controller_cmd(ctrl, cmds, N_ELEMENTS(cmds), ev);
@@ -2024,14 +2034,14 @@ bool attempt_charge_attack(controller *ctrl, ctrl_event **ev) {
             }
         } break;
         case HAR_GARGOYLE: {
-            if(enemy_range > RANGE_MID && roll_pref(a->pilot->att_jump) && diff_scale(a)) {
+            if(enemy_range > RANGE_MID && roll_pref(a, a->pilot->att_jump) && diff_scale(a)) {
                 // log_debug("Gargoyle move: Wing-charge");
                 // Wing Charge : F,F,P
                 int cmds[] = {FORWARD, ACT_STOP, FORWARD, ACT_PUNCH};
                 chain_controller_cmd(ctrl, cmds, N_ELEMENTS(cmds), ev);
             } else {
                 // log_debug("Gargoyle move: Talon");
-                if(enemy_range >= RANGE_MID && roll_pref(a->pilot->ap_special) && diff_scale(a)) {
+                if(enemy_range >= RANGE_MID && roll_pref(a, a->pilot->ap_special) && diff_scale(a)) {
                     // Shadow Talon : B,D,F,P
                     int cmds[] = {BACK, DOWNBACK};
                     chain_controller_cmd(ctrl, cmds, N_ELEMENTS(cmds), ev);
@@ -2052,11 +2062,11 @@ bool attempt_charge_attack(controller *ctrl, ctrl_event **ev) {
  * \brief Attempt to initiate a push atack using direct keyboard combinations.
  *
  * \param ctrl Controller instance.
- * \param ev The current controller event.
+ * \param ev The controller event queue.
  *
  * \return Boolean indicating whether an attack was initiated.
  */
-bool attempt_push_attack(controller *ctrl, ctrl_event **ev) {
+bool attempt_push_attack(controller *ctrl, ctrl_events *ev) {
     ai *a = ctrl->data;
     object *o = game_state_find_object(ctrl->gs, ctrl->har_obj_id);
     har *h = object_get_userdata(o);
@@ -2086,7 +2096,7 @@ bool attempt_push_attack(controller *ctrl, ctrl_event **ev) {
         } break;
         case HAR_KATANA: {
             // log_debug("Katana move: Rising Blade");
-            if(enemy_range >= RANGE_CLOSE && roll_pref(a->pilot->ap_special) && diff_scale(a)) {
+            if(enemy_range >= RANGE_CLOSE && roll_pref(a, a->pilot->ap_special) && diff_scale(a)) {
                 // Triple Blade : B,D,F+P
                 int cmds[] = {BACK, DOWNBACK};
                 chain_controller_cmd(ctrl, cmds, N_ELEMENTS(cmds), ev);
@@ -2096,7 +2106,7 @@ bool attempt_push_attack(controller *ctrl, ctrl_event **ev) {
             chain_controller_cmd(ctrl, cmds, N_ELEMENTS(cmds), ev);
         } break;
         case HAR_FLAIL: {
-            if(roll_chance(3)) {
+            if(roll_chance(a, 3)) {
                 // log_debug("Flail move: Slow Swing Chains");
                 // Slow Swing Chain : D,K
                 int cmds[] = {ACT_DOWN, ACT_KICK};
@@ -2110,7 +2120,7 @@ bool attempt_push_attack(controller *ctrl, ctrl_event **ev) {
         } break;
         case HAR_THORN: {
             // log_debug("Thorn move: Speed Kick");
-            if(enemy_range >= RANGE_CLOSE && roll_pref(a->pilot->ap_special) && diff_scale(a)) {
+            if(enemy_range >= RANGE_CLOSE && roll_pref(a, a->pilot->ap_special) && diff_scale(a)) {
                 // Shadow Kick : B,D,F+K
                 int cmds[] = {BACK, DOWNBACK};
                 chain_controller_cmd(ctrl, cmds, N_ELEMENTS(cmds), ev);
@@ -2155,11 +2165,11 @@ bool attempt_push_attack(controller *ctrl, ctrl_event **ev) {
  * \brief Attempt to initiate a push atack using direct keyboard combinations.
  *
  * \param ctrl Controller instance.
- * \param ev The current controller event.
+ * \param ev The controller event queue.
  *
  * \return Boolean indicating whether an attack was initiated.
  */
-bool attempt_trip_attack(controller *ctrl, ctrl_event **ev) {
+bool attempt_trip_attack(controller *ctrl, ctrl_events *ev) {
     object *o = game_state_find_object(ctrl->gs, ctrl->har_obj_id);
     har *h = object_get_userdata(o);
 
@@ -2188,11 +2198,12 @@ bool attempt_trip_attack(controller *ctrl, ctrl_event **ev) {
  * \brief Attempt to initiate a projectile attack using direct keyboard combinations.
  *
  * \param ctrl Controller instance.
- * \param ev The current controller event.
+ * \param ev The controller event queue.
  *
  * \return Boolean indicating whether an attack was initiated.
  */
-bool attempt_projectile_attack(controller *ctrl, ctrl_event **ev) {
+bool attempt_projectile_attack(controller *ctrl, ctrl_events *ev) {
+    ai *a = ctrl->data;
     object *o = game_state_find_object(ctrl->gs, ctrl->har_obj_id);
     har *h = object_get_userdata(o);
     int enemy_range = get_enemy_range(ctrl);
@@ -2216,7 +2227,7 @@ bool attempt_projectile_attack(controller *ctrl, ctrl_event **ev) {
         case HAR_SHADOW: {
             int cmds[] = {ACT_DOWN, DOWNBACK, BACK};
             chain_controller_cmd(ctrl, cmds, N_ELEMENTS(cmds), ev);
-            if(roll_chance(2)) {
+            if(roll_chance(a, 2)) {
                 // Shadow Punch : D,B+P
                 int cmds2[] = {ACT_PUNCH};
                 chain_controller_cmd(ctrl, cmds2, N_ELEMENTS(cmds2), ev);
@@ -2239,7 +2250,7 @@ bool attempt_projectile_attack(controller *ctrl, ctrl_event **ev) {
         } break;
         case HAR_NOVA: {
             controller_cmd(ctrl, ACT_DOWN, ev);
-            if(roll_chance(3) && enemy_range >= RANGE_MID) {
+            if(roll_chance(a, 3) && enemy_range >= RANGE_MID) {
                 // Mini-Grenade : D, B, P
                 int cmds[] = {ACT_DOWN, DOWNBACK, BACK | ACT_PUNCH};
                 chain_controller_cmd(ctrl, cmds, N_ELEMENTS(cmds), ev);
@@ -2259,11 +2270,11 @@ bool attempt_projectile_attack(controller *ctrl, ctrl_event **ev) {
  * \brief Handle the next phase of the currently queued tactic.
  *
  * \param ctrl Controller instance.
- * \param ev The current controller event.
+ * \param ev The controller event queue.
  *
  * \return Boolean indicating whether AI moved or attacked.
  */
-bool handle_queued_tactic(controller *ctrl, ctrl_event **ev) {
+bool handle_queued_tactic(controller *ctrl, ctrl_events *ev) {
     ai *a = ctrl->data;
     object *o = game_state_find_object(ctrl->gs, ctrl->har_obj_id);
     har *h = object_get_userdata(o);
@@ -2296,7 +2307,7 @@ bool handle_queued_tactic(controller *ctrl, ctrl_event **ev) {
                     tactic->move_timer = 0;
                     acted = false;
                 } else {
-                    if(enemy_range == RANGE_CRAMPED || !roll_pref(a->pilot->pref_jump)) {
+                    if(enemy_range == RANGE_CRAMPED || !roll_pref(a, a->pilot->pref_jump)) {
                         // take a step away
                         a->cur_act = BACK;
                     } else {
@@ -2326,13 +2337,13 @@ bool handle_queued_tactic(controller *ctrl, ctrl_event **ev) {
                     a->cur_act = UPFORWARD;
                     controller_cmd(ctrl, a->cur_act, ev);
                     controller_cmd(ctrl, ACT_STOP, ev);
-                    if(roll_pref(a->pilot->pref_jump)) {
+                    if(roll_pref(a, a->pilot->pref_jump)) {
                         tactic->move_timer--;
                     } else {
                         tactic->move_timer = 0;
                     }
                 } else if(tactic->tactic_type == TACTIC_FLY) {
-                    if(roll_pref(a->pilot->att_jump) && smart_sometimes(a)) {
+                    if(roll_pref(a, a->pilot->att_jump) && smart_sometimes(a)) {
                         // do high jump
                         controller_cmd(ctrl, ACT_DOWN, ev);
                     }
@@ -2433,7 +2444,7 @@ bool handle_queued_tactic(controller *ctrl, ctrl_event **ev) {
                     if(!in_attempt_range)
                         break;
 
-                    int light_cat = roll_chance(2) ? CAT_BASIC : CAT_MEDIUM;
+                    int light_cat = roll_chance(a, 2) ? CAT_BASIC : CAT_MEDIUM;
                     if(assign_move_by_cat(ctrl, light_cat, false)) {
                         reset_tactic_state(a);
                         // log_debug("Light attack success: %d", h->id);
@@ -2460,7 +2471,7 @@ bool handle_queued_tactic(controller *ctrl, ctrl_event **ev) {
                     if(!in_attempt_range)
                         break;
 
-                    int heavy_cat = roll_chance(2) ? CAT_MEDIUM : CAT_HIGH;
+                    int heavy_cat = roll_chance(a, 2) ? CAT_MEDIUM : CAT_HIGH;
                     if(assign_move_by_cat(ctrl, heavy_cat, true)) {
                         reset_tactic_state(a);
                         // log_debug("Heavy attack success: %d", h->id);
@@ -2590,7 +2601,7 @@ bool handle_queued_tactic(controller *ctrl, ctrl_event **ev) {
     return acted;
 }
 
-int ai_controller_poll(controller *ctrl, ctrl_event **ev) {
+int ai_controller_poll(controller *ctrl, ctrl_events *ev) {
     ai *a = ctrl->data;
     object *o = game_state_find_object(ctrl->gs, ctrl->har_obj_id);
     scene *scene = game_state_get_scene(ctrl->gs);
@@ -2683,7 +2694,7 @@ int ai_controller_poll(controller *ctrl, ctrl_event **ev) {
     int enemy_range = get_enemy_range(ctrl);
 
     // attempt a random attack
-    if((roll_chance(RANDOM_ATTACK_CHANCE) || diff_scale(a)) && (enemy_range <= RANGE_CLOSE || dumb_sometimes(a)) &&
+    if((roll_chance(a, RANDOM_ATTACK_CHANCE) || diff_scale(a)) && (enemy_range <= RANGE_CLOSE || dumb_sometimes(a)) &&
        attempt_attack(ctrl, false)) {
         // log_debug("Random attack: %d", h->id);
         // reset movement act timer
@@ -2697,7 +2708,8 @@ int ai_controller_poll(controller *ctrl, ctrl_event **ev) {
     // log_debug("=== POLL === handle_movement");
 
     // queue a random tactic for next poll
-    if((a->last_move_id == 0 || a->tactic->tactic_type == 0 || (roll_chance(RANDOM_ATTACK_CHANCE) && diff_scale(a))) &&
+    if((a->last_move_id == 0 || a->tactic->tactic_type == 0 ||
+        (roll_chance(a, RANDOM_ATTACK_CHANCE) && diff_scale(a))) &&
        can_move) {
         // log_debug("Attempt to queue random tactic[0m");
         int tacs[] = {TACTIC_SHOOT, TACTIC_CLOSE, TACTIC_FLY, TACTIC_PUSH, TACTIC_TRIP, TACTIC_GRAB, TACTIC_QUICK};
@@ -2783,6 +2795,15 @@ void ai_controller_print_state(controller *ctrl, char *buf, size_t bufsize) {
              ai_attack(a->tactic->attack_type), a->last_move_id);
 }
 
+int ai_controller_get_move_attempts(const controller *ctrl, int *dst, int count) {
+    const ai *a = ctrl->data;
+    int n = min2(count, (int)N_ELEMENTS(a->move_stats));
+    for(int i = 0; i < n; i++) {
+        dst[i] = a->move_stats[i].attempts;
+    }
+    return n;
+}
+
 void ai_controller_create(controller *ctrl, int difficulty, sd_pilot *pilot, int pilot_id) {
     ai *a = omf_calloc(1, sizeof(ai));
     a->difficulty = difficulty + 1;
@@ -2803,6 +2824,7 @@ void ai_controller_create(controller *ctrl, int difficulty, sd_pilot *pilot, int
     a->thrown = 0;
     a->shot = 0;
     vector_create(&a->active_projectiles, sizeof(object *));
+    random_seed(&a->rand, random_intmax(&ctrl->gs->rand));
     pilot->pilot_id = pilot_id;
     a->pilot = pilot;
 
@@ -10,4 +10,14 @@ void ai_controller_create(controller *ctrl, int difficulty, sd_pilot *pilot, int
 
 void ai_controller_print_state(controller *ctrl, char *buf, size_t bufsize);
 
+/**
+ * Copies the per-move attempt counters of the AI into dst, indexed by move id.
+ *
+ * @param ctrl AI controller
+ * @param dst Destination array
+ * @param count Size of the destination array
+ * @return Number of counters written
+ */
+int ai_controller_get_move_attempts(const controller *ctrl, int *dst, int count);
+
 #endif // AI_CONTROLLER_H
@@ -11,7 +11,7 @@ typedef struct {
 void controller_init(controller *ctrl, game_state *gs) {
     list_create(&ctrl->hooks);
     ctrl->gs = gs;
-    ctrl->extra_events = NULL;
+    ctrl_events_clear(&ctrl->extra_events);
     ctrl->har_obj_id = 0;
     ctrl->poll_fun = NULL;
     ctrl->tick_fun = NULL;
@@ -20,6 +20,8 @@ void controller_init(controller *ctrl, game_state *gs) {
     ctrl->rumble_fun = NULL;
     ctrl->rtt = 0;
     ctrl->repeat = 0;
+    ctrl->input_stamp = 0;
+    ctrl->hooks_only = false;
 }
 
 void controller_add_hook(controller *ctrl, controller *source, void (*fp)(controller *ctrl, int act_type)) {
@@ -39,14 +41,8 @@ void controller_clear_hooks(controller *ctrl) {
     }
 }
 
-void controller_free_chain(ctrl_event *ev) {
-    ctrl_event *now = ev;
-    ctrl_event *tmp;
-    while(now != NULL) {
-        tmp = now->next;
-        omf_free(now);
-        now = tmp;
-    }
+void ctrl_events_clear(ctrl_events *ev) {
+    ev->count = 0;
 }
 
 void controller_free(controller *ctrl) {
@@ -55,24 +51,18 @@ void controller_free(controller *ctrl) {
     ctrl->free_fun(ctrl);
 }
 
-static inline void ctrl_action_push(ctrl_event **ev, int action) {
-    ctrl_event *new = omf_calloc(1, sizeof(ctrl_event));
-
-    new->type = EVENT_TYPE_ACTION;
-    new->event_data.action = action;
-
-    if(*ev == NULL) {
-        *ev = new;
-    } else {
-        ctrl_event *i = *ev;
-        while(i->next) {
-            i = i->next;
-        }
-        i->next = new;
+static inline void ctrl_event_push(ctrl_events *ev, int type, int action, uint64_t timestamp) {
+    if(ev->count == CTRL_EVENT_CAPACITY) {
+        log_debug("Controller event queue full, dropping event %d", action);
+        return;
     }
+    ctrl_event *new = &ev->events[ev->count++];
+    new->type = type;
+    new->action = action;
+    new->timestamp = timestamp;
 }
 
-void controller_cmd(controller *ctrl, int action, ctrl_event **ev) {
+void controller_cmd(controller *ctrl, int action, ctrl_events *ev) {
     ctrl->current |= action;
 
     // always debounce these actions
@@ -101,18 +91,19 @@ void controller_cmd(controller *ctrl, int action, ctrl_event **ev) {
         (hook.fp)(hook.source, action);
     }
 
-    ctrl_action_push(ev, action);
+    if(!ctrl->hooks_only) {
+        ctrl_event_push(ev, EVENT_TYPE_ACTION, action, ctrl->input_stamp);
+    }
+    ctrl->input_stamp = 0;
 }
 
-void controller_close(controller *ctrl, ctrl_event **ev) {
+void controller_close(controller *ctrl, ctrl_events *ev) {
     // a close event obsoletes all previous events
-    controller_free_chain(*ev);
-    *ev = omf_calloc(1, sizeof(ctrl_event));
-    (*ev)->type = EVENT_TYPE_CLOSE;
-    (*ev)->next = NULL;
+    ctrl_events_clear(ev);
+    ctrl_event_push(ev, EVENT_TYPE_CLOSE, ACT_NONE, 0);
 }
 
-int controller_tick(controller *ctrl, uint32_t ticks, ctrl_event **ev) {
+int controller_tick(controller *ctrl, uint32_t ticks, ctrl_events *ev) {
     if(ctrl->repeat_tick) {
         ctrl->repeat_tick--;
     }
@@ -122,14 +113,14 @@ int controller_tick(controller *ctrl, uint32_t ticks, ctrl_event **ev) {
     return 0;
 }
 
-int controller_dyntick(controller *ctrl, uint32_t ticks, ctrl_event **ev) {
+int controller_dyntick(controller *ctrl, uint32_t ticks, ctrl_events *ev) {
     if(ctrl->dyntick_fun != NULL) {
         return ctrl->dyntick_fun(ctrl, ticks, ev);
     }
     return 0;
 }
 
-int controller_poll(controller *ctrl, ctrl_event **ev) {
+int controller_poll(controller *ctrl, ctrl_events *ev) {
     if(ctrl->poll_fun != NULL) {
         return ctrl->poll_fun(ctrl, ev);
     }
@@ -40,27 +40,33 @@ enum
     EVENT_TYPE_CLOSE
 };
 
+// Events a controller may produce between two resets. Further events are dropped.
+#define CTRL_EVENT_CAPACITY 32
+
 typedef struct ctrl_event_t ctrl_event;
 
 struct ctrl_event_t {
     int type;
-    union {
-        int action;
-        serial *ser;
-    } event_data;
-    ctrl_event *next;
+    int action;
+    uint64_t timestamp; // performance counter of the input event that caused this, 0 if not known
 };
 
+// Events in the order they were produced. Reset in bulk with ctrl_events_clear() once handled.
+typedef struct ctrl_events_t {
+    ctrl_event events[CTRL_EVENT_CAPACITY];
+    unsigned int count;
+} ctrl_events;
+
 typedef struct controller_t controller;
 
 struct controller_t {
     game_state *gs;
     uint32_t har_obj_id;
     list hooks;
-    ctrl_event *extra_events;
-    int (*tick_fun)(controller *ctrl, uint32_t ticks, ctrl_event **ev);
-    int (*dyntick_fun)(controller *ctrl, uint32_t ticks, ctrl_event **ev);
-    int (*poll_fun)(controller *ctrl, ctrl_event **ev);
+    ctrl_events extra_events;
+    int (*tick_fun)(controller *ctrl, uint32_t ticks, ctrl_events *ev);
+    int (*dyntick_fun)(controller *ctrl, uint32_t ticks, ctrl_events *ev);
+    int (*poll_fun)(controller *ctrl, ctrl_events *ev);
     int (*rumble_fun)(controller *ctrl, float magnitude, int duration);
     int (*har_hook)(controller *ctrl, har_event event);
     void (*controller_hook)(controller *ctrl, int action);
@@ -72,18 +78,20 @@ struct controller_t {
     int repeat_tick;
     int current;
     int last;
+    uint64_t input_stamp; // given to the next event from controller_cmd(), see game/utils/input_latency.h
+    bool hooks_only;      // actions only go to the hooks, which apply them on their own (delayed netplay input)
 };
 
 void controller_init(controller *ctrl, game_state *gs);
-void controller_cmd(controller *ctrl, int action, ctrl_event **ev);
-void controller_close(controller *ctrl, ctrl_event **ev);
-int controller_poll(controller *ctrl, ctrl_event **ev);
-int controller_tick(controller *ctrl, uint32_t ticks, ctrl_event **ev);
-int controller_dyntick(controller *ctrl, uint32_t ticks, ctrl_event **ev);
+void controller_cmd(controller *ctrl, int action, ctrl_events *ev);
+void controller_close(controller *ctrl, ctrl_events *ev);
+int controller_poll(controller *ctrl, ctrl_events *ev);
+int controller_tick(controller *ctrl, uint32_t ticks, ctrl_events *ev);
+int controller_dyntick(controller *ctrl, uint32_t ticks, ctrl_events *ev);
 int controller_har_hook(controller *ctrl, har_event event);
 void controller_add_hook(controller *ctrl, controller *source, void (*fp)(controller *ctrl, int act_type));
 void controller_clear_hooks(controller *ctrl);
-void controller_free_chain(ctrl_event *ev);
+void ctrl_events_clear(ctrl_events *ev);
 void controller_free(controller *ctrl);
 void controller_set_repeat(controller *ctrl, int repeat);
 int controller_rumble(controller *ctrl, float magnitude, int duration);
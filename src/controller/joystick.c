@@ -1,4 +1,5 @@
 #include "controller/joystick.h"
+#include "game/utils/input_latency.h"
 #include "utils/allocator.h"
 #include "utils/log.h"
 #include <stdlib.h>
@@ -19,7 +20,7 @@ void joystick_free(controller *ctrl) {
     omf_free(k);
 }
 
-static inline void joystick_cmd(controller *ctrl, int action, ctrl_event **ev) {
+static inline void joystick_cmd(controller *ctrl, int action, ctrl_events *ev) {
     controller_cmd(ctrl, action, ev);
 }
 
@@ -78,7 +79,7 @@ int joystick_name_to_id(const char *name, int offset) {
     return -1;
 }
 
-static int internal_joystick_poll(joystick *k, controller *ctrl, ctrl_event **ev) {
+static int internal_joystick_poll(joystick *k, controller *ctrl, ctrl_events *ev) {
     if(!SDL_GameControllerGetAttached(k->joy)) {
         controller_close(ctrl, ev);
         return 0;
@@ -138,6 +139,11 @@ static int internal_joystick_poll(joystick *k, controller *ctrl, ctrl_event **ev
         action |= ACT_KICK;
     }
 
+    // Only new presses get the stamp; anything else was pressed before this poll
+    uint64_t stamp = input_latency_take_gamepad(SDL_JoystickInstanceID(SDL_GameControllerGetJoystick(k->joy)));
+    if(action & ~ctrl->last) {
+        ctrl->input_stamp = stamp;
+    }
     if(action) {
         joystick_cmd(ctrl, action, ev);
     }
@@ -153,7 +159,7 @@ static int internal_joystick_poll(joystick *k, controller *ctrl, ctrl_event **ev
     return 0;
 }
 
-int joystick_poll(controller *ctrl, ctrl_event **ev) {
+int joystick_poll(controller *ctrl, ctrl_events *ev) {
     joystick *k = ctrl->data;
 
     ctrl->last = ctrl->current;
@@ -238,7 +244,7 @@ void joystick_close(void) {
     vector_free(&every_gamepad);
 }
 
-void joystick_menu_poll_all(controller *menu_ctrl, ctrl_event **ev) {
+void joystick_menu_poll_all(controller *menu_ctrl, ctrl_events *ev) {
     if(vector_size(&every_gamepad) == 0)
         return;
 
@@ -30,7 +30,7 @@ int joystick_offset(int id, const char *name);
 
 void joystick_init(void);
 void joystick_close(void);
-void joystick_menu_poll_all(controller *menu_ctrl, ctrl_event **ev);
+void joystick_menu_poll_all(controller *menu_ctrl, ctrl_events *ev);
 void joystick_deviceadded(int sdl_joystick_index);
 void joystick_deviceremoved(int sdl_joystick_instance_id);
 
@@ -1,4 +1,5 @@
 #include "controller/keyboard.h"
+#include "game/utils/input_latency.h"
 #include "utils/allocator.h"
 #include "utils/log.h"
 #include <stdlib.h>
@@ -9,11 +10,25 @@ void keyboard_free(controller *ctrl) {
     omf_free(k);
 }
 
-static inline void keyboard_cmd(controller *ctrl, int action, ctrl_event **ev) {
+static inline void keyboard_cmd(controller *ctrl, int action, ctrl_events *ev) {
     controller_cmd(ctrl, action, ev);
 }
 
-int keyboard_poll(controller *ctrl, ctrl_event **ev) {
+// Stamp of the first new press among the held keys
+static uint64_t keyboard_take_stamp(const keyboard_keys *keys, const unsigned char *state) {
+    const unsigned bound[] = {keys->jump_up,   keys->jump_right, keys->walk_right, keys->duck_forward, keys->duck,
+                              keys->duck_back, keys->walk_back,  keys->jump_left,  keys->punch,        keys->kick};
+    uint64_t stamp = 0;
+    for(unsigned i = 0; i < sizeof(bound) / sizeof(bound[0]); i++) {
+        uint64_t key_stamp = state[bound[i]] ? input_latency_take_key(bound[i]) : 0;
+        if(key_stamp != 0 && (stamp == 0 || key_stamp < stamp)) {
+            stamp = key_stamp;
+        }
+    }
+    return stamp;
+}
+
+int keyboard_poll(controller *ctrl, ctrl_events *ev) {
     keyboard *k = ctrl->data;
     ctrl->current = 0;
     const unsigned char *state = SDL_GetKeyboardState(NULL);
@@ -52,6 +67,7 @@ int keyboard_poll(controller *ctrl, ctrl_event **ev) {
         action |= ACT_KICK;
     }
 
+    ctrl->input_stamp = keyboard_take_stamp(k->keys, state);
     if(action == 0) {
         keyboard_cmd(ctrl, ACT_STOP, ev);
     } else {
@@ -82,7 +98,7 @@ void keyboard_create(controller *ctrl, keyboard_keys *keys, int delay) {
     ctrl->free_fun = &keyboard_free;
 }
 
-void keyboard_menu_poll(controller *ctrl, ctrl_event **ev) {
+void keyboard_menu_poll(controller *ctrl, ctrl_events *ev) {
     const unsigned char *state = SDL_GetKeyboardState(NULL);
 
     if(state[SDL_SCANCODE_RIGHT] || state[SDL_SCANCODE_KP_6]) {
@@ -8,14 +8,22 @@
 #include "game/game_state_type.h"
 #include "game/protos/scene.h"
 #include "game/scenes/arena.h"
+#include "game/utils/input_latency.h"
+#include "game/utils/net_pacing.h"
+#include "game/utils/profiler.h"
 #include "game/utils/serial.h"
 #include "game/utils/settings.h"
 #include "resources/ids.h"
 #include "utils/allocator.h"
+#include "utils/c_array_util.h"
 #include "utils/list.h"
 #include "utils/log.h"
 #include "utils/miscmath.h"
 
+#define NET_DELAY_INTERVAL 60        // ticks between changes of the input delay
+#define NET_CHECKPOINT_TICKS 30      // replay to move the saved state forward at least this often
+#define NET_TELEMETRY_TICKS 10       // ticks between telemetry lines
+
 typedef struct {
     ENetHost *host;
     ENetPeer *peer;
@@ -41,6 +49,7 @@ typedef struct {
     uint32_t last_acked_tick;
     int last_har_state;
     uint32_t last_traced_tick;
+    uint32_t rec_agreed_tick; // all agreed moves up to this tick have been written to gs->rec
     uint32_t peer_last_hash;
     uint32_t peer_last_hash_tick;
     uint32_t last_hash;
@@ -50,12 +59,24 @@ typedef struct {
     SDL_RWops *trace_file;
     game_state *gs_bak;
     int winner;
+    uint32_t start_seed; // seed proposed for the match, 0 to pick one from the clock
+    net_controller_stats stats;
+    int peer_frame_advantage;
+    float advantage;        // smoothed half difference of both frame advantages, positive when we are ahead
+    bool managed_input;     // local inputs are delayed, and applied by net_controller_dyntick()
+    int max_input_delay;    // 0 applies local inputs as they are polled
+    int input_delay;        // ticks between polling a local input and applying it
+    uint32_t input_horizon; // local inputs up to this tick are final, and can be sent
+    uint32_t delay_tick;    // tick the input delay was last changed
+    SDL_RWops *telemetry_file;
+    uint32_t telemetry_tick;
 } wtf;
 
 typedef struct {
     uint32_t tick;
     uint8_t events[2][11];
     int8_t direction[2];
+    uint64_t stamp; // input latency stamp of a delayed local action, see game/utils/input_latency.h
 } tick_events;
 
 // simple standard deviation calculation
@@ -93,7 +114,7 @@ int avg_rtt(int data[], int n) {
 }
 
 // insert an event into the event trace
-void insert_event(wtf *data, uint32_t tick, uint16_t action, int id, int direction) {
+void insert_event(wtf *data, uint32_t tick, uint16_t action, int id, int direction, uint64_t stamp) {
 
     iterator it;
     list *transcript = &data->transcript;
@@ -107,6 +128,7 @@ void insert_event(wtf *data, uint32_t tick, uint16_t action, int id, int directi
     memset(event.events[abs(id - 1)], 0, 11);
     event.events[id][0] = action;
     event.direction[id] = direction;
+    event.stamp = stamp;
     int i = 0;
 
     foreach(it, ev) {
@@ -134,6 +156,9 @@ void insert_event(wtf *data, uint32_t tick, uint16_t action, int id, int directi
                 if(ev->events[id][j] == 0) {
                     ev->events[id][j] = action;
                     ev->direction[id] = direction;
+                    if(ev->stamp == 0) {
+                        ev->stamp = stamp;
+                    }
                     break;
                 }
             }
@@ -164,20 +189,73 @@ done:
     }
 }
 
-// check if we have any events for this tick
-bool has_event(wtf *data, uint32_t tick) {
+// check if we have any final events that have not been sent yet
+bool has_unsent_event(wtf *data) {
 
     iterator it;
     list_iter_begin(&data->transcript, &it);
     tick_events *ev = NULL;
     foreach(it, ev) {
-        if(ev->tick == tick - data->local_proposal && ev->events[data->id][0]) {
+        if(ev->tick > data->last_sent && ev->tick <= data->input_horizon && ev->events[data->id][0]) {
             return true;
         }
     }
     return false;
 }
 
+// round trip time in ticks that the given percentage of the measurements stay under
+static int rtt_percentile(wtf *data, int percent) {
+    return net_rtt_percentile(data->rttbuf, data->rttfilled ? 100 : data->rttpos, percent);
+}
+
+// enough input delay to cover the trip to the peer for nine inputs out of ten
+static int pick_input_delay(wtf *data) {
+    return net_input_delay_target(data->rttbuf, data->rttfilled ? 100 : data->rttpos, data->max_input_delay);
+}
+
+// Move the input delay towards the one the connection needs. It only moves a tick at a time, and not too often,
+// so that a few slow heartbeats do not make the controls feel different from one moment to the next.
+static void update_input_delay(wtf *data, uint32_t ticks) {
+    if(!data->managed_input || ticks - data->delay_tick < NET_DELAY_INTERVAL) {
+        return;
+    }
+    data->delay_tick = ticks;
+    data->input_delay = net_input_delay_step(data->input_delay, pick_input_delay(data));
+}
+
+// While local inputs are delayed, the local controller hands its actions to our hook only
+static void set_managed_input(controller *ctrl, bool managed) {
+    wtf *data = ctrl->data;
+    data->managed_input = managed;
+    data->input_delay = managed ? pick_input_delay(data) : 0;
+    data->delay_tick = ctrl->gs->int_tick;
+    controller *local = game_player_get_ctrl(game_state_get_player(ctrl->gs, data->id));
+    if(local) {
+        local->hooks_only = managed;
+    }
+}
+
+// With delayed inputs, instead of stalling the side that is ahead, both sides stretch or shorten their ticks a
+// little until they run level, see game/utils/net_pacing.h.
+static void update_pace(wtf *data, game_state *gs) {
+    gs->pace_us = data->managed_input && data->gs_bak ? net_advantage_pace(&data->advantage) : 0;
+}
+
+static void write_telemetry(wtf *data, uint32_t ticks, int pace_us) {
+    if(!data->telemetry_file || !data->synchronized || !data->gs_bak ||
+       ticks - data->telemetry_tick < NET_TELEMETRY_TICKS) {
+        return;
+    }
+    data->telemetry_tick = ticks;
+    char buf[256];
+    int sz = snprintf(buf, sizeof(buf), "%" PRIu32 ",%d,%d,%d,%d,%d,%.2f,%d,%" PRIu32 ",%" PRIu32 ",%.3f,%" PRIu32 "\n",
+                      ticks - data->local_proposal, data->input_delay, rtt_percentile(data, 50),
+                      rtt_percentile(data, 90), data->frame_advantage, data->peer_frame_advantage, data->advantage,
+                      pace_us, data->stats.rollbacks, data->stats.replayed_ticks, data->stats.replay_ms,
+                      data->stats.desyncs);
+    SDL_RWwrite(data->telemetry_file, buf, sz, 1);
+}
+
 void event_names(char *buf, uint8_t *actions) {
 
     for(int i = 0; i < 11; i++) {
@@ -235,7 +313,7 @@ void print_transcript(list *transcript) {
     }
 }
 
-// send any events we've made that are older than the last acked event from the peer
+// send any final events we've made that are newer than the last acked event from the peer
 void send_events(wtf *data) {
     serial ser;
     ENetPacket *packet;
@@ -258,8 +336,7 @@ void send_events(wtf *data) {
     int last_sent = 0;
 
     foreach(it, ev) {
-        if(ev->events[data->id][0] != 0 && ev->tick > data->last_acked_tick &&
-           ev->tick < data->last_tick - data->local_proposal) {
+        if(ev->events[data->id][0] != 0 && ev->tick > data->last_acked_tick && ev->tick <= data->input_horizon) {
             serial_write_uint32(&ser, ev->tick);
             int i = 0;
             while(ev->events[data->id][i]) {
@@ -292,6 +369,16 @@ void send_events(wtf *data) {
     enet_host_flush(host);
 }
 
+// keep a copy of the replayed game state as the starting point of future replays. The old copy is reused:
+// objects that are still around keep their allocations and only have their state restored.
+static game_state *save_agreed_state(wtf *data, game_state *gs, game_state *gs_old) {
+    log_debug("saving game state at last agreed on tick %d with hash %" PRIu32, gs->int_tick - data->local_proposal,
+              arena_state_hash(gs));
+    game_state_reclone(gs, gs_old);
+    data->gs_bak = gs_old;
+    return gs_old;
+}
+
 // replay the game state, using the input logs from both sides
 int rewind_and_replay(wtf *data, game_state *gs_current) {
     // first, find the last frame we have input from the other side
@@ -321,11 +408,14 @@ int rewind_and_replay(wtf *data, game_state *gs_current) {
     }
 
     uint64_t replay_start = SDL_GetTicks64();
+    uint64_t replay_counter = SDL_GetPerformanceCounter();
+    uint32_t replay_from = gs->int_tick;
     int tick_count = 0;
 
     uint32_t arena_hash = 0; // arena_state_hash(gs);
 
     uint32_t last_agreed = min2(data->last_acked_tick, data->last_received_tick);
+    bool inputs_now = false;
 
     foreach(it, ev) {
         if(ev->tick + data->local_proposal <= data->gs_bak->int_tick) {
@@ -338,15 +428,15 @@ int rewind_and_replay(wtf *data, game_state *gs_current) {
         // for future replays
         if(gs_new == NULL && ev->tick > last_agreed && gs->int_tick - data->local_proposal <= last_agreed &&
            gs->int_tick > gs_old->int_tick) {
-            log_debug("saving game state at last agreed on tick %d with hash %" PRIu32,
-                      gs->int_tick - data->local_proposal, arena_state_hash(gs));
             // save off the game state at the point we last agreed
             // on the state of the game
-            gs_new = omf_calloc(1, sizeof(game_state));
-            game_state_clone(gs, gs_new);
-            data->gs_bak = gs_new;
-            game_state_clone_free(gs_old);
-            omf_free(gs_old);
+            gs_new = save_agreed_state(data, gs, gs_old);
+        }
+
+        if(data->managed_input && ev->tick + data->local_proposal >= data->last_tick) {
+            // not simulated yet, net_controller_dyntick() applies these when their tick comes up
+            inputs_now = ev->tick + data->local_proposal == data->last_tick;
+            break;
         }
 
         // these are 'dynamic ticks'
@@ -388,6 +478,9 @@ int rewind_and_replay(wtf *data, game_state *gs_current) {
         if((ev->events[0][0] || ev->events[1][0]) && ev->tick <= last_agreed && ev->tick > data->last_traced_tick) {
             // this event has been agreed on by both sides
             sd_rec_move move;
+            sd_rec_move moves[N_ELEMENTS(ev->events) * N_ELEMENTS(ev->events[0])];
+            unsigned int move_count = 0;
+            memset(&move, 0, sizeof(move));
             data->last_traced_tick = ev->tick;
 
             for(int j = 0; j < 2; j++) {
@@ -426,10 +519,12 @@ int rewind_and_replay(wtf *data, game_state *gs_current) {
                         move.action = SD_ACT_NONE;
                     }
 
-                    sd_rec_insert_action(gs->rec, gs->rec->move_count, &move);
+                    moves[move_count++] = move;
                     k++;
                 }
             }
+            // Record the whole tick at once
+            sd_rec_insert_actions(gs->rec, gs->rec->move_count, moves, move_count);
 
             if(data->trace_file) {
                 char buf0[12];
@@ -477,6 +572,7 @@ int rewind_and_replay(wtf *data, game_state *gs_current) {
                     c->gs = gs_current;
                 }
             }
+            data->stats.desyncs++;
             return 1;
         } else if(gs->int_tick - data->local_proposal == data->peer_last_hash_tick) {
             log_debug("arena hashes agree!");
@@ -499,8 +595,21 @@ int rewind_and_replay(wtf *data, game_state *gs_current) {
         game_state_dynamic_tick(gs, true);
     }
 
+    // With delayed inputs, the inputs of both sides can be known up to the present. A saved state must have the
+    // inputs of its own tick applied, so this only works when there are none for the present tick.
+    if(gs_new == NULL && data->managed_input && !inputs_now && gs->int_tick - data->local_proposal <= last_agreed &&
+       gs->int_tick > gs_old->int_tick) {
+        gs_new = save_agreed_state(data, gs, gs_old);
+    }
+
     uint64_t replay_end = SDL_GetTicks64();
 
+    data->stats.rollbacks++;
+    data->stats.replayed_ticks += gs->int_tick - replay_from;
+    data->stats.max_depth = umax2(data->stats.max_depth, gs->int_tick - replay_from);
+    data->stats.replay_ms +=
+        (double)(SDL_GetPerformanceCounter() - replay_counter) * 1000.0 / SDL_GetPerformanceFrequency();
+
     if(gs_new == NULL) {
         // we weren't able to make a new state backup, so restore the old one
         data->gs_bak = gs_old;
@@ -511,7 +620,11 @@ int rewind_and_replay(wtf *data, game_state *gs_current) {
 
     log_debug("replayed %d ticks in %d milliseconds", tick_count, replay_end - replay_start);
 
+    data->rec_agreed_tick = umax2(data->rec_agreed_tick, last_agreed);
+
     // replace the game state with the replayed one
+    gs->pace_us = gs_current->pace_us;
+    gs->pace_carry = gs_current->pace_carry;
     gs->new_state = NULL;
     if(gs_current->new_state) {
         game_state_clone_free(gs_current->new_state);
@@ -532,6 +645,11 @@ ENetHost *net_controller_get_host(controller *ctrl) {
     return data->host;
 }
 
+uint32_t net_controller_get_agreed_tick(controller *ctrl) {
+    wtf *data = ctrl->data;
+    return data->rec_agreed_tick;
+}
+
 void net_controller_set_winner(controller *ctrl, int winner) {
     wtf *data = ctrl->data;
     data->winner = winner;
@@ -558,6 +676,38 @@ int net_controller_tick_offset(controller *ctrl) {
     return data->tick_offset / 2;
 }
 
+void net_controller_set_start_seed(controller *ctrl, uint32_t seed) {
+    wtf *data = ctrl->data;
+    data->start_seed = seed;
+}
+
+void net_controller_get_stats(controller *ctrl, net_controller_stats *stats) {
+    wtf *data = ctrl->data;
+    *stats = data->stats;
+    stats->input_delay = data->input_delay;
+    stats->advantage = data->advantage;
+}
+
+bool net_controller_set_telemetry_file(controller *ctrl, const char *filename) {
+    wtf *data = ctrl->data;
+    if(data->telemetry_file) {
+        SDL_RWclose(data->telemetry_file);
+        data->telemetry_file = NULL;
+    }
+    if(filename == NULL) {
+        return true;
+    }
+    data->telemetry_file = SDL_RWFromFile(filename, "w");
+    if(!data->telemetry_file) {
+        log_error("failed to open telemetry file %s", filename);
+        return false;
+    }
+    const char *header = "tick,input_delay,rtt_p50,rtt_p90,frame_advantage,peer_frame_advantage,advantage,pace_us,"
+                         "rollbacks,replayed_ticks,replay_ms,desyncs\n";
+    SDL_RWwrite(data->telemetry_file, header, strlen(header), 1);
+    return true;
+}
+
 void net_controller_free(controller *ctrl) {
     wtf *data = ctrl->data;
 
@@ -584,6 +734,9 @@ void net_controller_free(controller *ctrl) {
 
         SDL_RWclose(data->trace_file);
     }
+    if(data->telemetry_file) {
+        SDL_RWclose(data->telemetry_file);
+    }
     ENetEvent event;
     if(!data->disconnected) {
         if(data->peer == data->lobby) {
@@ -623,7 +776,7 @@ done:
     }
 }
 
-int net_controller_tick(controller *ctrl, uint32_t ticks0, ctrl_event **ev) {
+int net_controller_tick(controller *ctrl, uint32_t ticks0, ctrl_events *ev) {
     ENetEvent event;
     wtf *data = ctrl->data;
     ENetHost *host = data->host;
@@ -631,7 +784,13 @@ int net_controller_tick(controller *ctrl, uint32_t ticks0, ctrl_event **ev) {
     serial ser;
     uint32_t ticks = ctrl->gs->int_tick;
 
-    if(data->gs_bak && has_event(data, ticks - 1) && ticks > data->last_tick) {
+    if(data->gs_bak && ticks > data->local_proposal) {
+        update_input_delay(data, ticks);
+        // local inputs polled from now on are scheduled after the horizon, so everything up to it is final
+        data->input_horizon = umax2(data->input_horizon, ticks - data->local_proposal - 1 + data->input_delay);
+    }
+
+    if(data->gs_bak && has_unsent_event(data) && ticks > data->last_tick) {
         data->last_tick = ticks;
         send_events(data);
     }
@@ -665,6 +824,8 @@ int net_controller_tick(controller *ctrl, uint32_t ticks0, ctrl_event **ev) {
         data->local_proposal = ticks; // reset the tick offset to the start of the match
         data->last_hash_tick = data->gs_bak->int_tick - data->local_proposal;
         data->last_hash = arena_state_hash(data->gs_bak);
+        data->input_horizon = 0;
+        set_managed_input(ctrl, data->synchronized && data->max_input_delay > 0);
     } else if(data->gs_bak != NULL && !scene_is_arena(game_state_get_scene(ctrl->gs))) {
         // changed scene and no longer need a game state backup, release it
         game_state_clone_free(data->gs_bak);
@@ -682,10 +843,14 @@ int net_controller_tick(controller *ctrl, uint32_t ticks0, ctrl_event **ev) {
         data->last_acked_tick = 0;
         data->last_har_state = -1;
         data->last_traced_tick = 0;
+        data->rec_agreed_tick = 0;
         data->peer_last_hash = 0;
         data->peer_last_hash_tick = 0;
         data->last_hash = 0;
         data->last_hash_tick = 0;
+        data->input_horizon = 0;
+        data->advantage = 0.0f;
+        set_managed_input(ctrl, false);
 
         list_free(&data->transcript);
         list_create(&data->transcript);
@@ -693,6 +858,7 @@ int net_controller_tick(controller *ctrl, uint32_t ticks0, ctrl_event **ev) {
 
     int last_received = 0;
     int has_received = 0;
+    int has_late = 0;
 
     while(enet_host_service(host, &event, 0) > 0) {
         switch(event.type) {
@@ -710,7 +876,13 @@ int net_controller_tick(controller *ctrl, uint32_t ticks0, ctrl_event **ev) {
                         data->frame_advantage =
                             (ticks - data->local_proposal) - (peerticks + (avg_rtt(data->rttbuf, 100) / 2));
 
-                        if(data->gs_bak && data->synchronized && data->frame_advantage > peer_frame_advantage + 1) {
+                        data->peer_frame_advantage = peer_frame_advantage;
+                        if(data->managed_input && data->gs_bak) {
+                            // the pace follows the smoothed advantage, see update_pace()
+                            data->advantage =
+                                net_advantage_sample(data->advantage, data->frame_advantage, peer_frame_advantage);
+                        } else if(data->gs_bak && data->synchronized &&
+                                  data->frame_advantage > peer_frame_advantage + 1) {
                             log_debug("%d %d (%d) frame advantage %d > %d", ticks - data->local_proposal, peerticks,
                                       (avg_rtt(data->rttbuf, 100) / 2), data->frame_advantage, peer_frame_advantage);
                             ctrl->gs->delay = (data->frame_advantage - peer_frame_advantage) * 2;
@@ -735,7 +907,11 @@ int net_controller_tick(controller *ctrl, uint32_t ticks0, ctrl_event **ev) {
                                     if(data->synchronized && data->gs_bak) {
                                         if(remote_tick > data->last_received_tick) {
                                             insert_event(data, remote_tick, action, abs(data->id - 1),
-                                                         OBJECT_FACE_NONE);
+                                                         OBJECT_FACE_NONE, 0);
+                                            // the tick was simulated without it
+                                            if(remote_tick + data->local_proposal < ticks) {
+                                                has_late = 1;
+                                            }
                                         }
                                         last_received = remote_tick;
                                         if(action != 0) {
@@ -790,7 +966,7 @@ int net_controller_tick(controller *ctrl, uint32_t ticks0, ctrl_event **ev) {
                                 // we're synchronized on a stable connection, propose a time to start the match
                                 data->peer_proposal = peerticks + (newrtt / 2) + 100;
                                 data->local_proposal = ticks + 100;
-                                uint32_t seed = time(NULL);
+                                uint32_t seed = data->start_seed ? data->start_seed : (uint32_t)time(NULL);
                                 random_seed(&ctrl->gs->rand, seed);
                                 log_debug("proposing peer start game at their time %" PRIu32 ", my time %" PRIu32
                                           ", seed %" PRIu32,
@@ -886,6 +1062,8 @@ int net_controller_tick(controller *ctrl, uint32_t ticks0, ctrl_event **ev) {
                 data->disconnected = 1;
                 event.peer->data = NULL;
                 data->synchronized = false;
+                set_managed_input(ctrl, false);
+                ctrl->gs->pace_us = 0;
                 if(data->gs_bak) {
                     game_state_clone_free(data->gs_bak);
                     omf_free(data->gs_bak);
@@ -906,9 +1084,14 @@ int net_controller_tick(controller *ctrl, uint32_t ticks0, ctrl_event **ev) {
     }
 
     // if the match is actually proceeding (don't rewind during round/fight animation)
-    // AND we've received events then try a rewind/replay
-    if(has_received) {
-        if(rewind_and_replay(data, ctrl->gs)) {
+    // AND we've received events then try a rewind/replay.
+    // With delayed inputs, the ones that arrive in time are applied when their tick comes up, so only late ones
+    // need a replay. Replay now and then anyway, to move the saved state and the recording forward.
+    if(has_received && (!data->managed_input || has_late || ticks - data->gs_bak->int_tick >= NET_CHECKPOINT_TICKS)) {
+        profiler_begin(PROFILE_ROLLBACK);
+        int replay_failed = rewind_and_replay(data, ctrl->gs);
+        profiler_end(PROFILE_ROLLBACK);
+        if(replay_failed) {
             if(data->lobby == data->peer) {
                 game_state_set_next(ctrl->gs, SCENE_LOBBY);
                 return 1;
@@ -924,6 +1107,10 @@ int net_controller_tick(controller *ctrl, uint32_t ticks0, ctrl_event **ev) {
         send_events(data);
     }
 
+    // the replay may have swapped the game state, the pace goes on the one that is live now
+    update_pace(data, ctrl->gs);
+    write_telemetry(data, ticks, ctrl->gs->pace_us);
+
     unsigned tick_interval = 5;
     if(data->rttfilled) {
         tick_interval = 20;
@@ -971,8 +1158,15 @@ void controller_hook(controller *ctrl, int action) {
     if(peer) {
         // log_debug("Local event %d at %d", action, data->last_tick - data->local_proposal);
         if(data->synchronized && data->gs_bak) {
-            insert_event(data, ctrl->gs->int_tick - data->local_proposal /*+ (ctrl->rtt / 2)*/, action, data->id,
-                         direction);
+            uint32_t tick = ctrl->gs->int_tick - data->local_proposal;
+            uint64_t stamp = 0;
+            if(data->managed_input) {
+                // the inputs up to the horizon may have been sent already, so this one has to come later
+                tick = umax2(tick + data->input_delay, data->input_horizon + 1);
+                // the local controller only hands the action to us, its latency is measured when we apply it
+                stamp = game_player_get_ctrl(player)->input_stamp;
+            }
+            insert_event(data, tick, action, data->id, direction, stamp);
         } else {
             serial ser;
             ENetPacket *packet;
@@ -998,6 +1192,43 @@ void controller_hook(controller *ctrl, int action) {
     }
 }
 
+// Applies the inputs of both sides for the tick about to be simulated, in the same way as rewind_and_replay()
+int net_controller_dyntick(controller *ctrl, uint32_t ticks0, ctrl_events *ev) {
+    wtf *data = ctrl->data;
+    game_state *gs = ctrl->gs;
+    if(!data->managed_input || !data->synchronized || !data->gs_bak) {
+        return 0;
+    }
+
+    iterator it;
+    list_iter_begin(&data->transcript, &it);
+    tick_events *tev = NULL;
+    foreach(it, tev) {
+        if(tev->tick + data->local_proposal > gs->int_tick) {
+            break;
+        }
+        if(tev->tick + data->local_proposal < gs->int_tick) {
+            continue;
+        }
+        for(int j = 0; j < 2; j++) {
+            object *har_obj = game_state_find_object(gs, game_player_get_har_obj_id(game_state_get_player(gs, j)));
+            if(har_obj == NULL) {
+                continue;
+            }
+            int k = 0;
+            do {
+                object_act(har_obj, tev->events[j][k]);
+                k++;
+            } while(tev->events[j][k]);
+            if(j == data->id && tev->stamp != 0) {
+                input_latency_acted(tev->stamp, game_state_get_player(gs, j)->ctrl->type, game_state_get_speed(gs));
+                tev->stamp = 0;
+            }
+        }
+    }
+    return 0;
+}
+
 void net_controller_create(controller *ctrl, ENetHost *host, ENetPeer *peer, ENetPeer *lobby, int id) {
     wtf *data = omf_calloc(1, sizeof(wtf));
     data->id = id;
@@ -1025,6 +1256,8 @@ void net_controller_create(controller *ctrl, ENetHost *host, ENetPeer *peer, ENe
     data->winner = -1;
     data->last_action = ACT_NONE;
     data->last_direction = OBJECT_FACE_NONE;
+    data->max_input_delay = max2(settings_get()->net.net_max_input_delay, 0);
+    data->telemetry_file = NULL;
     char *trace_file = settings_get()->net.trace_file;
     if(trace_file) {
         data->trace_file = SDL_RWFromFile(trace_file, "w");
@@ -1036,6 +1269,10 @@ void net_controller_create(controller *ctrl, ENetHost *host, ENetPeer *peer, ENe
     ctrl->data = data;
     ctrl->type = CTRL_TYPE_NETWORK;
     ctrl->tick_fun = &net_controller_tick;
+    ctrl->dyntick_fun = &net_controller_dyntick;
     ctrl->controller_hook = &controller_hook;
     ctrl->free_fun = &net_controller_free;
+    if(settings_get()->net.telemetry_file) {
+        net_controller_set_telemetry_file(ctrl, settings_get()->net.telemetry_file);
+    }
 }
@@ -5,6 +5,17 @@
 #include <SDL.h>
 #include <enet/enet.h>
 
+// Rollback counters of a net controller, accumulated over its lifetime
+typedef struct net_controller_stats {
+    uint32_t rollbacks;      // calls to rewind_and_replay()
+    uint32_t replayed_ticks; // dynamic ticks simulated by all replays
+    uint32_t max_depth;      // most ticks simulated by a single replay
+    double replay_ms;        // wall clock time spent replaying
+    uint32_t desyncs;        // replays that ended in an arena hash mismatch
+    int input_delay;         // current delay of local inputs, in ticks
+    float advantage;         // current smoothed frame advantage, positive when this side is ahead
+} net_controller_stats;
+
 void net_controller_create(controller *ctrl, ENetHost *host, ENetPeer *peer, ENetPeer *lobby, int id);
 void net_controller_free(controller *ctrl);
 int net_controller_get_rtt(controller *ctrl);
@@ -13,10 +24,18 @@ void net_controller_har_hook(int action, void *cb_data);
 bool net_controller_ready(controller *ctrl);
 int net_controller_tick_offset(controller *ctrl);
 
+// Seed to propose for the match instead of the current time, so that test runs are reproducible. 0 resets.
+void net_controller_set_start_seed(controller *ctrl, uint32_t seed);
+void net_controller_get_stats(controller *ctrl, net_controller_stats *stats);
+// Writes a CSV line of input delay, frame advantage, pace and rollbacks every few ticks of a match. NULL closes.
+bool net_controller_set_telemetry_file(controller *ctrl, const char *filename);
+
 ENetPeer *net_controller_get_lobby_connection(controller *ctrl);
 
 ENetHost *net_controller_get_host(controller *ctrl);
 int net_controller_get_winner(controller *ctrl);
 void net_controller_set_winner(controller *ctrl, int winner);
+// Tick up to which the agreed inputs of both sides have been written to the recording
+uint32_t net_controller_get_agreed_tick(controller *ctrl);
 
 #endif // NET_CONTROLLER_H
@@ -5,6 +5,7 @@
 #include "game/game_state_type.h"
 #include "utils/allocator.h"
 #include "utils/log.h"
+#include "utils/miscmath.h"
 #include <inttypes.h>
 
 typedef struct {
@@ -13,6 +14,10 @@ typedef struct {
     uint32_t max_tick;
     uint8_t last_action;
     hashmap tick_lookup;
+    unsigned int indexed; // moves of the recording already in tick_lookup
+    uint32_t indexed_tick;
+    int indexed_j;
+    int failed_assertions;
 } wtf;
 
 void rec_controller_free(controller *ctrl) {
@@ -23,44 +28,78 @@ void rec_controller_free(controller *ctrl) {
     }
 }
 
-int get_operand(rec_assertion_operand *op, controller *ctrl) {
+// Finds the HAR an assertion operand refers to. NULL if there is no such HAR, eg. outside of the arena.
+static object *get_har_obj(controller *ctrl, int har_id) {
+    if(har_id < 0 || har_id > 1) {
+        return NULL;
+    }
+    object *obj = game_state_find_object(ctrl->gs, game_player_get_har_obj_id(game_state_get_player(ctrl->gs, har_id)));
+    if(obj == NULL || object_get_userdata(obj) == NULL) {
+        return NULL;
+    }
+    return obj;
+}
+
+// Returns 0 and sets value on success, 1 if the operand cannot be evaluated.
+static int get_operand(rec_assertion_operand *op, controller *ctrl, int *value) {
     if(op->is_literal) {
-        return op->value.literal;
-    } else {
-        object *obj = game_state_find_object(
-            ctrl->gs, game_player_get_har_obj_id(game_state_get_player(ctrl->gs, op->value.attr.har_id)));
-        har *har = object_get_userdata(obj);
-        switch(op->value.attr.attribute) {
-            case ATTR_X_POS:
-                return obj->pos.x;
-            case ATTR_Y_POS:
-                return obj->pos.y;
-            case ATTR_X_VEL:
-                return obj->vel.x;
-            case ATTR_Y_VEL:
-                return obj->vel.y;
-            case ATTR_STATE_ID:
-                return har->state;
-            case ATTR_ANIMATION_ID:
-                return obj->cur_animation->id;
-            case ATTR_HEALTH:
-                return har->health;
-            case ATTR_STAMINA:
-                return har->endurance;
-            case ATTR_OPPONENT_DISTANCE: {
-                object *obj_opp = game_state_find_object(ctrl->gs, game_player_get_har_obj_id(game_state_get_player(
-                                                                       ctrl->gs, abs(op->value.attr.har_id - 1))));
-                return fabsf(obj->pos.x - obj_opp->pos.x);
+        *value = op->value.literal;
+        return 0;
+    }
+    object *obj = get_har_obj(ctrl, op->value.attr.har_id);
+    if(obj == NULL) {
+        log_error("assertion refers to missing HAR %d", op->value.attr.har_id);
+        return 1;
+    }
+    har *har = object_get_userdata(obj);
+    switch(op->value.attr.attribute) {
+        case ATTR_X_POS:
+            *value = obj->pos.x;
+            return 0;
+        case ATTR_Y_POS:
+            *value = obj->pos.y;
+            return 0;
+        case ATTR_X_VEL:
+            *value = obj->vel.x;
+            return 0;
+        case ATTR_Y_VEL:
+            *value = obj->vel.y;
+            return 0;
+        case ATTR_STATE_ID:
+            *value = har->state;
+            return 0;
+        case ATTR_ANIMATION_ID:
+            *value = obj->cur_animation->id;
+            return 0;
+        case ATTR_HEALTH:
+            *value = har->health;
+            return 0;
+        case ATTR_STAMINA:
+            *value = har->endurance;
+            return 0;
+        case ATTR_OPPONENT_DISTANCE: {
+            object *obj_opp = get_har_obj(ctrl, 1 - op->value.attr.har_id);
+            if(obj_opp == NULL) {
+                log_error("assertion refers to missing HAR %d", 1 - op->value.attr.har_id);
+                return 1;
             }
-            default:
-                abort();
+            *value = fabsf(obj->pos.x - obj_opp->pos.x);
+            return 0;
         }
+        default:
+            log_error("unsupported assertion attribute %d", op->value.attr.attribute);
+            return 1;
     }
 }
 
-void check_assertion(rec_assertion *ass, controller *ctrl) {
-    int16_t operand1 = get_operand(&ass->operand1, ctrl);
-    int16_t operand2 = get_operand(&ass->operand2, ctrl);
+// Returns 0 if the assertion holds (or was applied), 1 if it failed or could not be evaluated.
+static int check_assertion(rec_assertion *ass, controller *ctrl) {
+    int value1, value2;
+    if(get_operand(&ass->operand1, ctrl, &value1) || get_operand(&ass->operand2, ctrl, &value2)) {
+        return 1;
+    }
+    int16_t operand1 = value1;
+    int16_t operand2 = value2;
 
     log_debug("operand 1 %d operand 2 %d", operand1, operand2);
 
@@ -68,56 +107,60 @@ void check_assertion(rec_assertion *ass, controller *ctrl) {
         case OP_EQ:
             if(operand1 != operand2) {
                 log_error("%d != %d", operand1, operand2);
-                abort();
+                return 1;
             }
-            break;
+            return 0;
         case OP_LT:
             if(operand1 >= operand2) {
                 log_error("%d !< %d", operand1, operand2);
-                abort();
+                return 1;
             }
-            break;
+            return 0;
         case OP_GT:
             if(operand1 <= operand2) {
                 log_error("%d !> %d", operand1, operand2);
-                abort();
+                return 1;
             }
-            break;
+            return 0;
         case OP_SET: {
-            object *obj = game_state_find_object(
-                ctrl->gs, game_player_get_har_obj_id(game_state_get_player(ctrl->gs, ass->operand1.value.attr.har_id)));
+            if(ass->operand1.is_literal) {
+                log_error("cannot set a literal");
+                return 1;
+            }
+            object *obj = get_har_obj(ctrl, ass->operand1.value.attr.har_id);
             har *har = object_get_userdata(obj);
 
             switch(ass->operand1.value.attr.attribute) {
                 case ATTR_X_POS:
                     obj->pos.x = operand2;
-                    return;
+                    return 0;
                 case ATTR_Y_POS:
                     obj->pos.y = operand2;
-                    return;
+                    return 0;
                 case ATTR_X_VEL:
                     obj->vel.x = operand2;
-                    return;
+                    return 0;
                 case ATTR_Y_VEL:
                     obj->vel.y = operand2;
-                    return;
+                    return 0;
                 case ATTR_HEALTH:
                     har->health = operand2;
-                    return;
+                    return 0;
                 case ATTR_STAMINA:
                     har->endurance = operand2;
-                    return;
+                    return 0;
                 default:
                     log_error("unsupported set");
-                    abort();
+                    return 1;
             }
         }
         default:
-            abort();
+            log_error("unsupported assertion operator %d", ass->op);
+            return 1;
     }
 }
 
-int rec_controller_poll(controller *ctrl, ctrl_event **ev) {
+int rec_controller_poll(controller *ctrl, ctrl_events *ev) {
     uint32_t ticks = ctrl->gs->int_tick;
     wtf *data = ctrl->data;
     sd_rec_move *move;
@@ -141,7 +184,13 @@ int rec_controller_poll(controller *ctrl, ctrl_event **ev) {
                 rec_assertion ass;
                 if(parse_assertion(buf, &ass)) {
                     print_assertion(&ass);
-                    check_assertion(&ass, ctrl);
+                    if(check_assertion(&ass, ctrl)) {
+                        log_error("REC assertion failed at tick %" PRIu32, ticks);
+                        data->failed_assertions++;
+                    }
+                } else {
+                    log_error("Malformed REC assertion at tick %" PRIu32, ticks);
+                    data->failed_assertions++;
                 }
             } else if(move->lookup_id == 2) {
                 found_action = true;
@@ -190,28 +239,60 @@ int rec_controller_poll(controller *ctrl, ctrl_event **ev) {
     return 0;
 }
 
+// Adds the moves recorded since the last call to the tick lookup
+static void rec_controller_index(wtf *data, const sd_rec_file *rec) {
+    for(; data->indexed < rec->move_count; data->indexed++) {
+        sd_rec_move *move = &rec->moves[data->indexed];
+        if(move->player_id == data->id && (move->lookup_id == 2 || move->lookup_id == 10)) {
+            if(data->indexed_tick == move->tick) {
+                data->indexed_j++;
+            } else {
+                data->indexed_j = 0;
+            }
+            hashmap_put_int(&data->tick_lookup, (move->tick * 10) + data->indexed_j, move, sizeof(sd_rec_move));
+            data->indexed_tick = move->tick;
+        }
+    }
+    if(rec->move_count > 0) {
+        data->max_tick = umax2(data->max_tick, rec->moves[rec->move_count - 1].tick);
+    }
+}
+
 void rec_controller_create(controller *ctrl, int player, sd_rec_file *rec) {
     wtf *data = omf_calloc(1, sizeof(wtf));
+    data->id = player;
     data->last_tick = 0;
     data->last_action = ACT_STOP;
     hashmap_create(&data->tick_lookup);
-    uint32_t last_tick = 0;
-    int j = 0;
-    for(unsigned int i = 0; i < rec->move_count; i++) {
-        if(rec->moves[i].player_id == player && (rec->moves[i].lookup_id == 2 || rec->moves[i].lookup_id == 10)) {
-            if(last_tick == rec->moves[i].tick) {
-                j++;
-            } else {
-                j = 0;
-            }
-            hashmap_put_int(&data->tick_lookup, (rec->moves[i].tick * 10) + j, &rec->moves[i], sizeof(sd_rec_move));
-            last_tick = rec->moves[i].tick;
-        }
-    }
-    data->max_tick = rec->moves[rec->move_count - 1].tick;
-    log_debug("max tick is %" PRIu32, data->last_tick);
+    rec_controller_index(data, rec);
+    log_debug("max tick is %" PRIu32, data->max_tick);
     ctrl->data = data;
     ctrl->type = CTRL_TYPE_REC;
     ctrl->poll_fun = &rec_controller_poll;
     ctrl->free_fun = &rec_controller_free;
 }
+
+void rec_controller_update(controller *ctrl, const sd_rec_file *rec, uint32_t max_tick) {
+    wtf *data = ctrl->data;
+    rec_controller_index(data, rec);
+    data->max_tick = umax2(data->max_tick, max_tick);
+}
+
+int rec_controller_failed_assertions(const controller *ctrl) {
+    const wtf *data = ctrl->data;
+    return data->failed_assertions;
+}
+
+void rec_controller_save_state(const controller *ctrl, rec_controller_state *state) {
+    const wtf *data = ctrl->data;
+    state->last_tick = data->last_tick;
+    state->last_action = data->last_action;
+    state->ctrl_last = ctrl->last;
+}
+
+void rec_controller_load_state(controller *ctrl, const rec_controller_state *state) {
+    wtf *data = ctrl->data;
+    data->last_tick = state->last_tick;
+    data->last_action = state->last_action;
+    ctrl->last = state->ctrl_last;
+}
@@ -5,7 +5,21 @@
 #include "formats/rec.h"
 #include "utils/hashmap.h"
 
+// Playback position of a REC controller, so that a replay can be restored to an earlier point.
+typedef struct rec_controller_state {
+    uint32_t last_tick;
+    uint8_t last_action;
+    int ctrl_last;
+} rec_controller_state;
+
 void rec_controller_create(controller *ctrl, int player, sd_rec_file *rec);
 void rec_controller_free(controller *ctrl);
+// Picks up moves appended to the recording after the controller was created, and lets playback run up to
+// max_tick even if there are no moves that far yet.
+void rec_controller_update(controller *ctrl, const sd_rec_file *rec, uint32_t max_tick);
+// Number of assertions in the recording that did not hold, or could not be checked, during playback so far.
+int rec_controller_failed_assertions(const controller *ctrl);
+void rec_controller_save_state(const controller *ctrl, rec_controller_state *state);
+void rec_controller_load_state(controller *ctrl, const rec_controller_state *state);
 
 #endif // REC_CONTROLLER_H
@@ -3,69 +3,146 @@
 #include "console/console.h"
 #include "controller/controller.h"
 #include "formats/altpal.h"
+#include "formats/error.h"
 #include "formats/rec.h"
 #include "game/game_player.h"
 #include "game/game_state.h"
 #include "game/gui/text_render.h"
+#include "game/utils/input_latency.h"
+#include "game/utils/profiler.h"
+#include "game/utils/spectator.h"
 #include "game/utils/settings.h"
+#include "resources/asset_pack.h"
 #include "resources/languages.h"
+#include "resources/pathmanager.h"
 #include "resources/sounds_loader.h"
 #include "utils/allocator.h"
+#include "utils/io_worker.h"
 #include "utils/log.h"
 #include "utils/miscmath.h"
 #include "utils/png_writer.h"
+#include "utils/task_graph.h"
 #include "utils/time_fmt.h"
+#include "video/frame_writer.h"
 #include "video/vga_state.h"
 #include "video/video.h"
 #include <SDL.h>
 #include <stdio.h>
+#include <string.h>
 
 #define MAX_TICKS_PER_FRAME 10
 #define TICK_EXPIRY_MS 100
+#define MAX_SPECTATORS 64
+#define EXPORT_FPS 50
 
 static int run = 0;
 static int start_timeout = 30;
 static int enable_screen_updates = 1;
 static int debug_palette_number = 0;
+static vga_state *vga = NULL;
 
-int engine_init(engine_init_flags *init_flags) {
-    settings *setting = settings_get();
-
-    int w = setting->video.screen_w;
-    int h = setting->video.screen_h;
-    int fs = setting->video.fullscreen;
-    int vsync = setting->video.vsync;
-    int aspect = setting->video.aspect;
-    int frequency = setting->sound.sample_rate;
-    int resampler = setting->sound.music_resampler;
-    bool mono = setting->sound.music_mono;
-    float music_volume = setting->sound.music_vol / 10.0;
-    float sound_volume = setting->sound.sound_vol / 10.0;
-    const char *player = setting->sound.player;
-    const char *renderer = setting->video.renderer;
-    if(strlen(init_flags->force_audio_backend) > 0)
-        player = init_flags->force_audio_backend;
+static bool init_video(void *userdata) {
+    engine_init_flags *init_flags = userdata;
+    settings_video *setting = &settings_get()->video;
+    const char *renderer = setting->renderer;
     if(strlen(init_flags->force_renderer) > 0)
         renderer = init_flags->force_renderer;
-
-    // Initialize everything.
     video_scan_renderers();
+    return video_init(renderer, setting->screen_w, setting->screen_h, setting->fullscreen, setting->vsync,
+                      setting->aspect);
+}
+
+static bool init_audio(void *userdata) {
+    engine_init_flags *init_flags = userdata;
+    settings_sound *setting = &settings_get()->sound;
+    const char *player = setting->player;
+    if(strlen(init_flags->force_audio_backend) > 0)
+        player = init_flags->force_audio_backend;
     audio_scan_backends();
-    if(!video_init(renderer, w, h, fs, vsync, aspect))
+    return audio_init(player, setting->sample_rate, setting->music_mono, setting->music_resampler,
+                      setting->music_vol / 10.0, setting->sound_vol / 10.0);
+}
+
+static bool init_asset_pack(void *userdata) {
+    // Resources are taken from the asset pack where possible, and loaded from their files otherwise
+    char pack_path[256];
+    snprintf(pack_path, sizeof(pack_path), "%s%s", pm_get_local_path(RESOURCE_PATH), ASSET_PACK_FILE);
+    asset_pack_open(pack_path);
+    return true;
+}
+
+static bool init_sounds(void *userdata) {
+    return sounds_loader_init();
+}
+
+static bool init_languages(void *userdata) {
+    return lang_init();
+}
+
+static bool init_fonts(void *userdata) {
+    return fonts_init();
+}
+
+static bool init_altpals(void *userdata) {
+    return altpals_init() == 0;
+}
+
+static bool init_console(void *userdata) {
+    return console_init();
+}
+
+static void close_video(void *userdata) {
+    video_close();
+}
+
+static void close_audio(void *userdata) {
+    audio_close();
+}
+
+static void close_asset_pack(void *userdata) {
+    asset_pack_close();
+}
+
+static void close_sounds(void *userdata) {
+    sounds_loader_close();
+}
+
+static void close_languages(void *userdata) {
+    lang_close();
+}
+
+static void close_fonts(void *userdata) {
+    fonts_close();
+}
+
+static void close_altpals(void *userdata) {
+    altpals_close();
+}
+
+static void close_console(void *userdata) {
+    console_close();
+}
+
+int engine_init(engine_init_flags *init_flags) {
+    // The window and the audio device are set up on the main thread, while the resource files are loaded on
+    // worker threads. If something fails, whatever did succeed is closed in the reverse order of the list.
+    task_graph init;
+    task_graph_create(&init);
+    task_graph_add(&init, "video", init_video, close_video, init_flags, 0, true);
+    task_graph_add(&init, "audio", init_audio, close_audio, init_flags, 0, true);
+    int pack = task_graph_add(&init, "asset pack", init_asset_pack, close_asset_pack, NULL, 0, false);
+    task_graph_add(&init, "sounds", init_sounds, close_sounds, NULL, TASK_DEP(pack), false);
+    task_graph_add(&init, "languages", init_languages, close_languages, NULL, TASK_DEP(pack), false);
+    task_graph_add(&init, "fonts", init_fonts, close_fonts, NULL, TASK_DEP(pack), false);
+    task_graph_add(&init, "altpals", init_altpals, close_altpals, NULL, 0, false);
+    task_graph_add(&init, "console", init_console, close_console, NULL, 0, true);
+    if(!task_graph_run(&init, SDL_GetCPUCount()))
+        goto exit_0;
+    task_graph_log_profile(&init, "Engine initialization");
+    if(!io_worker_init())
         goto exit_0;
-    if(!audio_init(player, frequency, mono, resampler, music_volume, sound_volume))
-        goto exit_1;
-    if(!sounds_loader_init())
-        goto exit_2;
-    if(!lang_init())
-        goto exit_3;
-    if(!fonts_init())
-        goto exit_4;
-    if(altpals_init())
-        goto exit_5;
-    if(!console_init())
-        goto exit_6;
-    vga_state_init();
+    input_latency_init(init_flags->latency_log);
+    vga = vga_state_create();
 
     // Return successfully
     run = 1;
@@ -73,56 +150,121 @@ int engine_init(engine_init_flags *init_flags) {
     return 0;
 
     // If something failed, close in correct order
-exit_6:
-    altpals_close();
-exit_5:
-    fonts_close();
-exit_4:
-    lang_close();
-exit_3:
-    sounds_loader_close();
-exit_2:
-    audio_close();
-exit_1:
-    video_close();
 exit_0:
+    task_graph_close(&init);
     return 1;
 }
 
-void save_screenshot(const SDL_Rect *r, unsigned char *data, bool flip) {
+typedef struct screenshot_job {
+    char filename[256];
+    int w;
+    int h;
+    bool flip;
+    unsigned char *data;
+} screenshot_job;
+
+static bool write_screenshot(void *userdata) {
+    screenshot_job *job = userdata;
+    return write_rgb_png(job->filename, job->w, job->h, job->data, false, job->flip);
+}
+
+static void free_screenshot(void *userdata) {
+    screenshot_job *job = userdata;
+    omf_free(job->data);
+    omf_free(job);
+}
+
+void save_screenshot(const SDL_Rect *r, const unsigned char *data, bool flip) {
     char *time = format_time();
-    char *filename = omf_malloc(256);
-    snprintf(filename, 256, "screenshot_%s.png", time);
-    if(write_rgb_png(filename, r->w, r->h, data, false, flip)) {
-        log_info("Got a screenshot: %s", filename);
-    } else {
-        log_error("Screenshot write operation failed (%s)", filename);
-    }
-    omf_free(filename);
+    screenshot_job *job = omf_calloc(1, sizeof(screenshot_job));
+    snprintf(job->filename, sizeof(job->filename), "screenshot_%s.png", time);
+    job->w = r->w;
+    job->h = r->h;
+    job->flip = flip;
+    job->data = omf_malloc(r->w * r->h * 3);
+    memcpy(job->data, data, r->w * r->h * 3);
+    io_worker_submit(job->filename, write_screenshot, free_screenshot, job);
     omf_free(time);
 }
 
-void save_palette_shot(void) {
+typedef struct palette_shot_job {
+    char filename[256];
+    vga_palette palette;
+} palette_shot_job;
+
+// Writes the palette as a 16x16 image, one pixel per color
+static bool write_palette_shot(void *userdata) {
+    palette_shot_job *job = userdata;
+    unsigned char img[256];
+    for(int i = 0; i < 256; i++) {
+        img[i] = i;
+    }
+    return write_paletted_png(job->filename, 16, 16, &job->palette, img);
+}
+
+static void free_palette_shot(void *userdata) {
+    omf_free(userdata);
+}
+
+void save_palette_shot(vga_state *state) {
     char *time = format_time();
-    char *filename = omf_malloc(256);
-    snprintf(filename, 256, "debug_palette_%s_%d.png", time, debug_palette_number++);
-    vga_state_debug_screenshot(filename);
-    log_info("Palette saved: %s", filename);
-    omf_free(filename);
+    palette_shot_job *job = omf_calloc(1, sizeof(palette_shot_job));
+    snprintf(job->filename, sizeof(job->filename), "debug_palette_%s_%d.png", time, debug_palette_number++);
+    memcpy(&job->palette, vga_state_get_palette(state), sizeof(vga_palette));
+    io_worker_submit(job->filename, write_palette_shot, free_palette_shot, job);
     omf_free(time);
 }
 
+typedef struct rec_job {
+    char filename[256];
+    sd_rec_file rec;
+} rec_job;
+
+static bool write_rec(void *userdata) {
+    rec_job *job = userdata;
+    return sd_rec_save(&job->rec, job->filename) == SD_SUCCESS;
+}
+
+static void free_rec(void *userdata) {
+    rec_job *job = userdata;
+    sd_rec_free(&job->rec);
+    omf_free(job);
+}
+
 void save_rec(game_state *gs) {
     char *time = format_time();
-    char *filename = omf_malloc(256);
-    snprintf(filename, 256, "%s.rec", time);
-    sd_rec_finish(gs->rec, gs->int_tick);
-    sd_rec_save(gs->rec, filename);
-    log_info("REC saved: %s", filename);
-    omf_free(filename);
+    rec_job *job = omf_calloc(1, sizeof(rec_job));
+    snprintf(job->filename, sizeof(job->filename), "%s.rec", time);
+
+    // Save a snapshot, so that the match can keep on recording into the live REC
+    sd_rec_copy(&job->rec, gs->rec);
+    sd_rec_finish(&job->rec, gs->int_tick);
+    io_worker_submit(job->filename, write_rec, free_rec, job);
     omf_free(time);
 }
 
+static void export_frame(const unsigned char *pixels, const vga_palette *palette, void *userdata) {
+    frame_writer_push(userdata, pixels, palette);
+}
+
+static void log_sprite_sharing(void) {
+    surface_intern_stats stats;
+    surface_get_intern_stats(&stats);
+    log_debug("Sprites: %u surfaces share %u pixel buffers of %zu bytes, saving %zu bytes", stats.surfaces,
+              stats.buffers, stats.bytes, stats.bytes_saved);
+}
+
+// Applies the video effects the simulation requested during the ticks of this frame.
+static void apply_host_outputs(game_state *gs) {
+    if(gs->host.scene_changed) {
+        // Free texture items, the new scene will create new ones.
+        video_signal_scene_change();
+        log_sprite_sharing();
+        gs->host.scene_changed = false;
+    }
+    video_move_target(gs->host.screen_offset_x, gs->host.screen_offset_y);
+}
+
 void engine_run(engine_init_flags *init_flags) {
     SDL_Event e;
     int visual_debugger = 0;
@@ -134,31 +276,58 @@ void engine_run(engine_init_flags *init_flags) {
 
     log_info(" --- BEGIN GAME LOG ---");
 
+    // When exporting video, the game runs on simulated time as fast as it can, and every frame is written out.
+    frame_writer *exporter = NULL;
+    if(init_flags->export_path[0]) {
+        exporter = frame_writer_open(init_flags->export_path, NATIVE_W, NATIVE_H, EXPORT_FPS);
+        if(exporter == NULL) {
+            return;
+        }
+        video_capture_frames(export_frame, exporter);
+    }
+
     // Game start timeout.
     // Wait a moment so that people are mentally prepared
     // (with the recording software on) for the game to start :)
-    if(!settings_get()->video.crossfade_on) {
+    if(!settings_get()->video.crossfade_on || exporter != NULL) {
         start_timeout = 0;
     }
     while(start_timeout > 0) {
         start_timeout--;
         while(SDL_PollEvent(&e)) {
             if(e.type == SDL_QUIT) {
-                return;
+                goto exit_0;
             }
         }
         video_render_prepare();
-        video_render_finish();
+        video_render_finish(vga);
     }
 
     // apply volume settings
     audio_set_sound_volume(settings_get()->sound.sound_vol / 10.0f);
 
     // Set up game
+    spectator_client *spectator = NULL;
+    spectator_relay *relay = NULL;
     game_state *gs = omf_calloc(1, sizeof(game_state));
-    if(game_state_create(gs, init_flags)) {
+    if(init_flags->spectate_addr[0]) {
+        spectator = spectator_client_connect(init_flags->spectate_addr, init_flags->spectate_port, 5000);
+        if(spectator == NULL) {
+            log_error("Unable to spectate %s", init_flags->spectate_addr);
+            omf_free(gs);
+            goto exit_0;
+        }
+        if(game_state_create_spectator(gs, init_flags, vga, spectator_client_take_rec(spectator))) {
+            game_state_free(&gs);
+            spectator_client_free(&spectator);
+            goto exit_0;
+        }
+    } else if(game_state_create(gs, init_flags, vga)) {
         game_state_free(&gs);
-        return;
+        goto exit_0;
+    }
+    if(init_flags->spectate_relay) {
+        relay = spectator_relay_create(init_flags->spectate_port, MAX_SPECTATORS, init_flags->spectate_delay);
     }
 
     joystick_init();
@@ -168,9 +337,14 @@ void engine_run(engine_init_flags *init_flags) {
     int dynamic_wait = 0;
     int static_wait = 0;
     while(run && game_state_is_running(gs)) {
+        profiler_frame();
+
         // Handle events
+        profiler_begin(PROFILE_EVENTS);
         bool check_fs;
         while(SDL_PollEvent(&e)) {
+            input_latency_event(&e);
+
             // Handle other events
             switch(e.type) {
                 case SDL_QUIT:
@@ -181,7 +355,7 @@ void engine_run(engine_init_flags *init_flags) {
                         video_schedule_screenshot(save_screenshot);
                     }
                     if(e.key.keysym.sym == SDLK_F2) {
-                        save_palette_shot();
+                        save_palette_shot(gs->vga);
                     }
                     if(e.key.keysym.sym == SDLK_F3) {
                         if(init_flags->playback != 1) {
@@ -266,6 +440,7 @@ void engine_run(engine_init_flags *init_flags) {
                 game_state_handle_event(gs, &e);
             }
         }
+        profiler_end(PROFILE_EVENTS);
 
         // hide mouse after n ticks
         if(mouse_visible_ticks > 0) {
@@ -278,6 +453,9 @@ void engine_run(engine_init_flags *init_flags) {
         // Render scene
         uint64_t frame_dt = SDL_GetTicks64() - frame_start;
         frame_start = SDL_GetTicks64();
+        if(exporter != NULL) {
+            frame_dt = 1000 / EXPORT_FPS;
+        }
         if(!visual_debugger) {
             dynamic_wait += frame_dt;
             static_wait += frame_dt;
@@ -291,6 +469,30 @@ void engine_run(engine_init_flags *init_flags) {
         dynamic_wait = min2(dynamic_wait, TICK_EXPIRY_MS);
         static_wait = min2(static_wait, TICK_EXPIRY_MS);
 
+        // Hand over the current user preferences; the tick functions do not look at global state.
+        gs->host.input_blocked = console_window_is_open();
+        game_state_sync_settings(gs);
+
+        // A spectator may only run as far as the moves it has received. One that is far behind, eg. because
+        // it joined mid-match, catches up quietly before it starts showing the match.
+        uint32_t watermark = 0;
+        if(spectator != NULL) {
+            watermark = spectator_client_sync(spectator, gs);
+            if(spectator_client_is_live(spectator) && gs->int_tick + init_flags->spectate_delay < watermark) {
+                bool audio = gs->host.audio;
+                gs->host.audio = false;
+                while(gs->int_tick < watermark && game_state_is_running(gs) && gs->new_state == NULL) {
+                    profiler_begin(PROFILE_STATIC_TICK);
+                    game_state_static_tick(gs, false);
+                    profiler_end(PROFILE_STATIC_TICK);
+                    profiler_begin(PROFILE_DYNAMIC_TICK);
+                    game_state_dynamic_tick(gs, false);
+                    profiler_end(PROFILE_DYNAMIC_TICK);
+                }
+                gs->host.audio = audio;
+            }
+        }
+
         // In warp mode, allow more ticks to happen per vsync period.
         bool has_dynamic = true;
         bool has_static = true;
@@ -300,7 +502,9 @@ void engine_run(engine_init_flags *init_flags) {
             // that are not dependent on game speed (such as menus).
             has_static = static_wait > STATIC_TICKS;
             if(has_static) {
+                profiler_begin(PROFILE_STATIC_TICK);
                 game_state_static_tick(gs, false);
+                profiler_end(PROFILE_STATIC_TICK);
                 // check if we need to replace the game state
                 if(gs->new_state) {
                     // one of the controllers wants to replace the game state
@@ -313,6 +517,9 @@ void engine_run(engine_init_flags *init_flags) {
                     game_state_clone_free(old_gs);
                     omf_free(old_gs);
                 }
+                if(relay != NULL) {
+                    spectator_relay_update(relay, gs);
+                }
                 console_tick(gs);
                 static_wait -= STATIC_TICKS;
             }
@@ -320,13 +527,25 @@ void engine_run(engine_init_flags *init_flags) {
             // Tick dynamic features. This is a dynamically changing tick, and it depends on things such as
             // hit-pause, hit slowdown and game-speed slider. It is meant for ticking everything that has to do
             // with the actual gameplay stuff.
-            has_dynamic = dynamic_wait > game_state_ms_per_dyntick(gs);
+            // The wait is taken before the tick, as netplay pacing changes it from one tick to the next.
+            int dyntick_wait = game_state_dyntick_wait(gs);
+            has_dynamic = dynamic_wait > dyntick_wait;
+            if(spectator != NULL && spectator_client_is_live(spectator) && gs->int_tick >= watermark) {
+                // Waiting for the relay
+                has_dynamic = false;
+                dynamic_wait = 0;
+            }
             if(has_dynamic) {
+                profiler_begin(PROFILE_DYNAMIC_TICK);
                 game_state_dynamic_tick(gs, false);
-                dynamic_wait -= game_state_ms_per_dyntick(gs);
+                profiler_end(PROFILE_DYNAMIC_TICK);
+                dynamic_wait -= dyntick_wait;
                 if(gs->delay > 0) {
+                    // Without input delay, netplay stalls the side that is ahead instead of pacing it
                     log_debug("applying delay %d", gs->delay);
-                    SDL_Delay(4);
+                    if(exporter == NULL) {
+                        SDL_Delay(4);
+                    }
                     gs->delay--;
                     dynamic_wait -= 4;
                 }
@@ -334,20 +553,32 @@ void engine_run(engine_init_flags *init_flags) {
 
             // Ensure any pending palette changes are handled after any ticks are made.
             if(has_dynamic || has_static) {
+                profiler_begin(PROFILE_PALETTE);
                 game_state_palette_transform(gs);
-                vga_state_render();
+                vga_state_render(gs->vga);
+                profiler_end(PROFILE_PALETTE);
             }
         } while(tick_limit-- && (has_dynamic || has_static));
+        apply_host_outputs(gs);
 
         // Do the actual video rendering jobs
-        if(enable_screen_updates) {
+        if(enable_screen_updates || exporter != NULL) {
+            profiler_begin(PROFILE_RENDER);
             video_render_prepare();
             game_state_render(gs);
             if(debugger_render) {
                 game_state_debug(gs);
             }
+            profiler_end(PROFILE_RENDER);
+            input_latency_render();
+            profiler_render();
+            profiler_begin(PROFILE_CONSOLE);
             console_render();
-            video_render_finish();
+            profiler_end(PROFILE_CONSOLE);
+            profiler_begin(PROFILE_PRESENT);
+            video_render_finish(gs->vga);
+            profiler_end(PROFILE_PRESENT);
+            input_latency_presented();
         } else {
             // If screen updates are disabled, then wait
             SDL_Delay(1);
@@ -357,19 +588,33 @@ void engine_run(engine_init_flags *init_flags) {
     joystick_close();
 
     // Free scene object
+    spectator_relay_free(&relay);
+    spectator_client_free(&spectator);
     game_state_free(&gs);
 
+exit_0:
+    if(exporter != NULL) {
+        video_capture_frames(NULL, NULL);
+        if(!frame_writer_close(&exporter)) {
+            log_error("Video export to %s failed", init_flags->export_path);
+        }
+    }
+
     log_info(" --- END GAME LOG ---");
 }
 
 void engine_close(void) {
+    profiler_close();
+    input_latency_close();
+    io_worker_close();
     console_close();
     altpals_close();
     fonts_close();
     lang_close();
     sounds_loader_close();
+    asset_pack_close();
     audio_close();
     video_close();
-    vga_state_close();
+    vga_state_free(&vga);
     log_info("Engine deinit successful.");
 }
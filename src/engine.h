@@ -1,6 +1,8 @@
 #ifndef ENGINE_H
 #define ENGINE_H
 
+#include <stdint.h>
+
 // static tick duration, in ms
 #define STATIC_TICKS 10
 
@@ -13,6 +15,12 @@ typedef struct engine_init_flags_t {
     char rec_file[255];
     int warpspeed;
     int speed;
+    char spectate_addr[255]; // relay to watch a match from, if not empty
+    uint16_t spectate_port;  // port of the spectator relay, to connect to or to listen on
+    int spectate_relay;      // relay the matches played here to spectators
+    uint32_t spectate_delay; // ticks the relayed matches lag behind
+    char export_path[255];   // write the played back recording out as video, see video/frame_writer.h
+    char latency_log[255];   // write input latency samples to this CSV file, if not empty
 } engine_init_flags;
 
 int engine_init(engine_init_flags *init_flags); // Init window, audiodevice, etc.
@@ -50,7 +50,7 @@ int sd_chr_from_trn(sd_chr_file *chr, sd_tournament_file *trn, sd_pilot *pilot)
     return SD_SUCCESS;
 }
 
-int sd_chr_load(sd_chr_file *chr, const char *filename) {
+static int load_chr(sd_chr_file *chr, const char *filename, bool summary) {
     if(chr == NULL || filename == NULL) {
         return SD_INVALID_INPUT;
     }
@@ -74,10 +74,21 @@ int sd_chr_load(sd_chr_file *chr, const char *filename) {
     str pic_file;
     str trn_file;
     sd_tournament_file trn;
-    sd_pic_file pic, players;
+    sd_pic_file pic;
     bool trn_loaded = false;
 
-    if(dirname) {
+    // Load player gender from PLAYERS.PIC. Only the one photo is read, so summaries get it too.
+    const char *players_filename = pm_get_resource_path(PIC_PLAYERS);
+    if(players_filename) {
+        log_debug("loading %d from players.pic", chr->pilot.photo_id);
+        sd_pic_photo photo;
+        if(sd_pic_load_photo_info(players_filename, chr->pilot.photo_id, &photo) == SD_SUCCESS) {
+            chr->pilot.sex = photo.sex;
+        }
+    }
+
+    // The tournament and its photo file are only needed for the enemy states, which summaries leave out.
+    if(dirname && !summary) {
         str_from_c(&pic_file, chr->pilot.trn_image);
         str_toupper(&pic_file);
         snprintf(tmp, 200, "%s%s", dirname, str_c(&pic_file));
@@ -85,21 +96,6 @@ int sd_chr_load(sd_chr_file *chr, const char *filename) {
         sd_pic_create(&pic);
         sd_pic_load(&pic, tmp);
 
-        const char *players_filename = pm_get_resource_path(PIC_PLAYERS);
-        if(players_filename) {
-            log_debug("trying to load players.pic from %s", players_filename);
-            // Load PIC file and make a surface
-            sd_pic_create(&players);
-            int ret = sd_pic_load(&players, players_filename);
-            if(ret == SD_SUCCESS) {
-                // Load player gender from PLAYERS.PIC
-                log_debug("loading %d from players.pic", chr->pilot.photo_id);
-                const sd_pic_photo *photo = sd_pic_get(&players, chr->pilot.photo_id);
-                chr->pilot.sex = photo->sex;
-                sd_pic_free(&players);
-            }
-        }
-
         if(*chr->pilot.trn_name != '\0') {
             str_from_c(&trn_file, chr->pilot.trn_name);
             str_toupper(&trn_file);
@@ -135,7 +131,7 @@ int sd_chr_load(sd_chr_file *chr, const char *filename) {
     memreader_xor(mr, (chr->pilot.enemies_inc_unranked * 68) & 0xFF);
 
     // Handle enemy data
-    for(int i = 0; i < chr->pilot.enemies_inc_unranked; i++) {
+    for(int i = 0; i < chr->pilot.enemies_inc_unranked && !summary; i++) {
         // Reserve & zero out
         chr->enemies[i] = omf_calloc(1, sizeof(sd_chr_enemy));
         sd_pilot_create(&chr->enemies[i]->pilot);
@@ -251,6 +247,14 @@ error_1:
     return SD_FILE_PARSE_ERROR;
 }
 
+int sd_chr_load(sd_chr_file *chr, const char *filename) {
+    return load_chr(chr, filename, false);
+}
+
+int sd_chr_load_summary(sd_chr_file *chr, const char *filename) {
+    return load_chr(chr, filename, true);
+}
+
 int sd_chr_save(sd_chr_file *chr, const char *filename) {
     if(chr == NULL || filename == NULL) {
         return SD_INVALID_INPUT;
@@ -81,6 +81,21 @@ int sd_chr_from_trn(sd_chr_file *chr, sd_tournament_file *trn, sd_pilot *pilot);
  */
 int sd_chr_load(sd_chr_file *chr, const char *filename);
 
+/*! \brief Load the pilot data of a .CHR file
+ *
+ * Loads only the pilot block, palette and photo of the given CHR file, and the pilot's sex from
+ * its PLAYERS.PIC entry. Enemy states are not loaded, and the tournament files are not touched.
+ * This is enough to list savegames for selection; use sd_chr_load() for the full savegame.
+ *
+ * \retval SD_FILE_OPEN_ERROR File could not be opened.
+ * \retval SD_FILE_PARSE_ERROR File does not contain valid data or has syntax problems.
+ * \retval SD_SUCCESS Success.
+ *
+ * \param chr CHR struct pointer.
+ * \param filename Name of the CHR file to load from.
+ */
+int sd_chr_load_summary(sd_chr_file *chr, const char *filename);
+
 /*! \brief Save .CHR file
  *
  * Saves the given CHR file from memory to a file on disk. The structure must be at
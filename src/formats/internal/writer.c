@@ -35,6 +35,14 @@ void sd_writer_close(sd_writer *writer) {
     omf_free(writer);
 }
 
+int sd_writer_flush(sd_writer *writer) {
+    if(fflush(writer->handle) != 0) {
+        writer->sd_errno = errno;
+        return 0;
+    }
+    return 1;
+}
+
 long sd_writer_pos(sd_writer *writer) {
     long res = ftell(writer->handle);
     if(res == -1) {
@@ -23,6 +23,11 @@ int sd_writer_errno(const sd_writer *writer);
  */
 void sd_writer_close(sd_writer *writer);
 
+/**
+ * Push buffered data out to the file, so that it survives a crash.
+ */
+int sd_writer_flush(sd_writer *writer);
+
 /**
  * Returns the position of the file pointer
  */
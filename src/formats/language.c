@@ -110,6 +110,137 @@ const sd_lang_string *sd_language_get(const sd_language *language, unsigned num)
     return &language->strings[num];
 }
 
+// Language strings are xor'ed with a key that starts from their length
+static void decode_string(char *data, uint32_t len) {
+    uint8_t key = len & 0xFF;
+    for(uint32_t i = 0; i < len; i++) {
+        data[i] ^= key++;
+    }
+}
+
+// Reads the string catalog. The strings follow the catalog back to back, so the file size ends the last one.
+static int read_offsets(sd_reader *r, uint32_t **offsets, unsigned int *count) {
+    uint32_t file_size = sd_reader_filesize(r);
+    uint32_t first = sd_read_udword(r);
+    if(first >= file_size) {
+        return SD_FILE_INVALID_TYPE;
+    }
+
+    // Entries are 36 bytes, and the catalog ends where the first string starts
+    uint32_t *table = omf_malloc((first / 36 + 2) * sizeof(uint32_t));
+    unsigned int n = 0;
+    sd_reader_set(r, 0);
+    while(n * 36 < first) {
+        uint32_t offset = sd_read_udword(r);
+        if(offset >= file_size) {
+            break;
+        }
+        if(n > 0 && offset < table[n - 1]) {
+            omf_free(table);
+            return SD_FILE_PARSE_ERROR;
+        }
+        table[n++] = offset;
+        sd_skip(r, 32);
+    }
+    if(n == 0) {
+        omf_free(table);
+        return SD_FILE_INVALID_TYPE;
+    }
+    table[n] = file_size;
+    *offsets = table;
+    *count = n;
+    return SD_SUCCESS;
+}
+
+int sd_lang_table_load(sd_lang_table *table, const char *filename) {
+    if(table == NULL || filename == NULL) {
+        return SD_INVALID_INPUT;
+    }
+    memset(table, 0, sizeof(sd_lang_table));
+
+    sd_reader *r = sd_reader_open(filename);
+    if(!r) {
+        return SD_FILE_OPEN_ERROR;
+    }
+    uint32_t *offsets;
+    unsigned int count;
+    int ret = read_offsets(r, &offsets, &count);
+    if(ret != SD_SUCCESS) {
+        goto error_0;
+    }
+
+    // The strings are read in one go, and each gets a terminator
+    table->count = count;
+    table->offsets = omf_malloc(count * sizeof(uint32_t));
+    table->data = omf_malloc(offsets[count] - offsets[0] + count);
+    uint32_t pos = 0;
+    sd_reader_set(r, offsets[0]);
+    for(unsigned int i = 0; i < count; i++) {
+        uint32_t len = offsets[i + 1] - offsets[i];
+        if(!sd_read_buf(r, table->data + pos, len)) {
+            ret = SD_FILE_PARSE_ERROR;
+            sd_lang_table_free(table);
+            goto error_1;
+        }
+        decode_string(table->data + pos, len);
+        table->offsets[i] = pos;
+        pos += len;
+        table->data[pos++] = 0;
+    }
+
+error_1:
+    omf_free(offsets);
+error_0:
+    sd_reader_close(r);
+    return ret;
+}
+
+void sd_lang_table_free(sd_lang_table *table) {
+    if(table == NULL)
+        return;
+    omf_free(table->offsets);
+    omf_free(table->data);
+    table->count = 0;
+}
+
+int sd_language_read_string(const char *filename, unsigned int num, unsigned int *count, char **data) {
+    if(filename == NULL || count == NULL || data == NULL) {
+        return SD_INVALID_INPUT;
+    }
+    *count = 0;
+    *data = NULL;
+
+    sd_reader *r = sd_reader_open(filename);
+    if(!r) {
+        return SD_FILE_OPEN_ERROR;
+    }
+    uint32_t *offsets;
+    int ret = read_offsets(r, &offsets, count);
+    if(ret != SD_SUCCESS) {
+        goto error_0;
+    }
+    if(num >= *count) {
+        ret = SD_INVALID_INPUT;
+        goto error_1;
+    }
+
+    uint32_t len = offsets[num + 1] - offsets[num];
+    *data = omf_calloc(len + 1, 1);
+    sd_reader_set(r, offsets[num]);
+    if(!sd_read_buf(r, *data, len)) {
+        omf_free(*data);
+        ret = SD_FILE_PARSE_ERROR;
+        goto error_1;
+    }
+    decode_string(*data, len);
+
+error_1:
+    omf_free(offsets);
+error_0:
+    sd_reader_close(r);
+    return ret;
+}
+
 void sd_language_append(sd_language *language, const char *description, const char *data) {
     assert(strlen(description) < 32);
     language->count++;
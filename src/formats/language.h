@@ -10,6 +10,8 @@
 #ifndef SD_LANGUAGE_H
 #define SD_LANGUAGE_H
 
+#include <stdint.h>
+
 /*! \brief Language string container
  *
  * Contains a single language string and a short description for it. Descriptions
@@ -29,6 +31,17 @@ typedef struct {
     sd_lang_string *strings; ///< Language string array
 } sd_language;
 
+/*! \brief Compact language string table
+ *
+ * Contains the strings of a language file without their descriptions. All strings are kept
+ * in a single buffer, one after another, each terminated with a zero.
+ */
+typedef struct {
+    unsigned int count; ///< Amount of language strings in the file
+    uint32_t *offsets;  ///< Offset of each string in data
+    char *data;         ///< Language strings
+} sd_lang_table;
+
 /*! \brief Initialize language structure
  *
  * Initializes the language structure with empty values.
@@ -91,6 +104,45 @@ int sd_language_save(sd_language *language, const char *filename);
  */
 const sd_lang_string *sd_language_get(const sd_language *language, unsigned num);
 
+/*! \brief Load the strings of a language file
+ *
+ * Loads the strings of the given language file to a compact table, skipping the descriptions.
+ * Use this instead of sd_language_load() when only the strings are needed.
+ *
+ * \retval SD_INVALID_INPUT Table or filename was NULL.
+ * \retval SD_FILE_OPEN_ERROR File could not be opened.
+ * \retval SD_FILE_INVALID_TYPE File has no strings.
+ * \retval SD_FILE_PARSE_ERROR File is damaged.
+ * \retval SD_SUCCESS Success.
+ *
+ * \param table Table struct pointer. Free with sd_lang_table_free().
+ * \param filename Name of the language file to load from.
+ */
+int sd_lang_table_load(sd_lang_table *table, const char *filename);
+
+/*! \brief Free language string table
+ *
+ * \param table Table to free. All string pointers to it will be invalid.
+ */
+void sd_lang_table_free(sd_lang_table *table);
+
+/*! \brief Read a single string from a language file
+ *
+ * Reads only the string catalog and the given string, without loading the rest of the file.
+ *
+ * \retval SD_INVALID_INPUT An argument was NULL, or num is not smaller than the string count.
+ * \retval SD_FILE_OPEN_ERROR File could not be opened.
+ * \retval SD_FILE_INVALID_TYPE File has no strings.
+ * \retval SD_FILE_PARSE_ERROR File is damaged.
+ * \retval SD_SUCCESS Success.
+ *
+ * \param filename Name of the language file to read from.
+ * \param num Language entry number to read.
+ * \param count Set to the amount of strings in the file, 0 if the catalog could not be read.
+ * \param data Set to the string, free it with omf_free(). NULL on failure.
+ */
+int sd_language_read_string(const char *filename, unsigned int num, unsigned int *count, char **data);
+
 void sd_language_append(sd_language *language, const char *description, const char *data);
 
 #endif // SD_LANGUAGE_H
@@ -3,7 +3,6 @@
 #include "formats/error.h"
 #include "utils/allocator.h"
 #include "utils/miscmath.h"
-#include "video/vga_state.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -115,7 +114,7 @@ int palette_from_gimp_palette(vga_palette *pal, const char *filename) {
     return SD_SUCCESS;
 }
 
-void palette_set_menu_colors(void) {
+void palette_set_menu_colors(vga_state *vga) {
     // Set the default menu colors. These are always set for the default (0) palette.
     vga_palette pal;
     for(int i = 0; i < 6; i++) {
@@ -123,10 +122,10 @@ void palette_set_menu_colors(void) {
         pal.colors[i].g = COLOR_6TO8(menu_colors[i].g);
         pal.colors[i].b = COLOR_6TO8(menu_colors[i].b);
     }
-    vga_state_set_base_palette_from_range(&pal, 250, 0, 6);
+    vga_state_set_base_palette_from_range(vga, &pal, 250, 0, 6);
 }
 
-void palette_pulse_menu_colors(int tick) {
+void palette_pulse_menu_colors(vga_state *vga, int tick) {
     int i = tick % 16;
     if(i > 8) {
         i = 16 - i;
@@ -136,7 +135,7 @@ void palette_pulse_menu_colors(int tick) {
         COLOR_6TO8(pulse_colors[i].g),
         COLOR_6TO8(pulse_colors[i].b),
     };
-    vga_state_set_base_palette_index(255, &c);
+    vga_state_set_base_palette_index(vga, 255, &c);
 }
 
 int palette_load_range(sd_reader *reader, vga_palette *pal, int index_start, int index_count) {
@@ -201,11 +200,11 @@ void palette_remaps_save(sd_writer *writer, const vga_remap_tables *remaps) {
     }
 }
 
-void palette_load_player_colors(vga_palette *src, int player) {
+void palette_load_player_colors(vga_state *vga, vga_palette *src, int player) {
     // only load 47 palette colors, skipping the first one
     // because that seems to be ignored by the original
     int dst_offset = (player * 48) + 1;
-    vga_state_set_base_palette_from_range(src, dst_offset, 1, 47);
+    vga_state_set_base_palette_from_range(vga, src, dst_offset, 1, 47);
 }
 
 void palette_load_altpal_player_color(vga_palette *dst, int player, int src_color, int dst_color) {
@@ -218,16 +217,16 @@ void palette_load_altpal_player_color(vga_palette *dst, int player, int src_colo
     dst->colors[0] = tmp;
 }
 
-void palette_set_player_color(int player, int src_color, int dst_color) {
+void palette_set_player_color(vga_state *vga, int player, int src_color, int dst_color) {
     int dst_index = dst_color * 16 + player * 48;
     int src_index = src_color * 16;
     vga_palette pal;
     vga_palette_init(&pal);
     palette_load_altpal_player_color(&pal, player, src_color, dst_color);
-    vga_state_set_base_palette_from_range(&pal, dst_index, src_index, 16 * 3);
+    vga_state_set_base_palette_from_range(vga, &pal, dst_index, src_index, 16 * 3);
 }
 
-void palette_set_player_expanded_color(vga_palette *src) {
+void palette_set_player_expanded_color(vga_state *vga, vga_palette *src) {
     // expand the player 1 colors, which are 3 shades of 16 colors
     // into 3 shades of 32 colors
 
@@ -257,7 +256,7 @@ void palette_set_player_expanded_color(vga_palette *src) {
     }
     // setting 3 shades of 32 colors, and skipping palette index 0
     vga_index set_count = 3 * 32 - 1;
-    vga_state_set_base_palette_from_range(&tmp, 1, 1, set_count);
+    vga_state_set_base_palette_from_range(vga, &tmp, 1, 1, set_count);
 }
 
 void palette_copy(vga_palette *dst, const vga_palette *src, int index_start, int index_count) {
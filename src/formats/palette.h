@@ -16,6 +16,7 @@
 #include "formats/internal/writer.h"
 #include "video/vga_palette.h"
 #include "video/vga_remap.h"
+#include "video/vga_state.h"
 #include <stdint.h>
 
 /*! \brief Resolves an RGB color to palette index
@@ -60,8 +61,8 @@ int palette_to_gimp_palette(const vga_palette *pal, const char *filename);
  */
 int palette_from_gimp_palette(vga_palette *pal, const char *filename);
 
-void palette_set_menu_colors(void);
-void palette_pulse_menu_colors(int tick);
+void palette_set_menu_colors(vga_state *vga);
+void palette_pulse_menu_colors(vga_state *vga, int tick);
 int palette_mload_range(memreader *reader, vga_palette *pal, int index_start, int index_count);
 int palette_load_range(sd_reader *reader, vga_palette *pal, int index_start, int index_count);
 int palette_load(sd_reader *reader, vga_palette *pal);
@@ -70,10 +71,10 @@ void palette_msave_range(memwriter *writer, const vga_palette *pal, int index_st
 void palette_save_range(sd_writer *writer, const vga_palette *pal, int index_start, int index_count);
 void palette_save(sd_writer *writer, const vga_palette *pal);
 void palette_remaps_save(sd_writer *writer, const vga_remap_tables *remaps);
-void palette_load_player_colors(vga_palette *src, int player);
+void palette_load_player_colors(vga_state *vga, vga_palette *src, int player);
 void palette_load_altpal_player_color(vga_palette *dst, int player, int src_color, int dst_color);
-void palette_set_player_color(int player, int src_color, int dst_color);
-void palette_set_player_expanded_color(vga_palette *pal);
+void palette_set_player_color(vga_state *vga, int player, int src_color, int dst_color);
+void palette_set_player_expanded_color(vga_state *vga, vga_palette *pal);
 void palette_copy(vga_palette *dst, const vga_palette *src, int index_start, int index_count);
 
 #endif // PALETTE_H
@@ -108,6 +108,44 @@ error_0:
     return ret;
 }
 
+int sd_pic_load_photo_info(const char *filename, int entry_id, sd_pic_photo *photo) {
+    int ret = SD_FILE_PARSE_ERROR;
+    if(filename == NULL || photo == NULL) {
+        return SD_INVALID_INPUT;
+    }
+
+    sd_reader *r = sd_reader_open(filename);
+    if(!r) {
+        return SD_FILE_OPEN_ERROR;
+    }
+    if(sd_reader_filesize(r) < 200) {
+        goto exit_0;
+    }
+    int photo_count = sd_read_dword(r);
+    if(entry_id < 0 || entry_id >= photo_count || photo_count >= 256) {
+        goto exit_0;
+    }
+
+    // Jump straight to the photo through the offset list
+    sd_reader_set(r, 200 + entry_id * 4);
+    long offset = sd_read_udword(r);
+    if(offset + 3 + 48 * 3 + 1 > sd_reader_filesize(r)) {
+        goto exit_0;
+    }
+    sd_reader_set(r, offset);
+    memset(photo, 0, sizeof(sd_pic_photo));
+    photo->is_player = sd_read_ubyte(r);
+    photo->sex = sd_read_uword(r);
+    vga_palette_init(&photo->pal);
+    palette_load_range(r, &photo->pal, 0, 48);
+    photo->unk_flag = sd_read_ubyte(r);
+    ret = sd_reader_ok(r) ? SD_SUCCESS : SD_FILE_PARSE_ERROR;
+
+exit_0:
+    sd_reader_close(r);
+    return ret;
+}
+
 int sd_pic_save(const sd_pic_file *pic, const char *filename) {
     if(pic == NULL || filename == NULL) {
         return SD_INVALID_INPUT;
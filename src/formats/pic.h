@@ -70,6 +70,22 @@ void sd_pic_free(sd_pic_file *pic);
  */
 int sd_pic_load(sd_pic_file *pic, const char *filename);
 
+/*! \brief Load a single PIC photo without its image
+ *
+ * Reads the header fields and palette of one photo, without loading the rest of the file. The
+ * sprite of the returned photo is NULL, so there is nothing to free.
+ *
+ * \retval SD_INVALID_INPUT filename or photo was NULL.
+ * \retval SD_FILE_OPEN_ERROR File could not be opened.
+ * \retval SD_FILE_PARSE_ERROR File is damaged, or the photo does not exist.
+ * \retval SD_SUCCESS Success.
+ *
+ * \param filename Name of the PIC file to load from.
+ * \param entry_id Photo picture number to load.
+ * \param photo Photo struct to fill.
+ */
+int sd_pic_load_photo_info(const char *filename, int entry_id, sd_pic_photo *photo);
+
 /*! \brief Save PIC file
  *
  * Saves the given PIC file from memory to a file on disk. The structure must be at
@@ -6,8 +6,6 @@
 #include "utils/allocator.h"
 #include "utils/c_string_util.h"
 
-#define PILOT_BLOCK_LENGTH 428
-
 int sd_pilot_create(sd_pilot *pilot) {
     if(pilot == NULL) {
         return SD_INVALID_INPUT;
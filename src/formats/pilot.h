@@ -18,6 +18,8 @@
 #include "formats/sprite.h"
 #include <stdint.h>
 
+#define PILOT_BLOCK_LENGTH 428 ///< Length of the pilot data written by sd_pilot_save_to_mem()
+
 /*! \brief PIC pilot information
  *
  * Contains a pilot information. Current upgrades, powers, tournament, etc.
@@ -5,6 +5,7 @@
 #include "formats/internal/reader.h"
 #include "formats/internal/writer.h"
 #include "formats/rec.h"
+#include "formats/rec2.h"
 #include "utils/allocator.h"
 
 int sd_rec_extra_len(int key) {
@@ -22,6 +23,78 @@ int sd_rec_extra_len(int key) {
     return 0;
 }
 
+sd_action sd_rec_unpack_action(uint8_t raw_action) {
+    sd_action action = SD_ACT_NONE;
+    if(raw_action & 1) {
+        action |= SD_ACT_PUNCH;
+    }
+    if(raw_action & 2) {
+        action |= SD_ACT_KICK;
+    }
+    switch(raw_action & 0xF0) {
+        case 16:
+            action |= SD_ACT_UP;
+            break;
+        case 32:
+            action |= (SD_ACT_UP | SD_ACT_RIGHT);
+            break;
+        case 48:
+            action |= SD_ACT_RIGHT;
+            break;
+        case 64:
+            action |= (SD_ACT_DOWN | SD_ACT_RIGHT);
+            break;
+        case 80:
+            action |= SD_ACT_DOWN;
+            break;
+        case 96:
+            action |= (SD_ACT_DOWN | SD_ACT_LEFT);
+            break;
+        case 112:
+            action |= SD_ACT_LEFT;
+            break;
+        case 128:
+            action |= (SD_ACT_UP | SD_ACT_LEFT);
+            break;
+    }
+    return action;
+}
+
+uint8_t sd_rec_pack_action(sd_action action) {
+    uint8_t raw_action = 0;
+    switch(action & SD_MOVE_MASK) {
+        case(SD_ACT_UP):
+            raw_action = 16;
+            break;
+        case(SD_ACT_UP | SD_ACT_RIGHT):
+            raw_action = 32;
+            break;
+        case(SD_ACT_RIGHT):
+            raw_action = 48;
+            break;
+        case(SD_ACT_DOWN | SD_ACT_RIGHT):
+            raw_action = 64;
+            break;
+        case(SD_ACT_DOWN):
+            raw_action = 80;
+            break;
+        case(SD_ACT_DOWN | SD_ACT_LEFT):
+            raw_action = 96;
+            break;
+        case(SD_ACT_LEFT):
+            raw_action = 112;
+            break;
+        case(SD_ACT_UP | SD_ACT_LEFT):
+            raw_action = 128;
+            break;
+    }
+    if(action & SD_ACT_PUNCH)
+        raw_action |= 1;
+    if(action & SD_ACT_KICK)
+        raw_action |= 2;
+    return raw_action;
+}
+
 int sd_rec_create(sd_rec_file *rec) {
     if(rec == NULL) {
         return SD_INVALID_INPUT;
@@ -47,12 +120,49 @@ void sd_rec_free(sd_rec_file *rec) {
     }
 }
 
+int sd_rec_copy(sd_rec_file *dst, const sd_rec_file *src) {
+    if(dst == NULL || src == NULL) {
+        return SD_INVALID_INPUT;
+    }
+
+    // Copy the basic stuff
+    memcpy(dst, src, sizeof(sd_rec_file));
+    for(int i = 0; i < 2; i++) {
+        memset(&dst->pilots[i].info, 0, sizeof(sd_pilot));
+        sd_pilot_clone(&dst->pilots[i].info, &src->pilots[i].info);
+        dst->pilots[i].info.photo = NULL; // Not saved in REC files
+    }
+
+    // Copy moves, and their extra data
+    dst->moves = NULL;
+    dst->move_capacity = src->move_count;
+    if(src->move_count > 0) {
+        dst->moves = omf_malloc(src->move_count * sizeof(sd_rec_move));
+        memcpy(dst->moves, src->moves, src->move_count * sizeof(sd_rec_move));
+        for(unsigned i = 0; i < src->move_count; i++) {
+            // Action byte is not included in the extra data
+            int unknown_len = sd_rec_extra_len(src->moves[i].lookup_id) - 1;
+            dst->moves[i].extra_data = NULL;
+            if(src->moves[i].extra_data != NULL && unknown_len > 0) {
+                dst->moves[i].extra_data = omf_malloc(unknown_len);
+                memcpy(dst->moves[i].extra_data, src->moves[i].extra_data, unknown_len);
+            }
+        }
+    }
+    return SD_SUCCESS;
+}
+
 int sd_rec_load(sd_rec_file *rec, const char *file) {
     int ret = SD_FILE_PARSE_ERROR;
     if(rec == NULL || file == NULL) {
         return SD_INVALID_INPUT;
     }
 
+    // Compact recordings are loaded by their own reader
+    if(sd_rec2_is_compact(file)) {
+        return sd_rec2_load(rec, file);
+    }
+
     sd_reader *r = sd_reader_open(file);
     if(!r) {
         return SD_FILE_OPEN_ERROR;
@@ -130,39 +240,7 @@ int sd_rec_load(sd_rec_file *rec, const char *file) {
             rec->moves[i].raw_action = action;
 
             // Parse real action key
-            rec->moves[i].action = SD_ACT_NONE;
-            if(action & 1) {
-                rec->moves[i].action |= SD_ACT_PUNCH;
-            }
-            if(action & 2) {
-                rec->moves[i].action |= SD_ACT_KICK;
-            }
-            switch(action & 0xF0) {
-                case 16:
-                    rec->moves[i].action |= SD_ACT_UP;
-                    break;
-                case 32:
-                    rec->moves[i].action |= (SD_ACT_UP | SD_ACT_RIGHT);
-                    break;
-                case 48:
-                    rec->moves[i].action |= SD_ACT_RIGHT;
-                    break;
-                case 64:
-                    rec->moves[i].action |= (SD_ACT_DOWN | SD_ACT_RIGHT);
-                    break;
-                case 80:
-                    rec->moves[i].action |= SD_ACT_DOWN;
-                    break;
-                case 96:
-                    rec->moves[i].action |= (SD_ACT_DOWN | SD_ACT_LEFT);
-                    break;
-                case 112:
-                    rec->moves[i].action |= SD_ACT_LEFT;
-                    break;
-                case 128:
-                    rec->moves[i].action |= (SD_ACT_UP | SD_ACT_LEFT);
-                    break;
-            }
+            rec->moves[i].action = sd_rec_unpack_action(action);
 
             // We already read the action key, so minus one.
             int unknown_len = extra_length - 1;
@@ -177,6 +255,7 @@ int sd_rec_load(sd_rec_file *rec, const char *file) {
     // Okay, not reduce the allocated memory to match what we actually need
     // Realloc should keep our old data intact
     rec->moves = omf_realloc(rec->moves, rec->move_count * sizeof(sd_rec_move));
+    rec->move_capacity = rec->move_count;
 
     // Close & return
     sd_reader_close(r);
@@ -187,17 +266,7 @@ error_0:
     return ret;
 }
 
-int sd_rec_save(sd_rec_file *rec, const char *file) {
-    sd_writer *w;
-
-    if(rec == NULL || file == NULL) {
-        return SD_INVALID_INPUT;
-    }
-
-    if(!(w = sd_writer_open(file))) {
-        return SD_FILE_OPEN_ERROR;
-    }
-
+static void rec_write_header(sd_writer *w, const sd_rec_file *rec) {
     // Write pilots, palettes, etc.
     for(int i = 0; i < 2; i++) {
         sd_pilot_save(w, &rec->pilots[i].info);
@@ -239,61 +308,88 @@ int sd_rec_save(sd_rec_file *rec, const char *file) {
     out |= (rec->hyper_mode & 0x1) << 24;
     sd_write_udword(w, out);
     sd_write_byte(w, rec->unknown_m);
+}
 
-    // Move records
-    for(unsigned i = 0; i < rec->move_count; i++) {
-        sd_write_udword(w, rec->moves[i].tick);
-        sd_write_ubyte(w, rec->moves[i].lookup_id);
-        sd_write_ubyte(w, rec->moves[i].player_id);
+static void rec_write_move(sd_writer *w, const sd_rec_move *move) {
+    sd_write_udword(w, move->tick);
+    sd_write_ubyte(w, move->lookup_id);
+    sd_write_ubyte(w, move->player_id);
 
-        int extra_length = sd_rec_extra_len(rec->moves[i].lookup_id);
-        if(extra_length == 1) {
-            // Write action information
-            uint8_t raw_action = 0;
-            switch(rec->moves[i].action & SD_MOVE_MASK) {
-                case(SD_ACT_UP):
-                    raw_action = 16;
-                    break;
-                case(SD_ACT_UP | SD_ACT_RIGHT):
-                    raw_action = 32;
-                    break;
-                case(SD_ACT_RIGHT):
-                    raw_action = 48;
-                    break;
-                case(SD_ACT_DOWN | SD_ACT_RIGHT):
-                    raw_action = 64;
-                    break;
-                case(SD_ACT_DOWN):
-                    raw_action = 80;
-                    break;
-                case(SD_ACT_DOWN | SD_ACT_LEFT):
-                    raw_action = 96;
-                    break;
-                case(SD_ACT_LEFT):
-                    raw_action = 112;
-                    break;
-                case(SD_ACT_UP | SD_ACT_LEFT):
-                    raw_action = 128;
-                    break;
-            }
-            if(rec->moves[i].action & SD_ACT_PUNCH)
-                raw_action |= 1;
-            if(rec->moves[i].action & SD_ACT_KICK)
-                raw_action |= 2;
-            sd_write_ubyte(w, raw_action);
-        }
-        // If there is more extra data, write it
-        int unknown_len = extra_length - 1;
-        if(unknown_len > 0) {
-            sd_write_ubyte(w, rec->moves[i].raw_action);
-            sd_write_buf(w, rec->moves[i].extra_data, unknown_len);
-        }
+    int extra_length = sd_rec_extra_len(move->lookup_id);
+    if(extra_length == 1) {
+        // Write action information
+        sd_write_ubyte(w, sd_rec_pack_action(move->action));
+    }
+    // If there is more extra data, write it
+    int unknown_len = extra_length - 1;
+    if(unknown_len > 0) {
+        sd_write_ubyte(w, move->raw_action);
+        sd_write_buf(w, move->extra_data, unknown_len);
+    }
+}
+
+int sd_rec_save(sd_rec_file *rec, const char *file) {
+    sd_writer *w;
+
+    if(rec == NULL || file == NULL) {
+        return SD_INVALID_INPUT;
+    }
+
+    if(!(w = sd_writer_open(file))) {
+        return SD_FILE_OPEN_ERROR;
+    }
+
+    rec_write_header(w, rec);
+    for(unsigned i = 0; i < rec->move_count; i++) {
+        rec_write_move(w, &rec->moves[i]);
     }
 
     sd_writer_close(w);
     return SD_SUCCESS;
 }
 
+struct sd_rec_stream {
+    sd_writer *w;
+    unsigned int written; ///< Number of event records already in the file
+};
+
+sd_rec_stream *sd_rec_stream_open(const sd_rec_file *rec, const char *filename) {
+    if(rec == NULL || filename == NULL) {
+        return NULL;
+    }
+    sd_writer *w = sd_writer_open(filename);
+    if(w == NULL) {
+        return NULL;
+    }
+    sd_rec_stream *stream = omf_calloc(1, sizeof(sd_rec_stream));
+    stream->w = w;
+    rec_write_header(w, rec);
+    return stream;
+}
+
+int sd_rec_stream_flush(sd_rec_stream *stream, const sd_rec_file *rec) {
+    if(stream == NULL || rec == NULL) {
+        return SD_INVALID_INPUT;
+    }
+    // The file has no record count in it, so new records can just be appended to the end.
+    for(; stream->written < rec->move_count; stream->written++) {
+        rec_write_move(stream->w, &rec->moves[stream->written]);
+    }
+    if(!sd_writer_flush(stream->w) || sd_writer_errno(stream->w)) {
+        return SD_FILE_WRITE_ERROR;
+    }
+    return SD_SUCCESS;
+}
+
+int sd_rec_stream_close(sd_rec_stream *stream, const sd_rec_file *rec) {
+    int ret = sd_rec_stream_flush(stream, rec);
+    if(stream != NULL) {
+        sd_writer_close(stream->w);
+        omf_free(stream);
+    }
+    return ret;
+}
+
 int sd_rec_delete_action(sd_rec_file *rec, unsigned int number) {
     if(rec == NULL || number >= rec->move_count) {
         return SD_INVALID_INPUT;
@@ -304,35 +400,48 @@ int sd_rec_delete_action(sd_rec_file *rec, unsigned int number) {
         memmove(rec->moves + number, rec->moves + number + 1, (rec->move_count - number - 1) * sizeof(sd_rec_move));
     }
 
-    // Resize to save memory
+    // Keep the allocation; the list is likely to grow again.
     rec->move_count--;
-    rec->moves = omf_realloc(rec->moves, rec->move_count * sizeof(sd_rec_move));
     return SD_SUCCESS;
 }
 
-int sd_rec_insert_action(sd_rec_file *rec, unsigned int number, const sd_rec_move *move) {
-    if(rec == NULL) {
+int sd_rec_insert_actions(sd_rec_file *rec, unsigned int number, const sd_rec_move *moves, unsigned int count) {
+    if(rec == NULL || moves == NULL) {
         return SD_INVALID_INPUT;
     }
     if(number > rec->move_count) {
         return SD_INVALID_INPUT;
     }
+    if(count == 0) {
+        return SD_SUCCESS;
+    }
 
-    // Resize
-    rec->moves = omf_realloc(rec->moves, (rec->move_count + 1) * sizeof(sd_rec_move));
+    // Grow by doubling, so that recording a long match does not reallocate on every move
+    if(rec->move_count + count > rec->move_capacity) {
+        unsigned int capacity = rec->move_capacity > 0 ? rec->move_capacity : 64;
+        while(capacity < rec->move_count + count) {
+            capacity *= 2;
+        }
+        rec->moves = omf_realloc(rec->moves, capacity * sizeof(sd_rec_move));
+        rec->move_capacity = capacity;
+    }
 
     // Only move if we are inserting, not appending
-    // when number == move_count-1, we are pushing the last entry forwards by one
+    // when number == move_count-1, we are pushing the last entry forwards
     // when number == move_count, we are pushing to the end.
     if(number < rec->move_count) {
-        memmove(rec->moves + number + 1, rec->moves + number, (rec->move_count - number) * sizeof(sd_rec_move));
+        memmove(rec->moves + number + count, rec->moves + number, (rec->move_count - number) * sizeof(sd_rec_move));
     }
-    memcpy(rec->moves + number, move, sizeof(sd_rec_move));
+    memcpy(rec->moves + number, moves, count * sizeof(sd_rec_move));
 
-    rec->move_count++;
+    rec->move_count += count;
     return SD_SUCCESS;
 }
 
+int sd_rec_insert_action(sd_rec_file *rec, unsigned int number, const sd_rec_move *move) {
+    return sd_rec_insert_actions(rec, number, move, 1);
+}
+
 void sd_rec_finish(sd_rec_file *rec, unsigned int ticks) {
     sd_rec_move move;
 
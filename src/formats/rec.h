@@ -92,10 +92,19 @@ typedef struct {
 
     int8_t unknown_m; ///< Unknown \todo: Find out
 
-    unsigned int move_count; ///< How many REC event records
-    sd_rec_move *moves;      ///< REC event records list
+    uint32_t seed; ///< Seed of the match random state, 0 if not known. Not saved in legacy REC files.
+
+    unsigned int move_count;    ///< How many REC event records
+    unsigned int move_capacity; ///< How many REC event records fit in the allocated list
+    sd_rec_move *moves;         ///< REC event records list
 } sd_rec_file;
 
+/*! \brief REC streaming writer
+ *
+ * Writes a REC file to disk while it is still being recorded. Opaque, see sd_rec_stream_open().
+ */
+typedef struct sd_rec_stream sd_rec_stream;
+
 /*! \brief Initialize REC file structure
  *
  * Initializes the REC file structure with empty values.
@@ -116,11 +125,25 @@ int sd_rec_create(sd_rec_file *rec);
  */
 void sd_rec_free(sd_rec_file *rec);
 
+/*! \brief Copy REC structure
+ *
+ * Copies the contents of a REC file structure. The destination must not be initialized, as its
+ * contents will be overwritten. Free the copy with sd_rec_free().
+ *
+ * \retval SD_INVALID_INPUT Either input value was NULL.
+ * \retval SD_SUCCESS Success.
+ *
+ * \param dst Destination REC struct pointer.
+ * \param src Source REC struct pointer.
+ */
+int sd_rec_copy(sd_rec_file *dst, const sd_rec_file *src);
+
 /*! \brief Load .REC file
  *
- * Loads the given REC file to memory. The structure must be initialized with sd_rec_create()
- * before using this function. Loading to a previously loaded or filled sd_rec_file structure
- * will result in old data and pointers getting lost. This is very likely to cause a memory leak.
+ * Loads the given REC file to memory. Both legacy REC files and compact ones (see rec2.h) are supported.
+ * The structure must be initialized with sd_rec_create() before using this function. Loading to a previously
+ * loaded or filled sd_rec_file structure will result in old data and pointers getting lost. This is very likely
+ * to cause a memory leak.
  *
  * \retval SD_FILE_OPEN_ERROR File could not be opened.
  * \retval SD_FILE_PARSE_ERROR File does not contain valid data or has syntax problems.
@@ -144,6 +167,45 @@ int sd_rec_load(sd_rec_file *rec, const char *filename);
  */
 int sd_rec_save(sd_rec_file *rec, const char *filename);
 
+/*! \brief Start streaming a REC file to disk
+ *
+ * Writes the header of the given REC file, and returns a stream that the event records can be
+ * appended to with sd_rec_stream_flush() as they are recorded. The header must be filled in before
+ * calling this, as it is not written again. Event records must only be appended to the REC after
+ * opening the stream; records inserted before already flushed records will not be written.
+ *
+ * \retval NULL File could not be opened for writing, or rec was NULL.
+ *
+ * \param rec REC struct pointer.
+ * \param filename Name of the REC file to save into.
+ */
+sd_rec_stream *sd_rec_stream_open(const sd_rec_file *rec, const char *filename);
+
+/*! \brief Write out new REC event records
+ *
+ * Writes all event records added to the REC since the last flush, and pushes them out to the file.
+ *
+ * \retval SD_INVALID_INPUT stream or rec was NULL.
+ * \retval SD_FILE_WRITE_ERROR Writing to the file failed.
+ * \retval SD_SUCCESS Success.
+ *
+ * \param stream REC stream pointer.
+ * \param rec REC struct pointer. Must be the same that the stream was opened with.
+ */
+int sd_rec_stream_flush(sd_rec_stream *stream, const sd_rec_file *rec);
+
+/*! \brief Finish streaming a REC file
+ *
+ * Writes out any remaining event records and closes the file. The stream pointer will be invalid afterwards.
+ *
+ * \retval SD_FILE_WRITE_ERROR Writing to the file failed.
+ * \retval SD_SUCCESS Success.
+ *
+ * \param stream REC stream pointer.
+ * \param rec REC struct pointer. Must be the same that the stream was opened with.
+ */
+int sd_rec_stream_close(sd_rec_stream *stream, const sd_rec_file *rec);
+
 /*! \brief Deletes a REC event record
  *
  * Deletes a REC event record at given position.
@@ -158,6 +220,24 @@ int sd_rec_delete_action(sd_rec_file *rec, unsigned int number);
 
 int sd_rec_extra_len(int key);
 
+/*! \brief Pack REC actions to a raw action byte
+ *
+ * Packs the directions and buttons of an action to the byte stored in REC files.
+ *
+ * \param action Combination of sd_action values.
+ * \return Raw action byte.
+ */
+uint8_t sd_rec_pack_action(sd_action action);
+
+/*! \brief Unpack a raw REC action byte
+ *
+ * Reverse of sd_rec_pack_action().
+ *
+ * \param raw_action Raw action byte.
+ * \return Combination of sd_action values.
+ */
+sd_action sd_rec_unpack_action(uint8_t raw_action);
+
 /*! \brief Inserts a REC event record
  *
  * Inserts a new event record to a given position. All contents starting from the given
@@ -176,6 +256,24 @@ int sd_rec_extra_len(int key);
  */
 int sd_rec_insert_action(sd_rec_file *rec, unsigned int number, const sd_rec_move *move);
 
+/*! \brief Inserts several REC event records
+ *
+ * Inserts count event records to a given position, eg. all records of a single tick. All contents
+ * starting from the given position will be moved forwards by count entries. Appending to the end
+ * of the list does not move anything, and grows the list only now and then.
+ *
+ * Event record data will be copied. Make sure to free your local copy yourself.
+ *
+ * \retval SD_INVALID_INPUT Slot you tried to insert to does not exist, or rec or moves was NULL.
+ * \retval SD_SUCCESS Success.
+ *
+ * \param rec REC struct pointer.
+ * \param number Record number of the first inserted record
+ * \param moves Moves to insert
+ * \param count Number of moves to insert
+ */
+int sd_rec_insert_actions(sd_rec_file *rec, unsigned int number, const sd_rec_move *moves, unsigned int count);
+
 /*! \brief Insert a closing ACT_NONE on a rec at `ticks`
  */
 void sd_rec_finish(sd_rec_file *rec, unsigned int ticks);
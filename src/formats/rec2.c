@@ -0,0 +1,584 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "formats/error.h"
+#include "formats/internal/memreader.h"
+#include "formats/internal/memwriter.h"
+#include "formats/internal/reader.h"
+#include "formats/internal/writer.h"
+#include "formats/rec2.h"
+#include "utils/allocator.h"
+#include "utils/range_coder.h"
+
+#define CHUNK_HEADER 'H'
+#define CHUNK_PHOTO 'P'
+#define CHUNK_MOVES 'M'
+#define CHUNK_KEYFRAME 'K'
+
+// Raw size after which a block of moves is written out. Blocks are compressed separately, so this
+// trades compression against how much of a match is lost if the recording is cut short.
+#define REC2_BLOCK_SIZE 16384
+
+// Largest raw size of a chunk. Move blocks stay near REC2_BLOCK_SIZE; headers and keyframes are far below this.
+#define REC2_MAX_CHUNK_SIZE (16 * 1024 * 1024)
+
+// The range coder saves at most a fraction of a bit per bit, so no chunk can have shrunk by more than this
+#define REC2_MAX_RATIO 64
+
+// Length of the header fields that follow the pilots
+#define REC2_SETTINGS_SIZE (2 * 4 + 3 + 8 * 2 + 10 + 1)
+
+struct sd_rec2_writer {
+    sd_writer *w;
+    memwriter *block;   ///< Moves not yet written to the file
+    uint32_t prev_tick; ///< Tick of the last move in the block
+};
+
+struct sd_rec2_reader {
+    sd_reader *r;
+    char *block;        ///< Decoded moves of the current block
+    uint32_t block_len;
+    uint32_t block_pos;
+    uint32_t prev_tick; ///< Tick of the last move read from the block
+};
+
+static void write_varint(memwriter *w, uint32_t value) {
+    while(value >= 0x80) {
+        memwrite_ubyte(w, (value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    memwrite_ubyte(w, value);
+}
+
+static bool read_varint(const char *buf, uint32_t len, uint32_t *pos, uint32_t *value) {
+    *value = 0;
+    for(int shift = 0; shift < 35; shift += 7) {
+        if(*pos >= len) {
+            return false;
+        }
+        uint8_t byte = buf[(*pos)++];
+        *value |= (uint32_t)(byte & 0x7F) << shift;
+        if(!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Ticks almost always grow, but zigzag keeps the odd step backwards small too
+static uint32_t zigzag(uint32_t delta) {
+    return (delta << 1) ^ (uint32_t)-(int32_t)(delta >> 31);
+}
+
+static uint32_t unzigzag(uint32_t value) {
+    return (value >> 1) ^ (uint32_t)-(int32_t)(value & 1);
+}
+
+static void write_chunk(sd_writer *w, uint8_t type, const char *data, uint32_t len) {
+    char *packed = NULL;
+    size_t packed_len = len > 0 ? range_compress(data, len, &packed) : 0;
+    sd_write_ubyte(w, type);
+    sd_write_udword(w, len);
+    if(packed_len < len) {
+        sd_write_udword(w, packed_len);
+        sd_write_buf(w, packed, packed_len);
+    } else {
+        // Did not compress, store as is
+        sd_write_udword(w, len);
+        sd_write_buf(w, data, len);
+    }
+    omf_free(packed);
+}
+
+// Reads the next chunk. False at the end of the file, or if the chunk was cut short.
+static bool read_chunk(sd_reader *r, uint8_t *type, char **data, uint32_t *len) {
+    if(sd_reader_filesize(r) - sd_reader_pos(r) < 9) {
+        return false;
+    }
+    *type = sd_read_ubyte(r);
+    uint32_t raw_len = sd_read_udword(r);
+    uint32_t stored_len = sd_read_udword(r);
+    if(stored_len > raw_len || (long)stored_len > sd_reader_filesize(r) - sd_reader_pos(r)) {
+        return false;
+    }
+    // Do not trust a damaged length with the allocation
+    if(raw_len > REC2_MAX_CHUNK_SIZE || raw_len / REC2_MAX_RATIO > stored_len) {
+        return false;
+    }
+    char *stored = omf_malloc(stored_len + 1);
+    if(!sd_read_buf(r, stored, stored_len)) {
+        omf_free(stored);
+        return false;
+    }
+    if(stored_len == raw_len) {
+        *data = stored;
+        *len = raw_len;
+        return true;
+    }
+    *data = omf_malloc(raw_len);
+    bool ok = range_decompress(stored, stored_len, *data, raw_len);
+    omf_free(stored);
+    if(!ok) {
+        omf_free(*data);
+        return false;
+    }
+    *len = raw_len;
+    return true;
+}
+
+static void write_header(memwriter *w, const sd_rec_file *rec) {
+    for(int i = 0; i < 2; i++) {
+        const sd_pilot *pilot = &rec->pilots[i].info;
+
+        // Pilot block is written without the xor, it would only hurt compression
+        sd_pilot_save_to_mem(w, pilot);
+        for(int m = 0; m < 10; m++) {
+            uint16_t len = pilot->quotes[m] ? strlen(pilot->quotes[m]) + 1 : 0;
+            memwrite_uword(w, len);
+            if(len > 0) {
+                memwrite_buf(w, pilot->quotes[m], len);
+            }
+        }
+        memwrite_ubyte(w, rec->pilots[i].unknown_a);
+        memwrite_uword(w, rec->pilots[i].unknown_b);
+        palette_msave_range(w, &pilot->palette, 0, 48);
+        memwrite_ubyte(w, pilot->photo ? 1 : 0);
+    }
+
+    for(int i = 0; i < 2; i++)
+        memwrite_udword(w, rec->scores[i]);
+
+    memwrite_byte(w, rec->unknown_a);
+    memwrite_byte(w, rec->unknown_b);
+    memwrite_byte(w, rec->game_mode);
+    memwrite_word(w, rec->throw_range);
+    memwrite_word(w, rec->hit_pause);
+    memwrite_word(w, rec->block_damage);
+    memwrite_word(w, rec->vitality);
+    memwrite_word(w, rec->jump_height);
+    memwrite_word(w, rec->p1_controller);
+    memwrite_word(w, rec->p2_controller);
+    memwrite_word(w, rec->p2_controller_);
+    memwrite_ubyte(w, rec->knock_down);
+    memwrite_ubyte(w, rec->rehit_mode);
+    memwrite_ubyte(w, rec->def_throws);
+    memwrite_ubyte(w, rec->arena_id);
+    memwrite_ubyte(w, rec->power[0]);
+    memwrite_ubyte(w, rec->power[1]);
+    memwrite_ubyte(w, rec->hazards);
+    memwrite_ubyte(w, rec->round_type);
+    memwrite_ubyte(w, rec->unknown_l);
+    memwrite_ubyte(w, rec->hyper_mode);
+    memwrite_byte(w, rec->unknown_m);
+    memwrite_udword(w, rec->seed);
+}
+
+static bool has_bytes(const memreader *mr, long len) {
+    return memreader_size(mr) - memreader_pos(mr) >= len;
+}
+
+// Reads the header chunk, and tells which pilots have a photo chunk coming
+static int read_header(memreader *mr, sd_rec_file *rec, bool has_photo[2]) {
+    for(int i = 0; i < 2; i++) {
+        sd_pilot *pilot = &rec->pilots[i].info;
+        if(!has_bytes(mr, PILOT_BLOCK_LENGTH)) {
+            return SD_FILE_PARSE_ERROR;
+        }
+        sd_pilot_load_from_mem(mr, pilot);
+
+        for(int m = 0; m < 10; m++) {
+            if(!has_bytes(mr, 2)) {
+                return SD_FILE_PARSE_ERROR;
+            }
+            uint16_t len = memread_uword(mr);
+            if(!has_bytes(mr, len)) {
+                return SD_FILE_PARSE_ERROR;
+            }
+            omf_free(pilot->quotes[m]);
+            if(len > 0) {
+                pilot->quotes[m] = omf_calloc(len, 1);
+                memread_buf(mr, pilot->quotes[m], len);
+                pilot->quotes[m][len - 1] = 0;
+            }
+        }
+
+        if(!has_bytes(mr, 1 + 2 + 48 * 3 + 1)) {
+            return SD_FILE_PARSE_ERROR;
+        }
+        rec->pilots[i].unknown_a = memread_ubyte(mr);
+        rec->pilots[i].unknown_b = memread_uword(mr);
+        vga_palette_init(&pilot->palette);
+        palette_mload_range(mr, &pilot->palette, 0, 48);
+        has_photo[i] = memread_ubyte(mr) != 0;
+    }
+
+    if(!has_bytes(mr, REC2_SETTINGS_SIZE)) {
+        return SD_FILE_PARSE_ERROR;
+    }
+    for(int i = 0; i < 2; i++)
+        rec->scores[i] = memread_udword(mr);
+
+    rec->unknown_a = memread_byte(mr);
+    rec->unknown_b = memread_byte(mr);
+    rec->game_mode = memread_byte(mr);
+    rec->throw_range = memread_word(mr);
+    rec->hit_pause = memread_word(mr);
+    rec->block_damage = memread_word(mr);
+    rec->vitality = memread_word(mr);
+    rec->jump_height = memread_word(mr);
+    rec->p1_controller = memread_word(mr);
+    rec->p2_controller = memread_word(mr);
+    rec->p2_controller_ = memread_word(mr);
+    rec->knock_down = memread_ubyte(mr);
+    rec->rehit_mode = memread_ubyte(mr);
+    rec->def_throws = memread_ubyte(mr);
+    rec->arena_id = memread_ubyte(mr);
+    rec->power[0] = memread_ubyte(mr);
+    rec->power[1] = memread_ubyte(mr);
+    rec->hazards = memread_ubyte(mr);
+    rec->round_type = memread_ubyte(mr);
+    rec->unknown_l = memread_ubyte(mr);
+    rec->hyper_mode = memread_ubyte(mr);
+    rec->unknown_m = memread_byte(mr);
+
+    // Older files end the header before the seed
+    if(has_bytes(mr, 4)) {
+        rec->seed = memread_udword(mr);
+    }
+    return SD_SUCCESS;
+}
+
+bool sd_rec2_is_compact(const char *filename) {
+    if(filename == NULL) {
+        return false;
+    }
+    sd_reader *r = sd_reader_open(filename);
+    if(r == NULL) {
+        return false;
+    }
+    char magic[4];
+    bool compact = sd_read_buf(r, magic, sizeof(magic)) && memcmp(magic, SD_REC2_MAGIC, sizeof(magic)) == 0;
+    sd_reader_close(r);
+    return compact;
+}
+
+sd_rec2_writer *sd_rec2_writer_open(const sd_rec_file *rec, const char *filename) {
+    if(rec == NULL || filename == NULL) {
+        return NULL;
+    }
+    sd_writer *w = sd_writer_open(filename);
+    if(w == NULL) {
+        return NULL;
+    }
+    sd_write_buf(w, SD_REC2_MAGIC, 4);
+    sd_write_ubyte(w, SD_REC2_VERSION);
+
+    memwriter *header = memwriter_open();
+    write_header(header, rec);
+    write_chunk(w, CHUNK_HEADER, header->buf, memwriter_pos(header));
+    memwriter_close(header);
+
+    // Photos are already compressed sprites, so they are stored as is
+    for(int i = 0; i < 2; i++) {
+        if(rec->pilots[i].info.photo == NULL) {
+            continue;
+        }
+        sd_write_ubyte(w, CHUNK_PHOTO);
+        long lengths = sd_writer_pos(w);
+        sd_write_udword(w, 0);
+        sd_write_udword(w, 0);
+        sd_write_ubyte(w, i);
+        sd_sprite_save(w, rec->pilots[i].info.photo);
+        long end = sd_writer_pos(w);
+        uint32_t len = end - lengths - 8;
+        sd_writer_seek_start(w, lengths);
+        sd_write_udword(w, len);
+        sd_write_udword(w, len);
+        sd_writer_seek_start(w, end);
+    }
+
+    sd_rec2_writer *writer = omf_calloc(1, sizeof(sd_rec2_writer));
+    writer->w = w;
+    writer->block = memwriter_open();
+    return writer;
+}
+
+// Writes out the current block, and starts a new one
+static void writer_end_block(sd_rec2_writer *writer) {
+    if(memwriter_pos(writer->block) == 0) {
+        return;
+    }
+    write_chunk(writer->w, CHUNK_MOVES, writer->block->buf, memwriter_pos(writer->block));
+    memwriter_close(writer->block);
+    writer->block = memwriter_open();
+    writer->prev_tick = 0;
+}
+
+static int writer_status(const sd_rec2_writer *writer) {
+    return sd_writer_errno(writer->w) ? SD_FILE_WRITE_ERROR : SD_SUCCESS;
+}
+
+int sd_rec2_writer_add(sd_rec2_writer *writer, const sd_rec_move *moves, unsigned int count) {
+    if(writer == NULL || (moves == NULL && count > 0)) {
+        return SD_INVALID_INPUT;
+    }
+    for(unsigned int i = 0; i < count; i++) {
+        const sd_rec_move *move = &moves[i];
+        memwriter *w = writer->block;
+        write_varint(w, zigzag(move->tick - writer->prev_tick));
+        writer->prev_tick = move->tick;
+
+        // Nearly every move is a plain input, so its lookup id is folded into the player byte
+        write_varint(w, ((uint32_t)move->player_id << 1) | (move->lookup_id != 2));
+        if(move->lookup_id != 2) {
+            memwrite_ubyte(w, move->lookup_id);
+        }
+        int extra_length = sd_rec_extra_len(move->lookup_id);
+        if(extra_length == 1) {
+            memwrite_ubyte(w, sd_rec_pack_action(move->action));
+        } else if(extra_length > 1) {
+            memwrite_ubyte(w, move->raw_action);
+            if(move->extra_data != NULL) {
+                memwrite_buf(w, move->extra_data, extra_length - 1);
+            } else {
+                memwrite_fill(w, 0, extra_length - 1);
+            }
+        }
+
+        if(memwriter_pos(w) >= REC2_BLOCK_SIZE) {
+            writer_end_block(writer);
+        }
+    }
+    return writer_status(writer);
+}
+
+int sd_rec2_writer_keyframe(sd_rec2_writer *writer, uint32_t tick, const char *data, uint32_t len) {
+    if(writer == NULL || data == NULL || len > REC2_MAX_CHUNK_SIZE - 4) {
+        return SD_INVALID_INPUT;
+    }
+    writer_end_block(writer);
+    memwriter *chunk = memwriter_open();
+    memwrite_udword(chunk, tick);
+    if(len > 0) {
+        memwrite_buf(chunk, data, len);
+    }
+    write_chunk(writer->w, CHUNK_KEYFRAME, chunk->buf, memwriter_pos(chunk));
+    memwriter_close(chunk);
+    return writer_status(writer);
+}
+
+int sd_rec2_writer_flush(sd_rec2_writer *writer) {
+    if(writer == NULL) {
+        return SD_INVALID_INPUT;
+    }
+    writer_end_block(writer);
+    if(!sd_writer_flush(writer->w)) {
+        return SD_FILE_WRITE_ERROR;
+    }
+    return writer_status(writer);
+}
+
+int sd_rec2_writer_close(sd_rec2_writer *writer) {
+    int ret = sd_rec2_writer_flush(writer);
+    if(writer != NULL) {
+        sd_writer_close(writer->w);
+        memwriter_close(writer->block);
+        omf_free(writer);
+    }
+    return ret;
+}
+
+sd_rec2_reader *sd_rec2_reader_open(sd_rec_file *rec, const char *filename, int *error) {
+    int ret = SD_INVALID_INPUT;
+    sd_reader *r = NULL;
+    char *data = NULL;
+    if(rec == NULL || filename == NULL) {
+        goto error_0;
+    }
+
+    ret = SD_FILE_OPEN_ERROR;
+    if(!(r = sd_reader_open(filename))) {
+        goto error_0;
+    }
+
+    ret = SD_FILE_PARSE_ERROR;
+    char magic[4];
+    if(!sd_read_buf(r, magic, sizeof(magic)) || memcmp(magic, SD_REC2_MAGIC, sizeof(magic)) != 0) {
+        goto error_1;
+    }
+    if(sd_read_ubyte(r) != SD_REC2_VERSION) {
+        goto error_1;
+    }
+
+    uint8_t type;
+    uint32_t len;
+    if(!read_chunk(r, &type, &data, &len) || type != CHUNK_HEADER) {
+        goto error_1;
+    }
+    bool has_photo[2];
+    memreader *mr = memreader_open(data, len);
+    ret = read_header(mr, rec, has_photo);
+    memreader_close(mr);
+    if(ret != SD_SUCCESS) {
+        goto error_1;
+    }
+
+    // Photo chunks follow the header, one for each pilot that has a photo
+    for(int i = 0; i < 2; i++) {
+        if(!has_photo[i]) {
+            continue;
+        }
+        ret = SD_FILE_PARSE_ERROR;
+        if(sd_read_ubyte(r) != CHUNK_PHOTO) {
+            goto error_1;
+        }
+        uint32_t photo_len = sd_read_udword(r);
+        sd_skip(r, 4);
+        long photo_end = sd_reader_pos(r) + photo_len;
+        if(photo_end > sd_reader_filesize(r) || sd_read_ubyte(r) != i) {
+            goto error_1;
+        }
+        rec->pilots[i].info.photo = omf_calloc(1, sizeof(sd_sprite));
+        sd_sprite_create(rec->pilots[i].info.photo);
+        if((ret = sd_sprite_load(r, rec->pilots[i].info.photo)) != SD_SUCCESS) {
+            goto error_1;
+        }
+        sd_reader_set(r, photo_end);
+    }
+
+    omf_free(data);
+    sd_rec2_reader *reader = omf_calloc(1, sizeof(sd_rec2_reader));
+    reader->r = r;
+    if(error != NULL) {
+        *error = SD_SUCCESS;
+    }
+    return reader;
+
+error_1:
+    omf_free(data);
+    sd_reader_close(r);
+error_0:
+    if(error != NULL) {
+        *error = ret;
+    }
+    return NULL;
+}
+
+// Decodes the next move of the current block. False if the block is used up or damaged.
+static bool reader_next_move(sd_rec2_reader *reader, sd_rec_move *move) {
+    const char *buf = reader->block;
+    uint32_t len = reader->block_len;
+    uint32_t *pos = &reader->block_pos;
+    uint32_t delta, player;
+    if(!read_varint(buf, len, pos, &delta) || !read_varint(buf, len, pos, &player)) {
+        return false;
+    }
+    memset(move, 0, sizeof(sd_rec_move));
+    move->tick = reader->prev_tick + unzigzag(delta);
+    move->player_id = player >> 1;
+    move->lookup_id = 2;
+    if(player & 1) {
+        if(*pos >= len) {
+            return false;
+        }
+        move->lookup_id = buf[(*pos)++];
+    }
+    int extra_length = sd_rec_extra_len(move->lookup_id);
+    if(extra_length > 0) {
+        if(len - *pos < (uint32_t)extra_length) {
+            return false;
+        }
+        move->raw_action = buf[(*pos)++];
+        move->action = sd_rec_unpack_action(move->raw_action);
+        if(extra_length > 1) {
+            move->extra_data = omf_malloc(extra_length - 1);
+            memcpy(move->extra_data, buf + *pos, extra_length - 1);
+            *pos += extra_length - 1;
+        }
+    }
+    reader->prev_tick = move->tick;
+    return true;
+}
+
+sd_rec2_item sd_rec2_reader_next(sd_rec2_reader *reader, sd_rec_move *move, sd_rec2_keyframe *keyframe) {
+    if(reader == NULL || move == NULL) {
+        return SD_REC2_END;
+    }
+    while(1) {
+        if(reader->block_pos < reader->block_len) {
+            if(reader_next_move(reader, move)) {
+                return SD_REC2_MOVE;
+            }
+            // A damaged block ends the recording
+            break;
+        }
+
+        uint8_t type;
+        char *data;
+        uint32_t len;
+        if(!read_chunk(reader->r, &type, &data, &len)) {
+            break;
+        }
+        if(type == CHUNK_MOVES) {
+            omf_free(reader->block);
+            reader->block = data;
+            reader->block_len = len;
+            reader->block_pos = 0;
+            reader->prev_tick = 0;
+            continue;
+        }
+        if(type == CHUNK_KEYFRAME && keyframe != NULL && len >= 4) {
+            memcpy(&keyframe->tick, data, 4);
+            keyframe->len = len - 4;
+            keyframe->data = omf_calloc(len - 4 + 1, 1);
+            memcpy(keyframe->data, data + 4, len - 4);
+            omf_free(data);
+            return SD_REC2_KEYFRAME;
+        }
+
+        // Skipped keyframes, and chunks from newer versions
+        omf_free(data);
+    }
+    omf_free(reader->block);
+    reader->block_len = 0;
+    reader->block_pos = 0;
+    return SD_REC2_END;
+}
+
+void sd_rec2_reader_close(sd_rec2_reader *reader) {
+    if(reader == NULL) {
+        return;
+    }
+    sd_reader_close(reader->r);
+    omf_free(reader->block);
+    omf_free(reader);
+}
+
+int sd_rec2_load(sd_rec_file *rec, const char *filename) {
+    if(rec == NULL || filename == NULL) {
+        return SD_INVALID_INPUT;
+    }
+    int ret;
+    sd_rec2_reader *reader = sd_rec2_reader_open(rec, filename, &ret);
+    if(reader == NULL) {
+        return ret;
+    }
+    sd_rec_move move;
+    while(sd_rec2_reader_next(reader, &move, NULL) == SD_REC2_MOVE) {
+        sd_rec_insert_action(rec, rec->move_count, &move);
+    }
+    sd_rec2_reader_close(reader);
+    return SD_SUCCESS;
+}
+
+int sd_rec2_save(const sd_rec_file *rec, const char *filename) {
+    if(rec == NULL || filename == NULL) {
+        return SD_INVALID_INPUT;
+    }
+    sd_rec2_writer *writer = sd_rec2_writer_open(rec, filename);
+    if(writer == NULL) {
+        return SD_FILE_OPEN_ERROR;
+    }
+    sd_rec2_writer_add(writer, rec->moves, rec->move_count);
+    return sd_rec2_writer_close(writer);
+}
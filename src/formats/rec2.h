@@ -0,0 +1,191 @@
+/*! \file
+ * \brief Compact match record file handling.
+ * \details Functions for reading and writing compact (v2) match record files. These hold the same
+ *          data as legacy REC files in a fraction of the space, and can be written and read while a
+ *          match is in progress.
+ * \copyright MIT license.
+ *
+ * A compact REC file starts with the magic bytes and a version byte, followed by chunks. Each chunk
+ * is a type byte, the length of its data, and the length it is stored in; when the two differ, the
+ * data is compressed with range_compress(). The header chunk comes first and holds the match settings
+ * and pilots, in the same fields as sd_rec_file. Moves are stored in blocks, each decodable on its own:
+ * every move is the varint tick delta from the previous move of the block, the player and lookup id, and
+ * the packed action byte. Keyframe chunks hold opaque state snapshots, and follow the moves before them.
+ */
+
+#ifndef SD_REC2_H
+#define SD_REC2_H
+
+#include "formats/rec.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SD_REC2_MAGIC "OMFR"
+#define SD_REC2_VERSION 2
+
+/*! \brief Compact REC streaming writer
+ *
+ * Opaque, see sd_rec2_writer_open().
+ */
+typedef struct sd_rec2_writer sd_rec2_writer;
+
+/*! \brief Compact REC streaming reader
+ *
+ * Opaque, see sd_rec2_reader_open().
+ */
+typedef struct sd_rec2_reader sd_rec2_reader;
+
+/*! \brief Compact REC keyframe
+ *
+ * A snapshot of the match at a given tick. The contents are up to the application.
+ */
+typedef struct {
+    uint32_t tick; ///< Game tick of the snapshot
+    uint32_t len;  ///< Length of the data
+    char *data;    ///< Snapshot data. Owned by the caller once read.
+} sd_rec2_keyframe;
+
+/*! \brief Item read from a compact REC
+ */
+typedef enum sd_rec2_item
+{
+    SD_REC2_END,     ///< No more data
+    SD_REC2_MOVE,    ///< An event record was read
+    SD_REC2_KEYFRAME ///< A keyframe was read
+} sd_rec2_item;
+
+/*! \brief Check for a compact REC file
+ *
+ * \retval true The file exists and starts with the compact REC magic.
+ * \retval false Otherwise.
+ *
+ * \param filename Name of the file to check.
+ */
+bool sd_rec2_is_compact(const char *filename);
+
+/*! \brief Load compact .REC file
+ *
+ * Loads the given compact REC file to memory, in the same way as sd_rec_load(). Keyframes are skipped.
+ * A recording that was cut short, eg. by a crash, loads up to the last complete chunk.
+ *
+ * \retval SD_INVALID_INPUT rec or filename was NULL.
+ * \retval SD_FILE_OPEN_ERROR File could not be opened.
+ * \retval SD_FILE_PARSE_ERROR File is not a compact REC, or its header is damaged.
+ * \retval SD_SUCCESS Success.
+ *
+ * \param rec REC struct pointer.
+ * \param filename Name of the REC file to load from.
+ */
+int sd_rec2_load(sd_rec_file *rec, const char *filename);
+
+/*! \brief Save compact .REC file
+ *
+ * Saves the given REC in the compact format.
+ *
+ * \retval SD_INVALID_INPUT rec or filename was NULL.
+ * \retval SD_FILE_OPEN_ERROR File could not be opened for writing.
+ * \retval SD_FILE_WRITE_ERROR Writing to the file failed.
+ * \retval SD_SUCCESS Success.
+ *
+ * \param rec REC struct pointer.
+ * \param filename Name of the REC file to save into.
+ */
+int sd_rec2_save(const sd_rec_file *rec, const char *filename);
+
+/*! \brief Start writing a compact REC file
+ *
+ * Writes the header of the given REC, ie. everything but the event records. Event records and
+ * keyframes are then added with sd_rec2_writer_add() and sd_rec2_writer_keyframe().
+ *
+ * \retval NULL File could not be opened for writing, or rec was NULL.
+ *
+ * \param rec REC struct pointer.
+ * \param filename Name of the REC file to save into.
+ */
+sd_rec2_writer *sd_rec2_writer_open(const sd_rec_file *rec, const char *filename);
+
+/*! \brief Add event records
+ *
+ * Encodes event records into the current block. Full blocks are compressed and written out.
+ *
+ * \retval SD_INVALID_INPUT writer was NULL, or moves was NULL with a count.
+ * \retval SD_FILE_WRITE_ERROR Writing to the file failed.
+ * \retval SD_SUCCESS Success.
+ *
+ * \param writer Writer pointer.
+ * \param moves Event records to add.
+ * \param count Number of event records.
+ */
+int sd_rec2_writer_add(sd_rec2_writer *writer, const sd_rec_move *moves, unsigned int count);
+
+/*! \brief Add a keyframe
+ *
+ * Ends the current block, and writes a keyframe after it.
+ *
+ * \retval SD_INVALID_INPUT writer or data was NULL, or the data is larger than a chunk may be (16MiB).
+ * \retval SD_FILE_WRITE_ERROR Writing to the file failed.
+ * \retval SD_SUCCESS Success.
+ *
+ * \param writer Writer pointer.
+ * \param tick Game tick of the snapshot.
+ * \param data Snapshot data, copied.
+ * \param len Length of the data.
+ */
+int sd_rec2_writer_keyframe(sd_rec2_writer *writer, uint32_t tick, const char *data, uint32_t len);
+
+/*! \brief Write out the current block
+ *
+ * Ends the current block and pushes it out to the file, so that it survives a crash. Smaller blocks
+ * compress worse, so do not flush more often than needed.
+ *
+ * \retval SD_INVALID_INPUT writer was NULL.
+ * \retval SD_FILE_WRITE_ERROR Writing to the file failed.
+ * \retval SD_SUCCESS Success.
+ *
+ * \param writer Writer pointer.
+ */
+int sd_rec2_writer_flush(sd_rec2_writer *writer);
+
+/*! \brief Finish writing a compact REC file
+ *
+ * Writes out the current block and closes the file. The writer pointer will be invalid afterwards.
+ *
+ * \retval SD_FILE_WRITE_ERROR Writing to the file failed.
+ * \retval SD_SUCCESS Success.
+ *
+ * \param writer Writer pointer.
+ */
+int sd_rec2_writer_close(sd_rec2_writer *writer);
+
+/*! \brief Start reading a compact REC file
+ *
+ * Reads the header of the file into the given REC, which must be initialized with sd_rec_create().
+ * No event records are added to it; read them with sd_rec2_reader_next().
+ *
+ * \retval NULL File could not be opened or is not a compact REC. error tells which.
+ *
+ * \param rec REC struct pointer.
+ * \param filename Name of the REC file to load from.
+ * \param error Set to an SD_ERRORCODE value, may be NULL.
+ */
+sd_rec2_reader *sd_rec2_reader_open(sd_rec_file *rec, const char *filename, int *error);
+
+/*! \brief Read the next item
+ *
+ * Reads the next event record or keyframe. A chunk that was cut short or does not decode ends the file.
+ *
+ * \return Type of the item read, SD_REC2_END at the end of the file.
+ *
+ * \param reader Reader pointer.
+ * \param move Filled in when an event record is read. Its extra data is owned by the caller.
+ * \param keyframe Filled in when a keyframe is read. If NULL, keyframes are skipped.
+ */
+sd_rec2_item sd_rec2_reader_next(sd_rec2_reader *reader, sd_rec_move *move, sd_rec2_keyframe *keyframe);
+
+/*! \brief Finish reading a compact REC file
+ *
+ * \param reader Reader pointer. Will be invalid afterwards.
+ */
+void sd_rec2_reader_close(sd_rec2_reader *reader);
+
+#endif // SD_REC2_H
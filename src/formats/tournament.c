@@ -1,3 +1,4 @@
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -133,7 +134,7 @@ static void parse_tournament_description(sd_tournament_locale *locale) {
     }
 }
 
-int sd_tournament_load(sd_tournament_file *trn, const char *filename) {
+static int load_tournament(sd_tournament_file *trn, const char *filename, bool summary) {
     int ret = SD_FILE_PARSE_ERROR;
     if(trn == NULL || filename == NULL) {
         return SD_INVALID_INPUT;
@@ -181,8 +182,8 @@ int sd_tournament_load(sd_tournament_file *trn, const char *filename) {
         offset_list[i] = sd_read_dword(r);
     }
 
-    // Read enemy data
-    for(unsigned i = 0; i < trn->enemy_count; i++) {
+    // Read enemy data. Summaries only need what the selection menu shows, so skip the pilots.
+    for(unsigned i = 0; i < trn->enemy_count && !summary; i++) {
         trn->enemies[i] = omf_calloc(1, sizeof(sd_pilot));
 
         // Find data length
@@ -237,7 +238,7 @@ int sd_tournament_load(sd_tournament_file *trn, const char *filename) {
     }
 
     // Load texts
-    for(int i = 0; i < MAX_TRN_LOCALES; i++) {
+    for(int i = 0; i < MAX_TRN_LOCALES && !summary; i++) {
         for(int har = 0; har < 11; har++) {
             for(int page = 0; page < 10; page++) {
                 trn->locales[i]->end_texts[har][page] = sd_read_variable_str(r);
@@ -260,6 +261,14 @@ error_0:
     return ret;
 }
 
+int sd_tournament_load(sd_tournament_file *trn, const char *filename) {
+    return load_tournament(trn, filename, false);
+}
+
+int sd_tournament_load_summary(sd_tournament_file *trn, const char *filename) {
+    return load_tournament(trn, filename, true);
+}
+
 int sd_tournament_save(const sd_tournament_file *trn, const char *filename) {
     if(trn == NULL || filename == NULL) {
         return SD_INVALID_INPUT;
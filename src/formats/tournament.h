@@ -100,6 +100,21 @@ int sd_tournament_create(sd_tournament_file *trn);
  */
 int sd_tournament_load(sd_tournament_file *trn, const char *filename);
 
+/*! \brief Load the header of a TRN file
+ *
+ * Loads the parts of a TRN file needed to present the tournament for selection: the header fields,
+ * logos, palette, titles and descriptions. Enemy pilots and victory texts are left empty; use
+ * sd_tournament_load() to get those.
+ *
+ * \retval SD_FILE_OPEN_ERROR File could not be opened.
+ * \retval SD_FILE_PARSE_ERROR Syntax error in file.
+ * \retval SD_SUCCESS Success.
+ *
+ * \param trn TRN file struct pointer.
+ * \param filename Name of the TRN file to load from.
+ */
+int sd_tournament_load_summary(sd_tournament_file *trn, const char *filename);
+
 /*! \brief Save TRN file
  *
  * Saves the given TRN file from memory to a file on disk. The structure must be at
@@ -1,6 +1,5 @@
 #include "game/game_state.h"
 #include "audio/audio.h"
-#include "console/console.h"
 #include "controller/joystick.h"
 #include "controller/keyboard.h"
 #include "controller/rec_controller.h"
@@ -21,6 +20,8 @@
 #include "game/scenes/openomf.h"
 #include "game/scenes/scoreboard.h"
 #include "game/scenes/vs.h"
+#include "game/utils/profiler.h"
+#include "game/utils/rec_keyframes.h"
 #include "game/utils/serial.h"
 #include "game/utils/settings.h"
 #include "game/utils/ticktimer.h"
@@ -30,6 +31,7 @@
 #include "utils/c_array_util.h"
 #include "utils/log.h"
 #include "utils/miscmath.h"
+#include "video/soft_framebuffer.h"
 #include "video/vga_state.h"
 #include "video/video.h"
 #include <SDL.h>
@@ -105,25 +107,30 @@ void game_state_match_settings_defaults(game_state *gs) {
     gs->match_settings.sim = false;
 }
 
-int game_state_create(game_state *gs, engine_init_flags *init_flags) {
+// Copies the user preferences the simulation needs from the global settings. Must not be called from the tick
+// functions, so that those stay free of global state.
+void game_state_sync_settings(game_state *gs) {
+    gs->host.crossfade = settings_get()->video.crossfade_on;
+    gs->host.sound_volume = settings_get()->sound.sound_vol / 10.0f;
+}
+
+// Sets up the fields shared by all game state constructors. Scene is allocated, but not created.
+static void game_state_init(game_state *gs, engine_init_flags *init_flags, vga_state *vga) {
     gs->run = 1;
     gs->paused = 0;
     gs->tick = 0;
     gs->int_tick = 0;
     gs->role = ROLE_CLIENT;
     gs->net_mode = init_flags->net_mode;
-    gs->speed = settings_get()->gameplay.speed + 5;
-
-    if(init_flags->speed >= 0) {
-        gs->speed = clamp(init_flags->speed, 1, 10) + 5;
-    }
     gs->init_flags = init_flags;
+    gs->vga = vga;
     gs->new_state = NULL;
+    gs->keyframes = NULL;
     gs->clone = false;
     gs->hit_pause = 0;
-    game_state_match_settings_reset(gs);
     vector_create(&gs->objects, sizeof(render_obj));
     vector_create(&gs->sounds, sizeof(playing_sound));
+    render_queue_create(&gs->render_queue);
 
     // For screen shake
     gs->screen_shake_horizontal = 0;
@@ -140,8 +147,17 @@ int game_state_create(game_state *gs, engine_init_flags *init_flags) {
     // Disable warp (debug) speed by default. This can be set in console.
     gs->warp_speed = init_flags->warpspeed;
 
-    gs->hide_ui = false;
     gs->menu_ctrl = omf_calloc(1, sizeof(controller));
+    gs->next_object_id = 1;
+
+    // Headless by default; the engine enables the outputs it can serve.
+    gs->host.crossfade = false;
+    gs->host.input_blocked = false;
+    gs->host.audio = false;
+    gs->host.sound_volume = 1.0f;
+    gs->host.screen_offset_x = 0;
+    gs->host.screen_offset_y = 0;
+    gs->host.scene_changed = false;
 
     gs->sc = omf_calloc(1, sizeof(scene));
 
@@ -150,60 +166,96 @@ int game_state_create(game_state *gs, engine_init_flags *init_flags) {
         gs->players[i] = omf_calloc(1, sizeof(game_player));
         game_player_create(gs->players[i]);
     }
+}
+
+// Sets up the arena and controllers to play back gs->rec. The match seed is taken from the recording when it has
+// one, otherwise gs->rand is left as is.
+static int game_state_play_rec(game_state *gs) {
+    if(gs->rec->seed != 0) {
+        random_seed(&gs->rand, gs->rec->seed);
+    }
+    int nscene = SCENE_ARENA0 + gs->rec->arena_id;
+    gs->this_id = nscene;
+    gs->next_id = nscene;
+
+    if(scene_create(gs->sc, gs, nscene)) {
+        log_error("Error while loading scene %d.", nscene);
+        return 1;
+    }
+
+    // set the HAR colors, pilot, har type and and pilot and HAR stats
+    for(int i = 0; i < 2; i++) {
+        sd_pilot_free(gs->players[i]->pilot);
+        omf_free(gs->players[i]->pilot);
+        gs->players[i]->pilot = &gs->rec->pilots[i].info;
+        // this function alters the palette
+        sd_pilot_set_player_color(gs->players[i]->pilot, PRIMARY, gs->rec->pilots[i].info.color_3);
+        sd_pilot_set_player_color(gs->players[i]->pilot, SECONDARY, gs->rec->pilots[i].info.color_2);
+        sd_pilot_set_player_color(gs->players[i]->pilot, TERTIARY, gs->rec->pilots[i].info.color_1);
+    }
+
+    gs->match_settings.throw_range = gs->rec->throw_range;
+    gs->match_settings.hit_pause = gs->rec->hit_pause;
+    gs->match_settings.block_damage = gs->rec->block_damage;
+    gs->match_settings.vitality = gs->rec->vitality;
+    gs->match_settings.jump_height = gs->rec->jump_height;
+    gs->match_settings.knock_down = gs->rec->knock_down;
+    gs->match_settings.rehit = gs->rec->rehit_mode;
+    gs->match_settings.defensive_throws = gs->rec->def_throws;
+    gs->match_settings.power1 = gs->rec->power[0];
+    gs->match_settings.power2 = gs->rec->power[1];
+    gs->match_settings.hazards = gs->rec->hazards;
+    gs->match_settings.rounds = gs->rec->round_type;
+    gs->match_settings.fight_mode = gs->rec->hyper_mode;
+    gs->match_settings.sim = false;
+
+    _setup_rec_controller(gs, 0, gs->rec);
+    _setup_rec_controller(gs, 1, gs->rec);
+    if(arena_create(gs->sc)) {
+        log_error("Error while creating arena scene.");
+        scene_free(gs->sc);
+        return 1;
+    }
+    return 0;
+}
+
+// Loads the recording named in init_flags, and sets up the arena and controllers to play it back.
+static int game_state_load_rec(game_state *gs, engine_init_flags *init_flags) {
+    gs->rec = omf_malloc(sizeof(sd_rec_file));
+    sd_rec_create(gs->rec);
+    int ret = sd_rec_load(gs->rec, init_flags->rec_file);
+    if(ret != SD_SUCCESS) {
+        log_error("Unable to load recording %s.", init_flags->rec_file);
+        return 1;
+    }
+    log_debug("playing recording file %s", init_flags->rec_file);
+    return game_state_play_rec(gs);
+}
+
+// Shared by game_state_create and game_state_create_spectator. If rec is given, it is played back.
+static int game_state_create_with_rec(game_state *gs, engine_init_flags *init_flags, vga_state *vga,
+                                      sd_rec_file *rec) {
+    game_state_init(gs, init_flags, vga);
+    gs->host.audio = true;
+    game_state_sync_settings(gs);
+    gs->speed = settings_get()->gameplay.speed + 5;
+    if(init_flags->speed >= 0) {
+        gs->speed = clamp(init_flags->speed, 1, 10) + 5;
+    }
+    game_state_match_settings_reset(gs);
+    random_seed(&gs->rand, time(NULL));
 
     reconfigure_controller(gs);
     int nscene;
-    if(strlen(init_flags->rec_file) > 0 && init_flags->playback == 1) {
-        gs->rec = omf_malloc(sizeof(sd_rec_file));
-        sd_rec_create(gs->rec);
-        int ret = sd_rec_load(gs->rec, init_flags->rec_file);
-        if(ret != SD_SUCCESS) {
-            log_error("Unable to load recording %s.", init_flags->rec_file);
+    if(rec != NULL) {
+        gs->rec = rec;
+        if(game_state_play_rec(gs)) {
             goto error_0;
         }
-
-        nscene = SCENE_ARENA0 + gs->rec->arena_id;
-        log_debug("playing recording file %s", init_flags->rec_file);
-        gs->this_id = nscene;
-        gs->next_id = nscene;
-
-        if(scene_create(gs->sc, gs, nscene)) {
-            log_error("Error while loading scene %d.", nscene);
+    } else if(strlen(init_flags->rec_file) > 0 && init_flags->playback == 1) {
+        if(game_state_load_rec(gs, init_flags)) {
             goto error_0;
         }
-
-        // set the HAR colors, pilot, har type and and pilot and HAR stats
-        for(int i = 0; i < 2; i++) {
-            sd_pilot_free(gs->players[i]->pilot);
-            omf_free(gs->players[i]->pilot);
-            gs->players[i]->pilot = &gs->rec->pilots[i].info;
-            // this function alters the palette
-            sd_pilot_set_player_color(gs->players[i]->pilot, PRIMARY, gs->rec->pilots[i].info.color_3);
-            sd_pilot_set_player_color(gs->players[i]->pilot, SECONDARY, gs->rec->pilots[i].info.color_2);
-            sd_pilot_set_player_color(gs->players[i]->pilot, TERTIARY, gs->rec->pilots[i].info.color_1);
-        }
-
-        gs->match_settings.throw_range = gs->rec->throw_range;
-        gs->match_settings.hit_pause = gs->rec->hit_pause;
-        gs->match_settings.block_damage = gs->rec->block_damage;
-        gs->match_settings.vitality = gs->rec->vitality;
-        gs->match_settings.jump_height = gs->rec->jump_height;
-        gs->match_settings.knock_down = gs->rec->knock_down;
-        gs->match_settings.rehit = gs->rec->rehit_mode;
-        gs->match_settings.defensive_throws = gs->rec->def_throws;
-        gs->match_settings.power1 = gs->rec->power[0];
-        gs->match_settings.power2 = gs->rec->power[1];
-        gs->match_settings.hazards = gs->rec->hazards;
-        gs->match_settings.rounds = gs->rec->round_type;
-        gs->match_settings.fight_mode = gs->rec->hyper_mode;
-        gs->match_settings.sim = false;
-
-        _setup_rec_controller(gs, 0, gs->rec);
-        _setup_rec_controller(gs, 1, gs->rec);
-        if(arena_create(gs->sc)) {
-            log_error("Error while creating arena scene.");
-            goto error_1;
-        }
     } else {
         // Select correct starting scene and load resources
         nscene = (init_flags->net_mode == NET_MODE_NONE ? SCENE_OPENOMF : SCENE_MENU);
@@ -228,11 +280,14 @@ int game_state_create(game_state *gs, engine_init_flags *init_flags) {
         }
     }
 
-    random_seed(&gs->rand, time(NULL));
-
     // Initialize scene
     scene_init(gs->sc);
 
+    // Keep snapshots of the recording so that the console can seek in it
+    if(gs->rec != NULL) {
+        game_state_enable_keyframes(gs, REC_KEYFRAME_INTERVAL);
+    }
+
     // All done
     return 0;
 
@@ -245,6 +300,138 @@ error_0:
     return 1;
 }
 
+int game_state_create(game_state *gs, engine_init_flags *init_flags, vga_state *vga) {
+    return game_state_create_with_rec(gs, init_flags, vga, NULL);
+}
+
+int game_state_create_spectator(game_state *gs, engine_init_flags *init_flags, vga_state *vga, sd_rec_file *rec) {
+    return game_state_create_with_rec(gs, init_flags, vga, rec);
+}
+
+void game_state_setup_match_players(game_state *gs, const ai_match_setup *setup) {
+    for(int i = 0; i < 2; i++) {
+        game_player *player = game_state_get_player(gs, i);
+        player->pilot->har_id = setup->har_id[i];
+        chr_score_reset(&player->score, 1);
+
+        pilot pilot_info;
+        pilot_get_info(&pilot_info, setup->pilot_id[i]);
+        player->pilot->endurance = pilot_info.endurance;
+        player->pilot->power = pilot_info.power;
+        player->pilot->agility = pilot_info.agility;
+        sd_pilot_set_player_color(player->pilot, PRIMARY, pilot_info.colors[2]);
+        sd_pilot_set_player_color(player->pilot, SECONDARY, pilot_info.colors[1]);
+        sd_pilot_set_player_color(player->pilot, TERTIARY, pilot_info.colors[0]);
+    }
+}
+
+int game_state_create_ai_match(game_state *gs, engine_init_flags *init_flags, vga_state *vga,
+                               const ai_match_setup *setup) {
+    game_state_init(gs, init_flags, vga);
+    gs->speed = clamp(init_flags->speed, 1, 10) + 5;
+    game_state_match_settings_defaults(gs);
+
+    // Seed before anything is created, everything downstream draws from this.
+    random_seed(&gs->rand, setup->seed);
+
+    int nscene = SCENE_ARENA0 + setup->arena_id;
+    gs->this_id = nscene;
+    gs->next_id = nscene;
+    if(scene_create(gs->sc, gs, nscene)) {
+        log_error("Error while loading scene %d.", nscene);
+        goto error_0;
+    }
+
+    game_state_setup_match_players(gs, setup);
+    for(int i = 0; i < 2; i++) {
+        game_player *player = game_state_get_player(gs, i);
+        controller *ctrl = omf_calloc(1, sizeof(controller));
+        controller_init(ctrl, gs);
+        ai_controller_create(ctrl, setup->difficulty, player->pilot, setup->pilot_id[i]);
+        game_player_set_ctrl(player, ctrl);
+        game_player_set_selectable(player, 0);
+    }
+
+    if(arena_create(gs->sc)) {
+        log_error("Error while creating arena scene.");
+        goto error_1;
+    }
+    scene_init(gs->sc);
+    return 0;
+
+error_1:
+    scene_free(gs->sc);
+error_0:
+    omf_free(gs->sc);
+    vector_free(&gs->objects);
+    vector_free(&gs->sounds);
+    return 1;
+}
+
+void game_state_create_empty(game_state *gs, engine_init_flags *init_flags, vga_state *vga, uint32_t seed) {
+    game_state_init(gs, init_flags, vga);
+    gs->speed = clamp(init_flags->speed, 1, 10) + 5;
+    game_state_match_settings_defaults(gs);
+    random_seed(&gs->rand, seed);
+    gs->this_id = SCENE_NONE;
+    gs->next_id = SCENE_NONE;
+    scene_create_empty(gs->sc, gs, SCENE_NONE);
+}
+
+// Frees everything game_state_init() and a failed game_state_load_rec() leave behind, the same way as
+// game_state_free(). The scene must not be set up. gs itself is left to the caller.
+static void game_state_free_partial(game_state *gs) {
+    render_obj *robj;
+    iterator it;
+    vector_iter_begin(&gs->objects, &it);
+    foreach(it, robj) {
+        object_free(robj->obj);
+        omf_free(robj->obj);
+        vector_delete(&gs->objects, &it);
+    }
+    vector_free(&gs->objects);
+    vector_free(&gs->sounds);
+    render_queue_free(&gs->render_queue);
+    omf_free(gs->sc);
+
+    if(gs->rec) {
+        // Playback hands the pilots of the recording to the players
+        for(int i = 0; i < 2; i++) {
+            if(gs->players[i]->pilot == &gs->rec->pilots[i].info) {
+                gs->players[i]->pilot = NULL;
+            }
+        }
+        sd_rec_free(gs->rec);
+        omf_free(gs->rec);
+    }
+    for(int i = 0; i < 2; i++) {
+        game_player_set_ctrl(gs->players[i], NULL);
+        game_player_free(gs->players[i]);
+        omf_free(gs->players[i]);
+    }
+    omf_free(gs->menu_ctrl);
+}
+
+int game_state_create_replay(game_state *gs, engine_init_flags *init_flags, vga_state *vga, uint32_t seed) {
+    game_state_init(gs, init_flags, vga);
+    gs->speed = clamp(init_flags->speed, 1, 10) + 5;
+    random_seed(&gs->rand, seed);
+    if(game_state_load_rec(gs, init_flags)) {
+        game_state_free_partial(gs);
+        return 1;
+    }
+    scene_init(gs->sc);
+    return 0;
+}
+
+void game_state_enable_keyframes(game_state *gs, uint32_t interval) {
+    if(gs->keyframes == NULL) {
+        gs->keyframes = omf_calloc(1, sizeof(rec_keyframes));
+        rec_keyframes_create(gs->keyframes, interval);
+        rec_keyframes_record(gs->keyframes, gs);
+    }
+}
+
 /*
  * \param game_state gs Game state object
  * \param obj Object to add
@@ -444,72 +631,100 @@ void cross_fade_transform(damage_tracker *damage, vga_palette *pal, void *userda
     damage_set_range(damage, 0, 255);
 }
 
-void game_state_render(game_state *gs) {
-    iterator it;
-    render_obj *robj;
-
-    // Render scene background
-    scene_render(gs->sc);
-
-    // Get har objects
-    object *har[2];
-    har[0] = game_state_find_object(gs, game_state_get_player(gs, 0)->har_obj_id);
-    har[1] = game_state_find_object(gs, game_state_get_player(gs, 1)->har_obj_id);
-
-    // Render BOTTOM layer
-    vector_iter_begin(&gs->objects, &it);
-    foreach(it, robj) {
-        if(robj->layer == RENDER_LAYER_BOTTOM) {
-            if(robj->obj == har[0] || robj->obj == har[1])
-                continue;
-            object_render(robj->obj);
-        }
+static render_slot layer_render_slot(int layer) {
+    switch(layer) {
+        case RENDER_LAYER_BOTTOM:
+            return RENDER_SLOT_BOTTOM;
+        case RENDER_LAYER_MIDDLE:
+            return RENDER_SLOT_MIDDLE;
+        case RENDER_LAYER_TOP:
+            return RENDER_SLOT_TOP;
     }
+    return RENDER_SLOT_COUNT;
+}
 
-    // cast object shadows (scrap, projectiles, etc)
-    vector_iter_begin(&gs->objects, &it);
-    foreach(it, robj) {
-        object_render_shadow(robj->obj);
-    }
+// Queues the draw commands of all objects, and optionally their shadows (scrap, projectiles, etc.)
+static void queue_objects(game_state *gs, render_queue *queue, bool shadows) {
+    iterator it;
+    render_obj *robj;
 
-    // Render passive HARs here
+    // HARs are drawn in their own slots instead of their layer: passive HARs below the middle layer, active
+    // HARs above it. Work the slots out once, so the pass below only needs to compare IDs.
+    uint32_t har_id[2];
+    render_slot har_slot[2];
     for(int i = 0; i < 2; i++) {
-        if(har[i] != NULL && !har_is_active(har[i])) {
-            object_render(har[i]);
+        object *har = game_state_find_object(gs, game_state_get_player(gs, i)->har_obj_id);
+        har_id[i] = har != NULL ? har->id : 0;
+        if(har == NULL) {
+            har_slot[i] = RENDER_SLOT_COUNT;
+        } else if(har_is_active(har)) {
+            har_slot[i] = RENDER_SLOT_ACTIVE_HAR1 + i;
+        } else {
+            har_slot[i] = RENDER_SLOT_PASSIVE_HAR1 + i;
         }
     }
 
-    // Render MIDDLE layer
+    render_queue_clear(queue);
+    video_draw_cmd cmds[OBJECT_SHADOW_CMDS];
     vector_iter_begin(&gs->objects, &it);
     foreach(it, robj) {
-        if(robj->layer == RENDER_LAYER_MIDDLE) {
-            if(robj->obj == har[0] || robj->obj == har[1])
-                continue;
-            object_render(robj->obj);
+        object *obj = robj->obj;
+        render_slot slot = layer_render_slot(robj->layer);
+        if(har_slot[0] != RENDER_SLOT_COUNT && obj->id == har_id[0]) {
+            slot = har_slot[0];
+        } else if(har_slot[1] != RENDER_SLOT_COUNT && obj->id == har_id[1]) {
+            slot = har_slot[1];
         }
-    }
-
-    // Render active HARs here
-    for(int i = 0; i < 2; i++) {
-        if(har[i] != NULL && har_is_active(har[i])) {
-            object_render(har[i]);
+        if(slot != RENDER_SLOT_COUNT && object_draw_cmd(obj, &cmds[0])) {
+            render_queue_add(queue, slot, cmds, 1);
         }
-    }
-
-    // Render TOP layer
-    vector_iter_begin(&gs->objects, &it);
-    foreach(it, robj) {
-        if(robj->layer == RENDER_LAYER_TOP) {
-            if(robj->obj == har[0] || robj->obj == har[1])
-                continue;
-            object_render(robj->obj);
+        if(shadows) {
+            render_queue_add(queue, RENDER_SLOT_SHADOWS, cmds, object_shadow_draw_cmds(obj, cmds));
         }
     }
+}
+
+void game_state_render(game_state *gs) {
+    // Render scene background
+    scene_render(gs->sc);
+
+    queue_objects(gs, &gs->render_queue, true);
+    render_queue_draw(&gs->render_queue);
 
     // Render scene overlay (menus, etc.)
     scene_render_overlay(gs->sc);
 }
 
+void game_state_render_to_surface(game_state *gs, surface *dst, int x, int y, int w, int h) {
+    // Same draw commands as game_state_render, minus the shadows and the scene overlay, drawn with the CPU
+    // framebuffer instead of the renderer.
+    soft_framebuffer fb;
+    soft_framebuffer_create(&fb, w, h);
+    memcpy(&fb.remaps, vga_state_get_remaps(gs->vga), sizeof(vga_remap_tables));
+    SDL_Rect rect;
+
+    // Scene background. Empty scenes have none.
+    if(gs->sc->bk_data != NULL) {
+        const surface *background = &gs->sc->bk_data->background;
+        rect = (SDL_Rect){-x, -y, background->w, background->h};
+        soft_framebuffer_draw(&fb, background, &rect, 0, 0, 0, 255, 255, FLIP_NONE, 0);
+    }
+
+    queue_objects(gs, &gs->render_queue, false);
+    const video_draw_cmd *cmds = render_queue_sort(&gs->render_queue);
+    for(int i = 0; i < gs->render_queue.count; i++) {
+        const video_draw_cmd *cmd = &cmds[i];
+        rect = cmd->dst;
+        rect.x -= x;
+        rect.y -= y;
+        soft_framebuffer_draw(&fb, cmd->src, &rect, cmd->remap_offset, cmd->remap_rounds, cmd->palette_offset,
+                              cmd->palette_limit, cmd->opacity, cmd->flip_mode, cmd->options);
+    }
+    surface_create(dst, w, h);
+    soft_framebuffer_resolve(&fb, gs->vga, 0, 0, dst->data);
+    soft_framebuffer_free(&fb);
+}
+
 void game_state_palette_transform(game_state *gs) {
     // object transforms
     render_obj *robj;
@@ -521,7 +736,7 @@ void game_state_palette_transform(game_state *gs) {
 
     // Cross-fade effect
     if(gs->next_wait_ticks > 0 || gs->this_wait_ticks > 0) {
-        vga_state_enable_palette_transform(cross_fade_transform, gs);
+        vga_state_enable_palette_transform(gs->vga, cross_fade_transform, gs);
     }
 }
 
@@ -555,8 +770,8 @@ int game_load_new(game_state *gs, int scene_id) {
         }
     }
 
-    // Free texture items, we are going to create new ones.
-    video_signal_scene_change();
+    // Let the engine free texture items, we are going to create new ones.
+    gs->host.scene_changed = true;
 
     gs->this_id = scene_id;
     gs->next_id = scene_id;
@@ -723,13 +938,12 @@ void game_state_dyntick_controllers(game_state *gs) {
     }
 }
 
-void game_state_ctrl_events_free(game_state *gs) {
+void game_state_ctrl_events_clear(game_state *gs) {
     for(int i = 0; i < game_state_num_players(gs); i++) {
         game_player *gp = game_state_get_player(gs, i);
         controller *c = game_player_get_ctrl(gp);
         if(c) {
-            controller_free_chain(c->extra_events);
-            c->extra_events = NULL;
+            ctrl_events_clear(&c->extra_events);
         }
     }
 }
@@ -767,6 +981,11 @@ void game_state_merge_sounds(game_state *old, game_state *new) {
     // * Fade out any sounds only playing in the old state
     // * Fade in any new sounds, and start playing them at the appropriate offset
 
+    if(!new->host.audio) {
+        // Nothing was ever passed to the audio backend
+        return;
+    }
+
     playing_sound *s, *s2;
     iterator it, it2;
     vector_iter_begin(&old->sounds, &it);
@@ -814,7 +1033,7 @@ void game_state_merge_sounds(game_state *old, game_state *new) {
             int offset = elapsed_ms * 8 * clampf(s->pitch, PITCH_MIN, PITCH_MAX);
 
             // Load sample (8000Hz, mono, 8bit)
-            char *src_buf;
+            const char *src_buf;
             int src_len;
             if(!sounds_loader_get(s->id, &src_buf, &src_len)) {
                 log_error("Requested sound sample %d not found", s->id);
@@ -851,7 +1070,7 @@ void game_state_static_tick(game_state *gs, bool replay) {
     }
 
     // We want to load another scene
-    if(gs->this_id != gs->next_id && (gs->next_wait_ticks <= 1 || !settings_get()->video.crossfade_on)) {
+    if(gs->this_id != gs->next_id && (gs->next_wait_ticks <= 1 || !gs->host.crossfade)) {
         // If this is the end, set run to 0 so that engine knows to close here
         if(gs->next_id == SCENE_NONE) {
             log_debug("Next ID is SCENE_NONE! bailing.");
@@ -865,7 +1084,7 @@ void game_state_static_tick(game_state *gs, bool replay) {
             gs->run = 0;
             return;
         }
-        if(settings_get()->video.crossfade_on) {
+        if(gs->host.crossfade) {
             gs->this_wait_ticks = FRAME_WAIT_TICKS;
         } else {
             gs->this_wait_ticks = 0;
@@ -910,7 +1129,8 @@ void game_state_dynamic_tick(game_state *gs, bool replay) {
     if((gs->screen_shake_horizontal > 0 || gs->screen_shake_vertical > 0) && !replay) {
         float shake_x = sin(gs->screen_shake_horizontal) * 5 * ((float)gs->screen_shake_horizontal / 15);
         float shake_y = sin(gs->screen_shake_vertical) * 5 * ((float)gs->screen_shake_vertical / 15);
-        video_move_target((int)shake_x, (int)shake_y);
+        gs->host.screen_offset_x = (int)shake_x;
+        gs->host.screen_offset_y = (int)shake_y;
         for(int i = 0; i < game_state_num_players(gs); i++) {
             game_player *gp = game_state_get_player(gs, i);
             controller *c = game_player_get_ctrl(gp);
@@ -924,7 +1144,8 @@ void game_state_dynamic_tick(game_state *gs, bool replay) {
     } else {
         // XXX Occasionally the screen does not return back to normal position
         if(!replay) {
-            video_move_target(0, 0);
+            gs->host.screen_offset_x = 0;
+            gs->host.screen_offset_y = 0;
         }
     }
 
@@ -935,23 +1156,31 @@ void game_state_dynamic_tick(game_state *gs, bool replay) {
     // Tick scene
     scene_dynamic_tick(gs->sc, game_state_is_paused(gs));
 
-    // Poll input. If console is opened, do not poll the controllers.
-    if(!console_window_is_open() && !replay) {
+    // Poll input. If the host blocks input (eg. console is opened), do not poll the controllers.
+    if(!gs->host.input_blocked && !replay) {
         scene_input_poll(gs->sc);
     }
 
     if(!game_state_is_paused(gs)) {
         // Clean up objects
+        profiler_begin(PROFILE_CLEANUP);
         game_state_cleanup(gs);
+        profiler_end(PROFILE_CLEANUP);
 
         // Call object_move for all objects
+        profiler_begin(PROFILE_MOVE);
         game_state_call_move(gs);
+        profiler_end(PROFILE_MOVE);
 
         // Handle physics for all pairs of objects
+        profiler_begin(PROFILE_COLLIDE);
         game_state_call_collide(gs);
+        profiler_end(PROFILE_COLLIDE);
 
         // Tick all objects
+        profiler_begin(PROFILE_TICK);
         game_state_call_tick(gs, TICK_DYNAMIC);
+        profiler_end(PROFILE_TICK);
 
         // Increment tick
         gs->tick++;
@@ -959,7 +1188,10 @@ void game_state_dynamic_tick(game_state *gs, bool replay) {
 
     if(!replay) {
         // Free extra controller events
-        game_state_ctrl_events_free(gs);
+        game_state_ctrl_events_clear(gs);
+
+        // Keep the part of the pace that did not add up to a whole millisecond for the next tick
+        gs->pace_carry = (gs->pace_carry + gs->pace_us) % 1000;
     }
 
     // Speed back up
@@ -973,6 +1205,10 @@ void game_state_dynamic_tick(game_state *gs, bool replay) {
 
     // int_tick is used for ping calculation so it shouldn't be touched
     gs->int_tick++;
+
+    if(gs->keyframes != NULL) {
+        rec_keyframes_record(gs->keyframes, gs);
+    }
 }
 
 unsigned int game_state_get_tick(game_state *gs) {
@@ -1100,7 +1336,7 @@ void game_state_init_demo(game_state *gs) {
     }
 }
 
-void game_state_menu_poll(game_state *gs, ctrl_event **ev) {
+void game_state_menu_poll(game_state *gs, ctrl_events *ev) {
     gs->menu_ctrl->last = gs->menu_ctrl->current;
     gs->menu_ctrl->current = 0;
     // poll keyboard
@@ -1121,6 +1357,7 @@ void game_state_clone_free(game_state *gs) {
     }
     vector_free(&gs->objects);
     vector_free(&gs->sounds);
+    render_queue_free(&gs->render_queue);
 
     // Free scene
     scene_clone_free(gs->sc);
@@ -1150,6 +1387,7 @@ void game_state_free(game_state **_gs) {
     }
     vector_free(&gs->objects);
     vector_free(&gs->sounds);
+    render_queue_free(&gs->render_queue);
 
     // Free scene
     scene_free(gs->sc);
@@ -1159,6 +1397,10 @@ void game_state_free(game_state **_gs) {
         sd_rec_free(gs->rec);
         omf_free(gs->rec);
     }
+    if(gs->keyframes) {
+        rec_keyframes_free(gs->keyframes);
+        omf_free(gs->keyframes);
+    }
 
     if(gs->init_flags->playback == 1) {
         gs->players[0]->pilot = NULL;
@@ -1194,6 +1436,14 @@ int game_state_ms_per_dyntick(game_state *gs) {
     return STATIC_TICKS;
 }
 
+int game_state_dyntick_wait(game_state *gs) {
+    int ms = game_state_ms_per_dyntick(gs);
+    if(gs->pace_us == 0 || gs->warp_speed) {
+        return ms;
+    }
+    return max2(ms + (gs->pace_carry + gs->pace_us) / 1000, 1);
+}
+
 int render_obj_clone(render_obj *src, render_obj *dst, game_state *gs) {
     memcpy(dst, src, sizeof(render_obj));
     dst->obj = omf_calloc(1, sizeof(object));
@@ -1217,7 +1467,7 @@ void game_state_play_sound(game_state *gs, int id, float volume, float panning,
         return;
 
     // Load sample (8000Hz, mono, 8bit)
-    char *src_buf;
+    const char *src_buf;
     int src_len;
     if(!sounds_loader_get(id, &src_buf, &src_len)) {
         log_error("Requested sound sample %d not found", id);
@@ -1238,8 +1488,8 @@ void game_state_play_sound(game_state *gs, int id, float volume, float panning,
     s.pitch = pitch;
     s.playback_id = -1;
 
-    if(!gs->clone) {
-        // do not actually begin playback if this is a cloned game state
+    if(!gs->clone && gs->host.audio) {
+        // do not actually begin playback if this is a cloned or headless game state
         // cloned game states that are promoted to the active game state
         // will have this flag removed
         s.playback_id = audio_play_sound_buf(src_buf, src_len, volume, panning, pitch, 0);
@@ -1252,16 +1502,32 @@ void game_state_play_sound(game_state *gs, int id, float volume, float panning,
     vector_append(&gs->sounds, &s);
 }
 
-int game_state_clone(game_state *src, game_state *dst) {
+void game_state_play_music(game_state *gs, resource_id id) {
+    if(gs->host.audio) {
+        audio_play_music(id);
+    }
+}
+
+void game_state_stop_music(game_state *gs) {
+    if(gs->host.audio) {
+        audio_stop_music();
+    }
+}
+
+// First half of a clone: the static fields, and empty containers for the volatile data.
+static void game_state_clone_begin(game_state *src, game_state *dst) {
     // copy all the static fields
     memcpy(dst, src, sizeof(game_state));
     // fix any pointers to volatile data
     vector_create(&dst->objects, sizeof(render_obj));
     vector_create(&dst->sounds, sizeof(playing_sound));
+    render_queue_create(&dst->render_queue);
 
     dst->next_wait_ticks = 0;
     dst->this_wait_ticks = 0;
+}
 
+static void game_state_clone_objects(game_state *src, game_state *dst) {
     iterator it;
     vector_iter_begin(&src->objects, &it);
     render_obj *robj;
@@ -1270,7 +1536,12 @@ int game_state_clone(game_state *src, game_state *dst) {
         render_obj_clone(robj, &d, dst);
         vector_append(&dst->objects, &d);
     }
+}
 
+// Second half of a clone: everything but the objects. The objects must be in place already, as the scene
+// looks up its HARs while it is cloned.
+static void game_state_clone_end(game_state *src, game_state *dst) {
+    iterator it;
     vector_iter_begin(&src->sounds, &it);
     playing_sound *s;
     while((s = iter_next(&it)) != NULL) {
@@ -1290,10 +1561,114 @@ int game_state_clone(game_state *src, game_state *dst) {
     dst->new_state = NULL;
 
     dst->clone = true;
+}
 
+int game_state_clone(game_state *src, game_state *dst) {
+    game_state_clone_begin(src, dst);
+    game_state_clone_objects(src, dst);
+    game_state_clone_end(src, dst);
     return 0;
 }
 
+int game_state_clone_shell(game_state *src, game_state *dst) {
+    game_state_clone_begin(src, dst);
+    game_state_clone_end(src, dst);
+    return 0;
+}
+
+bool game_state_same_objects(game_state *a, game_state *b) {
+    if(vector_size(&a->objects) != vector_size(&b->objects)) {
+        return false;
+    }
+    for(unsigned int i = 0; i < vector_size(&a->objects); i++) {
+        render_obj *ra = vector_get(&a->objects, i);
+        render_obj *rb = vector_get(&b->objects, i);
+        if(ra->obj->id != rb->obj->id) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void game_state_serialize_objects(game_state *gs, serial *ser) {
+    serial_write_uint32(ser, vector_size(&gs->objects));
+    iterator it;
+    vector_iter_begin(&gs->objects, &it);
+    render_obj *robj;
+    foreach(it, robj) {
+        serial_write_uint32(ser, robj->obj->id);
+    }
+    vector_iter_begin(&gs->objects, &it);
+    foreach(it, robj) {
+        object_serialize(robj->obj, ser);
+    }
+}
+
+int game_state_unserialize_objects(game_state *gs, serial *ser) {
+    // Check that the objects match before touching any of them
+    uint32_t count = serial_read_uint32(ser);
+    if(count != vector_size(&gs->objects)) {
+        return 1;
+    }
+    for(unsigned int i = 0; i < count; i++) {
+        render_obj *robj = vector_get(&gs->objects, i);
+        if(serial_read_uint32(ser) != robj->obj->id) {
+            return 1;
+        }
+    }
+    iterator it;
+    vector_iter_begin(&gs->objects, &it);
+    render_obj *robj;
+    foreach(it, robj) {
+        if(object_unserialize(robj->obj, ser)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int game_state_restore(game_state *shell, game_state *base, serial *objects, game_state *dst) {
+    game_state_clone_begin(shell, dst);
+    game_state_clone_objects(base, dst);
+    game_state_clone_end(shell, dst);
+    serial_read_reset(objects);
+    return game_state_unserialize_objects(dst, objects);
+}
+
+void game_state_reclone(game_state *src, game_state *dst) {
+    if(!game_state_same_objects(src, dst)) {
+        game_state_clone_free(dst);
+        game_state_clone(src, dst);
+        return;
+    }
+
+    serial ser;
+    serial_create(&ser);
+    game_state_serialize_objects(src, &ser);
+
+    // Keep the objects of dst, and clone the rest anew around them
+    vector objects = dst->objects;
+    vector_create(&dst->objects, sizeof(render_obj));
+    game_state_clone_free(dst);
+    game_state_clone_begin(src, dst);
+    vector_free(&dst->objects);
+    dst->objects = objects;
+    iterator it;
+    vector_iter_begin(&dst->objects, &it);
+    render_obj *robj;
+    foreach(it, robj) {
+        robj->obj->gs = dst;
+    }
+    game_state_clone_end(src, dst);
+
+    if(game_state_unserialize_objects(dst, &ser)) {
+        log_debug("Unable to restore the objects in place, cloning them");
+        game_state_clone_free(dst);
+        game_state_clone(src, dst);
+    }
+    serial_free(&ser);
+}
+
 bool is_netplay(game_state *gs) {
     return game_state_get_player(gs, 0)->ctrl->type == CTRL_TYPE_NETWORK ||
            game_state_get_player(gs, 1)->ctrl->type == CTRL_TYPE_NETWORK;
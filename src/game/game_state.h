@@ -3,22 +3,50 @@
 
 #include "game/game_state_type.h"
 #include "game/utils/serial.h"
+#include "resources/ids.h"
 #include "utils/random.h"
 #include "utils/vector.h"
+#include "video/surface.h"
 #include <SDL.h>
 #include <stdbool.h>
 
 typedef struct scene_t scene;
 typedef struct game_player_t game_player;
 typedef struct object_t object;
-typedef struct ctrl_event_t ctrl_event;
+typedef struct ctrl_events_t ctrl_events;
+
+// Describes a match between two AI controlled players. Used by headless tools.
+typedef struct ai_match_setup {
+    uint32_t seed;  // Seed for the match random state; same seed gives the same match
+    int arena_id;   // 0 ... 4
+    int difficulty; // AI_DIFFICULTY_*
+    int pilot_id[2];
+    int har_id[2];
+} ai_match_setup;
 
 void game_state_match_settings_reset(game_state *gs);
 void game_state_match_settings_defaults(game_state *gs);
-int game_state_create(game_state *gs, engine_init_flags *init_flags);
+int game_state_create(game_state *gs, engine_init_flags *init_flags, vga_state *vga);
+int game_state_create_ai_match(game_state *gs, engine_init_flags *init_flags, vga_state *vga,
+                               const ai_match_setup *setup);
+// Sets up the pilots and HARs of both players from a match setup. Controllers are left to the caller.
+void game_state_setup_match_players(game_state *gs, const ai_match_setup *setup);
+// Creates a game state that plays back a match as it is relayed to a spectator. Takes ownership of rec.
+int game_state_create_spectator(game_state *gs, engine_init_flags *init_flags, vga_state *vga, sd_rec_file *rec);
+// Creates a game state with an empty scene and nothing loaded from disk. Objects must be added by the caller.
+void game_state_create_empty(game_state *gs, engine_init_flags *init_flags, vga_state *vga, uint32_t seed);
+// Creates a headless game state that plays back init_flags->rec_file. Playback must be set in init_flags.
+// Legacy recordings do not store the match seed; for those it has to be supplied by the caller.
+int game_state_create_replay(game_state *gs, engine_init_flags *init_flags, vga_state *vga, uint32_t seed);
+// Starts taking snapshots of a REC playback every interval ticks, so that it can be seeked with rec_keyframes_seek.
+void game_state_enable_keyframes(game_state *gs, uint32_t interval);
+void game_state_sync_settings(game_state *gs);
 void game_state_free(game_state **gs);
 int game_state_handle_event(game_state *gs, SDL_Event *event);
 void game_state_render(game_state *gs);
+// Creates dst as a w * h surface, and draws the scene and its objects into it on the CPU, with (x, y) being the
+// screen position of dst's top left corner. Shadows and the UI are left out. Works without a renderer.
+void game_state_render_to_surface(game_state *gs, surface *dst, int x, int y, int w, int h);
 void game_state_palette_transform(game_state *gs);
 void game_state_debug(game_state *gs);
 void game_state_static_tick(game_state *gs, bool replay);
@@ -34,22 +62,47 @@ game_player *game_state_get_player(const game_state *gs, int player_id);
 int game_state_num_players(game_state *gs);
 void game_state_init_demo(game_state *gs);
 int game_state_ms_per_dyntick(game_state *gs);
+// Wall clock time to wait for the next dynamic tick, which is ms_per_dyntick stretched by the netplay pace
+int game_state_dyntick_wait(game_state *gs);
 ticktimer *game_state_get_ticktimer(game_state *gs);
 
 object *game_state_find_object(game_state *gs, uint32_t object_id);
 
 // used to play sounds that may be subject to rollback (eg sounds from player.c, HAR and arena)
 void game_state_play_sound(game_state *gs, int id, float volume, float panning, float pitch);
+void game_state_play_music(game_state *gs, resource_id id);
+void game_state_stop_music(game_state *gs);
 
 int game_state_clone(game_state *src, game_state *dst);
 void game_state_clone_free(game_state *gs);
 
+// Clones everything but the objects. Free with game_state_clone_free().
+int game_state_clone_shell(game_state *src, game_state *dst);
+
+// Returns true if both game states hold the same objects, by id and in the same order.
+bool game_state_same_objects(game_state *a, game_state *b);
+
+// Writes the state of all objects with object_serialize(), preceded by their ids.
+void game_state_serialize_objects(game_state *gs, serial *ser);
+
+// Restores the object state written by game_state_serialize_objects(). gs must hold the same objects.
+// Returns 1 if it does not, or an object could not be restored; in the latter case gs is partly restored.
+int game_state_unserialize_objects(game_state *gs, serial *ser);
+
+// Makes dst a clone of the shell from game_state_clone_shell(), with the objects of base cloned into it and
+// their state restored from objects. Returns 1 if the objects could not be restored; dst must still be freed.
+int game_state_restore(game_state *shell, game_state *base, serial *objects, game_state *dst);
+
+// Makes dst, a clone of an earlier state, a clone of src. When both hold the same objects, the objects of dst
+// are kept and their state is restored from src; otherwise they are cloned anew.
+void game_state_reclone(game_state *src, game_state *dst);
+
 void _setup_keyboard(game_state *gs, int player_id);
 void _setup_ai(game_state *gs, int player_id);
 int _setup_joystick(game_state *gs, int player_id, const char *joyname, int offset);
 void reconfigure_controller(game_state *gs);
 
-void game_state_menu_poll(game_state *gs, ctrl_event **ev);
+void game_state_menu_poll(game_state *gs, ctrl_events *ev);
 
 int game_state_rewind(game_state *gs, int rtt);
 void game_state_replay(game_state *gs, int rtt);
@@ -6,9 +6,11 @@
 #include "engine.h"
 #include "formats/rec.h"
 #include "game/protos/fight_stats.h"
+#include "game/utils/render_queue.h"
 #include "game/utils/settings.h"
 #include "utils/random.h"
 #include "utils/vector.h"
+#include "video/vga_state.h"
 
 enum
 {
@@ -54,6 +56,24 @@ typedef struct {
     bool sim;
 } match_settings;
 
+// Connects the simulation to the host application. The engine fills in the inputs before ticking and applies the
+// outputs afterwards, so the tick functions never need to touch the global video, audio, console or settings state.
+typedef struct {
+    // Inputs
+    bool crossfade;     // Crossfade between scenes
+    bool input_blocked; // Do not poll controllers, eg. while the console is open
+    bool audio;         // Pass sounds and music to the audio backend
+    float sound_volume; // Sound effect volume, 0.0 ... 1.0
+
+    // Outputs
+    int screen_offset_x; // Screen shake offset
+    int screen_offset_y;
+    bool scene_changed; // A new scene was loaded since the engine last looked
+} game_host;
+
+// Snapshots for seeking in REC playback, see game/utils/rec_keyframes.h
+typedef struct rec_keyframes rec_keyframes;
+
 typedef struct game_state_t {
     unsigned int run;
     unsigned int paused;
@@ -82,9 +102,6 @@ typedef struct game_state_t {
     int next_wait_ticks;
     int this_wait_ticks;
 
-    // Newsroom HAR screencaps
-    bool hide_ui;
-
     // For debugging, sets fastest possible mode :)
     int warp_speed;
 
@@ -94,15 +111,29 @@ typedef struct game_state_t {
     vector sounds;
     game_player *players[2];
 
+    // Draw commands of the frame being rendered
+    render_queue render_queue;
+
     fight_stats fight_stats;
     void *new_state;
     bool clone;
     int delay;
+    int pace_us;    // netplay: microseconds added to every dynamic tick, negative to run faster
+    int pace_carry; // microseconds of pace left over from earlier ticks
     struct random_t rand;
 
     sd_rec_file *rec;
+    rec_keyframes *keyframes;
 
     controller *menu_ctrl;
+
+    // Palette state this game state draws into. Not owned; clones share the same instance.
+    vga_state *vga;
+
+    game_host host;
+
+    // Next free object ID
+    uint32_t next_object_id;
 } game_state;
 
 #endif // GAME_STATE_TYPE_H
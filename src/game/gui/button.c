@@ -33,6 +33,7 @@ void button_set_border(component *c, vga_index border_color) {
     int width = text_width(&tb->tconf, tb->text);
     menu_background_border_create(&tb->border, width + 6, fsize + 3, border_color);
     tb->border_created = 1;
+    component_mark_dirty(c);
 }
 
 void button_set_text(component *c, const char *text) {
@@ -42,6 +43,7 @@ void button_set_text(component *c, const char *text) {
     }
     tb->text = omf_strdup(text);
     component_set_size_hints(c, text_width(&tb->tconf, text), 10);
+    component_mark_dirty(c);
 }
 
 static void button_render(component *c) {
@@ -107,6 +109,7 @@ component *button_create(const text_settings *tconf, const char *text, const cha
     widget_set_render_cb(c, button_render);
     widget_set_action_cb(c, button_action);
     widget_set_free_cb(c, button_free);
+    component_set_retained(c, true);
 
     return c;
 }
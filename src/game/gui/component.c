@@ -4,6 +4,13 @@
 #include "utils/allocator.h"
 #include "utils/log.h"
 
+// Retained rendering: a retained component records its draws, and submits them again without calling
+// the render callback until something marks it dirty. Layout is skipped for components whose area did
+// not change, unless something below them was marked layout dirty.
+static bool retained_mode = true;
+static unsigned int rendered_count = 0;
+static unsigned int replayed_count = 0;
+
 void component_tick(component *c) {
     if(c->tick) {
         c->tick(c);
@@ -11,13 +18,31 @@ void component_tick(component *c) {
 }
 
 void component_render(component *c) {
-    if(c->render) {
+    if(c->render == NULL) {
+        return;
+    }
+    if(!retained_mode || !c->retained) {
         c->render(c);
+        return;
     }
+    if(!c->dirty) {
+        video_draw_batch(c->draws.cmds, c->draws.count);
+        replayed_count++;
+        return;
+    }
+    if(video_record_begin(&c->draws)) {
+        c->render(c);
+        video_record_end();
+        c->dirty = false;
+    } else {
+        c->render(c);
+    }
+    rendered_count++;
 }
 
 int component_event(component *c, SDL_Event *event) {
     if(c->event) {
+        component_mark_dirty(c);
         return c->event(c, event);
     }
     return 1;
@@ -25,16 +50,25 @@ int component_event(component *c, SDL_Event *event) {
 
 int component_action(component *c, int action) {
     if(c->action) {
+        component_mark_dirty(c);
         return c->action(c, action);
     }
     return 1;
 }
 
 void component_layout(component *c, int x, int y, int w, int h) {
+    bool moved = c->x != x || c->y != y || c->w != w || c->h != h;
+    if(retained_mode && !moved && !c->layout_dirty) {
+        return;
+    }
+    if(moved) {
+        c->dirty = true;
+    }
     c->x = x;
     c->y = y;
     c->w = w;
     c->h = h;
+    c->layout_dirty = false;
     if(c->layout) {
         c->layout(c, x, y, w, h);
     }
@@ -43,18 +77,28 @@ void component_layout(component *c, int x, int y, int w, int h) {
 void component_disable(component *c, int disabled) {
     if(!c->supports_disable)
         return;
-    c->is_disabled = (disabled != 0) ? 1 : 0;
+    int is_disabled = (disabled != 0) ? 1 : 0;
+    if(c->is_disabled != is_disabled) {
+        // Sizers may lay out differently around disabled components
+        component_mark_layout_dirty(c);
+    }
+    c->is_disabled = is_disabled;
 }
 
 void component_select(component *c, int selected) {
     if(!c->supports_select)
         return;
-    c->is_selected = (selected != 0) ? 1 : 0;
+    int is_selected = (selected != 0) ? 1 : 0;
+    if(c->is_selected != is_selected) {
+        component_mark_dirty(c);
+    }
+    c->is_selected = is_selected;
 }
 
 void component_focus(component *c, int focused) {
     if(!c->supports_focus)
         return;
+    component_mark_dirty(c);
     c->is_focused = (focused != 0) ? 1 : 0;
     if(c->focus) {
         c->focus(c, c->is_focused == 1);
@@ -87,11 +131,17 @@ int component_is_focused(const component *c) {
 }
 
 void component_set_size_hints(component *c, int w, int h) {
+    if(c->w_hint != w || c->h_hint != h) {
+        component_mark_layout_dirty(c);
+    }
     c->w_hint = w;
     c->h_hint = h;
 }
 
 void component_set_pos_hints(component *c, int x, int y) {
+    if(c->x_hint != x || c->y_hint != y) {
+        component_mark_layout_dirty(c);
+    }
     c->x_hint = x;
     c->y_hint = y;
 }
@@ -144,6 +194,36 @@ void component_set_help_text(component *c, const char *help) {
     c->help = help;
 }
 
+void component_set_retained(component *c, bool retained) {
+    c->retained = retained;
+    c->dirty = true;
+}
+
+void component_mark_dirty(component *c) {
+    c->dirty = true;
+}
+
+void component_mark_layout_dirty(component *c) {
+    c->dirty = true;
+    // Walk all the way up; not every sizer lays out all of its children, eg. menus and their submenus.
+    for(component *p = c; p != NULL; p = p->parent) {
+        p->layout_dirty = true;
+    }
+}
+
+void component_set_retained_mode(bool enabled) {
+    retained_mode = enabled;
+}
+
+bool component_get_retained_mode(void) {
+    return retained_mode;
+}
+
+void component_get_render_counts(unsigned int *rendered, unsigned int *replayed) {
+    *rendered = rendered_count;
+    *replayed = replayed_count;
+}
+
 component *component_create(void) {
     component *c = omf_calloc(1, sizeof(component));
     c->header = 0; // By default, this is unset.
@@ -153,6 +233,8 @@ component *component_create(void) {
     c->h_hint = -1;
     c->help = NULL;
     c->filler = false;
+    c->dirty = true;
+    c->layout_dirty = true;
     return c;
 }
 
@@ -163,5 +245,6 @@ void component_free(component *c) {
     if(c->free != NULL) {
         c->free(c);
     }
+    video_draw_list_free(&c->draws);
     omf_free(c);
 }
@@ -10,6 +10,7 @@
 #define COMPONENT_H
 
 #include "controller/controller.h"
+#include "video/video.h"
 #include <SDL.h>
 
 enum
@@ -68,6 +69,11 @@ struct component {
     const char *help;    ///< Help text, if available
     bool filler;         ///< Whether the component should fill unused space during layout
 
+    bool retained;         ///< Whether the draws of the component can be reused until it is marked dirty.
+    bool dirty;            ///< Whether the component must be rendered again instead of reusing the draws.
+    bool layout_dirty;     ///< Whether the component or something below it needs to be laid out again.
+    video_draw_list draws; ///< Draws made by the last render, if retained.
+
     component_render_cb render; ///< Render function callback. This tells the component to draw itself.
     component_event_cb event;   ///< Event function callback. Direct SDL2 event handler.
     component_action_cb action; ///< Action function callback. Handles OpenOMF abstract key events.
@@ -107,6 +113,14 @@ void component_set_pos_hints(component *c, int x, int y);
 
 void component_set_help_text(component *c, const char *help);
 
+// Retained rendering & layout caching
+void component_set_retained(component *c, bool retained);
+void component_mark_dirty(component *c);
+void component_mark_layout_dirty(component *c);
+void component_set_retained_mode(bool enabled);
+bool component_get_retained_mode(void);
+void component_get_render_counts(unsigned int *rendered, unsigned int *replayed);
+
 // ID lookup stuff
 component *component_find(component *c, int id);
 
@@ -8,5 +8,6 @@ component *filler_create(void) {
     c->supports_select = 0;
     c->supports_focus = 0;
     c->filler = true;
+    component_set_retained(c, true);
     return c;
 }
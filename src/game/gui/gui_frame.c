@@ -1,4 +1,5 @@
 #include "game/gui/gui_frame.h"
+#include "game/utils/profiler.h"
 #include "utils/allocator.h"
 
 typedef struct gui_frame {
@@ -68,7 +69,9 @@ void gui_frame_tick(gui_frame *frame) {
 
 void gui_frame_render(gui_frame *frame) {
     if(frame->root_node) {
+        profiler_begin(PROFILE_GUI);
         component_render(frame->root_node);
+        profiler_end(PROFILE_GUI);
     }
 }
 
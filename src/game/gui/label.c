@@ -25,10 +25,13 @@ void label_set_text(component *c, const char *text) {
         omf_free(local->text);
     }
     local->text = omf_strdup(text);
+    component_mark_dirty(c);
 }
 
 text_settings *label_get_text_settings(component *c) {
     label *local = widget_get_obj(c);
+    // Caller may change the settings through the pointer
+    component_mark_dirty(c);
     return &local->tconf;
 }
 
@@ -53,6 +56,7 @@ component *label_create_with_width(const text_settings *tconf, const char *text,
     widget_set_obj(c, local);
     widget_set_render_cb(c, label_render);
     widget_set_free_cb(c, label_free);
+    component_set_retained(c, true);
 
     return c;
 }
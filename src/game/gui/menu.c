@@ -349,11 +349,13 @@ void menu_set_tick_cb(component *c, menu_tick_cb cb) {
 void menu_set_horizontal(component *c, bool horizontal) {
     menu *m = sizer_get_obj(c);
     m->horizontal = horizontal;
+    component_mark_layout_dirty(c);
 }
 
 void menu_set_centered(component *c, bool centered) {
     menu *m = sizer_get_obj(c);
     m->centered = centered;
+    component_mark_layout_dirty(c);
 }
 
 void menu_set_background(component *c, bool background) {
@@ -412,11 +414,13 @@ static component *menu_find(component *c, int id) {
 void menu_set_margin_top(component *c, int margin) {
     menu *m = sizer_get_obj(c);
     m->margin_top = margin;
+    component_mark_layout_dirty(c);
 }
 
 void menu_set_padding(component *c, int padding) {
     menu *m = sizer_get_obj(c);
     m->padding = padding;
+    component_mark_layout_dirty(c);
 }
 
 component *menu_create(int obj_h) {
@@ -1,11 +1,8 @@
 #include "game/gui/portrait.h"
-#include "formats/error.h"
-#include "formats/pic.h"
 #include "game/gui/widget.h"
-#include "resources/pathmanager.h"
+#include "resources/pic_loader.h"
 #include "resources/sprite.h"
 #include "utils/allocator.h"
-#include "utils/log.h"
 #include "video/video.h"
 
 // Local small gauge type
@@ -31,32 +28,7 @@ static void portrait_free(component *c) {
 }
 
 int portrait_load(sd_sprite *s, vga_palette *pal, int pic_id, int pilot_id) {
-    const char *filename = pm_get_resource_path(pic_id);
-    if(filename == NULL) {
-        log_error("Could not find requested PIC file handle.");
-        return SD_FILE_OPEN_ERROR;
-    }
-
-    // Load PIC file and make a surface
-    sd_pic_file pics;
-    sd_pic_create(&pics);
-    int ret = sd_pic_load(&pics, filename);
-    if(ret != SD_SUCCESS) {
-        log_error("Could not load PIC file %s: %s", filename, sd_get_error(ret));
-        return ret;
-    } else {
-        log_debug("PIC file %s loaded, selecting picture %d.", get_resource_name(pic_id), pilot_id);
-    }
-
-    sd_sprite_free(s);
-    // Create new
-    const sd_pic_photo *photo = sd_pic_get(&pics, pilot_id);
-    sd_sprite_copy(s, photo->sprite);
-    palette_copy(pal, &photo->pal, 0, 48);
-    // Free pics
-    sd_pic_free(&pics);
-
-    return SD_SUCCESS;
+    return load_pic_photo(s, pal, NULL, pic_id, pilot_id);
 }
 
 void portrait_select(component *c, int pic_id, int pilot_id) {
@@ -72,9 +44,10 @@ void portrait_select(component *c, int pic_id, int pilot_id) {
     sd_sprite spr;
     sd_sprite_create(&spr);
     vga_palette pal;
-    portrait_load(&spr, &pal, pic_id, pilot_id);
+    sprite_bake bake;
+    load_pic_photo(&spr, &pal, &bake, pic_id, pilot_id);
 
-    sprite_create(local->img, &spr, -1);
+    sprite_create_baked(local->img, &spr, -1, &bake);
     sd_sprite_free(&spr);
 
     // Position and size hints for the gui component
@@ -113,6 +113,7 @@ void sizer_attach(component *c, component *nc) {
     sizer *local = component_get_obj(c);
     nc->parent = c;
     vector_append(&local->objs, &nc);
+    component_mark_layout_dirty(c);
 }
 
 static void sizer_tick(component *c) {
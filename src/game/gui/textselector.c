@@ -15,6 +15,7 @@ typedef struct textselector {
     int dir;
     int pos_;
     int *pos;
+    int rendered_pos;
     vector options;
 
     void *userdata;
@@ -34,12 +35,14 @@ void textselector_clear_options(component *c) {
 
     // Clear vector
     vector_clear(&tb->options);
+    component_mark_dirty(c);
 }
 
 void textselector_add_option(component *c, const char *value) {
     textselector *tb = widget_get_obj(c);
     char *new = omf_strdup(value);
     vector_append(&tb->options, &new);
+    component_mark_dirty(c);
 }
 
 const char *textselector_get_current_text(const component *c) {
@@ -53,6 +56,7 @@ const char *textselector_get_current_text(const component *c) {
 
 static void textselector_render(component *c) {
     textselector *tb = widget_get_obj(c);
+    tb->rendered_pos = *tb->pos;
     str buf;
     if(vector_size(&tb->options) > 0 && tb->text[0] != '\0') {
         // label & options
@@ -124,6 +128,10 @@ static void textselector_tick(component *c) {
     if(tb->ticks == 0) {
         tb->dir = 0;
     }
+    // Position may be bound to a value that is changed elsewhere
+    if(*tb->pos != tb->rendered_pos) {
+        component_mark_dirty(c);
+    }
 }
 
 int textselector_get_pos(const component *c) {
@@ -134,6 +142,7 @@ int textselector_get_pos(const component *c) {
 void textselector_set_pos(component *c, int pos) {
     textselector *tb = widget_get_obj(c);
     *tb->pos = pos;
+    component_mark_dirty(c);
 }
 
 static void textselector_free(component *c) {
@@ -164,6 +173,7 @@ component *textselector_create(const text_settings *tconf, const char *text, con
     widget_set_action_cb(c, textselector_action);
     widget_set_tick_cb(c, textselector_tick);
     widget_set_free_cb(c, textselector_free);
+    component_set_retained(c, true);
 
     return c;
 }
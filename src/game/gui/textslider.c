@@ -16,6 +16,7 @@ typedef struct textslider {
     int dir;
     int pos_;
     int *pos;
+    int rendered_pos;
     int has_off;
     int positions;
     bool disable_panning;
@@ -26,6 +27,7 @@ typedef struct textslider {
 
 static void textslider_render(component *c) {
     textslider *tb = widget_get_obj(c);
+    tb->rendered_pos = *tb->pos;
     str txt;
     str_from_format(&txt, "%s ", tb->text);
     if(tb->has_off && *tb->pos == 0) {
@@ -106,6 +108,10 @@ static void textslider_tick(component *c) {
     if(tb->ticks == 0) {
         tb->dir = 0;
     }
+    // Position may be bound to a value that is changed elsewhere
+    if(*tb->pos != tb->rendered_pos) {
+        component_mark_dirty(c);
+    }
 }
 
 static void textslider_free(component *c) {
@@ -138,6 +144,7 @@ component *textslider_create(const text_settings *tconf, const char *text, const
     widget_set_action_cb(c, textslider_action);
     widget_set_tick_cb(c, textslider_tick);
     widget_set_free_cb(c, textslider_free);
+    component_set_retained(c, true);
     return c;
 }
 
@@ -17,6 +17,7 @@
 typedef struct trnselect {
     sprite *img;
     list *tournaments;
+    vga_state *vga;
     component *label;
     int max;
     int selected;
@@ -62,7 +63,7 @@ static void load_description(component **c, const sd_tournament_locale *locale)
 
 static void trnselect_free(component *c) {
     trnselect *g = widget_get_obj(c);
-    vga_state_pop_palette(); // Recover previous palette
+    vga_state_pop_palette(g->vga); // Recover previous palette
     sprite_free(g->img);
     omf_free(g->img);
     list_free(g->tournaments);
@@ -79,7 +80,7 @@ void trnselect_next(component *c) {
     }
     sd_tournament_file *trn = list_get(local->tournaments, local->selected);
     sd_sprite *logo = trn->locales[0]->logo;
-    vga_state_set_base_palette_from_range(&trn->pal, 128, 128, 40);
+    vga_state_set_base_palette_from_range(local->vga, &trn->pal, 128, 128, 40);
     load_description(&local->label, trn->locales[0]);
     sprite_free(local->img);
     sprite_create(local->img, logo, -1);
@@ -93,7 +94,7 @@ void trnselect_prev(component *c) {
     }
     sd_tournament_file *trn = list_get(local->tournaments, local->selected);
     sd_sprite *logo = trn->locales[0]->logo;
-    vga_state_set_base_palette_from_range(&trn->pal, 128, 128, 40);
+    vga_state_set_base_palette_from_range(local->vga, &trn->pal, 128, 128, 40);
     load_description(&local->label, trn->locales[0]);
     sprite_free(local->img);
     sprite_create(local->img, logo, -1);
@@ -101,10 +102,16 @@ void trnselect_prev(component *c) {
 
 sd_tournament_file *trnselect_selected(component *c) {
     trnselect *local = widget_get_obj(c);
-    return list_get(local->tournaments, local->selected);
+    sd_tournament_file *trn = list_get(local->tournaments, local->selected);
+    // The list only holds tournament summaries; the caller needs the enemy pilots as well.
+    if(trn_load_full(trn)) {
+        log_error("Could not load tournament %s", trn->filename);
+        return NULL;
+    }
+    return trn;
 }
 
-component *trnselect_create(void) {
+component *trnselect_create(vga_state *vga) {
     component *c = widget_create();
     c->supports_disable = 0;
     c->supports_select = 0;
@@ -116,14 +123,15 @@ component *trnselect_create(void) {
     local->tournaments = trnlist_init();
     local->max = list_size(local->tournaments);
     local->img = omf_calloc(1, sizeof(sprite));
+    local->vga = vga;
 
     local->label = NULL;
 
-    vga_state_push_palette(); // Backup the current palette
+    vga_state_push_palette(vga); // Backup the current palette
 
     sd_tournament_file *trn = list_get(local->tournaments, local->selected);
     sd_sprite *logo = trn->locales[0]->logo;
-    vga_state_set_base_palette_from_range(&trn->pal, 128, 128, 40);
+    vga_state_set_base_palette_from_range(local->vga, &trn->pal, 128, 128, 40);
     load_description(&local->label, trn->locales[0]);
 
     sprite_create(local->img, logo, -1);
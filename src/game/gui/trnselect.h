@@ -3,11 +3,13 @@
 
 #include "formats/tournament.h"
 #include "game/gui/component.h"
+#include "video/vga_state.h"
 
-component *trnselect_create(void);
+component *trnselect_create(vga_state *vga);
 int trnselect_get_pilot_count(component *c, int pic_id);
 void trnselect_next(component *c);
 void trnselect_prev(component *c);
+// Fully loads the selected tournament. NULL if it could not be loaded.
 sd_tournament_file *trnselect_selected(component *c);
 
 #endif // TRNSELECT_H
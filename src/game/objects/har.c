@@ -447,9 +447,9 @@ void cb_har_spawn_object(object *parent, int id, vec2i pos, vec2f vel, uint8_t m
 }
 
 void har_floor_landing_effects(object *obj, bool play_sound) {
-    int amount = rand_int(2) + 1;
+    int amount = random_int(&obj->gs->rand, 2) + 1;
     for(int i = 0; i < amount; i++) {
-        int variance = rand_int(20) - 10;
+        int variance = random_int(&obj->gs->rand, 20) - 10;
         vec2i coord = vec2i_create(obj->pos.x + variance + i * 10, obj->pos.y);
         object *dust = omf_calloc(1, sizeof(object));
         object_create(dust, obj->gs, coord, vec2f_create(0, 0));
@@ -824,7 +824,7 @@ void har_spawn_oil(object *obj, vec2i pos, int amount, float gravity, int layer)
     // burning oil
     for(int i = 0; i < amount; i++) {
         // Calculate velocity etc.
-        float rv = rand_int(100) / 100.0f - 0.5;
+        float rv = random_int(&obj->gs->rand, 100) / 100.0f - 0.5;
         float velx = (5 * cosf(90 + i - (amount) / 2 + rv)) * object_get_direction(obj);
         float vely = -12 * sinf(i / amount + rv);
 
@@ -877,7 +877,7 @@ void har_spawn_scrap(object *obj, vec2i pos, int amount) {
     }
     for(int i = 0; i < scrap_amount; i++) {
         // Calculate velocity etc.
-        float rv = rand_int(100) / 100.0f - 0.5;
+        float rv = random_int(&obj->gs->rand, 100) / 100.0f - 0.5;
         float velx = (5 * cosf(90 + i - (scrap_amount) / 2 + rv)) * object_get_direction(obj);
         float vely = -12 * sinf(i / scrap_amount + rv);
 
@@ -894,7 +894,7 @@ void har_spawn_scrap(object *obj, vec2i pos, int amount) {
 
         // Create the object
         object *scrap = omf_calloc(1, sizeof(object));
-        int anim_no = rand_int(3) + ANIM_SCRAP_METAL;
+        int anim_no = random_int(&obj->gs->rand, 3) + ANIM_SCRAP_METAL;
         object_create(scrap, obj->gs, pos, vec2f_create(velx, vely));
         object_set_animation(scrap, &af_get_move(h->af_data, anim_no)->ani);
         object_set_stl(scrap, object_get_stl(obj));
@@ -2405,6 +2405,17 @@ void har_finished(object *obj) {
 }
 
 void har_install_hook(har *h, har_hook_cb hook, void *data) {
+    // A HAR kept across clones gets its hooks installed again; replace rather than add a duplicate
+    iterator it;
+    har_hook *old;
+    list_iter_begin(&h->har_hooks, &it);
+    foreach(it, old) {
+        if(old->cb == hook) {
+            old->data = data;
+            return;
+        }
+    }
+
     har_hook hk;
     hk.cb = hook;
     hk.data = data;
@@ -2432,9 +2443,94 @@ int har_clone_free(object *obj) {
     return 0;
 }
 
+// Writes the HAR state that changes during a match. Stats that are set up by har_create() are left out.
+void har_serialize(const object *obj, serial *ser) {
+    const har *h = object_get_userdata(obj);
+    serial_write_int8(ser, h->state);
+    serial_write_int8(ser, h->executing_move);
+    serial_write_int8(ser, h->close);
+    serial_write_int8(ser, h->hard_close);
+    serial_write_int8(ser, h->enqueued);
+    serial_write_int8(ser, h->damage_done);
+    serial_write_int8(ser, h->damage_received);
+    serial_write_int8(ser, h->air_attacked);
+    serial_write_int8(ser, h->is_wallhugging);
+    serial_write_int8(ser, h->is_grabbed);
+    serial_write_float(ser, h->last_damage_value);
+    serial_write_float(ser, h->last_stun_value);
+    serial_write_int32(ser, h->in_stasis_ticks);
+    serial_write_int32(ser, h->throw_duration);
+    serial_write_int16(ser, h->health);
+    serial_write_float(ser, h->endurance);
+    serial_write(ser, h->inputs, sizeof(h->inputs));
+    serial_write_int8(ser, h->stun_timer);
+    serial_write_int8(ser, h->delay);
+    serial_write_int8(ser, h->p_pal_ref);
+    serial_write_int8(ser, h->p_har_switch);
+    serial_write_int16(ser, h->p_fade_out_ticks);
+    serial_write_int16(ser, h->p_fade_out_ticks_left);
+    serial_write_int16(ser, h->p_fade_in_ticks);
+    serial_write_int16(ser, h->p_fade_in_ticks_left);
+    serial_write_int16(ser, h->p_sustain_ticks_left);
+    serial_write_int8(ser, h->p_color_fn);
+    serial_write_uint32(ser, h->linked_obj);
+    serial_write_int32(ser, h->walk_destination);
+    serial_write_int32(ser, h->walk_done_anim);
+    serial_write_int8(ser, h->custom_defeat_animation);
+    serial_write(ser, h->rehits, sizeof(h->rehits));
+}
+
+int har_unserialize(object *obj, serial *ser, int animation_id) {
+    har *h = object_get_userdata(obj);
+    h->state = serial_read_int8(ser);
+    h->executing_move = serial_read_int8(ser);
+    h->close = serial_read_int8(ser);
+    h->hard_close = serial_read_int8(ser);
+    h->enqueued = serial_read_int8(ser);
+    h->damage_done = serial_read_int8(ser);
+    h->damage_received = serial_read_int8(ser);
+    h->air_attacked = serial_read_int8(ser);
+    h->is_wallhugging = serial_read_int8(ser);
+    h->is_grabbed = serial_read_int8(ser);
+    h->last_damage_value = serial_read_float(ser);
+    h->last_stun_value = serial_read_float(ser);
+    h->in_stasis_ticks = serial_read_int32(ser);
+    h->throw_duration = serial_read_int32(ser);
+    h->health = serial_read_int16(ser);
+    h->endurance = serial_read_float(ser);
+    serial_read(ser, h->inputs, sizeof(h->inputs));
+    h->stun_timer = serial_read_int8(ser);
+    h->delay = serial_read_int8(ser);
+    h->p_pal_ref = serial_read_int8(ser);
+    h->p_har_switch = serial_read_int8(ser);
+    h->p_fade_out_ticks = serial_read_int16(ser);
+    h->p_fade_out_ticks_left = serial_read_int16(ser);
+    h->p_fade_in_ticks = serial_read_int16(ser);
+    h->p_fade_in_ticks_left = serial_read_int16(ser);
+    h->p_sustain_ticks_left = serial_read_int16(ser);
+    h->p_color_fn = serial_read_int8(ser);
+    h->linked_obj = serial_read_uint32(ser);
+    h->walk_destination = serial_read_int32(ser);
+    h->walk_done_anim = serial_read_int32(ser);
+    h->custom_defeat_animation = serial_read_int8(ser);
+    serial_read(ser, h->rehits, sizeof(h->rehits));
+
+    // HAR animations are all moves of the AF file
+    if(obj->cur_animation == NULL || obj->cur_animation->id != animation_id) {
+        af_move *move = af_get_move(h->af_data, animation_id);
+        if(move == NULL) {
+            return 1;
+        }
+        obj->cur_animation = &move->ani;
+    }
+    return 0;
+}
+
 void har_bootstrap(object *obj) {
     obj->clone = har_clone;
     obj->clone_free = har_clone_free;
+    obj->serialize = har_serialize;
+    obj->unserialize = har_unserialize;
 }
 
 int har_create(object *obj, af *af_data, int dir, int har_id, int pilot_id, int player_id) {
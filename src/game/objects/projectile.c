@@ -112,6 +112,34 @@ int projectile_clone_free(object *obj) {
     return 0;
 }
 
+void projectile_serialize(const object *obj, serial *ser) {
+    const projectile_local *local = object_get_userdata(obj);
+    serial_write_int8(ser, local->wall_bounce);
+    serial_write_int8(ser, local->ground_freeze);
+    serial_write_int8(ser, local->invincible);
+    serial_write_int8(ser, local->has_hit);
+    serial_write_uint32(ser, local->linked_obj);
+}
+
+int projectile_unserialize(object *obj, serial *ser, int animation_id) {
+    projectile_local *local = object_get_userdata(obj);
+    local->wall_bounce = serial_read_int8(ser);
+    local->ground_freeze = serial_read_int8(ser);
+    local->invincible = serial_read_int8(ser);
+    local->has_hit = serial_read_int8(ser);
+    local->linked_obj = serial_read_uint32(ser);
+
+    // Projectiles may move on to a successor move of the owner's AF file
+    if(obj->cur_animation == NULL || obj->cur_animation->id != animation_id) {
+        af_move *move = af_get_move(local->af_data, animation_id);
+        if(move == NULL) {
+            return 1;
+        }
+        obj->cur_animation = &move->ani;
+    }
+    return 0;
+}
+
 int projectile_create(object *obj, har *har) {
     // strore the HAR in local userdata instead
     projectile_local *local = omf_calloc(1, sizeof(projectile_local));
@@ -128,6 +156,8 @@ int projectile_create(object *obj, har *har) {
     object_set_finish_cb(obj, projectile_finished);
     obj->clone = projectile_clone;
     obj->clone_free = projectile_clone_free;
+    obj->serialize = projectile_serialize;
+    obj->unserialize = projectile_unserialize;
     return 0;
 }
 
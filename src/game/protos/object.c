@@ -1,4 +1,5 @@
 #include "game/protos/object.h"
+#include "formats/error.h"
 #include "formats/sprite.h"
 #include "game/game_state.h"
 #include "game/objects/arena_constraints.h"
@@ -14,8 +15,6 @@
 
 #define UNUSED(x) (void)(x)
 
-static uint32_t object_id = 1;
-
 /** \brief Creates a new, empty object.
  * \param obj Object handle
  * \param gs Game state handle
@@ -25,7 +24,7 @@ static uint32_t object_id = 1;
 void object_create(object *obj, game_state *gs, vec2i pos, vec2f vel) {
     // State
     obj->gs = gs;
-    obj->id = object_id++;
+    obj->id = gs->next_object_id++;
 
     // Position related
     obj->pos = vec2i_to_f(pos);
@@ -72,7 +71,7 @@ void object_create(object *obj, game_state *gs, vec2i pos, vec2f vel) {
     obj->age = 0;
     player_create(obj);
 
-    random_seed(&obj->rand_state, rand_intmax());
+    random_seed(&obj->rand_state, random_intmax(&gs->rand));
 
     // For enabling multiple hits per move
     obj->q_counter = 0;
@@ -92,6 +91,8 @@ void object_create(object *obj, game_state *gs, vec2i pos, vec2f vel) {
     obj->debug = NULL;
     obj->clone = NULL;
     obj->clone_free = NULL;
+    obj->serialize = NULL;
+    obj->unserialize = NULL;
 }
 
 int object_clone(object *src, object *dst, game_state *gs) {
@@ -111,6 +112,261 @@ int object_clone(object *src, object *dst, game_state *gs) {
     return 0;
 }
 
+static void serial_write_vec2f(serial *ser, vec2f v) {
+    serial_write_float(ser, v.x);
+    serial_write_float(ser, v.y);
+}
+
+static void serial_write_vec2i(serial *ser, vec2i v) {
+    serial_write_int32(ser, v.x);
+    serial_write_int32(ser, v.y);
+}
+
+static vec2f serial_read_vec2f(serial *ser) {
+    vec2f v;
+    v.x = serial_read_float(ser);
+    v.y = serial_read_float(ser);
+    return v;
+}
+
+static vec2i serial_read_vec2i(serial *ser) {
+    vec2i v;
+    v.x = serial_read_int32(ser);
+    v.y = serial_read_int32(ser);
+    return v;
+}
+
+/** \brief Writes the simulation state of an object.
+ *
+ * Only state that changes while the object plays is written. Pointers are written as ids: the animation as
+ * its id, and the animation script as its encoded string. Callbacks, the sound translation table and such
+ * are left out, as they are set up when the object is created. The object type may append its own state
+ * with the serialize callback.
+ *
+ * \param obj Object handle
+ * \param ser Buffer to append to
+ */
+void object_serialize(const object *obj, serial *ser) {
+    serial_write_uint32(ser, obj->id);
+    serial_write_vec2f(ser, obj->start);
+    serial_write_vec2f(ser, obj->pos);
+    serial_write_vec2f(ser, obj->vel);
+    serial_write_float(ser, obj->vertical_velocity_modifier);
+    serial_write_float(ser, obj->horizontal_velocity_modifier);
+    serial_write_int8(ser, obj->direction);
+    serial_write_int8(ser, obj->group);
+    serial_write_int8(ser, obj->q_counter);
+    serial_write_int8(ser, obj->q_val);
+    serial_write_int8(ser, obj->can_hit);
+
+    serial_write_int8(ser, obj->orbit);
+    serial_write_float(ser, obj->orbit_tick);
+    serial_write_vec2f(ser, obj->orbit_dest);
+    serial_write_vec2f(ser, obj->orbit_dest_dir);
+    serial_write_vec2f(ser, obj->orbit_pos);
+    serial_write_vec2f(ser, obj->orbit_pos_vary);
+    serial_write_uint32(ser, obj->rand_state.seed);
+
+    serial_write_float(ser, obj->x_percent);
+    serial_write_float(ser, obj->y_percent);
+    serial_write_float(ser, obj->gravity);
+    serial_write_uint32(ser, obj->frame_video_effects);
+    serial_write_uint32(ser, obj->animation_video_effects);
+    serial_write_int8(ser, obj->layers);
+    serial_write_int32(ser, obj->cur_sprite_id);
+    serial_write_int8(ser, obj->sprite_override);
+    serial_write_uint32(ser, obj->attached_to_id);
+    serial_write_int8(ser, obj->pal_offset);
+    serial_write_int8(ser, obj->pal_limit);
+    serial_write_int8(ser, obj->halt);
+    serial_write_int16(ser, obj->halt_ticks);
+    serial_write_int8(ser, obj->stride);
+    serial_write_int8(ser, obj->cast_shadow);
+    serial_write_uint32(ser, obj->age);
+
+    const player_sprite_state *ss = &obj->sprite_state;
+    serial_write_int32(ser, ss->flipmode);
+    serial_write_int32(ser, ss->timer);
+    serial_write_int32(ser, ss->duration);
+    serial_write_int32(ser, ss->screen_shake_horizontal);
+    serial_write_int32(ser, ss->screen_shake_vertical);
+    serial_write_vec2i(ser, ss->o_correction);
+    serial_write_int32(ser, ss->disable_gravity);
+    serial_write_int32(ser, ss->blend_start);
+    serial_write_int32(ser, ss->blend_finish);
+    serial_write_int32(ser, ss->pal_ref_index);
+    serial_write_int32(ser, ss->pal_entry_count);
+    serial_write_int32(ser, ss->pal_start_index);
+    serial_write_int32(ser, ss->pal_begin);
+    serial_write_int32(ser, ss->pal_end);
+    serial_write_int32(ser, ss->pal_tint);
+    serial_write_int8(ser, ss->pal_tricks_off);
+    serial_write_int8(ser, ss->bd_flag);
+
+    const player_animation_state *as = &obj->animation_state;
+    serial_write_uint32(ser, as->previous_tick);
+    serial_write_uint32(ser, as->current_tick);
+    serial_write_int32(ser, as->previous);
+    serial_write_int32(ser, as->entered_frame);
+    serial_write_int8(ser, as->repeat);
+    serial_write_int8(ser, as->reverse);
+    serial_write_int8(ser, as->finished);
+    serial_write_int8(ser, as->disable_d);
+    serial_write_int8(ser, as->shadow_corner_hack);
+    serial_write_int8(ser, as->looping);
+    serial_write_int8(ser, as->pal_copy_entries);
+    serial_write_int8(ser, as->pal_copy_start);
+    serial_write_int8(ser, as->pal_copy_count);
+    serial_write_uint32(ser, as->enemy_obj_id);
+
+    serial_write_vec2f(ser, obj->slide_state.vel);
+    serial_write_int32(ser, obj->slide_state.timer);
+    serial_write_vec2i(ser, obj->enemy_slide_state.dest);
+    serial_write_int32(ser, obj->enemy_slide_state.timer);
+    serial_write_int32(ser, obj->enemy_slide_state.duration);
+
+    // The script may differ from the animation string (custom strings, delays), so write it as it is
+    str script;
+    str_create(&script);
+    sd_script_encode(&as->parser, &script);
+    serial_write_int16(ser, obj->cur_animation != NULL ? obj->cur_animation->id : -1);
+    serial_write_uint32(ser, str_size(&script));
+    serial_write(ser, str_c(&script), str_size(&script));
+    str_free(&script);
+
+    if(obj->serialize != NULL) {
+        obj->serialize(obj, ser);
+    }
+}
+
+/** \brief Restores the state written by object_serialize() into an object.
+ *
+ * The object must be the one the state was written from, or a clone of it: the callbacks and the type
+ * data are kept, only their state is restored. If the animation has changed, the unserialize callback
+ * of the object type is responsible for finding it by id.
+ *
+ * \param obj Object handle
+ * \param ser Buffer to read from
+ * \return 0 on success, 1 if the state does not belong to the object or can not be restored.
+ */
+int object_unserialize(object *obj, serial *ser) {
+    uint32_t id = serial_read_uint32(ser);
+    if(id != obj->id) {
+        log_error("Serialized state of object %u does not belong to object %u", id, obj->id);
+        return 1;
+    }
+    obj->start = serial_read_vec2f(ser);
+    obj->pos = serial_read_vec2f(ser);
+    obj->vel = serial_read_vec2f(ser);
+    obj->vertical_velocity_modifier = serial_read_float(ser);
+    obj->horizontal_velocity_modifier = serial_read_float(ser);
+    obj->direction = serial_read_int8(ser);
+    obj->group = serial_read_int8(ser);
+    obj->q_counter = serial_read_int8(ser);
+    obj->q_val = serial_read_int8(ser);
+    obj->can_hit = serial_read_int8(ser);
+
+    obj->orbit = serial_read_int8(ser);
+    obj->orbit_tick = serial_read_float(ser);
+    obj->orbit_dest = serial_read_vec2f(ser);
+    obj->orbit_dest_dir = serial_read_vec2f(ser);
+    obj->orbit_pos = serial_read_vec2f(ser);
+    obj->orbit_pos_vary = serial_read_vec2f(ser);
+    obj->rand_state.seed = serial_read_uint32(ser);
+
+    obj->x_percent = serial_read_float(ser);
+    obj->y_percent = serial_read_float(ser);
+    obj->gravity = serial_read_float(ser);
+    obj->frame_video_effects = serial_read_uint32(ser);
+    obj->animation_video_effects = serial_read_uint32(ser);
+    obj->layers = serial_read_int8(ser);
+    obj->cur_sprite_id = serial_read_int32(ser);
+    obj->sprite_override = serial_read_int8(ser);
+    obj->attached_to_id = serial_read_uint32(ser);
+    obj->pal_offset = serial_read_int8(ser);
+    obj->pal_limit = serial_read_int8(ser);
+    obj->halt = serial_read_int8(ser);
+    obj->halt_ticks = serial_read_int16(ser);
+    obj->stride = serial_read_int8(ser);
+    obj->cast_shadow = serial_read_int8(ser);
+    obj->age = serial_read_uint32(ser);
+
+    player_sprite_state *ss = &obj->sprite_state;
+    ss->flipmode = serial_read_int32(ser);
+    ss->timer = serial_read_int32(ser);
+    ss->duration = serial_read_int32(ser);
+    ss->screen_shake_horizontal = serial_read_int32(ser);
+    ss->screen_shake_vertical = serial_read_int32(ser);
+    ss->o_correction = serial_read_vec2i(ser);
+    ss->disable_gravity = serial_read_int32(ser);
+    ss->blend_start = serial_read_int32(ser);
+    ss->blend_finish = serial_read_int32(ser);
+    ss->pal_ref_index = serial_read_int32(ser);
+    ss->pal_entry_count = serial_read_int32(ser);
+    ss->pal_start_index = serial_read_int32(ser);
+    ss->pal_begin = serial_read_int32(ser);
+    ss->pal_end = serial_read_int32(ser);
+    ss->pal_tint = serial_read_int32(ser);
+    ss->pal_tricks_off = serial_read_int8(ser);
+    ss->bd_flag = serial_read_int8(ser);
+
+    player_animation_state *as = &obj->animation_state;
+    as->previous_tick = serial_read_uint32(ser);
+    as->current_tick = serial_read_uint32(ser);
+    as->previous = serial_read_int32(ser);
+    as->entered_frame = serial_read_int32(ser);
+    as->repeat = serial_read_int8(ser);
+    as->reverse = serial_read_int8(ser);
+    as->finished = serial_read_int8(ser);
+    as->disable_d = serial_read_int8(ser);
+    as->shadow_corner_hack = serial_read_int8(ser);
+    as->looping = serial_read_int8(ser);
+    as->pal_copy_entries = serial_read_int8(ser);
+    as->pal_copy_start = serial_read_int8(ser);
+    as->pal_copy_count = serial_read_int8(ser);
+    as->enemy_obj_id = serial_read_uint32(ser);
+
+    obj->slide_state.vel = serial_read_vec2f(ser);
+    obj->slide_state.timer = serial_read_int32(ser);
+    obj->enemy_slide_state.dest = serial_read_vec2i(ser);
+    obj->enemy_slide_state.timer = serial_read_int32(ser);
+    obj->enemy_slide_state.duration = serial_read_int32(ser);
+
+    int animation_id = serial_read_int16(ser);
+    uint32_t script_len = serial_read_uint32(ser);
+    if(script_len > serial_len(ser) - ser->rpos) {
+        log_error("Serialized state of object %u is truncated", id);
+        return 1;
+    }
+    char *script = omf_malloc(script_len + 1);
+    serial_read(ser, script, script_len);
+    script[script_len] = '\0';
+
+    int ret = 0;
+    if(obj->unserialize != NULL && obj->unserialize(obj, ser, animation_id) != 0) {
+        ret = 1;
+        goto exit_0;
+    }
+    if(obj->cur_animation == NULL || obj->cur_animation->id != animation_id) {
+        log_error("Unable to restore animation %d of object %u", animation_id, id);
+        ret = 1;
+        goto exit_0;
+    }
+
+    int err_pos;
+    sd_script_free(&as->parser);
+    sd_script_create(&as->parser);
+    if(sd_script_decode(&as->parser, script, &err_pos) != SD_SUCCESS) {
+        log_error("Unable to decode the script of object %u at position %d", id, err_pos);
+        ret = 1;
+    }
+    obj->cur_surface = NULL;
+
+exit_0:
+    omf_free(script);
+    return ret;
+}
+
 // FIXME: This was removed in HEAD, not sure why or what is the replacement
 // TODO: GET RID
 void object_create_static(object *obj, game_state *gs) {
@@ -331,26 +587,11 @@ void object_apply_controllable_velocity(object *obj, object *obj_har, char input
     }
 }
 
-void object_render(object *obj) {
-    // Stop here if cur_sprite_id is not set
-    if(obj->cur_sprite_id < 0)
-        return;
-
-    const sprite *cur_sprite = animation_get_sprite(obj->cur_animation, obj->cur_sprite_id);
-    if(cur_sprite == NULL)
-        return;
-
-    // Set current surface
-    obj->cur_surface = cur_sprite->data;
-
-    // Something to ease the pain ...
+// Top left corner of the given sprite of the object when drawn at w x h pixels
+static vec2i object_sprite_position(object *obj, const sprite *cur_sprite, int w, int h) {
     player_sprite_state *rstate = &obj->sprite_state;
-
-    // Position
     int x;
     int y;
-    int w = obj->cur_surface->w * obj->x_percent;
-    int h = obj->cur_surface->h * obj->y_percent;
 
     // Set Y coord, take into account sprite flipping
     if(rstate->flipmode & FLIP_VERTICAL) {
@@ -371,14 +612,42 @@ void object_render(object *obj) {
     }
 
     // Centrify if scaled
-    x = x + (obj->cur_surface->w - w) / 2;
-    y = y + (obj->cur_surface->h - h) / 2;
+    x = x + (cur_sprite->data->w - w) / 2;
+    y = y + (cur_sprite->data->h - h) / 2;
+    return vec2i_create(x, y);
+}
 
+static int object_sprite_flip_mode(object *obj) {
     // Flip to face the right direction
-    int flip_mode = rstate->flipmode;
+    int flip_mode = obj->sprite_state.flipmode;
     if(object_get_direction(obj) == OBJECT_FACE_LEFT) {
         flip_mode ^= FLIP_HORIZONTAL;
     }
+    return flip_mode;
+}
+
+bool object_draw_cmd(object *obj, video_draw_cmd *cmd) {
+    // Stop here if cur_sprite_id is not set
+    if(obj->cur_sprite_id < 0)
+        return false;
+
+    const sprite *cur_sprite = animation_get_sprite(obj->cur_animation, obj->cur_sprite_id);
+    if(cur_sprite == NULL)
+        return false;
+
+    // Set current surface
+    obj->cur_surface = cur_sprite->data;
+
+    // Something to ease the pain ...
+    player_sprite_state *rstate = &obj->sprite_state;
+
+    // Position
+    int w = obj->cur_surface->w * obj->x_percent;
+    int h = obj->cur_surface->h * obj->y_percent;
+    vec2i pos = object_sprite_position(obj, cur_sprite, w, h);
+    int x = pos.x;
+    int y = pos.y;
+    int flip_mode = object_sprite_flip_mode(obj);
 
     uint8_t opacity = rstate->blend_finish;
     if(rstate->duration > 0) {
@@ -418,18 +687,36 @@ void object_render(object *obj) {
         options |= SPRITE_INDEX_ADD;
     }
 
-    video_draw_full(obj->cur_surface, x, y, w, h, remap_offset, remap_rounds, obj->pal_offset, obj->pal_limit, opacity,
-                    flip_mode, options);
+    cmd->src = obj->cur_surface;
+    cmd->dst.x = x;
+    cmd->dst.y = y;
+    cmd->dst.w = w;
+    cmd->dst.h = h;
+    cmd->remap_offset = remap_offset;
+    cmd->remap_rounds = remap_rounds;
+    cmd->palette_offset = obj->pal_offset;
+    cmd->palette_limit = obj->pal_limit;
+    cmd->opacity = opacity;
+    cmd->flip_mode = flip_mode;
+    cmd->options = options;
+    return true;
 }
 
-void object_render_shadow(object *obj) {
+void object_render(object *obj) {
+    video_draw_cmd cmd;
+    if(object_draw_cmd(obj, &cmd)) {
+        video_draw_batch(&cmd, 1);
+    }
+}
+
+int object_shadow_draw_cmds(object *obj, video_draw_cmd *cmds) {
     if(obj->cur_sprite_id < 0 || !obj->cast_shadow) {
-        return;
+        return 0;
     }
 
     const sprite *cur_sprite = animation_get_sprite(obj->cur_animation, obj->cur_sprite_id);
     if(cur_sprite == NULL) {
-        return;
+        return 0;
     }
 
     // Scale of the sprite on Y axis should be less than the
@@ -460,21 +747,38 @@ void object_render_shadow(object *obj) {
 
     // Render shadow object twice with different offsets, so that
     // the shadows seem a bit blobbier and shadow-y
-    for(int i = 0; i < 2; i++) {
-        video_draw_full(cur_sprite->data, x + i, y + i, w, scaled_h, 2, 1, obj->pal_offset, obj->pal_limit, opacity,
-                        flip_mode, SPRITE_MASK);
+    for(int i = 0; i < OBJECT_SHADOW_CMDS; i++) {
+        video_draw_cmd *cmd = &cmds[i];
+        cmd->src = cur_sprite->data;
+        cmd->dst.x = x + i;
+        cmd->dst.y = y + i;
+        cmd->dst.w = w;
+        cmd->dst.h = scaled_h;
+        cmd->remap_offset = 2;
+        cmd->remap_rounds = 1;
+        cmd->palette_offset = obj->pal_offset;
+        cmd->palette_limit = obj->pal_limit;
+        cmd->opacity = opacity;
+        cmd->flip_mode = flip_mode;
+        cmd->options = SPRITE_MASK;
     }
+    return OBJECT_SHADOW_CMDS;
+}
+
+void object_render_shadow(object *obj) {
+    video_draw_cmd cmds[OBJECT_SHADOW_CMDS];
+    video_draw_batch(cmds, object_shadow_draw_cmds(obj, cmds));
 }
 
 void object_palette_transform(object *obj) {
     if(obj->palette_transform != NULL) {
-        vga_state_enable_palette_transform(obj->palette_transform, obj);
+        vga_state_enable_palette_transform(obj->gs->vga, obj->palette_transform, obj);
     }
 
     if(obj->sprite_state.pal_tricks_off) { // BPO tag is on
-        vga_state_enable_palette_transform(object_palette_copy_transform, obj);
+        vga_state_enable_palette_transform(obj->gs->vga, object_palette_copy_transform, obj);
     } else if(obj->sprite_state.pal_entry_count > 0 && obj->sprite_state.duration > 0) { // BPO tag is off
-        vga_state_enable_palette_transform(object_scenewide_palette_transform, obj);
+        vga_state_enable_palette_transform(obj->gs->vga, object_scenewide_palette_transform, obj);
     }
 }
 
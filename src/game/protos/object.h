@@ -10,11 +10,15 @@
 #include "utils/vec.h"
 #include "video/surface.h"
 #include "video/vga_state.h"
+#include "video/video.h"
 
 #define OBJECT_DEFAULT_LAYER 0x01
 
 #define OBJECT_EVENT_BUFFER_SIZE 16
 
+// Shadows are drawn twice with a small offset, see object_shadow_draw_cmds()
+#define OBJECT_SHADOW_CMDS 2
+
 enum
 {
     OBJECT_FACE_LEFT = -1,
@@ -69,6 +73,8 @@ typedef void (*object_finish_cb)(object *obj);
 typedef void (*object_debug_cb)(object *obj);
 typedef int (*object_clone_cb)(object *src, object *dst);
 typedef int (*object_clone_free_cb)(object *obj);
+typedef void (*object_serialize_cb)(const object *obj, serial *ser);
+typedef int (*object_unserialize_cb)(object *obj, serial *ser, int animation_id);
 
 struct object_t {
     uint32_t id;
@@ -145,12 +151,19 @@ struct object_t {
     object_debug_cb debug;
     object_clone_cb clone;
     object_clone_free_cb clone_free;
+    object_serialize_cb serialize;
+    object_unserialize_cb unserialize;
 };
 
 void object_create(object *obj, game_state *gs, vec2i pos, vec2f vel);
 void object_create_static(object *obj, game_state *gs);
 void object_render(object *obj);
 void object_render_shadow(object *obj);
+// Fills in the draw command of the current sprite, as object_render() would draw it. Returns false if there is
+// nothing to draw.
+bool object_draw_cmd(object *obj, video_draw_cmd *cmd);
+// Fills in the draw commands of the shadow, at most OBJECT_SHADOW_CMDS of them. Returns the count.
+int object_shadow_draw_cmds(object *obj, video_draw_cmd *cmds);
 void object_palette_transform(object *obj);
 void object_debug(object *obj);
 void object_static_tick(object *obj);
@@ -165,6 +178,9 @@ void object_free(object *obj);
 int object_clone(object *src, object *dst, game_state *gs);
 int object_clone_free(object *obj);
 
+void object_serialize(const object *obj, serial *ser);
+int object_unserialize(object *obj, serial *ser);
+
 void object_attach_to(object *obj, const object *attach_to);
 
 void object_set_stride(object *obj, int stride);
@@ -258,8 +274,6 @@ void object_set_vx(object *obj, float val);
 void object_set_vy(object *obj, float val);
 
 uint32_t object_get_age(object *obj);
-serial *object_get_last_serialization_point(const object *obj);
-serial *object_get_serialization_point(const object *obj, unsigned int ticks_ago);
 
 void object_set_spawn_cb(object *obj, object_state_add_cb cbf, void *userdata);
 void object_set_destroy_cb(object *obj, object_state_del_cb cbf, void *userdata);
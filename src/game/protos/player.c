@@ -8,7 +8,6 @@
 #include "game/game_state.h"
 #include "game/protos/object.h"
 #include "game/protos/player.h"
-#include "game/utils/settings.h"
 #include "resources/ids.h"
 #include "utils/log.h"
 #include "utils/miscmath.h"
@@ -438,19 +437,19 @@ void player_run(object *obj) {
         // Music playback
         if(sd_script_isset(frame, "smo")) {
             if(sd_script_get(frame, "smo") == 0) {
-                audio_stop_music();
+                game_state_stop_music(obj->gs);
                 return;
             }
-            audio_play_music(PSM_END + (sd_script_get(frame, "smo") - 1));
+            game_state_play_music(obj->gs, PSM_END + (sd_script_get(frame, "smo") - 1));
         }
         if(sd_script_isset(frame, "smf")) {
-            audio_stop_music();
+            game_state_stop_music(obj->gs);
         }
 
         // Sound playback
         if(sd_script_isset(frame, "s")) {
             float pitch = PITCH_DEFAULT;
-            float volume = VOLUME_DEFAULT * (settings_get()->sound.sound_vol / 10.0f);
+            float volume = VOLUME_DEFAULT * obj->gs->host.sound_volume;
             float panning = PANNING_DEFAULT;
             if(sd_script_isset(frame, "sf")) {
                 int sf = sd_script_get(frame, "sf");
@@ -466,7 +465,7 @@ void player_run(object *obj) {
             }
             if(sd_script_isset(frame, "l")) {
                 int v = clamp(sd_script_get(frame, "l"), 0, 100);
-                volume = (v / 100.0f) * (settings_get()->sound.sound_vol / 10.0f);
+                volume = (v / 100.0f) * obj->gs->host.sound_volume;
             }
             if(sd_script_isset(frame, "sb")) {
                 panning = clamp(sd_script_get(frame, "sb"), -100, 100) / 100.0f;
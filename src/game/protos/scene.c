@@ -16,19 +16,7 @@ void cb_scene_spawn_object(object *parent, int id, vec2i pos, vec2f vel, uint8_t
                            void *userdata);
 void cb_scene_destroy_object(object *parent, int id, void *userdata);
 
-// Loads BK file etc.
-int scene_create(scene *scene, game_state *gs, int scene_id) {
-    if(scene_id == SCENE_NONE) {
-        return 1;
-    }
-
-    // Load BK
-    int resource_id = scene_to_resource(scene_id);
-    scene->bk_data = omf_calloc(1, sizeof(bk));
-    if(load_bk_file(scene->bk_data, resource_id)) {
-        log_error("Unable to load scene %s (%s)!", scene_get_name(scene_id), get_resource_name(resource_id));
-        return 1;
-    }
+static void scene_set_defaults(scene *scene, game_state *gs, int scene_id) {
     scene->id = scene_id;
     scene->gs = gs;
     scene->af_data[0] = NULL;
@@ -47,23 +35,49 @@ int scene_create(scene *scene, game_state *gs, int scene_id) {
     scene->startup = NULL;
     scene->prio_override = NULL;
     scene->debug = NULL;
+}
+
+// Loads BK file etc.
+int scene_create(scene *scene, game_state *gs, int scene_id) {
+    if(scene_id == SCENE_NONE) {
+        return 1;
+    }
+
+    // Load BK
+    int resource_id = scene_to_resource(scene_id);
+    scene->bk_data = omf_calloc(1, sizeof(bk));
+    if(load_bk_file(scene->bk_data, resource_id)) {
+        log_error("Unable to load scene %s (%s)!", scene_get_name(scene_id), get_resource_name(resource_id));
+        return 1;
+    }
+    scene_set_defaults(scene, gs, scene_id);
 
     // Set base palette
-    vga_state_set_base_palette_from(bk_get_palette(scene->bk_data, 0));
-    vga_state_set_remaps_from(bk_get_remaps(scene->bk_data, 0));
+    vga_state_set_base_palette_from(gs->vga, bk_get_palette(scene->bk_data, 0));
+    vga_state_set_remaps_from(gs->vga, bk_get_remaps(scene->bk_data, 0));
 
     // Set menu colors to the correct position
-    palette_set_menu_colors();
+    palette_set_menu_colors(gs->vga);
 
     // Index 0 is always black.
     vga_color c = {0, 0, 0};
-    vga_state_set_base_palette_index(0, &c);
+    vga_state_set_base_palette_index(gs->vga, 0, &c);
 
     // All done.
     log_debug("Loaded scene %s (%s).", scene_get_name(scene_id), get_resource_name(resource_id));
     return 0;
 }
 
+/**
+ * Creates a scene without any background data, and initializes it. Nothing is loaded from disk, so
+ * this is usable without game resources; objects must be added by the caller.
+ */
+void scene_create_empty(scene *scene, game_state *gs, int scene_id) {
+    scene->bk_data = NULL;
+    scene_set_defaults(scene, gs, scene_id);
+    ticktimer_init(&scene->tick_timer);
+}
+
 int scene_load_har(scene *scene, int player_id) {
     game_player *player = game_state_get_player(scene->gs, player_id);
     if(scene->af_data[player_id]) {
@@ -223,8 +237,10 @@ void scene_free(scene *scene) {
     if(scene->free != NULL) {
         scene->free(scene);
     }
-    bk_free(scene->bk_data);
-    omf_free(scene->bk_data);
+    if(scene->bk_data) {
+        bk_free(scene->bk_data);
+        omf_free(scene->bk_data);
+    }
     if(scene->af_data[0]) {
         af_free(scene->af_data[0]);
         omf_free(scene->af_data[0]);
@@ -27,6 +27,7 @@
 #include "game/protos/object.h"
 #include "game/scenes/arena.h"
 #include "game/scenes/mechlab/lab_menu_customize.h"
+#include "game/utils/input_latency.h"
 #include "game/utils/score.h"
 #include "game/utils/settings.h"
 #include "game/utils/ticktimer.h"
@@ -34,6 +35,7 @@
 #include "resources/sgmanager.h"
 #include "utils/allocator.h"
 #include "utils/log.h"
+#include "utils/miscmath.h"
 #include "utils/random.h"
 #include "video/video.h"
 
@@ -45,6 +47,9 @@
 #define GAME_MENU_RETURN_ID 100
 #define GAME_MENU_QUIT_ID 101
 
+// How often a recording is written out to disk while the match is on, in milliseconds of game time
+#define REC_FLUSH_MS 1000
+
 typedef enum
 {
     NONE = 0,
@@ -72,9 +77,15 @@ typedef struct arena_local_t {
 
     int player_rounds[2][4];
 
+    arena_round_stats round_stats[ARENA_MAX_ROUNDS];
+    int rounds_decided;
+
     int rein_enabled;
 
     sd_action rec_last[2];
+    uint32_t rec_start_tick; // int_tick at which the recording started
+    sd_rec_stream *rec_stream;
+    int rec_flush_ms;
 } arena_local;
 
 void write_rec_move(scene *scene, game_player *player, int action);
@@ -269,11 +280,11 @@ void arena_end(scene *sc) {
         if(fight_stats->winner == 0) {
             int16_t hp_left_percent = har_health_percent(p1_har);
             if(hp_left_percent >= 75) {
-                fight_stats->plug_text = PLUG_WIN_BIG + rand_int(3);
+                fight_stats->plug_text = PLUG_WIN_BIG + random_int(&gs->rand, 3);
             } else if(hp_left_percent >= 50) {
-                fight_stats->plug_text = PLUG_WIN_OK + rand_int(3);
+                fight_stats->plug_text = PLUG_WIN_OK + random_int(&gs->rand, 3);
             } else {
-                fight_stats->plug_text = PLUG_WIN + rand_int(3);
+                fight_stats->plug_text = PLUG_WIN + random_int(&gs->rand, 3);
             }
         } else if(p1->pilot->money < 0 && sell_highest_value_upgrade(p1->pilot, fight_stats->sold)) {
             fight_stats->plug_text = PLUG_SOLD_UPGRADE;
@@ -284,7 +295,7 @@ void arena_end(scene *sc) {
         } else if(p1->pilot->money < 0) {
             fight_stats->plug_text = PLUG_WARNING;
         } else {
-            fight_stats->plug_text = PLUG_LOSE + rand_int(5);
+            fight_stats->plug_text = PLUG_LOSE + random_int(&gs->rand, 5);
         }
 
         if(p1->chr && sg_save(p1->chr) != SD_SUCCESS) {
@@ -383,6 +394,11 @@ void arena_reset(scene *sc) {
     }
 }
 
+uint32_t arena_rec_tick(scene *sc) {
+    arena_local *local = scene_get_userdata(sc);
+    return sc->gs->int_tick - local->rec_start_tick;
+}
+
 int arena_is_over(scene *sc) {
     arena_local *local = scene_get_userdata(sc);
 
@@ -393,6 +409,46 @@ int arena_is_over(scene *sc) {
     return -1;
 }
 
+/**
+ * Copies the statistics of the rounds decided so far.
+ * \param sc Arena scene
+ * \param dst Destination array
+ * \param max Size of the destination array
+ * \return Number of rounds copied
+ */
+int arena_get_round_stats(scene *sc, arena_round_stats *dst, int max) {
+    arena_local *local = scene_get_userdata(sc);
+    int count = min2(local->rounds_decided, max);
+    memcpy(dst, local->round_stats, count * sizeof(arena_round_stats));
+    return count;
+}
+
+static void arena_record_round(scene *scene, int winner_player_id) {
+    arena_local *local = scene_get_userdata(scene);
+    if(local->rounds_decided >= ARENA_MAX_ROUNDS) {
+        return;
+    }
+    const fight_stats *fight_stats = &scene->gs->fight_stats;
+    arena_round_stats *stats = &local->round_stats[local->rounds_decided];
+    stats->winner = winner_player_id;
+    stats->end_tick = scene->gs->tick;
+    for(int i = 0; i < 2; i++) {
+        object *obj_har =
+            game_state_find_object(scene->gs, game_player_get_har_obj_id(game_state_get_player(scene->gs, i)));
+        har *h = object_get_userdata(obj_har);
+        stats->health[i] = h->health;
+
+        // The fight statistics are totals for the whole match, so subtract what earlier rounds had.
+        stats->hits_landed[i] = fight_stats->hits_landed[i];
+        stats->total_attacks[i] = fight_stats->total_attacks[i];
+        for(int r = 0; r < local->rounds_decided; r++) {
+            stats->hits_landed[i] -= local->round_stats[r].hits_landed[i];
+            stats->total_attacks[i] -= local->round_stats[r].total_attacks[i];
+        }
+    }
+    local->rounds_decided++;
+}
+
 void arena_har_take_hit_hook(int hittee, af_move *move, scene *scene) {
     chr_score *score;
     chr_score *otherscore;
@@ -496,10 +552,10 @@ void arena_har_hit_wall_hook(int player_id, int wall, scene *scene) {
                 }
             }
 
-            int amount = rand_int(2) + 3;
+            int amount = random_int(&scene->gs->rand, 2) + 3;
             for(int i = 0; i < amount; i++) {
-                int variance = rand_int(20) - 10;
-                int anim_no = rand_int(2) + 24;
+                int variance = random_int(&scene->gs->rand, 20) - 10;
+                int anim_no = random_int(&scene->gs->rand, 2) + 24;
                 // log_debug("XXX anim = %d, variance = %d", anim_no, variance);
                 int pos_y = o_har->pos.y - object_get_size(o_har).y + variance + i * 25;
                 vec2i coord = vec2i_create(o_har->pos.x, pos_y);
@@ -558,6 +614,7 @@ void arena_har_defeat_hook(int loser_player_id, scene *scene) {
     har *winner_har = object_get_userdata(winner);
     fight_stats *fight_stats = &gs->fight_stats;
     fight_stats->winner = winner_player_id;
+    arena_record_round(scene, winner_player_id);
     chr_score *score = game_player_get_score(game_state_get_player(gs, winner_player_id));
     // XXX need a smarter way to detect if a player is networked or local
     if(player_winner->ctrl->type != CTRL_TYPE_NETWORK && player_loser->ctrl->type == CTRL_TYPE_NETWORK) {
@@ -756,6 +813,10 @@ void maybe_install_har_hooks(scene *scene) {
     object *obj_har1, *obj_har2;
     obj_har1 = game_state_find_object(scene->gs, game_player_get_har_obj_id(game_state_get_player(scene->gs, 0)));
     obj_har2 = game_state_find_object(scene->gs, game_player_get_har_obj_id(game_state_get_player(scene->gs, 1)));
+    if(obj_har1 == NULL || obj_har2 == NULL) {
+        // Clones without objects have no HARs to hook into
+        return;
+    }
     har *har1, *har2;
     har1 = obj_har1->userdata;
     har2 = obj_har2->userdata;
@@ -867,7 +928,12 @@ void arena_free(scene *scene) {
 
         if(scene->gs->init_flags->record == 1) {
             // we're supposed to save it
-            sd_rec_save(scene->gs->rec, scene->gs->init_flags->rec_file);
+            if(local->rec_stream != NULL) {
+                sd_rec_stream_close(local->rec_stream, scene->gs->rec);
+                local->rec_stream = NULL;
+            } else {
+                sd_rec_save(scene->gs->rec, scene->gs->init_flags->rec_file);
+            }
             sd_rec_free(scene->gs->rec);
             omf_free(scene->gs->rec);
             scene->gs->rec = NULL;
@@ -883,7 +949,7 @@ void arena_free(scene *scene) {
 
     gui_frame_free(local->game_menu);
 
-    audio_stop_music();
+    game_state_stop_music(scene->gs);
 
     // Free bar components
     for(int i = 0; i < 2; i++) {
@@ -910,7 +976,7 @@ void write_rec_move(scene *scene, game_player *player, int action) {
     }
 
     memset(&move, 0, sizeof(move));
-    move.tick = scene->gs->tick;
+    move.tick = arena_rec_tick(scene);
     move.lookup_id = 2;
     move.player_id = 0;
     move.action = 0;
@@ -955,37 +1021,38 @@ void write_rec_move(scene *scene, game_player *player, int action) {
     }
 }
 
-int arena_handle_events(scene *scene, game_player *player, ctrl_event *i) {
+int arena_handle_events(scene *scene, game_player *player, const ctrl_events *ev) {
     int need_sync = 0;
-    if(i) {
-        do {
-            if(i->type == EVENT_TYPE_ACTION) {
-                need_sync += object_act(game_state_find_object(scene->gs, game_player_get_har_obj_id(player)),
-                                        i->event_data.action);
-
-                if(!is_netplay(scene->gs)) {
-                    // netplay will manage its own REC events
-                    write_rec_move(scene, player, i->event_data.action);
-                }
-            } else if(i->type == EVENT_TYPE_CLOSE) {
-                if(player->ctrl->type == CTRL_TYPE_REC) {
-                    game_state_set_next(scene->gs, SCENE_NONE);
-                } else {
-                    if(scene->gs->net_mode == NET_MODE_LOBBY) {
-                        arena_local *local = scene_get_userdata(scene);
-                        if(game_state_get_player(scene->gs, 0)->ctrl->type == CTRL_TYPE_NETWORK) {
-                            net_controller_set_winner(game_state_get_player(scene->gs, 0)->ctrl, local->winner);
-                        }
-                        if(game_state_get_player(scene->gs, 1)->ctrl->type == CTRL_TYPE_NETWORK) {
-                            net_controller_set_winner(game_state_get_player(scene->gs, 1)->ctrl, local->winner);
-                        }
-                        game_state_set_next(scene->gs, SCENE_LOBBY);
+    for(unsigned int k = 0; k < ev->count; k++) {
+        const ctrl_event *i = &ev->events[k];
+        if(i->type == EVENT_TYPE_ACTION) {
+            need_sync += object_act(game_state_find_object(scene->gs, game_player_get_har_obj_id(player)), i->action);
+            if(i->timestamp != 0) {
+                input_latency_acted(i->timestamp, player->ctrl->type, game_state_get_speed(scene->gs));
+            }
+
+            if(!is_netplay(scene->gs)) {
+                // netplay will manage its own REC events
+                write_rec_move(scene, player, i->action);
+            }
+        } else if(i->type == EVENT_TYPE_CLOSE) {
+            if(player->ctrl->type == CTRL_TYPE_REC) {
+                game_state_set_next(scene->gs, SCENE_NONE);
+            } else {
+                if(scene->gs->net_mode == NET_MODE_LOBBY) {
+                    arena_local *local = scene_get_userdata(scene);
+                    if(game_state_get_player(scene->gs, 0)->ctrl->type == CTRL_TYPE_NETWORK) {
+                        net_controller_set_winner(game_state_get_player(scene->gs, 0)->ctrl, local->winner);
+                    }
+                    if(game_state_get_player(scene->gs, 1)->ctrl->type == CTRL_TYPE_NETWORK) {
+                        net_controller_set_winner(game_state_get_player(scene->gs, 1)->ctrl, local->winner);
                     }
-                    game_state_set_next(scene->gs, SCENE_MENU);
+                    game_state_set_next(scene->gs, SCENE_LOBBY);
                 }
-                return 0;
+                game_state_set_next(scene->gs, SCENE_MENU);
             }
-        } while((i = i->next));
+            return 0;
+        }
     }
     return need_sync;
 }
@@ -1148,13 +1215,13 @@ void arena_dynamic_tick(scene *scene, int paused) {
 
         // Pour some rein!
         if(local->rein_enabled) {
-            if(rand_float() > 0.65f) {
-                vec2i pos = vec2i_create(rand_int(NATIVE_W), -10);
+            if(random_float(&scene->gs->rand) > 0.65f) {
+                vec2i pos = vec2i_create(random_int(&scene->gs->rand, NATIVE_W), -10);
                 for(int harnum = 0; harnum < game_state_num_players(gs); harnum++) {
                     object *h_obj = game_state_find_object(gs, game_state_get_player(gs, harnum)->har_obj_id);
                     har *h = object_get_userdata(h_obj);
                     // Calculate velocity etc.
-                    float rv = rand_float() - 0.5f;
+                    float rv = random_float(&scene->gs->rand) - 0.5f;
                     float velx = rv;
                     float vely = -12 * sinf(0 / 2 + rv);
 
@@ -1165,7 +1232,7 @@ void arena_dynamic_tick(scene *scene, int paused) {
 
                     // Create the object
                     object *scrap = omf_calloc(1, sizeof(object));
-                    int anim_no = rand_int(3) + ANIM_SCRAP_METAL;
+                    int anim_no = random_int(&scene->gs->rand, 3) + ANIM_SCRAP_METAL;
                     object_create(scrap, gs, pos, vec2f_create(velx, vely));
                     object_set_animation(scrap, &af_get_move(h->af_data, anim_no)->ani);
                     object_set_gravity(scrap, 0.4f);
@@ -1193,6 +1260,18 @@ void arena_dynamic_tick(scene *scene, int paused) {
                    hars[1]->state == STATE_NONE || hars[1]->state == STATE_WALLDAMAGE);
         }
     } // if(!paused)
+
+    // Write the recording out as we go, so that a crash loses only the last second of it.
+    // Rollback clones replay ticks that are already recorded, so leave that to the live state.
+    if(local->rec_stream != NULL && !gs->clone) {
+        local->rec_flush_ms += game_state_ms_per_dyntick(gs);
+        if(local->rec_flush_ms >= REC_FLUSH_MS) {
+            local->rec_flush_ms = 0;
+            if(sd_rec_stream_flush(local->rec_stream, gs->rec) != SD_SUCCESS) {
+                log_error("Unable to write recording to %s", gs->init_flags->rec_file);
+            }
+        }
+    }
 }
 
 void arena_static_tick(scene *scene, int paused) {
@@ -1207,14 +1286,14 @@ void arena_input_tick(scene *scene) {
         game_player *player1 = game_state_get_player(scene->gs, 0);
         game_player *player2 = game_state_get_player(scene->gs, 1);
 
-        ctrl_event *p1 = NULL, *p2 = NULL;
+        ctrl_events p1, p2;
+        ctrl_events_clear(&p1);
+        ctrl_events_clear(&p2);
         controller_poll(player1->ctrl, &p1);
         controller_poll(player2->ctrl, &p2);
 
-        arena_handle_events(scene, player1, p1);
-        arena_handle_events(scene, player2, p2);
-        controller_free_chain(p1);
-        controller_free_chain(p2);
+        arena_handle_events(scene, player1, &p1);
+        arena_handle_events(scene, player2, &p2);
     }
 
     if(is_netplay(scene->gs)) {
@@ -1222,22 +1301,23 @@ void arena_input_tick(scene *scene) {
         return;
     }
 
-    ctrl_event *menu_ev = NULL;
+    ctrl_events menu_ev;
+    ctrl_events_clear(&menu_ev);
     game_state_menu_poll(scene->gs, &menu_ev);
-    for(ctrl_event *i = menu_ev; i; i = i->next) {
-        if(i->type == EVENT_TYPE_ACTION && i->event_data.action == ACT_ESC && is_demoplay(scene->gs)) {
+    for(unsigned int k = 0; k < menu_ev.count; k++) {
+        const ctrl_event *i = &menu_ev.events[k];
+        if(i->type == EVENT_TYPE_ACTION && i->action == ACT_ESC && is_demoplay(scene->gs)) {
             // exit demoplay
             game_state_set_next(scene->gs, SCENE_MENU);
-        } else if(i->type == EVENT_TYPE_ACTION && i->event_data.action == ACT_ESC) {
+        } else if(i->type == EVENT_TYPE_ACTION && i->action == ACT_ESC) {
             // toggle menu
             local->menu_visible = !local->menu_visible;
             game_state_set_paused(scene->gs, local->menu_visible);
-        } else if(i->type == EVENT_TYPE_ACTION && local->menu_visible && i->event_data.action != ACT_ESC) {
+        } else if(i->type == EVENT_TYPE_ACTION && local->menu_visible && i->action != ACT_ESC) {
             // menu events
-            gui_frame_action(local->game_menu, i->event_data.action);
+            gui_frame_action(local->game_menu, i->action);
         }
     }
-    controller_free_chain(menu_ev);
 }
 
 int arena_event(scene *scene, SDL_Event *e) {
@@ -1245,10 +1325,6 @@ int arena_event(scene *scene, SDL_Event *e) {
 }
 
 void arena_render_overlay(scene *scene) {
-    if(scene->gs->hide_ui) {
-        return;
-    }
-
     arena_local *local = scene_get_userdata(scene);
 
     // Render bars
@@ -1323,10 +1399,6 @@ void arena_render_overlay(scene *scene) {
 }
 
 static void arena_debug(scene *scene) {
-    if(scene->gs->hide_ui) {
-        return;
-    }
-
     char buf[100];
     game_player *player[2];
     object *obj_har[2];
@@ -1454,25 +1526,28 @@ int arena_create(scene *scene) {
     // Load up settings
     setting = settings_get();
 
+    // Everything random in the match draws from here on, so this is what a playback has to start from
+    uint32_t seed = random_get_seed(&scene->gs->rand);
+
     fight_stats *fight_stats = &scene->gs->fight_stats;
     memset(fight_stats, 0, sizeof(*fight_stats));
 
     // Handle music playback
     switch(scene->bk_data->file_id) {
         case 8:
-            audio_play_music(PSM_ARENA0);
+            game_state_play_music(scene->gs, PSM_ARENA0);
             break;
         case 16:
-            audio_play_music(PSM_ARENA1);
+            game_state_play_music(scene->gs, PSM_ARENA1);
             break;
         case 32:
-            audio_play_music(PSM_ARENA2);
+            game_state_play_music(scene->gs, PSM_ARENA2);
             break;
         case 64:
-            audio_play_music(PSM_ARENA3);
+            game_state_play_music(scene->gs, PSM_ARENA3);
             break;
         case 128:
-            audio_play_music(PSM_ARENA4);
+            game_state_play_music(scene->gs, PSM_ARENA4);
             break;
     }
 
@@ -1484,6 +1559,7 @@ int arena_create(scene *scene) {
     local->state = ARENA_STATE_STARTING;
     local->ending_ticks = 0;
     local->rein_enabled = 0;
+    local->rec_start_tick = scene->gs->int_tick;
 
     local->round = 0;
     switch(scene->gs->match_settings.rounds) {
@@ -1510,10 +1586,10 @@ int arena_create(scene *scene) {
 
     // If this is the desert arena, randomly pick a palette. This changes the time of day.
     if(scene->bk_data->file_id == 128) {
-        int pal_index = rand_int(vector_size(&scene->bk_data->palettes));
+        int pal_index = random_int(&scene->gs->rand, vector_size(&scene->bk_data->palettes));
         if(pal_index > 0) {
             // 0 is selected by default, so nothing to do if we hit that.
-            vga_state_set_base_palette_from(bk_get_palette(scene->bk_data, pal_index));
+            vga_state_set_base_palette_from(scene->gs->vga, bk_get_palette(scene->bk_data, pal_index));
         }
     }
 
@@ -1536,7 +1612,7 @@ int arena_create(scene *scene) {
         object *obj = omf_calloc(1, sizeof(object));
 
         // load the player's colors into the palette
-        palette_load_player_colors(&player->pilot->palette, i);
+        palette_load_player_colors(scene->gs->vga, &player->pilot->palette, i);
 
         // Create object and specialize it as HAR.
         // Errors are unlikely here, but check anyway.
@@ -1780,6 +1856,7 @@ int arena_create(scene *scene) {
             sd_rec_free(scene->gs->rec);
         }
         sd_rec_create(scene->gs->rec);
+        scene->gs->rec->seed = seed;
         for(int i = 0; i < 2; i++) {
             // Declare some vars
             game_player *player = game_state_get_player(scene->gs, i);
@@ -1875,6 +1952,15 @@ int arena_create(scene *scene) {
         scene->gs->rec->hazards = scene->gs->match_settings.hazards;
         scene->gs->rec->round_type = scene->gs->match_settings.rounds;
         scene->gs->rec->hyper_mode = scene->gs->match_settings.fight_mode;
+
+        // header is complete, start writing the file
+        if(scene->gs->init_flags->record == 1) {
+            local->rec_stream = sd_rec_stream_open(scene->gs->rec, scene->gs->init_flags->rec_file);
+            if(local->rec_stream == NULL) {
+                log_error("Unable to open %s for recording, saving it at the end of the match",
+                          scene->gs->init_flags->rec_file);
+            }
+        }
     }
 
     // All done!
@@ -10,6 +10,17 @@ enum
     ARENA_STATE_ENDING
 };
 
+#define ARENA_MAX_ROUNDS 7
+
+// Outcome of a single round
+typedef struct arena_round_stats {
+    int winner;
+    uint32_t end_tick;         // Game tick at which the round was decided
+    int health[2];             // HAR health left at the end of the round
+    unsigned hits_landed[2];   // Hits landed during the round
+    unsigned total_attacks[2]; // Attacks attempted during the round
+} arena_round_stats;
+
 static const uint8_t wall_slam_tolerance_default = 7;
 static const uint8_t wall_slam_tolerance_powerplant = 5;
 
@@ -23,6 +34,10 @@ uint32_t arena_state_hash(game_state *gs);
 void arena_state_dump(game_state *gs, char *buf, size_t bufsize);
 void arena_reset(scene *sc);
 int arena_is_over(scene *sc);
+// Tick of the match, as the moves in gs->rec are stamped. Playback runs on int_tick from the start of the match,
+// so this counts the same ticks, including the ones spent paused.
+uint32_t arena_rec_tick(scene *sc);
+int arena_get_round_stats(scene *sc, arena_round_stats *dst, int max);
 int arena_get_wall_slam_tolerance(game_state *gs);
 
 #endif // ARENA_H
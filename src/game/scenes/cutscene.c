@@ -46,34 +46,32 @@ static void cutscene_input_tick(scene *scene) {
     cutscene_local *local = scene_get_userdata(scene);
     game_player *player1 = game_state_get_player(scene->gs, 0);
 
-    ctrl_event *p1 = NULL, *i;
+    ctrl_events p1;
+    ctrl_events_clear(&p1);
     game_state_menu_poll(scene->gs, &p1);
 
-    i = p1;
-    if(i) {
-        do {
-            if(i->type == EVENT_TYPE_ACTION) {
-                if(i->event_data.action == ACT_KICK || i->event_data.action == ACT_PUNCH) {
-
-                    if(player1->chr && player1->chr->cutscene_text[local->pos + 1]) {
-                        local->pos++;
-                        local->current = player1->chr->cutscene_text[local->pos];
-                    } else if(!player1->chr && strlen(local->current) + local->pos < local->len) {
-                        local->pos += strlen(local->current) + 1;
-                        local->current += strlen(local->current) + 1;
-                        char *p;
-                        if((p = strchr(local->current, '\n'))) {
-                            // null out the byte
-                            *p = '\0';
-                        }
-                    } else {
-                        game_state_set_next(scene->gs, cutscene_next_scene(scene));
+    for(unsigned int k = 0; k < p1.count; k++) {
+        const ctrl_event *i = &p1.events[k];
+        if(i->type == EVENT_TYPE_ACTION) {
+            if(i->action == ACT_KICK || i->action == ACT_PUNCH) {
+
+                if(player1->chr && player1->chr->cutscene_text[local->pos + 1]) {
+                    local->pos++;
+                    local->current = player1->chr->cutscene_text[local->pos];
+                } else if(!player1->chr && strlen(local->current) + local->pos < local->len) {
+                    local->pos += strlen(local->current) + 1;
+                    local->current += strlen(local->current) + 1;
+                    char *p;
+                    if((p = strchr(local->current, '\n'))) {
+                        // null out the byte
+                        *p = '\0';
                     }
+                } else {
+                    game_state_set_next(scene->gs, cutscene_next_scene(scene));
                 }
             }
-        } while((i = i->next) != NULL);
+        }
     }
-    controller_free_chain(p1);
 }
 
 static void cutscene_render_overlay(scene *scene) {
@@ -183,7 +181,7 @@ int cutscene_create(scene *scene) {
         case SCENE_WAR:
             // Load colors for the HAR -- note that cutscenes use an expanded HAR color slides.
             // World championship does not use these.
-            palette_set_player_expanded_color(&p1->chr->pilot.palette);
+            palette_set_player_expanded_color(scene->gs->vga, &p1->chr->pilot.palette);
             // Fall through!
         case SCENE_WORLD:
             audio_play_music(PSM_END);
@@ -9,22 +9,19 @@ typedef struct intro_local_t {
 } intro_local;
 
 void intro_input_tick(scene *scene) {
-    ctrl_event *p1 = NULL, *i;
+    ctrl_events p1;
+    ctrl_events_clear(&p1);
     game_state_menu_poll(scene->gs, &p1);
 
-    i = p1;
-    if(i) {
-        do {
-            if(i->type == EVENT_TYPE_ACTION) {
-                if(i->event_data.action == ACT_ESC || i->event_data.action == ACT_KICK ||
-                   i->event_data.action == ACT_PUNCH) {
+    for(unsigned int k = 0; k < p1.count; k++) {
+        const ctrl_event *i = &p1.events[k];
+        if(i->type == EVENT_TYPE_ACTION) {
+            if(i->action == ACT_ESC || i->action == ACT_KICK || i->action == ACT_PUNCH) {
 
-                    game_state_set_next(scene->gs, SCENE_MENU);
-                }
+                game_state_set_next(scene->gs, SCENE_MENU);
             }
-        } while((i = i->next) != NULL);
+        }
     }
-    controller_free_chain(p1);
 }
 
 void intro_startup(scene *scene, int id, int *m_load, int *m_repeat) {
@@ -189,30 +189,28 @@ void lobby_show_dialog(scene *scene, int dialog_style, char *dialog_text, dialog
 
 void lobby_input_tick(scene *scene) {
     lobby_local *local = scene_get_userdata(scene);
-    ctrl_event *p1 = NULL, *i;
+    ctrl_events p1;
+    ctrl_events_clear(&p1);
     game_state_menu_poll(scene->gs, &p1);
 
-    i = p1;
-    if(i) {
-        do {
-            if(local->dialog && dialog_is_visible(local->dialog)) {
-                dialog_event(local->dialog, p1->event_data.action);
-            } else if(i->type == EVENT_TYPE_ACTION && i->event_data.action == ACT_DOWN) {
-                local->active_user++;
-                if(local->active_user >= list_size(&local->users)) {
-                    local->active_user = 0;
-                }
-            } else if(i->type == EVENT_TYPE_ACTION && i->event_data.action == ACT_UP) {
-                local->active_user--;
-                if(local->active_user >= list_size(&local->users)) {
-                    local->active_user = list_size(&local->users) - 1;
-                }
-            } else {
-                gui_frame_action(local->frame, p1->event_data.action);
+    for(unsigned int k = 0; k < p1.count; k++) {
+        const ctrl_event *i = &p1.events[k];
+        if(local->dialog && dialog_is_visible(local->dialog)) {
+            dialog_event(local->dialog, i->action);
+        } else if(i->type == EVENT_TYPE_ACTION && i->action == ACT_DOWN) {
+            local->active_user++;
+            if(local->active_user >= list_size(&local->users)) {
+                local->active_user = 0;
             }
-        } while((i = i->next));
+        } else if(i->type == EVENT_TYPE_ACTION && i->action == ACT_UP) {
+            local->active_user--;
+            if(local->active_user >= list_size(&local->users)) {
+                local->active_user = list_size(&local->users) - 1;
+            }
+        } else {
+            gui_frame_action(local->frame, i->action);
+        }
     }
-    controller_free_chain(p1);
 }
 
 void lobby_render_overlay(scene *scene) {
@@ -25,7 +25,7 @@ void mainmenu_free(scene *scene) {
 
 void mainmenu_tick(scene *scene, int paused) {
     mainmenu_local *local = scene_get_userdata(scene);
-    palette_pulse_menu_colors(scene->gs->tick / 8);
+    palette_pulse_menu_colors(scene->gs->vga, scene->gs->tick / 8);
     gui_frame_tick(local->frame);
 }
 
@@ -33,15 +33,16 @@ void mainmenu_input_tick(scene *scene) {
     mainmenu_local *local = scene_get_userdata(scene);
 
     // Poll the controller
-    ctrl_event *ev = NULL, *p;
+    ctrl_events ev;
+    ctrl_events_clear(&ev);
     game_state_menu_poll(scene->gs, &ev);
-    for(p = ev; p; p = p->next) {
+    for(unsigned int k = 0; k < ev.count; k++) {
+        const ctrl_event *p = &ev.events[k];
         if(p->type == EVENT_TYPE_ACTION) {
             // Pass on the event
-            gui_frame_action(local->frame, p->event_data.action);
+            gui_frame_action(local->frame, p->action);
         }
     }
-    controller_free_chain(ev);
 }
 
 int mainmenu_event(scene *scene, SDL_Event *event) {
@@ -90,23 +90,19 @@ component *menu_language_create(scene *s) {
     foreach(it, filename) {
         // Get localized language name from OpenOMF .DAT2 or .LNG2 file
         str_format(&filename2, "%s%s2", dirname, filename);
-        sd_language lang2;
-        if(sd_language_create(&lang2) != SD_SUCCESS) {
-            continue;
-        }
-        if(sd_language_load(&lang2, str_c(&filename2))) {
+        // Only the language name is read, not the whole file
+        char *language_name;
+        unsigned int count;
+        int ret = sd_language_read_string(str_c(&filename2), LANG2_STR_LANGUAGE, &count, &language_name);
+        if(ret == SD_FILE_OPEN_ERROR) {
             log_info("Warning: Unable to load OpenOMF language file '%s'!", str_c(&filename2));
-            sd_language_free(&lang2);
             continue;
         }
-        if(lang2.count != LANG2_STR_COUNT) {
-            log_info("Warning: Invalid OpenOMF language file '%s', got %d entries!", str_c(&filename2), lang2.count);
-            sd_language_free(&lang2);
+        if(ret != SD_SUCCESS || count != LANG2_STR_COUNT) {
+            log_info("Warning: Invalid OpenOMF language file '%s', got %u entries!", str_c(&filename2), count);
+            omf_free(language_name);
             continue;
         }
-        char *language_name = lang2.strings[LANG2_STR_LANGUAGE].data;
-        lang2.strings[LANG2_STR_LANGUAGE].data = NULL;
-        sd_language_free(&lang2);
 
         if(strcmp(setting->language.language, filename) == 0) {
             local->selected_language = local->language_count;
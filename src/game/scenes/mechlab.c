@@ -254,6 +254,13 @@ void mechlab_tick(scene *scene, int paused) {
             mechlab_enter_trnselect_menu(scene);
         } else if(local->dashtype == DASHBOARD_SELECT_TOURNAMENT) {
             sd_tournament_file *trn = lab_dash_trnselect_selected(&local->tw);
+            if(trn == NULL) {
+                // Could not be loaded; stay in the menu so that another one can be picked
+                gui_frame_free(local->frame);
+                local->frame = gui_frame_create(0, 0, 320, 200);
+                mechlab_enter_trnselect_menu(scene);
+                return;
+            }
             if(player1->pilot->money < trn->registration_fee) {
                 player1->pilot->money = 0;
             } else {
@@ -428,61 +435,58 @@ void mechlab_input_tick(scene *scene) {
     game_player *player1 = game_state_get_player(scene->gs, 0);
 
     // Poll the controller
-    ctrl_event *p1 = NULL, *i;
+    ctrl_events p1;
+    ctrl_events_clear(&p1);
     game_state_menu_poll(scene->gs, &p1);
-    i = p1;
-    if(i == NULL) {
-        return;
-    }
-    do {
+    for(unsigned int k = 0; k < p1.count; k++) {
+        const ctrl_event *i = &p1.events[k];
         if(i->type == EVENT_TYPE_ACTION) {
             // If view is new dashboard view, pass all input to it
             if(local->dashtype == DASHBOARD_NEW_PLAYER) {
                 // If inputting text for new player name is done, switch to next view.
                 // If ESC, exit view.
                 // Otherwise handle text input
-                if(i->event_data.action == ACT_ESC) {
+                if(i->action == ACT_ESC) {
                     bool found = mechlab_find_last_player(scene);
                     mechlab_select_dashboard(scene, DASHBOARD_STATS);
                     gui_frame_set_root(local->frame, lab_menu_main_create(scene, found));
                     gui_frame_layout(local->frame);
-                } else if(i->event_data.action == ACT_KICK || i->event_data.action == ACT_PUNCH) {
+                } else if(i->action == ACT_KICK || i->action == ACT_PUNCH) {
                     if(strlen(textinput_value(local->nw.input)) > 0) {
                         strncpy(player1->pilot->name, textinput_value(local->nw.input), 17);
                         trnmenu_finish(
                             gui_frame_get_root(local->frame)); // This will trigger exception case in mechlab_tick
                     }
                 } else {
-                    log_debug("sending input %d to new player dash", i->event_data.action);
-                    gui_frame_action(local->dashboard, i->event_data.action);
+                    log_debug("sending input %d to new player dash", i->action);
+                    gui_frame_action(local->dashboard, i->action);
                 }
 
-            } else if(local->dashtype == DASHBOARD_SELECT_NEW_PIC && i->event_data.action == ACT_ESC) {
+            } else if(local->dashtype == DASHBOARD_SELECT_NEW_PIC && i->action == ACT_ESC) {
                 bool found = mechlab_find_last_player(scene);
                 mechlab_select_dashboard(scene, DASHBOARD_STATS);
                 gui_frame_set_root(local->frame, lab_menu_main_create(scene, found));
                 gui_frame_layout(local->frame);
-            } else if(local->dashtype == DASHBOARD_SELECT_DIFFICULTY && i->event_data.action == ACT_ESC) {
+            } else if(local->dashtype == DASHBOARD_SELECT_DIFFICULTY && i->action == ACT_ESC) {
                 bool found = mechlab_find_last_player(scene);
                 mechlab_select_dashboard(scene, DASHBOARD_STATS);
                 gui_frame_set_root(local->frame, lab_menu_main_create(scene, found));
                 gui_frame_layout(local->frame);
-            } else if(local->dashtype == DASHBOARD_SELECT_TOURNAMENT && i->event_data.action == ACT_ESC) {
+            } else if(local->dashtype == DASHBOARD_SELECT_TOURNAMENT && i->action == ACT_ESC) {
                 bool found = mechlab_find_last_player(scene);
                 mechlab_select_dashboard(scene, DASHBOARD_STATS);
                 gui_frame_set_root(local->frame, lab_menu_main_create(scene, found));
                 gui_frame_layout(local->frame);
-            } else if(local->dashtype == DASHBOARD_SIM && i->event_data.action == ACT_ESC) {
+            } else if(local->dashtype == DASHBOARD_SIM && i->action == ACT_ESC) {
                 bool found = mechlab_find_last_player(scene);
                 mechlab_select_dashboard(scene, DASHBOARD_STATS);
                 gui_frame_set_root(local->frame, lab_menu_main_create(scene, found));
                 gui_frame_layout(local->frame);
             } else {
-                gui_frame_action(local->frame, i->event_data.action);
+                gui_frame_action(local->frame, i->action);
             }
         }
-    } while((i = i->next));
-    controller_free_chain(p1);
+    }
 }
 
 // Init mechlab
@@ -30,7 +30,7 @@ bool lab_dash_main_photo_left(component *c, void *userdata) {
     portrait_prev(dw->photo[0]);
     dw->pilot->photo_id = portrait_selected(dw->photo[0]);
     portrait_load(dw->pilot->photo, &dw->pilot->palette, PIC_PLAYERS, dw->pilot->photo_id);
-    palette_load_player_colors(&dw->pilot->palette, 0);
+    palette_load_player_colors(dw->scene->gs->vga, &dw->pilot->palette, 0);
     return true;
 }
 
@@ -39,7 +39,7 @@ bool lab_dash_main_photo_right(component *c, void *userdata) {
     portrait_next(dw->photo[0]);
     dw->pilot->photo_id = portrait_selected(dw->photo[0]);
     portrait_load(dw->pilot->photo, &dw->pilot->palette, PIC_PLAYERS, dw->pilot->photo_id);
-    palette_load_player_colors(&dw->pilot->palette, 0);
+    palette_load_player_colors(dw->scene->gs->vga, &dw->pilot->palette, 0);
     return true;
 }
 
@@ -386,7 +386,7 @@ component *lab_dash_main_create(scene *s, dashboard_widgets *dw) {
         dw->pilot->photo_id = portrait_selected(dw->photo[0]);
         portrait_load(dw->pilot->photo, &dw->pilot->palette, PIC_PLAYERS, 0);
     }
-    palette_load_player_colors(&dw->pilot->palette, 0);
+    palette_load_player_colors(dw->scene->gs->vga, &dw->pilot->palette, 0);
 
     xysizer_attach(xy, dw->photo[0], 12, -1, -1, -1);
 
@@ -568,7 +568,7 @@ void lab_dash_main_update(scene *s, dashboard_widgets *dw) {
     }
 
     // Palette
-    palette_load_player_colors(&p1->pilot->palette, 0);
+    palette_load_player_colors(s->gs->vga, &p1->pilot->palette, 0);
 
     lab_dash_main_update_gauges(dw, p1->pilot);
 }
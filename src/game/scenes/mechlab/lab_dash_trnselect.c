@@ -41,7 +41,7 @@ component *lab_dash_trnselect_create(scene *s, trnselect_widgets *tw) {
     tconf.cdisabled = TEXT_TRN_BLUE;
 
     // Pilot image
-    tw->trnselect = trnselect_create();
+    tw->trnselect = trnselect_create(s->gs->vga);
     xysizer_attach(xy, tw->trnselect, -1, -1, -1, -1);
 
     return xy;
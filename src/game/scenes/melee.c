@@ -142,7 +142,7 @@ static int ticks_to_blinky(int ticks) {
     return offset;
 }
 
-static void set_cursor_colors(int a_ticks, int b_ticks, bool a_done, bool b_done) {
+static void set_cursor_colors(vga_state *vga, int a_ticks, int b_ticks, bool a_done, bool b_done) {
     int base = 120;
     int a_offset = ticks_to_blinky(a_ticks);
     int b_offset = ticks_to_blinky(b_ticks);
@@ -151,9 +151,9 @@ static void set_cursor_colors(int a_ticks, int b_ticks, bool a_done, bool b_done
     vga_color blue_cursor_color = {0, 0, base + (b_done ? 64 : b_offset)};
     vga_color violet_cursor_color = {base + a_offset, 0, base + a_offset};
 
-    vga_state_set_base_palette_index(RED_CURSOR_INDEX, &red_cursor_color);
-    vga_state_set_base_palette_index(BLUE_CURSOR_INDEX, &blue_cursor_color);
-    vga_state_set_base_palette_index(VIOLET_CURSOR_INDEX, &violet_cursor_color);
+    vga_state_set_base_palette_index(vga, RED_CURSOR_INDEX, &red_cursor_color);
+    vga_state_set_base_palette_index(vga, BLUE_CURSOR_INDEX, &blue_cursor_color);
+    vga_state_set_base_palette_index(vga, VIOLET_CURSOR_INDEX, &violet_cursor_color);
 }
 
 static void load_pilot_portraits_palette(scene *scene) {
@@ -167,37 +167,32 @@ static void load_pilot_portraits_palette(scene *scene) {
         src.b /= 2;
         bk_pal->colors[idx] = src;
     }
-    vga_state_set_base_palette_from_range(bk_pal, 0x00, 0x00, 0x60);
+    vga_state_set_base_palette_from_range(scene->gs->vga, bk_pal, 0x00, 0x00, 0x60);
 }
 
 void melee_tick(scene *scene, int paused) {
     melee_local *local = scene_get_userdata(scene);
     game_player *player1 = game_state_get_player(scene->gs, 0);
     game_player *player2 = game_state_get_player(scene->gs, 1);
-    ctrl_event *i = NULL;
 
     // Handle extra controller inputs
-    i = player1->ctrl->extra_events;
-    if(i) {
-        do {
-            if(i->type == EVENT_TYPE_ACTION) {
-                handle_action(scene, 0, i->event_data.action);
-            } else if(i->type == EVENT_TYPE_CLOSE) {
-                game_state_set_next(scene->gs, SCENE_MENU);
-                return;
-            }
-        } while((i = i->next) != NULL);
-    }
-    i = player2->ctrl->extra_events;
-    if(i) {
-        do {
-            if(i->type == EVENT_TYPE_ACTION) {
-                handle_action(scene, 1, i->event_data.action);
-            } else if(i->type == EVENT_TYPE_CLOSE) {
-                game_state_set_next(scene->gs, SCENE_MENU);
-                return;
-            }
-        } while((i = i->next) != NULL);
+    for(unsigned int k = 0; k < player1->ctrl->extra_events.count; k++) {
+        const ctrl_event *i = &player1->ctrl->extra_events.events[k];
+        if(i->type == EVENT_TYPE_ACTION) {
+            handle_action(scene, 0, i->action);
+        } else if(i->type == EVENT_TYPE_CLOSE) {
+            game_state_set_next(scene->gs, SCENE_MENU);
+            return;
+        }
+    }
+    for(unsigned int k = 0; k < player2->ctrl->extra_events.count; k++) {
+        const ctrl_event *i = &player2->ctrl->extra_events.events[k];
+        if(i->type == EVENT_TYPE_ACTION) {
+            handle_action(scene, 1, i->action);
+        } else if(i->type == EVENT_TYPE_CLOSE) {
+            game_state_set_next(scene->gs, SCENE_MENU);
+            return;
+        }
     }
 
     if(local->page == HAR_SELECT && local->ticks % 10 == 1) {
@@ -208,8 +203,8 @@ void melee_tick(scene *scene, int paused) {
     }
 
     // Tick cursor colors
-    set_cursor_colors(local->ticks - local->tickbase[0], local->ticks - local->tickbase[1], CURSOR_A_DONE(local),
-                      CURSOR_B_DONE(local));
+    set_cursor_colors(scene->gs->vga, local->ticks - local->tickbase[0], local->ticks - local->tickbase[1],
+                      CURSOR_A_DONE(local), CURSOR_B_DONE(local));
     local->ticks++;
 }
 
@@ -331,7 +326,7 @@ void handle_action(scene *scene, int player, int action) {
                     sd_pilot_set_player_color(player1->pilot, TERTIARY, p_a.colors[0]);
                     sd_pilot_set_player_color(player1->pilot, SECONDARY, p_a.colors[1]);
                     sd_pilot_set_player_color(player1->pilot, PRIMARY, p_a.colors[2]);
-                    palette_load_player_colors(&player1->pilot->palette, 0);
+                    palette_load_player_colors(scene->gs->vga, &player1->pilot->palette, 0);
 
                     if(player2->selectable) {
                         object_select_sprite(&local->big_portrait_2, local->pilot_id_b);
@@ -344,7 +339,7 @@ void handle_action(scene *scene, int player, int action) {
                         sd_pilot_set_player_color(player2->pilot, TERTIARY, p_a.colors[0]);
                         sd_pilot_set_player_color(player2->pilot, SECONDARY, p_a.colors[1]);
                         sd_pilot_set_player_color(player2->pilot, PRIMARY, p_a.colors[2]);
-                        palette_load_player_colors(&player2->pilot->palette, 1);
+                        palette_load_player_colors(scene->gs->vga, &player2->pilot->palette, 1);
                     }
                 } else {
                     int nova_activated[2] = {1, 1};
@@ -446,37 +441,35 @@ void melee_input_tick(scene *scene) {
     melee_local *local = scene_get_userdata(scene);
     game_player *player1 = game_state_get_player(scene->gs, 0);
     game_player *player2 = game_state_get_player(scene->gs, 1);
-    ctrl_event *p1 = NULL, *p2 = NULL, *i;
+    ctrl_events p1, p2;
+    ctrl_events_clear(&p1);
+    ctrl_events_clear(&p2);
     controller_poll(player1->ctrl, &p1);
     controller_poll(player2->ctrl, &p2);
-    i = p1;
-    if(i) {
-        do {
-            if(i->type == EVENT_TYPE_ACTION) {
-                handle_action(scene, 0, i->event_data.action);
-            } else if(i->type == EVENT_TYPE_CLOSE) {
-                game_state_set_next(scene->gs, SCENE_MENU);
-            }
-        } while((i = i->next) != NULL);
-    }
-    controller_free_chain(p1);
-    i = p2;
-    if(i) {
-        do {
-            if(i->type == EVENT_TYPE_ACTION) {
-                handle_action(scene, 1, i->event_data.action);
-            } else if(i->type == EVENT_TYPE_CLOSE) {
-                game_state_set_next(scene->gs, SCENE_MENU);
-            }
-        } while((i = i->next) != NULL);
+    for(unsigned int k = 0; k < p1.count; k++) {
+        const ctrl_event *i = &p1.events[k];
+        if(i->type == EVENT_TYPE_ACTION) {
+            handle_action(scene, 0, i->action);
+        } else if(i->type == EVENT_TYPE_CLOSE) {
+            game_state_set_next(scene->gs, SCENE_MENU);
+        }
+    }
+    for(unsigned int k = 0; k < p2.count; k++) {
+        const ctrl_event *i = &p2.events[k];
+        if(i->type == EVENT_TYPE_ACTION) {
+            handle_action(scene, 1, i->action);
+        } else if(i->type == EVENT_TYPE_CLOSE) {
+            game_state_set_next(scene->gs, SCENE_MENU);
+        }
     }
-    controller_free_chain(p2);
 
-    ctrl_event *menu_ev = NULL;
+    ctrl_events menu_ev;
+    ctrl_events_clear(&menu_ev);
     game_state_menu_poll(scene->gs, &menu_ev);
 
-    for(i = menu_ev; i; i = i->next) {
-        if(i->type == EVENT_TYPE_ACTION && i->event_data.action == ACT_ESC) {
+    for(unsigned int k = 0; k < menu_ev.count; k++) {
+        const ctrl_event *i = &menu_ev.events[k];
+        if(i->type == EVENT_TYPE_ACTION && i->action == ACT_ESC) {
             audio_play_sound(20, 0.5f, 0.0f, 2.0f);
             if(local->page == HAR_SELECT) {
                 // restore the player selection
@@ -493,7 +486,6 @@ void melee_input_tick(scene *scene) {
             }
         }
     }
-    controller_free_chain(menu_ev);
 }
 
 static void draw_highlight(const melee_local *local, const cursor_data *cursor, int offset) {
@@ -762,9 +754,9 @@ int melee_create(scene *scene) {
     controller *player1_ctrl = game_player_get_ctrl(player1);
     controller *player2_ctrl = game_player_get_ctrl(player2);
 
-    palette_set_player_color(0, 8, 0);
-    palette_set_player_color(0, 8, 1);
-    palette_set_player_color(0, 8, 2);
+    palette_set_player_color(scene->gs->vga, 0, 8, 0);
+    palette_set_player_color(scene->gs->vga, 0, 8, 1);
+    palette_set_player_color(scene->gs->vga, 0, 8, 2);
 
     menu_background_create(&local->bg_player_stats, 90, 61, MenuBackgroundMeleeVs);
     menu_background_create(&local->bg_player_bio, 160, 43, MenuBackgroundMeleeVs);
@@ -836,7 +828,7 @@ int melee_create(scene *scene) {
     component_layout(local->bar_endurance[1], 320 - 66 - local->bg_player_stats.w, 48, 20 * 4, 8);
 
     refresh_pilot_stats(local);
-    set_cursor_colors(0, 0, false, false);
+    set_cursor_colors(scene->gs->vga, 0, 0, false, false);
 
     // initialize nova selection cheat
     memset(local->har_selected, 0, sizeof(local->har_selected));
@@ -222,87 +222,84 @@ void newsroom_input_tick(scene *scene) {
     game_player *p1 = game_state_get_player(scene->gs, 0);
     game_player *p2 = game_state_get_player(scene->gs, 1);
 
-    ctrl_event *event = NULL, *i;
+    ctrl_events event;
+    ctrl_events_clear(&event);
     game_state_menu_poll(scene->gs, &event);
-    i = event;
-    if(i) {
-        do {
-            if(i->type == EVENT_TYPE_ACTION) {
-                if(dialog_is_visible(&local->continue_dialog)) {
-                    dialog_event(&local->continue_dialog, i->event_data.action);
-                } else if(i->event_data.action == ACT_ESC || i->event_data.action == ACT_KICK ||
-                          i->event_data.action == ACT_PUNCH) {
-                    local->screen++;
-                    newsroom_fixup_str(local);
-
-                    if((local->screen >= 2 && !local->champion) || local->screen >= 3) {
-                        if(local->won || p1->chr) {
-                            // pick a new player
-                            if(p1->chr) {
-                                // clear the opponent as a signal to display plug on the VS
-                                p2->pilot = NULL;
-                                // also zero out the p2 wins so the game doesn't think
-                                // we keep losing
-                                p2->sp_wins = 0;
+    for(unsigned int k = 0; k < event.count; k++) {
+        const ctrl_event *i = &event.events[k];
+        if(i->type == EVENT_TYPE_ACTION) {
+            if(dialog_is_visible(&local->continue_dialog)) {
+                dialog_event(&local->continue_dialog, i->action);
+            } else if(i->action == ACT_ESC || i->action == ACT_KICK || i->action == ACT_PUNCH) {
+                local->screen++;
+                newsroom_fixup_str(local);
+
+                if((local->screen >= 2 && !local->champion) || local->screen >= 3) {
+                    if(local->won || p1->chr) {
+                        // pick a new player
+                        if(p1->chr) {
+                            // clear the opponent as a signal to display plug on the VS
+                            p2->pilot = NULL;
+                            // also zero out the p2 wins so the game doesn't think
+                            // we keep losing
+                            p2->sp_wins = 0;
+                        } else {
+                            log_debug("wins are %d", p1->sp_wins);
+                            if(p1->sp_wins == (4094 ^ (2 << p1->pilot->pilot_id))) {
+                                // won the game
+                                game_state_set_next(scene->gs, SCENE_END);
                             } else {
-                                log_debug("wins are %d", p1->sp_wins);
-                                if(p1->sp_wins == (4094 ^ (2 << p1->pilot->pilot_id))) {
-                                    // won the game
-                                    game_state_set_next(scene->gs, SCENE_END);
+                                if(p1->sp_wins == (2046 ^ (2 << p1->pilot->pilot_id))) {
+                                    // everyone but kreissack
+                                    p2->pilot->pilot_id = PILOT_KREISSACK;
+                                    p2->pilot->har_id = HAR_NOVA;
                                 } else {
-                                    if(p1->sp_wins == (2046 ^ (2 << p1->pilot->pilot_id))) {
-                                        // everyone but kreissack
-                                        p2->pilot->pilot_id = PILOT_KREISSACK;
-                                        p2->pilot->har_id = HAR_NOVA;
-                                    } else {
-                                        // pick an opponent we have not yet beaten
-                                        while(1) {
-                                            int i = rand_int(10);
-                                            if((2 << i) & p1->sp_wins || i == p1->pilot->pilot_id) {
-                                                continue;
-                                            }
-                                            p2->pilot->pilot_id = i;
-                                            p2->pilot->har_id = rand_int(10);
-                                            break;
+                                    // pick an opponent we have not yet beaten
+                                    while(1) {
+                                        int i = rand_int(10);
+                                        if((2 << i) & p1->sp_wins || i == p1->pilot->pilot_id) {
+                                            continue;
                                         }
+                                        p2->pilot->pilot_id = i;
+                                        p2->pilot->har_id = rand_int(10);
+                                        break;
                                     }
-                                    pilot p;
-                                    pilot_get_info(&p, p2->pilot->pilot_id);
-                                    sd_pilot_set_player_color(p2->pilot, TERTIARY, p.colors[0]);
-                                    sd_pilot_set_player_color(p2->pilot, SECONDARY, p.colors[1]);
-                                    sd_pilot_set_player_color(p2->pilot, PRIMARY, p.colors[2]);
-
-                                    strncpy_or_truncate(p2->pilot->name, lang_get(p2->pilot->pilot_id + 20),
-                                                        sizeof(p2->pilot->name));
-                                    // TODO: lang: remove (the need for) newline stripping
-                                    // 1player name strings end in a newline...
-                                    if(p2->pilot->name[strlen(p2->pilot->name) - 1] == '\n') {
-                                        p2->pilot->name[strlen(p2->pilot->name) - 1] = 0;
-                                    }
-
-                                    // make a new AI controller
-                                    controller *ctrl = omf_calloc(1, sizeof(controller));
-                                    controller_init(ctrl, scene->gs);
-                                    sd_pilot *pilot = game_player_get_pilot(p2);
-                                    ai_controller_create(ctrl, settings_get()->gameplay.difficulty, pilot,
-                                                         p2->pilot->pilot_id);
-                                    game_player_set_ctrl(p2, ctrl);
                                 }
+                                pilot p;
+                                pilot_get_info(&p, p2->pilot->pilot_id);
+                                sd_pilot_set_player_color(p2->pilot, TERTIARY, p.colors[0]);
+                                sd_pilot_set_player_color(p2->pilot, SECONDARY, p.colors[1]);
+                                sd_pilot_set_player_color(p2->pilot, PRIMARY, p.colors[2]);
+
+                                strncpy_or_truncate(p2->pilot->name, lang_get(p2->pilot->pilot_id + 20),
+                                                    sizeof(p2->pilot->name));
+                                // TODO: lang: remove (the need for) newline stripping
+                                // 1player name strings end in a newline...
+                                if(p2->pilot->name[strlen(p2->pilot->name) - 1] == '\n') {
+                                    p2->pilot->name[strlen(p2->pilot->name) - 1] = 0;
+                                }
+
+                                // make a new AI controller
+                                controller *ctrl = omf_calloc(1, sizeof(controller));
+                                controller_init(ctrl, scene->gs);
+                                sd_pilot *pilot = game_player_get_pilot(p2);
+                                ai_controller_create(ctrl, settings_get()->gameplay.difficulty, pilot,
+                                                     p2->pilot->pilot_id);
+                                game_player_set_ctrl(p2, ctrl);
                             }
-                            if(p1->chr && local->champion) {
-                                game_state_set_next(scene->gs, p1->chr->cutscene);
-                            } else {
-                                game_state_set_next(scene->gs, SCENE_VS);
-                            }
+                        }
+                        if(p1->chr && local->champion) {
+                            game_state_set_next(scene->gs, p1->chr->cutscene);
                         } else {
-                            dialog_show(&local->continue_dialog, 1);
+                            game_state_set_next(scene->gs, SCENE_VS);
                         }
+                    } else {
+                        dialog_show(&local->continue_dialog, 1);
                     }
                 }
             }
-        } while((i = i->next));
+        }
     }
-    controller_free_chain(event);
 }
 
 void newsroom_startup(scene *scene, int id, int *m_load, int *m_repeat) {
@@ -392,7 +389,7 @@ int newsroom_create(scene *scene) {
         game_player *player = game_state_get_player(scene->gs, i);
 
         // load the player's colors into the palette
-        palette_load_player_colors(&player->pilot->palette, i);
+        palette_load_player_colors(scene->gs->vga, &player->pilot->palette, i);
     }
 
     // Set callbacks
@@ -82,39 +82,36 @@ void scoreboard_tick(scene *scene, int paused) {
 
 void scoreboard_input_tick(scene *scene) {
     scoreboard_local *local = scene_get_userdata(scene);
-    ctrl_event *p1 = NULL, *i;
+    ctrl_events p1;
+    ctrl_events_clear(&p1);
     game_state_menu_poll(scene->gs, &p1);
-    i = p1;
-    if(i) {
-        do {
-            if(i->type == EVENT_TYPE_ACTION) {
-                // If there is pending data, and name has been given, save
-                if(local->has_pending_data && (i->event_data.action == ACT_KICK || i->event_data.action == ACT_PUNCH)) {
-
-                    handle_scoreboard_save(local);
-                    local->has_pending_data = 0;
-
-                    // Normal exit routine
-                    // Only allow if there is no pending data.
-                } else if(!local->has_pending_data &&
-                          (i->event_data.action == ACT_ESC || i->event_data.action == ACT_KICK ||
-                           i->event_data.action == ACT_PUNCH)) {
-
-                    game_state_set_next(scene->gs, scene->gs->next_next_id);
-
-                    // If left or right button is pressed, change page
-                    // but only if we are not in input mode.
-                } else if(!local->has_pending_data && i->event_data.action == ACT_LEFT) {
-                    local->page = (local->page > 0) ? local->page - 1 : 0;
-                } else if(!local->has_pending_data && i->event_data.action == ACT_RIGHT) {
-                    local->page = (local->page < MAX_PAGES) ? local->page + 1 : MAX_PAGES;
-                } else if(local->has_pending_data) {
-                    gui_frame_action(local->frame, i->event_data.action);
-                }
+    for(unsigned int k = 0; k < p1.count; k++) {
+        const ctrl_event *i = &p1.events[k];
+        if(i->type == EVENT_TYPE_ACTION) {
+            // If there is pending data, and name has been given, save
+            if(local->has_pending_data && (i->action == ACT_KICK || i->action == ACT_PUNCH)) {
+
+                handle_scoreboard_save(local);
+                local->has_pending_data = 0;
+
+                // Normal exit routine
+                // Only allow if there is no pending data.
+            } else if(!local->has_pending_data &&
+                      (i->action == ACT_ESC || i->action == ACT_KICK || i->action == ACT_PUNCH)) {
+
+                game_state_set_next(scene->gs, scene->gs->next_next_id);
+
+                // If left or right button is pressed, change page
+                // but only if we are not in input mode.
+            } else if(!local->has_pending_data && i->action == ACT_LEFT) {
+                local->page = (local->page > 0) ? local->page - 1 : 0;
+            } else if(!local->has_pending_data && i->action == ACT_RIGHT) {
+                local->page = (local->page < MAX_PAGES) ? local->page + 1 : MAX_PAGES;
+            } else if(local->has_pending_data) {
+                gui_frame_action(local->frame, i->action);
             }
-        } while((i = i->next));
+        }
     }
-    controller_free_chain(p1);
 }
 
 void scoreboard_render_overlay(scene *scene) {
@@ -222,7 +219,7 @@ int scoreboard_create(scene *scene) {
     }
 
     // Darken the colors for the background a bit.
-    vga_state_mul_base_palette(0, 0xEF, 0.6f);
+    vga_state_mul_base_palette(scene->gs->vga, 0, 0xEF, 0.6f);
 
     if(local->has_pending_data) {
         text_settings small_text;
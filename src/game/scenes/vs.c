@@ -182,18 +182,15 @@ void vs_handle_action(scene *scene, int action) {
 
 void vs_dynamic_tick(scene *scene, int paused) {
     game_player *player1 = game_state_get_player(scene->gs, 0);
-    ctrl_event *i = NULL;
     // Handle extra controller inputs
-    i = player1->ctrl->extra_events;
-    if(i) {
-        do {
-            if(i->type == EVENT_TYPE_ACTION) {
-                vs_handle_action(scene, i->event_data.action);
-            } else if(i->type == EVENT_TYPE_CLOSE) {
-                game_state_set_next(scene->gs, SCENE_MENU);
-                return;
-            }
-        } while((i = i->next));
+    for(unsigned int k = 0; k < player1->ctrl->extra_events.count; k++) {
+        const ctrl_event *i = &player1->ctrl->extra_events.events[k];
+        if(i->type == EVENT_TYPE_ACTION) {
+            vs_handle_action(scene, i->action);
+        } else if(i->type == EVENT_TYPE_CLOSE) {
+            game_state_set_next(scene->gs, SCENE_MENU);
+            return;
+        }
     }
 }
 
@@ -209,15 +206,17 @@ void vs_static_tick(scene *scene, int paused) {
 void vs_input_tick(scene *scene) {
     vs_local *local = scene->userdata;
     game_player *player1 = game_state_get_player(scene->gs, 0);
-    ctrl_event *menu_ev = NULL;
+    ctrl_events menu_ev;
+    ctrl_events_clear(&menu_ev);
     game_state_menu_poll(scene->gs, &menu_ev);
 
-    for(ctrl_event *i = menu_ev; i; i = i->next) {
-        if(i->type == EVENT_TYPE_ACTION && i->event_data.action == ACT_ESC) {
+    for(unsigned int k = 0; k < menu_ev.count; k++) {
+        const ctrl_event *i = &menu_ev.events[k];
+        if(i->type == EVENT_TYPE_ACTION && i->action == ACT_ESC) {
             if(dialog_is_visible(&local->too_pathetic_dialog)) {
-                dialog_event(&local->too_pathetic_dialog, i->event_data.action);
+                dialog_event(&local->too_pathetic_dialog, i->action);
             } else if(dialog_is_visible(&local->quit_dialog)) {
-                dialog_event(&local->quit_dialog, i->event_data.action);
+                dialog_event(&local->quit_dialog, i->action);
             } else if(vs_is_singleplayer(scene) && player1->sp_wins != 0 && !player1->chr) {
                 // there's an active singleplayer campaign, confirm quitting
                 dialog_show(&local->quit_dialog, 1);
@@ -234,21 +233,18 @@ void vs_input_tick(scene *scene) {
             }
         }
     }
-    controller_free_chain(menu_ev);
 
-    ctrl_event *p1 = NULL, *i;
+    ctrl_events p1;
+    ctrl_events_clear(&p1);
     controller_poll(player1->ctrl, &p1);
-    i = p1;
-    if(i) {
-        do {
-            if(i->type == EVENT_TYPE_ACTION) {
-                vs_handle_action(scene, i->event_data.action);
-            } else if(i->type == EVENT_TYPE_CLOSE) {
-                game_state_set_next(scene->gs, SCENE_MENU);
-            }
-        } while((i = i->next));
+    for(unsigned int k = 0; k < p1.count; k++) {
+        const ctrl_event *i = &p1.events[k];
+        if(i->type == EVENT_TYPE_ACTION) {
+            vs_handle_action(scene, i->action);
+        } else if(i->type == EVENT_TYPE_CLOSE) {
+            game_state_set_next(scene->gs, SCENE_MENU);
+        }
     }
-    controller_free_chain(p1);
 }
 
 void vs_render_fight_stats(scene *scene, text_settings *tconf_yellow) {
@@ -470,9 +466,9 @@ int vs_create(scene *scene) {
     }
 
     // Set player palettes
-    palette_load_player_colors(&player1->pilot->palette, 0);
+    palette_load_player_colors(scene->gs->vga, &player1->pilot->palette, 0);
     if(player2->pilot) {
-        palette_load_player_colors(&player2->pilot->palette, 1);
+        palette_load_player_colors(scene->gs->vga, &player2->pilot->palette, 1);
     }
 
     // HAR
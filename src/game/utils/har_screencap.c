@@ -1,6 +1,5 @@
 #include "game/utils/har_screencap.h"
 #include "utils/miscmath.h"
-#include "video/vga_state.h"
 #include "video/video.h"
 
 void har_screencaps_create(har_screencaps *caps) {
@@ -64,13 +63,10 @@ void har_screencaps_capture(har_screencaps *caps, object *obj, object *obj2, int
         pos.y -= (size.y - SCREENCAP_H) / 2;
     }
 
-    // Render offscreen and capture.
-    SDL_Rect clip_area = {pos.x, pos.y, size.x, size.y};
-    video_render_area_prepare(&clip_area);
-    gs->hide_ui = true;
-    game_state_render(gs);
-    gs->hide_ui = false;
-    video_render_area_finish(&caps->cap[id]);
+    // Composite on the CPU, so that we never have to wait on the renderer. The camera position is
+    // in bottom-up framebuffer coordinates, so flip it for the surface.
+    game_state_render_to_surface(gs, &caps->cap[id], pos.x, NATIVE_H - pos.y - size.y, size.x, size.y);
+    surface_set_transparency(&caps->cap[id], -1);
     caps->ok[id] = true;
 }
 
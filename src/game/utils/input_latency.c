@@ -0,0 +1,250 @@
+#include "game/utils/input_latency.h"
+#include "controller/controller.h"
+#include "game/gui/text_render.h"
+#include "utils/log.h"
+#include "utils/miscmath.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Game speed settings, 0-10
+#define LATENCY_SPEEDS 11
+
+// 1 ms buckets. The last one collects everything slower.
+#define LATENCY_BUCKETS 256
+
+// Presses that have been held for longer than this are not counted, eg. keys held over a scene change
+#define LATENCY_MAX_AGE_MS 1000
+
+#define LATENCY_MAX_PADS 8
+#define LATENCY_MAX_PENDING 32
+
+// Same as the half-way dead zone of joystick.c
+#define AXIS_THRESHOLD 16384
+
+typedef struct pad_state {
+    SDL_JoystickID id;
+    bool used;
+    uint64_t stamp;
+    bool axis_down[SDL_CONTROLLER_AXIS_MAX];
+} pad_state;
+
+typedef struct pending_sample {
+    int device;
+    unsigned int speed;
+    uint64_t stamp;
+    uint64_t acted;
+} pending_sample;
+
+typedef struct latency_histogram {
+    uint32_t act[LATENCY_BUCKETS];   // press to HAR action
+    uint32_t frame[LATENCY_BUCKETS]; // press to presented frame
+    uint32_t count;
+    float last_act_ms;
+    float last_frame_ms;
+} latency_histogram;
+
+static struct {
+    uint64_t keys[SDL_NUM_SCANCODES];
+    pad_state pads[LATENCY_MAX_PADS];
+    pending_sample pending[LATENCY_MAX_PENDING];
+    int pending_count;
+    latency_histogram histograms[LATENCY_DEVICE_COUNT][LATENCY_SPEEDS];
+    int last_device;
+    unsigned int last_speed;
+    FILE *csv;
+    bool overlay;
+} latency;
+
+static const char *device_names[LATENCY_DEVICE_COUNT] = {"keyboard", "gamepad"};
+
+static float counter_to_ms(uint64_t delta) {
+    return delta * 1000.0f / SDL_GetPerformanceFrequency();
+}
+
+static pad_state *find_pad(SDL_JoystickID id) {
+    pad_state *free_pad = NULL;
+    for(int i = 0; i < LATENCY_MAX_PADS; i++) {
+        if(latency.pads[i].used && latency.pads[i].id == id) {
+            return &latency.pads[i];
+        }
+        if(!latency.pads[i].used && free_pad == NULL) {
+            free_pad = &latency.pads[i];
+        }
+    }
+    if(free_pad != NULL) {
+        memset(free_pad, 0, sizeof(pad_state));
+        free_pad->id = id;
+        free_pad->used = true;
+    }
+    return free_pad;
+}
+
+// Returns the stamp if it is recent enough to be a press that was just picked up
+static uint64_t take_stamp(uint64_t *stamp) {
+    uint64_t taken = *stamp;
+    *stamp = 0;
+    if(taken == 0 || counter_to_ms(SDL_GetPerformanceCounter() - taken) > LATENCY_MAX_AGE_MS) {
+        return 0;
+    }
+    return taken;
+}
+
+static void record(uint32_t *buckets, float ms) {
+    buckets[clamp((int)ms, 0, LATENCY_BUCKETS - 1)]++;
+}
+
+// Upper bound in ms of the given percentile
+static int histogram_percentile(const uint32_t *buckets, uint32_t count, int percent) {
+    uint32_t limit = (count * percent + 99) / 100;
+    uint32_t total = 0;
+    for(int i = 0; i < LATENCY_BUCKETS; i++) {
+        total += buckets[i];
+        if(total >= limit) {
+            return i + 1;
+        }
+    }
+    return LATENCY_BUCKETS;
+}
+
+void input_latency_init(const char *csv_path) {
+    if(csv_path == NULL || csv_path[0] == '\0') {
+        return;
+    }
+    if((latency.csv = fopen(csv_path, "w")) == NULL) {
+        log_error("Unable to open %s for writing input latency", csv_path);
+        return;
+    }
+    fprintf(latency.csv, "device,speed,act_ms,frame_ms\n");
+    log_info("Writing input latency samples to %s", csv_path);
+}
+
+void input_latency_close(void) {
+    for(int d = 0; d < LATENCY_DEVICE_COUNT; d++) {
+        for(int s = 0; s < LATENCY_SPEEDS; s++) {
+            const latency_histogram *hist = &latency.histograms[d][s];
+            if(hist->count == 0) {
+                continue;
+            }
+            log_info("Input latency, %s at speed %d: %u samples, action p50 %d ms p95 %d ms, "
+                     "frame p50 %d ms p95 %d ms p99 %d ms",
+                     device_names[d], s, hist->count, histogram_percentile(hist->act, hist->count, 50),
+                     histogram_percentile(hist->act, hist->count, 95),
+                     histogram_percentile(hist->frame, hist->count, 50),
+                     histogram_percentile(hist->frame, hist->count, 95),
+                     histogram_percentile(hist->frame, hist->count, 99));
+        }
+    }
+    if(latency.csv != NULL) {
+        fclose(latency.csv);
+    }
+    memset(&latency, 0, sizeof(latency));
+}
+
+void input_latency_event(const SDL_Event *event) {
+    pad_state *pad;
+    switch(event->type) {
+        case SDL_KEYDOWN:
+            if(!event->key.repeat) {
+                latency.keys[event->key.keysym.scancode] = SDL_GetPerformanceCounter();
+            }
+            break;
+        case SDL_KEYUP:
+            latency.keys[event->key.keysym.scancode] = 0;
+            break;
+        case SDL_CONTROLLERBUTTONDOWN:
+            if((pad = find_pad(event->cbutton.which)) != NULL && pad->stamp == 0) {
+                pad->stamp = SDL_GetPerformanceCounter();
+            }
+            break;
+        case SDL_CONTROLLERAXISMOTION:
+            if((pad = find_pad(event->caxis.which)) != NULL && event->caxis.axis < SDL_CONTROLLER_AXIS_MAX) {
+                bool down = abs(event->caxis.value) >= AXIS_THRESHOLD;
+                if(down && !pad->axis_down[event->caxis.axis] && pad->stamp == 0) {
+                    pad->stamp = SDL_GetPerformanceCounter();
+                }
+                pad->axis_down[event->caxis.axis] = down;
+            }
+            break;
+        case SDL_CONTROLLERDEVICEREMOVED:
+            if((pad = find_pad(event->cdevice.which)) != NULL) {
+                pad->used = false;
+            }
+            break;
+    }
+}
+
+uint64_t input_latency_take_key(unsigned int scancode) {
+    if(scancode >= SDL_NUM_SCANCODES) {
+        return 0;
+    }
+    return take_stamp(&latency.keys[scancode]);
+}
+
+uint64_t input_latency_take_gamepad(SDL_JoystickID id) {
+    pad_state *pad = find_pad(id);
+    if(pad == NULL) {
+        return 0;
+    }
+    return take_stamp(&pad->stamp);
+}
+
+void input_latency_acted(uint64_t stamp, int ctrl_type, unsigned int speed) {
+    if(latency.pending_count >= LATENCY_MAX_PENDING) {
+        return;
+    }
+    pending_sample *sample = &latency.pending[latency.pending_count++];
+    sample->device = ctrl_type == CTRL_TYPE_GAMEPAD ? LATENCY_GAMEPAD : LATENCY_KEYBOARD;
+    sample->speed = min2(speed, LATENCY_SPEEDS - 1);
+    sample->stamp = stamp;
+    sample->acted = SDL_GetPerformanceCounter();
+}
+
+void input_latency_presented(void) {
+    if(latency.pending_count == 0) {
+        return;
+    }
+    uint64_t now = SDL_GetPerformanceCounter();
+    for(int i = 0; i < latency.pending_count; i++) {
+        const pending_sample *sample = &latency.pending[i];
+        latency_histogram *hist = &latency.histograms[sample->device][sample->speed];
+        hist->last_act_ms = counter_to_ms(sample->acted - sample->stamp);
+        hist->last_frame_ms = counter_to_ms(now - sample->stamp);
+        record(hist->act, hist->last_act_ms);
+        record(hist->frame, hist->last_frame_ms);
+        hist->count++;
+        latency.last_device = sample->device;
+        latency.last_speed = sample->speed;
+        if(latency.csv != NULL) {
+            fprintf(latency.csv, "%s,%u,%.3f,%.3f\n", device_names[sample->device], sample->speed,
+                    hist->last_act_ms, hist->last_frame_ms);
+        }
+    }
+    latency.pending_count = 0;
+}
+
+bool input_latency_toggle_overlay(void) {
+    latency.overlay = !latency.overlay;
+    return latency.overlay;
+}
+
+void input_latency_render(void) {
+    if(!latency.overlay) {
+        return;
+    }
+    const latency_histogram *hist = &latency.histograms[latency.last_device][latency.last_speed];
+    char buf[128];
+    if(hist->count == 0) {
+        snprintf(buf, sizeof(buf), "input latency: no samples");
+    } else {
+        snprintf(buf, sizeof(buf), "%s speed %u: last %.1f/%.1f ms, frame p50 %d p95 %d ms (%u)",
+                 device_names[latency.last_device], latency.last_speed, hist->last_act_ms, hist->last_frame_ms,
+                 histogram_percentile(hist->frame, hist->count, 50),
+                 histogram_percentile(hist->frame, hist->count, 95), hist->count);
+    }
+    text_settings tconf;
+    text_defaults(&tconf);
+    tconf.font = FONT_SMALL;
+    tconf.cforeground = TEXT_MEDIUM_GREEN;
+    text_render(&tconf, TEXT_DEFAULT, 2, 2, 316, 6, buf);
+}
@@ -0,0 +1,54 @@
+#ifndef INPUT_LATENCY_H
+#define INPUT_LATENCY_H
+
+#include <SDL.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Measures how long it takes for a local press to show up on screen. Presses are stamped with the
+ * performance counter as their SDL events are pulled from the queue. The keyboard and gamepad controllers
+ * move the stamp to the ctrl_event they create for the press, the arena reports when the HAR acted on it,
+ * and the engine when the first frame after that has been presented. Samples are kept per device and
+ * game speed, and may be shown as an overlay (console command "latency") or written out as CSV.
+ */
+
+enum
+{
+    LATENCY_KEYBOARD,
+    LATENCY_GAMEPAD,
+    LATENCY_DEVICE_COUNT
+};
+
+// Opens the CSV log, if csv_path is not empty. Can be left out if no log is wanted.
+void input_latency_init(const char *csv_path);
+
+// Logs the latency distributions and closes the CSV log.
+void input_latency_close(void);
+
+// Stamps presses of keys and gamepad buttons. Call for every event from SDL_PollEvent().
+void input_latency_event(const SDL_Event *event);
+
+// Takes the stamp of a held key, or 0 if it has none. Each press can only be taken once.
+uint64_t input_latency_take_key(unsigned int scancode);
+
+// Takes the stamp of the first gamepad press since the last call, or 0 if there is none.
+uint64_t input_latency_take_gamepad(SDL_JoystickID id);
+
+/**
+ * Report that a stamped action was applied to a HAR.
+ *
+ * @param stamp Stamp of the ctrl_event
+ * @param ctrl_type Type of the controller the event came from, CTRL_TYPE_*
+ * @param speed Game speed setting
+ */
+void input_latency_acted(uint64_t stamp, int ctrl_type, unsigned int speed);
+
+// Report that a frame was presented. Completes the samples of the actions applied before it.
+void input_latency_presented(void);
+
+// Returns the new state of the overlay.
+bool input_latency_toggle_overlay(void);
+void input_latency_render(void);
+
+#endif // INPUT_LATENCY_H
@@ -0,0 +1,49 @@
+#include "game/utils/net_pacing.h"
+#include "utils/miscmath.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define RTT_MAX_SAMPLES 100
+#define ADVANTAGE_SMOOTHING 0.1f // weight of a new frame advantage sample
+#define ADVANTAGE_DECAY 0.99f    // per tick, forgets old samples when the peer sends no inputs
+#define PACE_US_PER_TICK 250     // pace for each tick of frame advantage
+#define PACE_MAX_US 800          // a tenth of the shortest dynamic tick
+
+static int compare_int(const void *a, const void *b) {
+    return *(const int *)a - *(const int *)b;
+}
+
+int net_rtt_percentile(const int *samples, int count, int percent) {
+    int n = min2(count, RTT_MAX_SAMPLES);
+    if(n <= 0) {
+        return 0;
+    }
+    int sorted[RTT_MAX_SAMPLES];
+    memcpy(sorted, samples, n * sizeof(int));
+    qsort(sorted, n, sizeof(int), compare_int);
+    return sorted[(n - 1) * percent / 100];
+}
+
+int net_input_delay_target(const int *samples, int count, int max_delay) {
+    return clamp((net_rtt_percentile(samples, count, 90) + 1) / 2, 1, max_delay);
+}
+
+int net_input_delay_step(int delay, int target) {
+    if(target > delay) {
+        return delay + 1;
+    }
+    if(target < delay) {
+        return delay - 1;
+    }
+    return delay;
+}
+
+float net_advantage_sample(float advantage, int frame_advantage, int peer_frame_advantage) {
+    float error = (frame_advantage - peer_frame_advantage) / 2.0f;
+    return advantage + (error - advantage) * ADVANTAGE_SMOOTHING;
+}
+
+int net_advantage_pace(float *advantage) {
+    *advantage *= ADVANTAGE_DECAY;
+    return clamp((int)(*advantage * PACE_US_PER_TICK), -PACE_MAX_US, PACE_MAX_US);
+}
@@ -0,0 +1,39 @@
+#ifndef NET_PACING_H
+#define NET_PACING_H
+
+/*
+ * Input delay and frame advantage pacing of netplay. The net controller measures the round trip time and the
+ * frame advantage of both sides, and uses these to pick how far ahead local inputs are scheduled and how much
+ * to stretch or shorten each dynamic tick so that both sides run level.
+ */
+
+// Round trip time, in ticks, that the given percentage of the samples stay under. 0 without samples.
+int net_rtt_percentile(const int *samples, int count, int percent);
+
+// Input delay that covers the trip to the peer for nine inputs out of ten, from 1 to max_delay ticks
+int net_input_delay_target(const int *samples, int count, int max_delay);
+
+// Moves the input delay a single tick towards the target
+int net_input_delay_step(int delay, int target);
+
+/**
+ * Adds a frame advantage measurement to the smoothed advantage. Each side only knows its own view,
+ * so the advantage is half of the difference, and both sides do half of the correction.
+ *
+ * @param advantage Smoothed advantage, positive when this side is ahead
+ * @param frame_advantage Ticks this side is ahead of the peer
+ * @param peer_frame_advantage Ticks the peer says it is ahead of this side
+ * @return New smoothed advantage
+ */
+float net_advantage_sample(float advantage, int frame_advantage, int peer_frame_advantage);
+
+/**
+ * Ages the smoothed advantage by a tick, so that it is forgotten when the peer stops sending,
+ * and gives the pace that evens it out.
+ *
+ * @param advantage Smoothed advantage, updated
+ * @return Microseconds to add to the next dynamic tick, negative to shorten it
+ */
+int net_advantage_pace(float *advantage);
+
+#endif // NET_PACING_H
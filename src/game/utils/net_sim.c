@@ -0,0 +1,114 @@
+#include "game/utils/net_sim.h"
+#include "utils/allocator.h"
+#include <string.h>
+
+typedef struct net_datagram {
+    uint32_t release;
+    size_t len;
+    char *data;
+} net_datagram;
+
+static void free_datagram(void *ptr) {
+    net_datagram *datagram = ptr;
+    omf_free(datagram->data);
+}
+
+// Clock values wrap around, so compare them by distance
+static inline bool time_before(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) < 0;
+}
+
+void net_link_create(net_link *link, const net_sim_config *config, uint32_t seed) {
+    memset(link, 0, sizeof(net_link));
+    link->config = *config;
+    random_seed(&link->rand, seed);
+    vector_create_cb(&link->queue, sizeof(net_datagram), free_datagram);
+}
+
+void net_link_free(net_link *link) {
+    vector_free(&link->queue);
+}
+
+void net_link_set_config(net_link *link, const net_sim_config *config) {
+    link->config = *config;
+}
+
+static void queue_datagram(net_link *link, uint32_t now, bool reorder, uint32_t jitter, const void *data,
+                           size_t len) {
+    net_datagram datagram;
+    if(reorder) {
+        datagram.release = now;
+        link->stats.reordered++;
+    } else {
+        datagram.release = now + link->config.latency_ms + jitter;
+        // Jitter alone does not reorder, a datagram cannot leave before the one pushed ahead of it
+        if(time_before(datagram.release, link->last_release)) {
+            datagram.release = link->last_release;
+        }
+        link->last_release = datagram.release;
+    }
+    datagram.len = len;
+    datagram.data = omf_malloc(len);
+    memcpy(datagram.data, data, len);
+    vector_append(&link->queue, &datagram);
+}
+
+void net_link_push(net_link *link, uint32_t now, const void *data, size_t len) {
+    link->stats.pushed++;
+    if(vector_size(&link->queue) == 0) {
+        // Nothing in flight, so nothing to keep the order against
+        link->last_release = now;
+    }
+
+    // Every push draws the same values whatever the settings are, so that turning one setting on does not
+    // change the decisions made for the others.
+    bool drop = random_float(&link->rand) < link->config.loss;
+    bool duplicate = random_float(&link->rand) < link->config.duplicate;
+    bool reorder[2];
+    uint32_t jitter[2];
+    for(int i = 0; i < 2; i++) {
+        reorder[i] = random_float(&link->rand) < link->config.reorder;
+        jitter[i] = random_int(&link->rand, link->config.jitter_ms + 1);
+    }
+
+    if(drop) {
+        link->stats.dropped++;
+        return;
+    }
+    queue_datagram(link, now, reorder[0], jitter[0], data, len);
+    if(duplicate) {
+        link->stats.duplicated++;
+        queue_datagram(link, now, reorder[1], jitter[1], data, len);
+    }
+}
+
+bool net_link_pop(net_link *link, uint32_t now, void *buf, size_t size, size_t *len) {
+    // Earliest due datagram, first pushed on a tie
+    int next = -1;
+    uint32_t release = 0;
+    for(unsigned int i = 0; i < vector_size(&link->queue); i++) {
+        const net_datagram *datagram = vector_get(&link->queue, i);
+        if(time_before(now, datagram->release)) {
+            continue;
+        }
+        if(next < 0 || time_before(datagram->release, release)) {
+            next = i;
+            release = datagram->release;
+        }
+    }
+    if(next < 0) {
+        return false;
+    }
+
+    net_datagram *datagram = vector_get(&link->queue, next);
+    *len = datagram->len < size ? datagram->len : size;
+    memcpy(buf, datagram->data, *len);
+    omf_free(datagram->data);
+    vector_delete_at(&link->queue, next);
+    link->stats.delivered++;
+    return true;
+}
+
+unsigned int net_link_pending(const net_link *link) {
+    return vector_size(&link->queue);
+}
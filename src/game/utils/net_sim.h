@@ -0,0 +1,66 @@
+#ifndef NET_SIM_H
+#define NET_SIM_H
+
+#include "utils/random.h"
+#include "utils/vector.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Network condition simulator, for testing netplay on a single machine. A net_link is one direction of a
+ * simulated connection: datagrams pushed into it come out of it later, twice, or not at all. Every decision
+ * is drawn from a generator seeded by the caller, and time is whatever millisecond clock the caller passes
+ * in, so the same seed and the same pushes always give the same deliveries.
+ *
+ * Datagrams leave a link in the order they were pushed, however much jitter they got, unless they are
+ * picked for reordering. Like netem, a reordered datagram skips the delay and overtakes the ones queued
+ * before it, so reordering only has an effect with some latency.
+ */
+
+typedef struct net_sim_config {
+    uint32_t latency_ms; // one way delay of every datagram
+    uint32_t jitter_ms;  // extra delay, picked evenly from 0 to jitter_ms
+    float loss;          // chance of dropping a datagram, 0 to 1
+    float reorder;       // chance of sending a datagram without the delay
+    float duplicate;     // chance of delivering a datagram twice
+} net_sim_config;
+
+typedef struct net_link_stats {
+    uint32_t pushed;
+    uint32_t dropped;
+    uint32_t duplicated;
+    uint32_t reordered;
+    uint32_t delivered;
+} net_link_stats;
+
+typedef struct net_link {
+    net_sim_config config;
+    struct random_t rand;
+    vector queue; // net_datagram, in push order
+    uint32_t last_release;
+    net_link_stats stats;
+} net_link;
+
+void net_link_create(net_link *link, const net_sim_config *config, uint32_t seed);
+void net_link_free(net_link *link);
+
+// Takes effect for datagrams pushed after the call
+void net_link_set_config(net_link *link, const net_sim_config *config);
+
+void net_link_push(net_link *link, uint32_t now, const void *data, size_t len);
+
+/**
+ * Takes the next datagram that is due at the given time.
+ *
+ * @param buf Buffer for the datagram, longer datagrams are truncated
+ * @param size Size of the buffer
+ * @param len Length of the datagram
+ * @return True if a datagram was due
+ */
+bool net_link_pop(net_link *link, uint32_t now, void *buf, size_t size, size_t *len);
+
+// Datagrams still in flight
+unsigned int net_link_pending(const net_link *link);
+
+#endif // NET_SIM_H
@@ -0,0 +1,282 @@
+#include "game/utils/profiler.h"
+#include "game/gui/component.h"
+#include "game/gui/text_render.h"
+#include "utils/allocator.h"
+#include "utils/io_worker.h"
+#include "utils/log.h"
+#include "utils/miscmath.h"
+#include "utils/time_fmt.h"
+#include "video/surface.h"
+#include "video/video.h"
+#include <SDL.h>
+#include <stdio.h>
+#include <string.h>
+
+// Frames shown in the graph
+#define PROFILE_HISTORY 128
+#define PROFILE_MAX_DEPTH 16
+
+#define GRAPH_X 4
+#define GRAPH_H 50
+#define GRAPH_Y (200 - GRAPH_H - 4)
+#define US_PER_PIXEL 400
+#define LEGEND_X 214
+
+typedef struct open_zone {
+    profiler_zone zone;
+    uint64_t start;
+    uint64_t children; // time spent in nested zones
+} open_zone;
+
+typedef struct trace_event {
+    profiler_zone zone;
+    uint64_t start;
+    uint64_t end;
+} trace_event;
+
+typedef struct trace_job {
+    char filename[64];
+    trace_event *events;
+    unsigned int count;
+    uint64_t base;
+} trace_job;
+
+bool profiler_active = false;
+
+static struct {
+    open_zone stack[PROFILE_MAX_DEPTH];
+    int depth;
+    int overflow;
+
+    uint64_t self[PROFILE_ZONE_COUNT]; // self time of the current frame
+    uint32_t history[PROFILE_HISTORY][PROFILE_ZONE_COUNT];
+    unsigned int frame;
+
+    // Counts of the current frame are the differences to the totals at its start
+    unsigned int draws_start;
+    unsigned int rendered_start;
+    unsigned int replayed_start;
+    uint32_t draws[PROFILE_HISTORY];
+    uint32_t rendered[PROFILE_HISTORY];
+    uint32_t replayed[PROFILE_HISTORY];
+    bool overlay;
+
+    int capture_request; // frames to capture, starting from the next frame
+    int capture_frames;  // frames left to capture
+    trace_event *events;
+    unsigned int event_count;
+    unsigned int event_capacity;
+    uint64_t capture_start;
+
+    surface bars[PROFILE_ZONE_COUNT];
+    bool bars_created;
+} prof;
+
+static const char *zone_names[PROFILE_ZONE_COUNT] = {
+    "events", "static tick", "rollback", "dynamic tick", "cleanup", "move",    "collide",
+    "tick",   "palette",     "render",   "gui",          "console", "present",
+};
+
+// Graph colors. These are palette indexes, so they depend on the scene a bit.
+static const unsigned char zone_colors[PROFILE_ZONE_COUNT] = {
+    0xA5, 0xAB, 0xF6, 0xFD, 0xC0, 0xC8, 0xD0, 0xD8, 0x90, 0xFE, 0x68, 0xE0, 0xF0,
+};
+
+static uint32_t counter_to_us(uint64_t delta) {
+    return delta * 1000000 / SDL_GetPerformanceFrequency();
+}
+
+void profiler_zone_begin(profiler_zone zone) {
+    if(prof.depth == PROFILE_MAX_DEPTH) {
+        prof.overflow++;
+        return;
+    }
+    open_zone *z = &prof.stack[prof.depth++];
+    z->zone = zone;
+    z->children = 0;
+    z->start = SDL_GetPerformanceCounter();
+}
+
+void profiler_zone_end(profiler_zone zone) {
+    if(prof.overflow > 0) {
+        prof.overflow--;
+        return;
+    }
+    if(prof.depth == 0 || prof.stack[prof.depth - 1].zone != zone) {
+        return;
+    }
+    uint64_t now = SDL_GetPerformanceCounter();
+    const open_zone *z = &prof.stack[--prof.depth];
+    uint64_t total = now - z->start;
+    prof.self[zone] += total - z->children;
+    if(prof.depth > 0) {
+        prof.stack[prof.depth - 1].children += total;
+    }
+
+    if(prof.capture_frames > 0) {
+        if(prof.event_count == prof.event_capacity) {
+            prof.event_capacity = max2(prof.event_capacity * 2, 1024);
+            prof.events = omf_realloc(prof.events, prof.event_capacity * sizeof(trace_event));
+        }
+        trace_event *ev = &prof.events[prof.event_count++];
+        ev->zone = zone;
+        ev->start = z->start;
+        ev->end = now;
+    }
+}
+
+static bool write_trace(void *userdata) {
+    const trace_job *job = userdata;
+    FILE *fp = fopen(job->filename, "w");
+    if(fp == NULL) {
+        return false;
+    }
+    double scale = 1000000.0 / SDL_GetPerformanceFrequency();
+    fprintf(fp, "{\"traceEvents\":[\n");
+    for(unsigned int i = 0; i < job->count; i++) {
+        const trace_event *ev = &job->events[i];
+        fprintf(fp, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}%s\n",
+                zone_names[ev->zone], (ev->start - job->base) * scale, (ev->end - ev->start) * scale,
+                i + 1 < job->count ? "," : "");
+    }
+    fprintf(fp, "],\"displayTimeUnit\":\"ms\"}\n");
+    return fclose(fp) == 0;
+}
+
+static void free_trace(void *userdata) {
+    trace_job *job = userdata;
+    omf_free(job->events);
+    omf_free(job);
+}
+
+static void finish_capture(void) {
+    char *time = format_time();
+    trace_job *job = omf_calloc(1, sizeof(trace_job));
+    snprintf(job->filename, sizeof(job->filename), "trace_%s.json", time);
+    job->events = prof.events;
+    job->count = prof.event_count;
+    job->base = prof.capture_start;
+    io_worker_submit(job->filename, write_trace, free_trace, job);
+    omf_free(time);
+
+    prof.events = NULL;
+    prof.event_count = 0;
+    prof.event_capacity = 0;
+}
+
+void profiler_frame(void) {
+    unsigned int draws = video_get_draw_count();
+    unsigned int rendered, replayed;
+    component_get_render_counts(&rendered, &replayed);
+    if(profiler_active) {
+        unsigned int slot = prof.frame % PROFILE_HISTORY;
+        uint32_t *row = prof.history[slot];
+        for(int i = 0; i < PROFILE_ZONE_COUNT; i++) {
+            row[i] = counter_to_us(prof.self[i]);
+        }
+        prof.draws[slot] = draws - prof.draws_start;
+        prof.rendered[slot] = rendered - prof.rendered_start;
+        prof.replayed[slot] = replayed - prof.replayed_start;
+        prof.frame++;
+        if(prof.capture_frames > 0 && --prof.capture_frames == 0) {
+            finish_capture();
+        }
+    }
+    memset(prof.self, 0, sizeof(prof.self));
+    prof.draws_start = draws;
+    prof.rendered_start = rendered;
+    prof.replayed_start = replayed;
+    prof.depth = 0;
+    prof.overflow = 0;
+
+    if(prof.capture_request > 0 && prof.capture_frames == 0) {
+        prof.capture_frames = prof.capture_request;
+        prof.capture_request = 0;
+        prof.capture_start = SDL_GetPerformanceCounter();
+    }
+
+    bool was_active = profiler_active;
+    profiler_active = prof.overlay || prof.capture_frames > 0;
+    if(profiler_active && !was_active) {
+        prof.frame = 0;
+    }
+}
+
+bool profiler_toggle_overlay(void) {
+    prof.overlay = !prof.overlay;
+    return prof.overlay;
+}
+
+bool profiler_capture(int frames) {
+    if(prof.capture_frames > 0 || prof.capture_request > 0 || frames <= 0) {
+        return false;
+    }
+    prof.capture_request = frames;
+    return true;
+}
+
+void profiler_render(void) {
+    if(!prof.overlay) {
+        return;
+    }
+    if(!prof.bars_created) {
+        for(int i = 0; i < PROFILE_ZONE_COUNT; i++) {
+            surface_create_from_data(&prof.bars[i], 1, 1, &zone_colors[i]);
+        }
+        prof.bars_created = true;
+    }
+
+    // Stacked self times, one column per frame
+    unsigned int frames = min2(prof.frame, PROFILE_HISTORY);
+    unsigned int first = prof.frame - frames;
+    uint64_t totals[PROFILE_ZONE_COUNT] = {0};
+    uint64_t draws = 0, rendered = 0, replayed = 0;
+    for(unsigned int f = 0; f < frames; f++) {
+        unsigned int slot = (first + f) % PROFILE_HISTORY;
+        draws += prof.draws[slot];
+        rendered += prof.rendered[slot];
+        replayed += prof.replayed[slot];
+        const uint32_t *row = prof.history[slot];
+        int y = GRAPH_Y + GRAPH_H;
+        for(int i = 0; i < PROFILE_ZONE_COUNT; i++) {
+            int h = min2(row[i] / US_PER_PIXEL, y - GRAPH_Y);
+            if(h > 0) {
+                y -= h;
+                video_draw_size(&prof.bars[i], GRAPH_X + f, y, 1, h);
+            }
+            totals[i] += row[i];
+        }
+    }
+
+    // Legend with the average self time of each zone
+    text_settings tconf;
+    text_defaults(&tconf);
+    tconf.font = FONT_SMALL;
+    char buf[32];
+    for(int i = 0; i < PROFILE_ZONE_COUNT; i++) {
+        snprintf(buf, sizeof(buf), "%-12s%5.2f", zone_names[i], frames ? totals[i] / 1000.0f / frames : 0.0f);
+        tconf.cforeground = zone_colors[i];
+        text_render(&tconf, TEXT_DEFAULT, LEGEND_X, 10 + i * 7, 104, 6, buf);
+    }
+
+    // Per frame averages of the draw calls and of the retained GUI components rendered / replayed
+    int y = 10 + PROFILE_ZONE_COUNT * 7;
+    unsigned int div = max2(frames, 1);
+    tconf.cforeground = 0xFD;
+    snprintf(buf, sizeof(buf), "%-12s%5u", "draws", (unsigned int)(draws / div));
+    text_render(&tconf, TEXT_DEFAULT, LEGEND_X, y, 104, 6, buf);
+    snprintf(buf, sizeof(buf), "%-10s%3u/%-3u", component_get_retained_mode() ? "gui cached" : "gui off",
+             (unsigned int)(rendered / div), (unsigned int)(replayed / div));
+    text_render(&tconf, TEXT_DEFAULT, LEGEND_X, y + 7, 104, 6, buf);
+}
+
+void profiler_close(void) {
+    if(prof.bars_created) {
+        for(int i = 0; i < PROFILE_ZONE_COUNT; i++) {
+            surface_free(&prof.bars[i]);
+        }
+    }
+    omf_free(prof.events);
+    memset(&prof, 0, sizeof(prof));
+    profiler_active = false;
+}
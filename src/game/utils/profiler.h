@@ -0,0 +1,70 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdbool.h>
+
+/*
+ * Frame time profiler. Zones are wrapped around the parts of the frame with profiler_begin() and
+ * profiler_end(), and may nest. Each zone is charged its self time, ie. the time not spent in the zones
+ * nested in it, so the zones of a frame add up to the time it took.
+ *
+ * The profiler is off until the overlay is shown or a trace is captured (console command "profile"). While
+ * it is off, a zone costs a single branch. It is switched on and off at frame boundaries only.
+ *
+ * Besides the zones, the overlay shows the draw calls per frame, and how many retained GUI components were
+ * rendered against how many had their cached draws submitted again.
+ */
+typedef enum profiler_zone
+{
+    PROFILE_EVENTS,
+    PROFILE_STATIC_TICK,
+    PROFILE_ROLLBACK,
+    PROFILE_DYNAMIC_TICK,
+    PROFILE_CLEANUP,
+    PROFILE_MOVE,
+    PROFILE_COLLIDE,
+    PROFILE_TICK,
+    PROFILE_PALETTE,
+    PROFILE_RENDER,
+    PROFILE_GUI,
+    PROFILE_CONSOLE,
+    PROFILE_PRESENT,
+    PROFILE_ZONE_COUNT
+} profiler_zone;
+
+extern bool profiler_active;
+
+void profiler_zone_begin(profiler_zone zone);
+void profiler_zone_end(profiler_zone zone);
+
+static inline void profiler_begin(profiler_zone zone) {
+    if(profiler_active) {
+        profiler_zone_begin(zone);
+    }
+}
+
+static inline void profiler_end(profiler_zone zone) {
+    if(profiler_active) {
+        profiler_zone_end(zone);
+    }
+}
+
+// Call between frames, with no zones open.
+void profiler_frame(void);
+
+// Returns the new state of the overlay.
+bool profiler_toggle_overlay(void);
+
+/**
+ * Record the zones of the next frames, and write them out as a Chrome trace (chrome://tracing, Perfetto)
+ * once done. The file is written by the I/O worker.
+ *
+ * @param frames Frames to capture
+ * @return False if a capture is already running
+ */
+bool profiler_capture(int frames);
+
+void profiler_render(void);
+void profiler_close(void);
+
+#endif // PROFILER_H
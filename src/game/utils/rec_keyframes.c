@@ -0,0 +1,178 @@
+#include "game/utils/rec_keyframes.h"
+#include "game/common_defines.h"
+#include "game/game_player.h"
+#include "game/game_state.h"
+#include "game/protos/scene.h"
+#include "utils/allocator.h"
+#include "utils/log.h"
+#include <string.h>
+
+static void keyframe_free(void *userdata) {
+    rec_keyframe *frame = userdata;
+    game_state_clone_free(frame->gs);
+    omf_free(frame->gs);
+    serial_free(&frame->objects);
+}
+
+static void save_controllers(game_state *gs, rec_controller_state *ctrl) {
+    for(int i = 0; i < 2; i++) {
+        controller *c = game_player_get_ctrl(game_state_get_player(gs, i));
+        if(c != NULL && c->type == CTRL_TYPE_REC) {
+            rec_controller_save_state(c, &ctrl[i]);
+        }
+    }
+}
+
+// Points the shared controllers at gs, and rewinds the recordings to where gs was snapshotted.
+static void load_controllers(game_state *gs, const rec_controller_state *ctrl) {
+    for(int i = 0; i < 2; i++) {
+        controller *c = game_player_get_ctrl(game_state_get_player(gs, i));
+        if(c != NULL) {
+            c->gs = gs;
+            if(c->type == CTRL_TYPE_REC) {
+                rec_controller_load_state(c, &ctrl[i]);
+            }
+        }
+    }
+    if(gs->menu_ctrl != NULL) {
+        gs->menu_ctrl->gs = gs;
+    }
+}
+
+void rec_keyframes_create(rec_keyframes *kf, uint32_t interval) {
+    vector_create_cb(&kf->frames, sizeof(rec_keyframe), keyframe_free);
+    kf->interval = interval > 0 ? interval : 1;
+    kf->base_interval = kf->interval;
+    kf->max_frames = REC_KEYFRAME_MAX;
+    kf->scene_id = SCENE_NONE;
+}
+
+void rec_keyframes_free(rec_keyframes *kf) {
+    vector_free(&kf->frames);
+}
+
+// Finds the index of the newest keyframe at or before the given tick, or -1 if there is none
+static int find_keyframe_index(const rec_keyframes *kf, uint32_t tick) {
+    unsigned int lo = 0;
+    unsigned int hi = vector_size(&kf->frames);
+    while(lo < hi) {
+        unsigned int mid = lo + (hi - lo) / 2;
+        rec_keyframe *frame = vector_get(&kf->frames, mid);
+        if(frame->tick <= tick) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return (int)lo - 1;
+}
+
+static rec_keyframe *find_keyframe(const rec_keyframes *kf, uint32_t tick) {
+    int index = find_keyframe_index(kf, tick);
+    return index >= 0 ? vector_get(&kf->frames, index) : NULL;
+}
+
+// Drops every other keyframe and doubles the interval. Deltas are only kept along with their base, so a
+// delta whose base is dropped goes too.
+static void thin_keyframes(rec_keyframes *kf) {
+    unsigned int size = vector_size(&kf->frames);
+    bool *keep = omf_calloc(size, sizeof(bool));
+    for(unsigned int i = 0; i < size; i += 2) {
+        keep[i] = true;
+    }
+    for(unsigned int i = 0; i < size; i++) {
+        rec_keyframe *frame = vector_get(&kf->frames, i);
+        if(keep[i] && frame->base_tick != frame->tick && !keep[find_keyframe_index(kf, frame->base_tick)]) {
+            keep[i] = false;
+        }
+    }
+    for(unsigned int i = size; i-- > 0;) {
+        if(!keep[i]) {
+            keyframe_free(vector_get(&kf->frames, i));
+            vector_delete_at(&kf->frames, i);
+        }
+    }
+    omf_free(keep);
+    kf->interval *= 2;
+    log_debug("Keyframes thinned out to %u, now every %u ticks", vector_size(&kf->frames), kf->interval);
+}
+
+void rec_keyframes_record(rec_keyframes *kf, game_state *gs) {
+    if(gs->this_id != kf->scene_id) {
+        // Snapshots from another scene cannot be seeked to
+        vector_free(&kf->frames);
+        vector_create_cb(&kf->frames, sizeof(rec_keyframe), keyframe_free);
+        kf->scene_id = gs->this_id;
+        kf->interval = kf->base_interval;
+    }
+    if(!scene_is_arena(game_state_get_scene(gs))) {
+        return;
+    }
+    rec_keyframe *last = vector_back(&kf->frames);
+    if(last != NULL && gs->int_tick < last->tick + kf->interval) {
+        return;
+    }
+
+    rec_keyframe frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.tick = gs->int_tick;
+    frame.gs = omf_calloc(1, sizeof(game_state));
+    serial_create(&frame.objects);
+    rec_keyframe *base = last != NULL ? find_keyframe(kf, last->base_tick) : NULL;
+    if(base != NULL && game_state_same_objects(gs, base->gs)) {
+        frame.base_tick = base->tick;
+        game_state_clone_shell(gs, frame.gs);
+        game_state_serialize_objects(gs, &frame.objects);
+    } else {
+        frame.base_tick = frame.tick;
+        game_state_clone(gs, frame.gs);
+    }
+    save_controllers(gs, frame.ctrl);
+    vector_append(&kf->frames, &frame);
+    if(vector_size(&kf->frames) > kf->max_frames) {
+        thin_keyframes(kf);
+    }
+}
+
+game_state *rec_keyframes_seek(rec_keyframes *kf, game_state *gs, uint32_t tick) {
+    if(gs->this_id != kf->scene_id) {
+        return NULL;
+    }
+    rec_keyframe *frame = find_keyframe(kf, tick);
+    if(frame == NULL) {
+        return NULL;
+    }
+
+    // Seeking a little forward is quicker from where we already are
+    game_state *dst = omf_calloc(1, sizeof(game_state));
+    rec_controller_state ctrl[2];
+    memcpy(ctrl, frame->ctrl, sizeof(ctrl));
+    if(gs->int_tick <= tick && gs->int_tick > frame->tick) {
+        save_controllers(gs, ctrl);
+        game_state_clone(gs, dst);
+    } else if(frame->base_tick == frame->tick) {
+        game_state_clone(frame->gs, dst);
+    } else {
+        rec_keyframe *base = find_keyframe(kf, frame->base_tick);
+        if(game_state_restore(frame->gs, base->gs, &frame->objects, dst)) {
+            // An object changed in a way that can not be restored; simulate from the base instead
+            log_debug("Unable to restore keyframe at tick %u, starting from tick %u", frame->tick, base->tick);
+            game_state_clone_free(dst);
+            memcpy(ctrl, base->ctrl, sizeof(ctrl));
+            game_state_clone(base->gs, dst);
+        }
+    }
+    uint32_t start_tick = dst->int_tick;
+    load_controllers(dst, ctrl);
+
+    // Simulate the rest like a headless replay; the console may be blocking input on the live state.
+    bool input_blocked = gs->host.input_blocked;
+    dst->host.input_blocked = false;
+    while(dst->int_tick < tick && game_state_is_running(dst) && dst->this_id == kf->scene_id) {
+        game_state_static_tick(dst, false);
+        game_state_dynamic_tick(dst, false);
+    }
+    dst->host.input_blocked = input_blocked;
+    log_debug("Seeked to tick %u from tick %u", dst->int_tick, start_tick);
+    return dst;
+}
@@ -0,0 +1,50 @@
+#ifndef REC_KEYFRAMES_H
+#define REC_KEYFRAMES_H
+
+#include "controller/rec_controller.h"
+#include "game/game_state_type.h"
+#include "game/utils/serial.h"
+#include "utils/vector.h"
+#include <stdint.h>
+
+// Default distance between keyframes, in ticks
+#define REC_KEYFRAME_INTERVAL 250
+
+// Default limit of keyframes kept at once
+#define REC_KEYFRAME_MAX 64
+
+typedef struct rec_keyframe {
+    uint32_t tick;      // int_tick of the snapshot
+    uint32_t base_tick; // tick of the full snapshot the objects are restored from, same as tick for a full one
+    game_state *gs;     // full clone, or a clone without objects
+    serial objects;     // object state on top of the base, empty for a full snapshot
+    rec_controller_state ctrl[2];
+} rec_keyframe;
+
+// Snapshots of a REC playback, taken every few ticks while it plays. Seeking restores the closest
+// snapshot before the target and simulates the rest, so any point of the match can be reached without
+// playing it from the beginning. Snapshots are in-memory game state clones, and only stay valid while
+// the playback stays in the same scene. Only arenas are snapshotted, as the clones of other scenes share
+// their scene data with the live state. While the objects stay the same, a snapshot only clones the rest
+// of the game state and keeps the objects in serialized form, restored into the objects of the last full
+// snapshot when seeking. Once there are more than max_frames snapshots, every other one is dropped and
+// the interval doubled, so long matches keep a bounded number of them.
+struct rec_keyframes {
+    vector frames;          // rec_keyframe, ordered by tick
+    uint32_t interval;      // current distance between keyframes
+    uint32_t base_interval; // distance between keyframes when a scene starts
+    unsigned int max_frames;
+    unsigned int scene_id;
+};
+
+void rec_keyframes_create(rec_keyframes *kf, uint32_t interval);
+void rec_keyframes_free(rec_keyframes *kf);
+
+// Takes a snapshot of gs if it is in an arena, and at least one interval past the newest one.
+void rec_keyframes_record(rec_keyframes *kf, game_state *gs);
+
+// Returns a new game state at the given int_tick, or NULL if there is no snapshot to start from.
+// The returned state is a clone; swap it in with gs->new_state. Controllers are pointed at the new state.
+game_state *rec_keyframes_seek(rec_keyframes *kf, game_state *gs, uint32_t tick);
+
+#endif // REC_KEYFRAMES_H
@@ -0,0 +1,60 @@
+#include "game/utils/render_queue.h"
+#include "utils/allocator.h"
+#include <string.h>
+
+void render_queue_create(render_queue *queue) {
+    memset(queue, 0, sizeof(render_queue));
+}
+
+void render_queue_free(render_queue *queue) {
+    omf_free(queue->cmds);
+    omf_free(queue->slots);
+    omf_free(queue->sorted);
+    queue->count = 0;
+    queue->capacity = 0;
+}
+
+void render_queue_clear(render_queue *queue) {
+    queue->count = 0;
+}
+
+static void render_queue_grow(render_queue *queue, int needed) {
+    int capacity = queue->capacity > 0 ? queue->capacity : 64;
+    while(capacity < needed) {
+        capacity *= 2;
+    }
+    queue->cmds = omf_realloc(queue->cmds, capacity * sizeof(video_draw_cmd));
+    queue->slots = omf_realloc(queue->slots, capacity * sizeof(uint8_t));
+    queue->sorted = omf_realloc(queue->sorted, capacity * sizeof(video_draw_cmd));
+    queue->capacity = capacity;
+}
+
+void render_queue_add(render_queue *queue, render_slot slot, const video_draw_cmd *cmds, int count) {
+    if(queue->count + count > queue->capacity) {
+        render_queue_grow(queue, queue->count + count);
+    }
+    memcpy(&queue->cmds[queue->count], cmds, count * sizeof(video_draw_cmd));
+    memset(&queue->slots[queue->count], slot, count);
+    queue->count += count;
+}
+
+const video_draw_cmd *render_queue_sort(render_queue *queue) {
+    // Counting sort; stable, so commands keep their order within a slot.
+    int start[RENDER_SLOT_COUNT] = {0};
+    for(int i = 0; i < queue->count; i++) {
+        if(queue->slots[i] + 1 < RENDER_SLOT_COUNT) {
+            start[queue->slots[i] + 1]++;
+        }
+    }
+    for(int s = 1; s < RENDER_SLOT_COUNT; s++) {
+        start[s] += start[s - 1];
+    }
+    for(int i = 0; i < queue->count; i++) {
+        queue->sorted[start[queue->slots[i]]++] = queue->cmds[i];
+    }
+    return queue->sorted;
+}
+
+void render_queue_draw(render_queue *queue) {
+    video_draw_batch(render_queue_sort(queue), queue->count);
+}
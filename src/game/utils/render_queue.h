@@ -0,0 +1,49 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include "video/video.h"
+#include <stdint.h>
+
+/*
+ * Draw commands of a frame. Commands are added in any order, each with the slot it is drawn in, and are
+ * sorted by slot when the queue is drawn. Commands in the same slot are drawn in the order they were added.
+ * The queue keeps its memory between frames.
+ */
+typedef enum render_slot
+{
+    RENDER_SLOT_BOTTOM,
+    RENDER_SLOT_SHADOWS,
+    RENDER_SLOT_PASSIVE_HAR1,
+    RENDER_SLOT_PASSIVE_HAR2,
+    RENDER_SLOT_MIDDLE,
+    RENDER_SLOT_ACTIVE_HAR1,
+    RENDER_SLOT_ACTIVE_HAR2,
+    RENDER_SLOT_TOP,
+    RENDER_SLOT_COUNT
+} render_slot;
+
+typedef struct render_queue {
+    video_draw_cmd *cmds;   // in the order added
+    uint8_t *slots;         // slot of each command in cmds
+    video_draw_cmd *sorted; // cmds sorted by slot
+    int count;
+    int capacity;
+} render_queue;
+
+void render_queue_create(render_queue *queue);
+void render_queue_free(render_queue *queue);
+void render_queue_clear(render_queue *queue);
+void render_queue_add(render_queue *queue, render_slot slot, const video_draw_cmd *cmds, int count);
+
+/**
+ * Sorts the commands by slot.
+ *
+ * @param queue Queue to sort
+ * @return Array of all the commands in the queue, valid until the queue is next changed
+ */
+const video_draw_cmd *render_queue_sort(render_queue *queue);
+
+// Sorts and renders all commands in the queue.
+void render_queue_draw(render_queue *queue);
+
+#endif // RENDER_QUEUE_H
@@ -144,13 +144,15 @@ const field f_net[] = {
     F_STRING(settings_network, net_lobby_address, "lobby.openomf.org"),
     F_STRING(settings_network, net_username, ""),
     F_STRING(settings_network, trace_file, NULL),
+    F_STRING(settings_network, telemetry_file, NULL),
     F_INT(settings_network, net_connect_port, 2097),
     F_INT(settings_network, net_listen_port_start, 0),
     F_INT(settings_network, net_listen_port_end, 0),
     F_INT(settings_network, net_ext_port_start, 0),
     F_INT(settings_network, net_ext_port_end, 0),
     F_BOOL(settings_network, net_use_pmp, 1),
-    F_BOOL(settings_network, net_use_upnp, 1)
+    F_BOOL(settings_network, net_use_upnp, 1),
+    F_INT(settings_network, net_max_input_delay, 0)
 };
 
 // Map struct to field
@@ -112,6 +112,7 @@ typedef struct {
     char *net_connect_ip;
     char *net_lobby_address;
     char *trace_file;
+    char *telemetry_file;
     char *net_username;
     int net_connect_port;
     int net_listen_port_start;
@@ -120,6 +121,7 @@ typedef struct {
     int net_ext_port_end;
     int net_use_upnp;
     int net_use_pmp;
+    int net_max_input_delay;
 } settings_network;
 
 typedef struct {
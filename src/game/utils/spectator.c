@@ -0,0 +1,515 @@
+#include "game/utils/spectator.h"
+#include "controller/net_controller.h"
+#include "controller/rec_controller.h"
+#include "game/game_player.h"
+#include "game/game_state.h"
+#include "game/protos/scene.h"
+#include "game/scenes/arena.h"
+#include "game/utils/serial.h"
+#include "utils/allocator.h"
+#include "utils/log.h"
+#include "utils/miscmath.h"
+#include <SDL.h>
+#include <string.h>
+
+enum
+{
+    SPECTATE_MATCH = 1, // header of a new match
+    SPECTATE_MOVES,     // watermark tick, followed by moves up to it
+    SPECTATE_END,       // match is over
+};
+
+// Encoded move: uint32 tick, int8 player id, int8 action
+#define MOVE_SIZE 6
+
+// Encoded header: name, 14 int8 attributes and uint32 score of both pilots, then the match settings and the seed
+#define HEADER_SIZE (2 * (sizeof(((sd_pilot *)0)->name) + 14 + 4) + 1 + 8 * 2 + 9 + 4)
+
+// Send a watermark-only update when it has moved this many ticks, so that idle spectators do not stall
+#define WATERMARK_INTERVAL 10
+
+struct spectator_relay {
+    ENetHost *host;
+    uint32_t delay;
+    int spectators;
+    const sd_rec_file *rec; // recording being relayed, NULL between matches
+    unsigned int consumed;  // moves of rec already in the log
+    serial header;          // SPECTATE_MATCH packet of the current match
+    serial log;             // encoded moves of the current match
+    size_t released;        // bytes of the log that are older than the delay
+    uint32_t watermark;     // spectators may simulate up to this tick
+    size_t sent;            // bytes sent to spectators that are up to date
+    uint32_t sent_watermark;
+};
+
+// Per spectator state, in peer->data
+typedef struct {
+    size_t sent; // bytes of the log this spectator has
+    bool has_match;
+} spectator_peer;
+
+struct spectator_client {
+    ENetHost *host;
+    ENetPeer *peer;
+    sd_rec_file *rec;
+    sd_rec_file *taken;
+    uint32_t watermark;
+    bool live;
+};
+
+void spectator_write_header(serial *ser, const sd_rec_file *rec) {
+    for(int i = 0; i < 2; i++) {
+        const sd_pilot *p = &rec->pilots[i].info;
+        serial_write(ser, p->name, sizeof(p->name));
+        serial_write_int8(ser, p->pilot_id);
+        serial_write_int8(ser, p->har_id);
+        serial_write_int8(ser, p->color_1);
+        serial_write_int8(ser, p->color_2);
+        serial_write_int8(ser, p->color_3);
+        serial_write_int8(ser, p->power);
+        serial_write_int8(ser, p->agility);
+        serial_write_int8(ser, p->endurance);
+        serial_write_int8(ser, p->arm_power);
+        serial_write_int8(ser, p->leg_power);
+        serial_write_int8(ser, p->arm_speed);
+        serial_write_int8(ser, p->leg_speed);
+        serial_write_int8(ser, p->armor);
+        serial_write_int8(ser, p->stun_resistance);
+        serial_write_uint32(ser, rec->scores[i]);
+    }
+    serial_write_int8(ser, rec->game_mode);
+    serial_write_int16(ser, rec->throw_range);
+    serial_write_int16(ser, rec->hit_pause);
+    serial_write_int16(ser, rec->block_damage);
+    serial_write_int16(ser, rec->vitality);
+    serial_write_int16(ser, rec->jump_height);
+    serial_write_int16(ser, rec->p1_controller);
+    serial_write_int16(ser, rec->p2_controller);
+    serial_write_int16(ser, rec->p2_controller_);
+    serial_write_int8(ser, rec->knock_down);
+    serial_write_int8(ser, rec->rehit_mode);
+    serial_write_int8(ser, rec->def_throws);
+    serial_write_int8(ser, rec->arena_id);
+    serial_write_int8(ser, rec->power[0]);
+    serial_write_int8(ser, rec->power[1]);
+    serial_write_int8(ser, rec->hazards);
+    serial_write_int8(ser, rec->round_type);
+    serial_write_int8(ser, rec->hyper_mode);
+    serial_write_uint32(ser, rec->seed);
+}
+
+void spectator_read_header(serial *ser, sd_rec_file *rec) {
+    for(int i = 0; i < 2; i++) {
+        sd_pilot *p = &rec->pilots[i].info;
+        serial_read(ser, p->name, sizeof(p->name));
+        p->name[sizeof(p->name) - 1] = 0;
+        p->pilot_id = serial_read_int8(ser);
+        p->har_id = serial_read_int8(ser);
+        p->color_1 = serial_read_int8(ser);
+        p->color_2 = serial_read_int8(ser);
+        p->color_3 = serial_read_int8(ser);
+        p->power = serial_read_int8(ser);
+        p->agility = serial_read_int8(ser);
+        p->endurance = serial_read_int8(ser);
+        p->arm_power = serial_read_int8(ser);
+        p->leg_power = serial_read_int8(ser);
+        p->arm_speed = serial_read_int8(ser);
+        p->leg_speed = serial_read_int8(ser);
+        p->armor = serial_read_int8(ser);
+        p->stun_resistance = serial_read_int8(ser);
+        rec->scores[i] = serial_read_uint32(ser);
+    }
+    rec->game_mode = serial_read_int8(ser);
+    rec->throw_range = serial_read_int16(ser);
+    rec->hit_pause = serial_read_int16(ser);
+    rec->block_damage = serial_read_int16(ser);
+    rec->vitality = serial_read_int16(ser);
+    rec->jump_height = serial_read_int16(ser);
+    rec->p1_controller = serial_read_int16(ser);
+    rec->p2_controller = serial_read_int16(ser);
+    rec->p2_controller_ = serial_read_int16(ser);
+    rec->knock_down = serial_read_int8(ser);
+    rec->rehit_mode = serial_read_int8(ser);
+    rec->def_throws = serial_read_int8(ser);
+    rec->arena_id = serial_read_int8(ser);
+    rec->power[0] = serial_read_int8(ser);
+    rec->power[1] = serial_read_int8(ser);
+    rec->hazards = serial_read_int8(ser);
+    rec->round_type = serial_read_int8(ser);
+    rec->hyper_mode = serial_read_int8(ser);
+    rec->seed = serial_read_uint32(ser);
+}
+
+void spectator_write_move(serial *ser, const sd_rec_move *move) {
+    serial_write_uint32(ser, move->tick);
+    serial_write_int8(ser, move->player_id);
+    serial_write_int8(ser, move->action);
+}
+
+void spectator_read_move(serial *ser, sd_rec_move *move) {
+    memset(move, 0, sizeof(sd_rec_move));
+    move->lookup_id = 2;
+    move->tick = serial_read_uint32(ser);
+    move->player_id = serial_read_int8(ser);
+    move->action = (uint8_t)serial_read_int8(ser);
+}
+
+bool spectator_packet_is_valid(const char *data, size_t len) {
+    if(len < 1) {
+        return false;
+    }
+    switch(data[0]) {
+        case SPECTATE_MATCH:
+            return len == 1 + HEADER_SIZE;
+        case SPECTATE_MOVES:
+            return len >= 1 + sizeof(uint32_t) && (len - 1 - sizeof(uint32_t)) % MOVE_SIZE == 0;
+        case SPECTATE_END:
+            return len == 1;
+    }
+    return false;
+}
+
+static uint32_t read_move_tick(const serial *log, size_t offset) {
+    uint32_t tick;
+    memcpy(&tick, log->data + offset, sizeof(tick));
+    return SDL_SwapBE32(tick);
+}
+
+// -------- Relay --------
+
+spectator_relay *spectator_relay_create(uint16_t port, int max_spectators, uint32_t delay) {
+    ENetAddress address;
+    address.host = ENET_HOST_ANY;
+    address.port = port;
+    ENetHost *host = enet_host_create(&address, max_spectators, 1, 0, 0);
+    if(host == NULL) {
+        log_error("Failed to start spectator relay on port %d", port);
+        return NULL;
+    }
+
+    spectator_relay *relay = omf_calloc(1, sizeof(spectator_relay));
+    relay->host = host;
+    relay->delay = delay;
+    serial_create(&relay->header);
+    serial_create(&relay->log);
+    log_info("Spectator relay listening on port %d", port);
+    return relay;
+}
+
+void spectator_relay_free(spectator_relay **_relay) {
+    spectator_relay *relay = *_relay;
+    if(relay == NULL) {
+        return;
+    }
+    for(size_t i = 0; i < relay->host->peerCount; i++) {
+        ENetPeer *peer = &relay->host->peers[i];
+        omf_free(peer->data);
+        if(peer->state == ENET_PEER_STATE_CONNECTED) {
+            enet_peer_disconnect_now(peer, 0);
+        }
+    }
+    enet_host_destroy(relay->host);
+    serial_free(&relay->header);
+    serial_free(&relay->log);
+    omf_free(relay);
+    *_relay = NULL;
+}
+
+int spectator_relay_count(const spectator_relay *relay) {
+    return relay->spectators;
+}
+
+static void relay_send(ENetPeer *peer, const serial *ser) {
+    ENetPacket *packet = enet_packet_create(ser->data, serial_len((serial *)ser), ENET_PACKET_FLAG_RELIABLE);
+    enet_peer_send(peer, 0, packet);
+}
+
+// Moves part of the log to a spectator, along with the current watermark
+static ENetPacket *relay_moves_packet(spectator_relay *relay, size_t from) {
+    ENetPacket *packet =
+        enet_packet_create(NULL, 1 + sizeof(uint32_t) + relay->released - from, ENET_PACKET_FLAG_RELIABLE);
+    uint32_t watermark = SDL_SwapBE32(relay->watermark);
+    packet->data[0] = SPECTATE_MOVES;
+    memcpy(packet->data + 1, &watermark, sizeof(watermark));
+    memcpy(packet->data + 1 + sizeof(watermark), relay->log.data + from, relay->released - from);
+    return packet;
+}
+
+static void relay_start_match(spectator_relay *relay, const sd_rec_file *rec) {
+    relay->rec = rec;
+    relay->consumed = 0;
+    relay->released = 0;
+    relay->watermark = 0;
+    relay->sent = 0;
+    relay->sent_watermark = 0;
+    serial_free(&relay->log);
+    serial_create(&relay->log);
+    serial_free(&relay->header);
+    serial_create(&relay->header);
+    serial_write_int8(&relay->header, SPECTATE_MATCH);
+    spectator_write_header(&relay->header, rec);
+    for(size_t i = 0; i < relay->host->peerCount; i++) {
+        spectator_peer *sp = relay->host->peers[i].data;
+        if(sp != NULL) {
+            relay_send(&relay->host->peers[i], &relay->header);
+            sp->sent = 0;
+            sp->has_match = true;
+        }
+    }
+}
+
+static void relay_end_match(spectator_relay *relay) {
+    serial ser;
+    serial_create(&ser);
+    serial_write_int8(&ser, SPECTATE_END);
+    for(size_t i = 0; i < relay->host->peerCount; i++) {
+        spectator_peer *sp = relay->host->peers[i].data;
+        if(sp != NULL && sp->has_match) {
+            relay_send(&relay->host->peers[i], &ser);
+            sp->has_match = false;
+        }
+    }
+    serial_free(&ser);
+    relay->rec = NULL;
+}
+
+// Tick up to which the recording has all the moves it is going to get
+static uint32_t relay_confirmed_tick(game_state *gs) {
+    for(int i = 0; i < 2; i++) {
+        controller *ctrl = game_player_get_ctrl(game_state_get_player(gs, i));
+        if(ctrl != NULL && ctrl->type == CTRL_TYPE_NETWORK) {
+            return net_controller_get_agreed_tick(ctrl);
+        }
+    }
+    // Local inputs are recorded as they happen, see write_rec_move()
+    return arena_rec_tick(game_state_get_scene(gs));
+}
+
+void spectator_relay_update(spectator_relay *relay, game_state *gs) {
+    ENetEvent event;
+    while(enet_host_service(relay->host, &event, 0) > 0) {
+        switch(event.type) {
+            case ENET_EVENT_TYPE_CONNECT: {
+                spectator_peer *sp = omf_calloc(1, sizeof(spectator_peer));
+                event.peer->data = sp;
+                relay->spectators++;
+                if(relay->rec != NULL) {
+                    relay_send(event.peer, &relay->header);
+                    sp->has_match = true;
+                }
+                log_info("Spectator connected, %d watching", relay->spectators);
+                break;
+            }
+            case ENET_EVENT_TYPE_DISCONNECT:
+                if(event.peer->data != NULL) {
+                    omf_free(event.peer->data);
+                    event.peer->data = NULL;
+                    relay->spectators--;
+                }
+                log_info("Spectator disconnected, %d watching", relay->spectators);
+                break;
+            case ENET_EVENT_TYPE_RECEIVE:
+                // Spectators have nothing to say
+                enet_packet_destroy(event.packet);
+                break;
+            default:
+                break;
+        }
+    }
+
+    // Only matches that are being recorded here can be relayed
+    const sd_rec_file *rec = NULL;
+    if(gs->rec != NULL && gs->init_flags->playback == 0 && scene_is_arena(game_state_get_scene(gs))) {
+        rec = gs->rec;
+    }
+    if(relay->rec != NULL && (rec != relay->rec || rec->move_count < relay->consumed)) {
+        relay_end_match(relay);
+    }
+    if(rec == NULL) {
+        return;
+    }
+    if(relay->rec == NULL) {
+        relay_start_match(relay, rec);
+    }
+
+    // Encode new moves once, for all spectators
+    for(; relay->consumed < rec->move_count; relay->consumed++) {
+        const sd_rec_move *move = &rec->moves[relay->consumed];
+        if(move->lookup_id == 2) {
+            spectator_write_move(&relay->log, move);
+        }
+    }
+
+    // Release what is older than the delay
+    uint32_t confirmed = relay_confirmed_tick(gs);
+    if(confirmed < relay->delay) {
+        return;
+    }
+    relay->watermark = umax2(relay->watermark, confirmed - relay->delay);
+    size_t log_len = serial_len(&relay->log);
+    while(relay->released < log_len && read_move_tick(&relay->log, relay->released) <= relay->watermark) {
+        relay->released += MOVE_SIZE;
+    }
+    if(relay->released == relay->sent && relay->watermark < relay->sent_watermark + WATERMARK_INTERVAL) {
+        return;
+    }
+
+    // Spectators that are up to date all get the same packet; late joiners get everything they are missing.
+    ENetPacket *shared = NULL;
+    for(size_t i = 0; i < relay->host->peerCount; i++) {
+        ENetPeer *peer = &relay->host->peers[i];
+        spectator_peer *sp = peer->data;
+        if(sp == NULL || !sp->has_match) {
+            continue;
+        }
+        if(sp->sent == relay->sent) {
+            if(shared == NULL) {
+                shared = relay_moves_packet(relay, relay->sent);
+            }
+            enet_peer_send(peer, 0, shared);
+        } else {
+            enet_peer_send(peer, 0, relay_moves_packet(relay, sp->sent));
+        }
+        sp->sent = relay->released;
+    }
+    if(shared != NULL && shared->referenceCount == 0) {
+        enet_packet_destroy(shared);
+    }
+    relay->sent = relay->released;
+    relay->sent_watermark = relay->watermark;
+    enet_host_flush(relay->host);
+}
+
+// -------- Client --------
+
+static void client_receive(spectator_client *client, ENetPacket *packet) {
+    if(!spectator_packet_is_valid((const char *)packet->data, packet->dataLength)) {
+        log_warn("Dropping malformed spectator packet of %zu bytes", packet->dataLength);
+        return;
+    }
+    serial ser;
+    serial_create_from(&ser, (const char *)packet->data, packet->dataLength);
+    switch(serial_read_int8(&ser)) {
+        case SPECTATE_MATCH:
+            if(client->rec != NULL) {
+                // The relay moved on to the next match
+                client->live = false;
+                break;
+            }
+            client->rec = omf_calloc(1, sizeof(sd_rec_file));
+            sd_rec_create(client->rec);
+            spectator_read_header(&ser, client->rec);
+            client->live = true;
+            break;
+        case SPECTATE_MOVES: {
+            if(client->rec == NULL || !client->live) {
+                break;
+            }
+            client->watermark = serial_read_uint32(&ser);
+            size_t count = (packet->dataLength - 1 - sizeof(uint32_t)) / MOVE_SIZE;
+            for(size_t i = 0; i < count; i++) {
+                sd_rec_move move;
+                spectator_read_move(&ser, &move);
+                sd_rec_insert_action(client->rec, client->rec->move_count, &move);
+            }
+            break;
+        }
+        case SPECTATE_END:
+            client->live = false;
+            break;
+    }
+    serial_free(&ser);
+}
+
+static void client_service(spectator_client *client, uint32_t timeout_ms) {
+    ENetEvent event;
+    while(enet_host_service(client->host, &event, timeout_ms) > 0) {
+        timeout_ms = 0;
+        switch(event.type) {
+            case ENET_EVENT_TYPE_RECEIVE:
+                client_receive(client, event.packet);
+                enet_packet_destroy(event.packet);
+                break;
+            case ENET_EVENT_TYPE_DISCONNECT:
+                log_info("Spectator connection closed");
+                client->peer = NULL;
+                client->live = false;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+spectator_client *spectator_client_connect(const char *addr, uint16_t port, uint32_t timeout_ms) {
+    ENetAddress address;
+    ENetEvent event;
+    spectator_client *client = omf_calloc(1, sizeof(spectator_client));
+    client->host = enet_host_create(NULL, 1, 1, 0, 0);
+    if(client->host == NULL) {
+        log_error("Failed to initialize ENet client");
+        goto error_0;
+    }
+    enet_address_set_host(&address, addr);
+    address.port = port;
+    client->peer = enet_host_connect(client->host, &address, 1, 0);
+    if(client->peer == NULL || enet_host_service(client->host, &event, timeout_ms) <= 0 ||
+       event.type != ENET_EVENT_TYPE_CONNECT) {
+        log_error("Unable to connect to spectator relay at %s:%d", addr, port);
+        goto error_1;
+    }
+
+    // Wait for a match to start
+    uint64_t start = SDL_GetTicks64();
+    while(client->rec == NULL && client->peer != NULL && SDL_GetTicks64() - start < timeout_ms) {
+        client_service(client, 100);
+    }
+    if(client->rec == NULL) {
+        log_error("No match to watch at %s:%d", addr, port);
+        goto error_1;
+    }
+    return client;
+
+error_1:
+    enet_host_destroy(client->host);
+error_0:
+    omf_free(client);
+    return NULL;
+}
+
+void spectator_client_free(spectator_client **_client) {
+    spectator_client *client = *_client;
+    if(client == NULL) {
+        return;
+    }
+    if(client->peer != NULL) {
+        enet_peer_disconnect_now(client->peer, 0);
+    }
+    enet_host_destroy(client->host);
+    if(client->rec != NULL && client->rec != client->taken) {
+        sd_rec_free(client->rec);
+        omf_free(client->rec);
+    }
+    omf_free(client);
+    *_client = NULL;
+}
+
+sd_rec_file *spectator_client_take_rec(spectator_client *client) {
+    client->taken = client->rec;
+    return client->rec;
+}
+
+uint32_t spectator_client_sync(spectator_client *client, game_state *gs) {
+    client_service(client, 0);
+    for(int i = 0; i < 2; i++) {
+        controller *ctrl = game_player_get_ctrl(game_state_get_player(gs, i));
+        if(ctrl != NULL && ctrl->type == CTRL_TYPE_REC && gs->rec == client->rec) {
+            rec_controller_update(ctrl, gs->rec, client->watermark);
+        }
+    }
+    return client->watermark;
+}
+
+bool spectator_client_is_live(const spectator_client *client) {
+    return client->live;
+}
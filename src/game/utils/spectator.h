@@ -0,0 +1,61 @@
+#ifndef SPECTATOR_H
+#define SPECTATOR_H
+
+#include "formats/rec.h"
+#include "game/game_state_type.h"
+#include "game/utils/serial.h"
+#include <enet/enet.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Default port for spectators to connect to
+#define SPECTATOR_PORT 2098
+
+// Ticks the relayed input lags behind the match by default, so that spectators do not stall on jitter
+#define SPECTATOR_DELAY 100
+
+/*
+ * Spectating works by relaying the match inputs, not the game state. The relay runs next to a match, and
+ * sends the moves that get written into the recording (gs->rec) to all connected spectators once they
+ * are older than the delay. The moves of a match are encoded once, and every spectator is just an offset
+ * into that buffer, so the cost of the relay grows with the bytes sent and not with the simulation.
+ *
+ * Spectators run the match locally like REC playback. One that joins mid-match gets all the moves so far,
+ * and catches up by simulating them before it starts showing the match.
+ */
+typedef struct spectator_relay spectator_relay;
+typedef struct spectator_client spectator_client;
+
+spectator_relay *spectator_relay_create(uint16_t port, int max_spectators, uint32_t delay);
+void spectator_relay_free(spectator_relay **relay);
+
+// Accepts new spectators and sends out the moves recorded since the last update. Call with the live game state.
+void spectator_relay_update(spectator_relay *relay, game_state *gs);
+int spectator_relay_count(const spectator_relay *relay);
+
+// Connects to a relay, and waits until it has sent the match to watch. Returns NULL on failure.
+spectator_client *spectator_client_connect(const char *addr, uint16_t port, uint32_t timeout_ms);
+void spectator_client_free(spectator_client **client);
+
+// Match being watched. Received moves are appended to it, so it must stay alive as long as the client.
+// Ownership is handed over to the caller, eg. to a game state that plays it back.
+sd_rec_file *spectator_client_take_rec(spectator_client *client);
+
+// Receives new moves, and hands them to the REC controllers of gs. Returns the tick that gs may be
+// simulated up to; the match cannot go past moves that have not been received yet.
+uint32_t spectator_client_sync(spectator_client *client, game_state *gs);
+
+// False once the relay has moved on to another match, or the connection was lost.
+bool spectator_client_is_live(const spectator_client *client);
+
+// Wire format of the match header and of a single move (6 bytes), without the packet type.
+// The header carries the match settings, pilots and seed; that is all a spectator needs to start the match.
+void spectator_write_header(serial *ser, const sd_rec_file *rec);
+void spectator_read_header(serial *ser, sd_rec_file *rec);
+void spectator_write_move(serial *ser, const sd_rec_move *move);
+void spectator_read_move(serial *ser, sd_rec_move *move);
+
+// Checks the type and length of a packet from the relay, before any of it is decoded.
+bool spectator_packet_is_valid(const char *data, size_t len);
+
+#endif // SPECTATOR_H
@@ -2,6 +2,7 @@
 #include "engine.h"
 #include "game/game_state.h"
 #include "game/utils/settings.h"
+#include "game/utils/spectator.h"
 #include "game/utils/version.h"
 #include "resources/ids.h"
 #include "resources/pathmanager.h"
@@ -10,6 +11,7 @@
 #include "utils/c_array_util.h"
 #include "utils/c_string_util.h"
 #include "utils/log.h"
+#include "utils/miscmath.h"
 #include "utils/msgbox.h"
 #include "utils/random.h"
 #include <SDL.h>
@@ -90,9 +92,21 @@ int main(int argc, char *argv[]) {
     struct arg_file *rec = arg_file0("R", "rec", "<file>", "Record a new recfile");
     struct arg_lit *warp = arg_lit0(NULL, "warp", "run the game at warp speed");
     struct arg_int *speed = arg_int0(NULL, "speed", "<speed>", "game speed to use: 1-10");
+    struct arg_str *spectate = arg_str0(NULL, "spectate", "<host>", "Watch a match relayed by <host>");
+    struct arg_lit *relay = arg_lit0(NULL, "relay", "Relay the matches played here to spectators");
+    struct arg_int *spectate_port =
+        arg_int0(NULL, "spectate-port", "<port>", "Port of the spectator relay (default: 2098)");
+    struct arg_int *spectate_delay =
+        arg_int0(NULL, "spectate-delay", "<ticks>", "Ticks the relayed matches lag behind (default: 100)");
+    struct arg_str *export =
+        arg_str0(NULL, "export", "<path>", "Export the --play recfile as video to <path> (.y4m, - or a directory)");
+    struct arg_file *latency_log =
+        arg_file0(NULL, "latency-log", "<file>", "Write input latency samples to <file> as CSV");
     struct arg_end *end = arg_end(30);
-    void *argtable[] = {help, vers, listen, lobby, lobbyarg, connect, force_audio_backend, force_renderer, trace,
-                        port, play, rec,    warp,  speed,    end};
+    void *argtable[] = {help,                vers,           listen,   lobby, lobbyarg,      connect,
+                        force_audio_backend, force_renderer, trace,    port,  play,          rec,
+                        warp,                speed,          spectate, relay, spectate_port, spectate_delay,
+                        export,              latency_log,    end};
     const char *progname = "openomf";
 
     // Make sure everything got allocated
@@ -147,11 +161,19 @@ int main(int argc, char *argv[]) {
     } else if(play->count > 0) {
         init_flags.playback = 1;
         strncpy(init_flags.rec_file, play->filename[0], 254);
+    } else if(spectate->count > 0) {
+        // Spectating is playback of a recording that is still coming in
+        init_flags.playback = 1;
+        strncpy_or_truncate(init_flags.spectate_addr, spectate->sval[0], sizeof(init_flags.spectate_addr));
     } else if(rec->count > 0) {
         init_flags.record = 1;
         strncpy(init_flags.rec_file, rec->filename[0], 254);
     }
 
+    init_flags.spectate_relay = relay->count > 0;
+    init_flags.spectate_port = spectate_port->count > 0 ? spectate_port->ival[0] & 0xFFFF : SPECTATOR_PORT;
+    init_flags.spectate_delay = spectate_delay->count > 0 ? max2(spectate_delay->ival[0], 0) : SPECTATOR_DELAY;
+
     if(warp->count > 0) {
         init_flags.warpspeed = 1;
     } else {
@@ -164,6 +186,19 @@ int main(int argc, char *argv[]) {
         init_flags.speed = -1;
     }
 
+    if(export->count > 0) {
+        if(play->count == 0) {
+            fprintf(stderr, "Error: --export needs a recfile to play with --play.\n");
+            goto exit_0;
+        }
+        // Frames are composited on the CPU, so there is no need for a window or sound
+        strncpy_or_truncate(init_flags.export_path, export->sval[0], sizeof(init_flags.export_path));
+        strncpy_or_truncate(init_flags.force_renderer, "NULL", sizeof(init_flags.force_renderer));
+        strncpy_or_truncate(init_flags.force_audio_backend, "NULL", sizeof(init_flags.force_audio_backend));
+    }
+    if(latency_log->count > 0) {
+        strncpy_or_truncate(init_flags.latency_log, latency_log->filename[0], sizeof(init_flags.latency_log));
+    }
     if(force_renderer->count > 0) {
         strncpy_or_truncate(init_flags.force_renderer, force_renderer->sval[0], sizeof(init_flags.force_renderer));
     }
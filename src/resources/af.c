@@ -3,7 +3,7 @@
 #include "resources/sprite.h"
 #include <string.h>
 
-void af_create(af *a, void *src) {
+void af_create(af *a, void *src, sprite_bake *bake) {
     sd_af_file *sdaf = (sd_af_file *)src;
 
     // Trivial stuff
@@ -31,7 +31,7 @@ void af_create(af *a, void *src) {
     for(int i = 0; i < 70; i++) {
         if(sdaf->moves[i] != NULL) {
             af_move *move = omf_calloc(1, sizeof(af_move));
-            af_move_create(move, &a->sprites, (void *)sdaf->moves[i], i);
+            af_move_create(move, &a->sprites, (void *)sdaf->moves[i], i, bake);
             array_set(&a->moves, i, move);
         }
     }
@@ -18,7 +18,8 @@ typedef struct af_t {
     char sound_translation_table[30];
 } af;
 
-void af_create(af *a, void *src);
+// Bake may be NULL, see sprite_create_baked()
+void af_create(af *a, void *src, sprite_bake *bake);
 af_move *af_get_move(const af *a, int id);
 void af_free(af *a);
 
@@ -2,6 +2,7 @@
 #include "formats/af.h"
 #include "formats/error.h"
 #include "resources/pathmanager.h"
+#include "utils/log.h"
 
 int load_af_file(af *a, int id) {
     // Get directory + filename
@@ -17,8 +18,35 @@ int load_af_file(af *a, int id) {
         return 1;
     }
 
-    // Convert
-    af_create(a, &tmp);
+    // Convert, with the sprites from the asset pack if it has them
+    size_t len = 0;
+    sprite_bake bake;
+    sprite_bake_create(&bake, asset_pack_get(filename, &len), len);
+    af_create(a, &tmp, &bake);
     sd_af_free(&tmp);
     return 0;
 }
+
+bool af_bake(asset_pack_writer *writer, int id) {
+    const char *filename = pm_get_resource_path(id);
+    sd_af_file tmp;
+    if(sd_af_create(&tmp) != SD_SUCCESS) {
+        return false;
+    }
+    if(sd_af_load(&tmp, filename) != SD_SUCCESS) {
+        log_error("Unable to load AF file '%s'!", filename);
+        sd_af_free(&tmp);
+        return false;
+    }
+
+    af a;
+    sprite_bake bake;
+    sprite_bake_create_recorder(&bake);
+    af_create(&a, &tmp, &bake);
+    af_free(&a);
+    sd_af_free(&tmp);
+    if(bake.out_len == 0) {
+        return true;
+    }
+    return asset_pack_writer_add(writer, filename, bake.out, bake.out_len);
+}
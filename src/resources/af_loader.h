@@ -2,7 +2,11 @@
 #define AF_LOADER_H
 
 #include "resources/af.h"
+#include "resources/asset_pack.h"
 
 int load_af_file(af *a, int id);
 
+// Adds the decoded sprites of an AF file to an asset pack
+bool af_bake(asset_pack_writer *writer, int id);
+
 #endif // AF_LOADER_H
@@ -27,7 +27,7 @@ typedef struct af_move_t {
 #endif
 } af_move;
 
-void af_move_create(af_move *move, array *sprites, void *src, int id);
+void af_move_create(af_move *move, array *sprites, void *src, int id, sprite_bake *bake);
 void af_move_free(af_move *move);
 
 #endif // AF_MOVE_H
@@ -7,7 +7,7 @@ typedef struct sprite_reference_t {
     sprite *sprite;
 } sprite_reference;
 
-void animation_create(animation *ani, array *sprites, void *src, int id) {
+void animation_create(animation *ani, array *sprites, void *src, int id, sprite_bake *bake) {
     sd_animation *sdani = (sd_animation *)src;
 
     // Copy simple stuff
@@ -49,7 +49,7 @@ void animation_create(animation *ani, array *sprites, void *src, int id) {
             vector_append(&ani->sprites, &spr);
         } else {
             tmp_sprite = omf_calloc(1, sizeof(sprite));
-            sprite_create(tmp_sprite, (void *)sdani->sprites[i], i);
+            sprite_create_baked(tmp_sprite, (void *)sdani->sprites[i], i, bake);
             sprite_reference spr;
             spr.sprite = tmp_sprite;
             if(sdani->sprites[i]->index) {
@@ -46,7 +46,8 @@ typedef struct animation_t {
     vector sprites;
 } animation;
 
-void animation_create(animation *ani, array *sprites, void *src, int id);
+// Sprite pixels are taken from bake when it is given, see sprite_create_baked()
+void animation_create(animation *ani, array *sprites, void *src, int id, sprite_bake *bake);
 sprite *animation_get_sprite(animation *ani, int sprite_id);
 void animation_free(animation *ani);
 
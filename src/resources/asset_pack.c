@@ -0,0 +1,280 @@
+#include "resources/asset_pack.h"
+#include "utils/allocator.h"
+#include "utils/c_string_util.h"
+#include "utils/log.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#if defined(_WIN32) || defined(WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#define PACK_MAGIC "OMFPACK"
+#define PACK_BYTE_ORDER 0x01020304
+#define PACK_ALIGN 16
+#define PACK_NAME_LEN 32
+
+typedef struct pack_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order; // PACK_BYTE_ORDER, as written by the packing machine
+    uint32_t entry_count;
+    uint32_t reserved;
+} pack_header;
+
+typedef struct pack_entry {
+    char name[PACK_NAME_LEN]; // File name of the source, without the directory
+    uint64_t offset;
+    uint64_t len;
+    int64_t source_size;
+    int64_t source_mtime;
+} pack_entry;
+
+typedef struct writer_entry {
+    pack_entry entry;
+    void *data;
+} writer_entry;
+
+static struct {
+    const char *data;
+    size_t len;
+    const pack_entry *entries;
+    uint32_t entry_count;
+#if defined(_WIN32) || defined(WIN32)
+    HANDLE file;
+    HANDLE mapping;
+#endif
+} pack;
+
+static const char *base_name(const char *path) {
+    const char *name = path;
+    for(const char *c = path; *c != '\0'; c++) {
+        if(*c == '/' || *c == '\\') {
+            name = c + 1;
+        }
+    }
+    return name;
+}
+
+static bool source_stat(const char *path, int64_t *size, int64_t *mtime) {
+    struct stat info;
+    if(stat(path, &info) != 0) {
+        return false;
+    }
+    *size = info.st_size;
+    *mtime = info.st_mtime;
+    return true;
+}
+
+static size_t align_up(size_t value) {
+    return (value + PACK_ALIGN - 1) & ~(size_t)(PACK_ALIGN - 1);
+}
+
+#if defined(_WIN32) || defined(WIN32)
+static bool map_file(const char *filename) {
+    LARGE_INTEGER size;
+    pack.file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(pack.file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    if(!GetFileSizeEx(pack.file, &size) || size.QuadPart == 0) {
+        goto error_0;
+    }
+    pack.mapping = CreateFileMappingA(pack.file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(pack.mapping == NULL) {
+        goto error_0;
+    }
+    pack.data = MapViewOfFile(pack.mapping, FILE_MAP_READ, 0, 0, 0);
+    if(pack.data == NULL) {
+        goto error_1;
+    }
+    pack.len = size.QuadPart;
+    return true;
+
+error_1:
+    CloseHandle(pack.mapping);
+error_0:
+    CloseHandle(pack.file);
+    return false;
+}
+
+static void unmap_file(void) {
+    UnmapViewOfFile(pack.data);
+    CloseHandle(pack.mapping);
+    CloseHandle(pack.file);
+}
+#else
+static bool map_file(const char *filename) {
+    struct stat info;
+    int fd = open(filename, O_RDONLY);
+    if(fd < 0) {
+        return false;
+    }
+    if(fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    void *data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(data == MAP_FAILED) {
+        return false;
+    }
+    pack.data = data;
+    pack.len = info.st_size;
+    return true;
+}
+
+static void unmap_file(void) {
+    munmap((void *)pack.data, pack.len);
+}
+#endif
+
+static bool check_pack(const char *filename) {
+    const pack_header *header = (const pack_header *)pack.data;
+    if(pack.len < sizeof(pack_header) || memcmp(header->magic, PACK_MAGIC, sizeof(PACK_MAGIC)) != 0) {
+        log_error("Asset pack '%s' is not a valid pack file", filename);
+        return false;
+    }
+    if(header->byte_order != PACK_BYTE_ORDER || header->version != ASSET_PACK_VERSION) {
+        log_info("Asset pack '%s' was written by a different version, ignoring it", filename);
+        return false;
+    }
+    if(header->entry_count > (pack.len - sizeof(pack_header)) / sizeof(pack_entry)) {
+        log_error("Asset pack '%s' is truncated", filename);
+        return false;
+    }
+    pack.entries = (const pack_entry *)(pack.data + sizeof(pack_header));
+    pack.entry_count = header->entry_count;
+    for(uint32_t i = 0; i < pack.entry_count; i++) {
+        const pack_entry *entry = &pack.entries[i];
+        if(entry->offset % PACK_ALIGN != 0 || entry->offset > pack.len || entry->len > pack.len - entry->offset ||
+           memchr(entry->name, '\0', PACK_NAME_LEN) == NULL) {
+            log_error("Asset pack '%s' is corrupt", filename);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool asset_pack_open(const char *filename) {
+    if(!map_file(filename)) {
+        log_info("No asset pack found at '%s', loading resources from their files", filename);
+        return false;
+    }
+    if(!check_pack(filename)) {
+        asset_pack_close();
+        return false;
+    }
+    log_info("Loaded asset pack '%s' with %u entries", filename, pack.entry_count);
+    return true;
+}
+
+void asset_pack_close(void) {
+    if(pack.data != NULL) {
+        unmap_file();
+    }
+    memset(&pack, 0, sizeof(pack));
+}
+
+const void *asset_pack_get(const char *source_path, size_t *len) {
+    if(pack.data == NULL) {
+        return NULL;
+    }
+    const char *name = base_name(source_path);
+    for(uint32_t i = 0; i < pack.entry_count; i++) {
+        const pack_entry *entry = &pack.entries[i];
+        if(strcmp(entry->name, name) != 0) {
+            continue;
+        }
+        int64_t size, mtime;
+        if(!source_stat(source_path, &size, &mtime) || size != entry->source_size || mtime != entry->source_mtime) {
+            log_info("Asset pack entry of '%s' is out of date, loading the file instead", source_path);
+            return NULL;
+        }
+        *len = entry->len;
+        return pack.data + entry->offset;
+    }
+    return NULL;
+}
+
+static void free_writer_entry(void *ptr) {
+    writer_entry *entry = ptr;
+    omf_free(entry->data);
+}
+
+void asset_pack_writer_create(asset_pack_writer *writer) {
+    vector_create_cb(&writer->entries, sizeof(writer_entry), free_writer_entry);
+}
+
+void asset_pack_writer_free(asset_pack_writer *writer) {
+    vector_free(&writer->entries);
+}
+
+bool asset_pack_writer_add(asset_pack_writer *writer, const char *source_path, void *data, size_t len) {
+    writer_entry entry;
+    memset(&entry, 0, sizeof(entry));
+    const char *name = base_name(source_path);
+    if(strlen(name) >= PACK_NAME_LEN) {
+        log_error("Resource file name '%s' is too long for the asset pack", name);
+        goto error_0;
+    }
+    if(!source_stat(source_path, &entry.entry.source_size, &entry.entry.source_mtime)) {
+        log_error("Unable to find resource file '%s'", source_path);
+        goto error_0;
+    }
+    strncpy_or_truncate(entry.entry.name, name, PACK_NAME_LEN);
+    entry.entry.len = len;
+    entry.data = data;
+    vector_append(&writer->entries, &entry);
+    return true;
+
+error_0:
+    omf_free(data);
+    return false;
+}
+
+bool asset_pack_writer_save(asset_pack_writer *writer, const char *filename) {
+    static const char padding[PACK_ALIGN] = {0};
+    unsigned int count = vector_size(&writer->entries);
+    pack_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, PACK_MAGIC, sizeof(PACK_MAGIC));
+    header.version = ASSET_PACK_VERSION;
+    header.byte_order = PACK_BYTE_ORDER;
+    header.entry_count = count;
+
+    FILE *fp = fopen(filename, "wb");
+    if(fp == NULL) {
+        log_error("Unable to open asset pack '%s' for writing", filename);
+        return false;
+    }
+    fwrite(&header, sizeof(header), 1, fp);
+
+    // Entry table first, then the data of each entry, aligned
+    size_t offset = align_up(sizeof(pack_header) + count * sizeof(pack_entry));
+    for(unsigned int i = 0; i < count; i++) {
+        writer_entry *entry = vector_get(&writer->entries, i);
+        entry->entry.offset = offset;
+        fwrite(&entry->entry, sizeof(pack_entry), 1, fp);
+        offset = align_up(offset + entry->entry.len);
+    }
+    size_t pos = sizeof(pack_header) + count * sizeof(pack_entry);
+    for(unsigned int i = 0; i < count; i++) {
+        const writer_entry *entry = vector_get(&writer->entries, i);
+        fwrite(padding, 1, entry->entry.offset - pos, fp);
+        fwrite(entry->data, 1, entry->entry.len, fp);
+        pos = entry->entry.offset + entry->entry.len;
+    }
+    bool failed = ferror(fp);
+    if(fclose(fp) != 0 || failed) {
+        log_error("Unable to write asset pack '%s'", filename);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,48 @@
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include "utils/vector.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// Bump when the layout of the pack or of any baked resource changes
+#define ASSET_PACK_VERSION 1
+
+// Name of the pack file in the resource directory
+#define ASSET_PACK_FILE "openomf.pak"
+
+/*
+ * Pre-baked resources. packtool decodes resource files once and stores the results in a single pack file,
+ * which is then mapped into memory at startup. Loaders take their data straight from the mapping instead
+ * of parsing the original files, except for BK and AF files, of which only the decoded sprites are baked.
+ * Each entry remembers the size and modification time of the file it was baked from; an entry whose file
+ * has changed since is ignored, and its loader falls back to the file.
+ * The pack as a whole is ignored if it was written by a different version or on a different byte order.
+ */
+
+typedef struct asset_pack_writer {
+    vector entries;
+} asset_pack_writer;
+
+// Maps the pack. Returns false if there is no usable pack; resources are then loaded from their files.
+bool asset_pack_open(const char *filename);
+void asset_pack_close(void);
+
+/**
+ * Returns the baked data of a resource file. The data is aligned for any of the fixed size types, and
+ * stays valid until asset_pack_close().
+ *
+ * @param source_path Path of the original resource file
+ * @param len Length of the data
+ * @return Baked data, or NULL if the pack has none or the file has changed since it was baked
+ */
+const void *asset_pack_get(const char *source_path, size_t *len);
+
+void asset_pack_writer_create(asset_pack_writer *writer);
+void asset_pack_writer_free(asset_pack_writer *writer);
+
+// Adds the baked data of a resource file. Takes ownership of data, which must be allocated with omf_malloc.
+bool asset_pack_writer_add(asset_pack_writer *writer, const char *source_path, void *data, size_t len);
+bool asset_pack_writer_save(asset_pack_writer *writer, const char *filename);
+
+#endif // ASSET_PACK_H
@@ -3,7 +3,7 @@
 #include "utils/allocator.h"
 #include <string.h>
 
-void bk_create(bk *b, void *src) {
+void bk_create(bk *b, void *src, sprite_bake *bake) {
     sd_bk_file *sdbk = (sd_bk_file *)src;
 
     // File ID
@@ -31,7 +31,7 @@ void bk_create(bk *b, void *src) {
     bk_info tmp_bk_info;
     for(int i = 0; i < 50; i++) {
         if(sdbk->anims[i] != NULL) {
-            bk_info_create(&tmp_bk_info, &b->sprites, (void *)sdbk->anims[i], i);
+            bk_info_create(&tmp_bk_info, &b->sprites, (void *)sdbk->anims[i], i, bake);
             hashmap_put_int(&b->infos, i, &tmp_bk_info, sizeof(bk_info));
         }
     }
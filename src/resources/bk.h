@@ -16,7 +16,8 @@ typedef struct bk_t {
     char sound_translation_table[30];
 } bk;
 
-void bk_create(bk *b, void *src);
+// Bake may be NULL, see sprite_create_baked()
+void bk_create(bk *b, void *src, sprite_bake *bake);
 bk_info *bk_get_info(bk *b, int id);
 vga_palette *bk_get_palette(bk *b, int id);
 vga_remap_tables *bk_get_remaps(bk *b, int id);
@@ -1,9 +1,9 @@
 #include "resources/bk_info.h"
 #include "formats/bkanim.h"
 
-void bk_info_create(bk_info *info, array *sprites, void *src, int id) {
+void bk_info_create(bk_info *info, array *sprites, void *src, int id, sprite_bake *bake) {
     sd_bk_anim *sdinfo = (sd_bk_anim *)src;
-    animation_create(&info->ani, sprites, sdinfo->animation, id);
+    animation_create(&info->ani, sprites, sdinfo->animation, id, bake);
     info->chain_hit = sdinfo->chain_hit;
     info->chain_no_hit = sdinfo->chain_no_hit;
     info->load_on_start = sdinfo->load_on_start;
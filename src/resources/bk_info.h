@@ -13,7 +13,7 @@ typedef struct bk_info_t {
     animation ani;
 } bk_info;
 
-void bk_info_create(bk_info *info, array *sprites, void *src, int id);
+void bk_info_create(bk_info *info, array *sprites, void *src, int id, sprite_bake *bake);
 void bk_info_free(bk_info *info);
 
 #endif // BK_INFO_H
@@ -2,6 +2,7 @@
 #include "formats/bk.h"
 #include "formats/error.h"
 #include "resources/pathmanager.h"
+#include "utils/log.h"
 
 int load_bk_file(bk *b, int id) {
     // Get directory + filename
@@ -17,8 +18,35 @@ int load_bk_file(bk *b, int id) {
         return 1;
     }
 
-    // Convert
-    bk_create(b, &tmp);
+    // Convert, with the sprites from the asset pack if it has them
+    size_t len = 0;
+    sprite_bake bake;
+    sprite_bake_create(&bake, asset_pack_get(filename, &len), len);
+    bk_create(b, &tmp, &bake);
     sd_bk_free(&tmp);
     return 0;
 }
+
+bool bk_bake(asset_pack_writer *writer, int id) {
+    const char *filename = pm_get_resource_path(id);
+    sd_bk_file tmp;
+    if(sd_bk_create(&tmp) != SD_SUCCESS) {
+        return false;
+    }
+    if(sd_bk_load(&tmp, filename) != SD_SUCCESS) {
+        log_error("Unable to load BK file '%s'!", filename);
+        sd_bk_free(&tmp);
+        return false;
+    }
+
+    bk b;
+    sprite_bake bake;
+    sprite_bake_create_recorder(&bake);
+    bk_create(&b, &tmp, &bake);
+    bk_free(&b);
+    sd_bk_free(&tmp);
+    if(bake.out_len == 0) {
+        return true;
+    }
+    return asset_pack_writer_add(writer, filename, bake.out, bake.out_len);
+}
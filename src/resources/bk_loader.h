@@ -1,8 +1,12 @@
 #ifndef BK_LOADER_H
 #define BK_LOADER_H
 
+#include "resources/asset_pack.h"
 #include "resources/bk.h"
 
 int load_bk_file(bk *b, int id);
 
+// Adds the decoded sprites of a BK file to an asset pack
+bool bk_bake(asset_pack_writer *writer, int id);
+
 #endif // BK_LOADER_H
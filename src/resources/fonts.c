@@ -8,6 +8,8 @@
 #include "utils/log.h"
 #include "utils/vector.h"
 #include "video/surface.h"
+#include <stdint.h>
+#include <string.h>
 
 static font font_small;
 static font font_large;
@@ -16,6 +18,20 @@ static font font_net2;
 static int fonts_loaded = 0;
 static unsigned char FIRST_PRINTABLE_CHAR = (unsigned char)' ';
 
+// Baked fonts are a packed_font header and a table of packed_glyph, followed by the glyph pixels
+typedef struct packed_font {
+    uint32_t size;
+    int32_t w;
+    int32_t h;
+    uint32_t glyph_count;
+} packed_font;
+
+typedef struct packed_glyph {
+    uint16_t w;
+    uint16_t h;
+    uint32_t offset; // from the start of the header
+} packed_glyph;
+
 static void free_glyph(void *d) {
     surface *s = (surface *)d;
     surface_free(s);
@@ -123,6 +139,59 @@ static int pcx_font_load(font *font, const char *filename, int8_t palette_offset
     return 0;
 }
 
+static int font_load_packed(font *font, const char *filename) {
+    size_t len;
+    const char *data = asset_pack_get(filename, &len);
+    if(data == NULL || len < sizeof(packed_font)) {
+        return 1;
+    }
+    const packed_font *header = (const packed_font *)data;
+    const packed_glyph *glyphs = (const packed_glyph *)(data + sizeof(packed_font));
+    if(header->glyph_count > (len - sizeof(packed_font)) / sizeof(packed_glyph)) {
+        return 1;
+    }
+    for(uint32_t i = 0; i < header->glyph_count; i++) {
+        if(glyphs[i].offset > len || (size_t)glyphs[i].w * glyphs[i].h > len - glyphs[i].offset) {
+            log_error("Baked font file '%s' is corrupt!", filename);
+            return 1;
+        }
+    }
+
+    surface *sur;
+    for(uint32_t i = 0; i < header->glyph_count; i++) {
+        sur = vector_append_ptr(&font->surfaces);
+        surface_create_from_data(sur, glyphs[i].w, glyphs[i].h, (const unsigned char *)data + glyphs[i].offset);
+        surface_set_transparency(sur, 0);
+    }
+    font->w = header->w;
+    font->h = header->h;
+    font->size = header->size;
+    return 0;
+}
+
+static int font_load_any(font *font, const char *filename, font_size size) {
+    if(font_load_packed(font, filename) == 0) {
+        log_info("Loaded font file '%s' from the asset pack", filename);
+        return 0;
+    }
+    int ret;
+    switch(size) {
+        case FONT_NET1:
+            ret = pcx_font_load(font, filename, 3);
+            break;
+        case FONT_NET2:
+            ret = pcx_font_load(font, filename, 16);
+            break;
+        default:
+            ret = font_load(font, filename, size);
+            break;
+    }
+    if(ret == 0) {
+        log_info("Loaded font file '%s'", filename);
+    }
+    return ret;
+}
+
 bool fonts_init(void) {
     font_create(&font_small);
     font_create(&font_large);
@@ -132,35 +201,31 @@ bool fonts_init(void) {
 
     // Load small font
     filename = pm_get_resource_path(DAT_CHARSMAL);
-    if(font_load(&font_small, filename, FONT_SMALL)) {
+    if(font_load_any(&font_small, filename, FONT_SMALL)) {
         log_error("Unable to load font file '%s'!", filename);
         goto error_4;
     }
-    log_info("Loaded font file '%s'", filename);
 
     // Load big font
     filename = pm_get_resource_path(DAT_GRAPHCHR);
-    if(font_load(&font_large, filename, FONT_BIG)) {
+    if(font_load_any(&font_large, filename, FONT_BIG)) {
         log_error("Unable to load font file '%s'!", filename);
         goto error_3;
     }
-    log_info("Loaded font file '%s'", filename);
 
     // Load big net font
     filename = pm_get_resource_path(PCX_NETFONT1);
-    if(pcx_font_load(&font_net1, filename, 3)) {
+    if(font_load_any(&font_net1, filename, FONT_NET1)) {
         log_error("Unable to load font file '%s'!", filename);
         goto error_2;
     }
-    log_info("Loaded font file '%s'", filename);
 
     // Load small net font
     filename = pm_get_resource_path(PCX_NETFONT2);
-    if(pcx_font_load(&font_net2, filename, 16)) {
+    if(font_load_any(&font_net2, filename, FONT_NET2)) {
         log_error("Unable to load font file '%s'!", filename);
         goto error_1;
     }
-    log_info("Loaded font file '%s'", filename);
 
     // All done.
     fonts_loaded = 1;
@@ -201,3 +266,44 @@ void fonts_close(void) {
         fonts_loaded = 0;
     }
 }
+
+static bool font_bake(asset_pack_writer *writer, unsigned int resource_id, font_size size) {
+    const char *filename = pm_get_resource_path(resource_id);
+    font f;
+    font_create(&f);
+    if(font_load_any(&f, filename, size)) {
+        log_error("Unable to load font file '%s'!", filename);
+        font_free(&f);
+        return false;
+    }
+
+    unsigned int count = vector_size(&f.surfaces);
+    size_t len = sizeof(packed_font) + count * sizeof(packed_glyph);
+    for(unsigned int i = 0; i < count; i++) {
+        const surface *sur = vector_get(&f.surfaces, i);
+        len += sur->w * sur->h;
+    }
+    char *data = omf_calloc(len, 1);
+    packed_font *header = (packed_font *)data;
+    packed_glyph *glyphs = (packed_glyph *)(data + sizeof(packed_font));
+    header->size = f.size;
+    header->w = f.w;
+    header->h = f.h;
+    header->glyph_count = count;
+    size_t offset = sizeof(packed_font) + count * sizeof(packed_glyph);
+    for(unsigned int i = 0; i < count; i++) {
+        const surface *sur = vector_get(&f.surfaces, i);
+        glyphs[i].w = sur->w;
+        glyphs[i].h = sur->h;
+        glyphs[i].offset = offset;
+        memcpy(data + offset, sur->data, sur->w * sur->h);
+        offset += sur->w * sur->h;
+    }
+    font_free(&f);
+    return asset_pack_writer_add(writer, filename, data, len);
+}
+
+bool fonts_bake(asset_pack_writer *writer) {
+    return font_bake(writer, DAT_CHARSMAL, FONT_SMALL) && font_bake(writer, DAT_GRAPHCHR, FONT_BIG) &&
+           font_bake(writer, PCX_NETFONT1, FONT_NET1) && font_bake(writer, PCX_NETFONT2, FONT_NET2);
+}
@@ -1,6 +1,7 @@
 #ifndef FONTS_H
 #define FONTS_H
 
+#include "resources/asset_pack.h"
 #include "utils/vector.h"
 #include "video/surface.h"
 #include <stdbool.h>
@@ -27,4 +28,7 @@ bool fonts_init(void);
 void fonts_close(void);
 const font *fonts_get_font(font_size font);
 
+// Adds the decoded glyphs of all fonts to an asset pack
+bool fonts_bake(asset_pack_writer *writer);
+
 #endif // FONTS_H
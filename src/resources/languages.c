@@ -7,90 +7,150 @@
 #include "utils/c_array_util.h"
 #include "utils/log.h"
 #include "utils/str.h"
+#include <stdint.h>
 #include <string.h>
 
-static sd_language *language;
-static sd_language *language2;
+// Baked language files are the string count and a table of string offsets, followed by the strings
+#define PACKED_NO_STRING 0xFFFFFFFF
 
-bool lang_init(void) {
-    language = NULL;
-    language2 = NULL;
+// OMF GERMAN.DAT and old versions of ENGLISH.DAT have only 990 strings
+#define OLD_LANG_STR_COUNT 990
+#define NO_ENTRY 0xFFFF
 
-    str filename_str;
-    const char *dirname = pm_get_local_path(RESOURCE_PATH);
-    const char *lang = settings_get()->language.language;
-    str_from_format(&filename_str, "%s%s", dirname, lang);
-    char const *filename = str_c(&filename_str);
+// Strings of one language file. Strings are looked up from data with offsets, either in the asset pack or
+// in the loaded file. Files with old numbering are looked up through an index from the current string ids.
+typedef struct lang_table {
+    unsigned int count;
+    const char *data;
+    const uint32_t *offsets;
+    const uint16_t *index;
+    sd_lang_table file;
+} lang_table;
 
-    // Load up language file
-    language = omf_calloc(1, sizeof(sd_language));
-    if(sd_language_create(language) != SD_SUCCESS) {
-        goto error_0;
-    }
-    if(sd_language_load(language, filename)) {
-        log_error("Unable to load language file '%s'!", filename);
-        goto error_0;
-    }
+static lang_table language;
+static lang_table language2;
 
-    // OMF GERMAN.DAT and old versions of ENGLISH.DAT have only 990 strings
-    unsigned int const old_language_count = 990;
+// Current string id to old string id, NO_ENTRY for strings missing from the old files
+static uint16_t old_lang_index[LANG_STR_COUNT];
+static bool old_lang_index_built = false;
 
-    if(language->count == old_language_count) {
+static const uint16_t *lang_old_index(void) {
+    if(!old_lang_index_built) {
         // OMF 2.1 added netplay, and with it 23 new localization strings
-        unsigned new_ids[] = {149, 150, 172, 173, 174, 175, 176, 177, 178, 179, 180, 181,
-                              182, 183, 184, 185, 267, 269, 270, 271, 284, 295, 305};
-        unsigned *new_ids_end = new_ids + N_ELEMENTS(new_ids);
-
-        // insert dummy entries
-        sd_lang_string *expanded_strings = omf_malloc(LANG_STR_COUNT * sizeof(sd_lang_string));
+        static const unsigned new_ids[] = {149, 150, 172, 173, 174, 175, 176, 177, 178, 179, 180, 181,
+                                           182, 183, 184, 185, 267, 269, 270, 271, 284, 295, 305};
         unsigned next = 0;
-        unsigned next_from = 0;
-        for(unsigned *id = new_ids; id < new_ids_end; id++) {
-            unsigned copy_count = *id - next;
-            memcpy(expanded_strings + next, language->strings + next_from, copy_count * sizeof(sd_lang_string));
-            next += copy_count;
-            next_from += copy_count;
-
-            expanded_strings[next].data = NULL;
-            memcpy(expanded_strings[next].description, "dummy", 6);
-            next++;
-            language->count++;
+        unsigned old = 0;
+        for(unsigned id = 0; id < LANG_STR_COUNT; id++) {
+            if(next < N_ELEMENTS(new_ids) && new_ids[next] == id) {
+                old_lang_index[id] = NO_ENTRY;
+                next++;
+            } else {
+                old_lang_index[id] = old++;
+            }
         }
-        memcpy(expanded_strings + next, language->strings + next_from,
-               (LANG_STR_COUNT - next) * sizeof(sd_lang_string));
-        omf_free(language->strings);
-        language->strings = expanded_strings;
+        old_lang_index_built = true;
     }
-    if(language->count != LANG_STR_COUNT) {
-        log_error("Unable to load language file '%s', unsupported or corrupt file!", filename);
-        goto error_0;
+    return old_lang_index;
+}
+
+static const char *lang_table_get(const lang_table *lang, unsigned int id) {
+    if(id >= lang->count) {
+        return NULL;
+    }
+    unsigned int entry = id;
+    if(lang->index != NULL && (entry = lang->index[id]) == NO_ENTRY) {
+        return NULL;
     }
+    uint32_t offset = lang->offsets[entry];
+    return offset != PACKED_NO_STRING ? lang->data + offset : NULL;
+}
 
-    log_info("Loaded language file '%s'.", filename);
+static bool lang_load_packed(lang_table *lang, const char *filename, unsigned int count) {
+    size_t len;
+    const char *data = asset_pack_get(filename, &len);
+    if(data == NULL || len < sizeof(uint32_t)) {
+        return false;
+    }
+    const uint32_t *table = (const uint32_t *)data;
+    if(table[0] != count || len < (count + 1) * sizeof(uint32_t)) {
+        return false;
+    }
+    for(unsigned int i = 0; i < count; i++) {
+        uint32_t offset = table[i + 1];
+        if(offset != PACKED_NO_STRING && (offset >= len || memchr(data + offset, '\0', len - offset) == NULL)) {
+            log_error("Baked language file '%s' is corrupt!", filename);
+            return false;
+        }
+    }
 
-    // Load up language2 file (OpenOMF)
-    str_append_c(&filename_str, "2");
-    filename = str_c(&filename_str);
+    // Strings are used from the pack as they are
+    memset(lang, 0, sizeof(lang_table));
+    lang->count = count;
+    lang->data = data;
+    lang->offsets = table + 1;
+    return true;
+}
 
-    language2 = omf_calloc(1, sizeof(sd_language));
-    if(sd_language_create(language2) != SD_SUCCESS) {
-        goto error_0;
+static bool lang_load_file(lang_table *lang, const char *filename, unsigned int count) {
+    memset(lang, 0, sizeof(lang_table));
+    if(sd_lang_table_load(&lang->file, filename) != SD_SUCCESS) {
+        log_error("Unable to load language file '%s'!", filename);
+        return false;
     }
-    if(sd_language_load(language2, filename)) {
-        log_error("Unable to load OpenOMF language file '%s'!", filename);
-        goto error_0;
+    if(count == LANG_STR_COUNT && lang->file.count == OLD_LANG_STR_COUNT) {
+        lang->index = lang_old_index();
+    } else if(lang->file.count != count) {
+        log_error("Unable to load language file '%s', unsupported or corrupt file!", filename);
+        sd_lang_table_free(&lang->file);
+        return false;
     }
-    if(language2->count != LANG2_STR_COUNT) {
-        log_error("Unable to load OpenOMF language file '%s', unsupported or corrupt file!", filename);
-        goto error_0;
+    lang->count = count;
+    lang->data = lang->file.data;
+    lang->offsets = lang->file.offsets;
+    return true;
+}
+
+static bool lang_load(lang_table *lang, const char *filename, unsigned int count) {
+    if(lang_load_packed(lang, filename, count)) {
+        log_info("Loaded language file '%s' from the asset pack.", filename);
+    } else if(lang_load_file(lang, filename, count)) {
+        log_info("Loaded language file '%s'.", filename);
+    } else {
+        return false;
     }
+    return true;
+}
 
-    log_info("Loaded OpenOMF language file '%s'.", filename);
+static void lang_free(lang_table *lang) {
+    sd_lang_table_free(&lang->file);
+    memset(lang, 0, sizeof(lang_table));
+}
 
-    str_free(&filename_str);
+bool lang_init(void) {
+    str filename;
+    str_from_format(&filename, "%s%s", pm_get_local_path(RESOURCE_PATH), settings_get()->language.language);
+    bool ok = lang_load_language(str_c(&filename));
+    str_free(&filename);
+    return ok;
+}
+
+bool lang_load_language(const char *filename) {
+    str filename_str;
+    str_from_c(&filename_str, filename);
+
+    // Load up language file
+    if(!lang_load(&language, str_c(&filename_str), LANG_STR_COUNT)) {
+        goto error_0;
+    }
 
-    // XXX we're wasting 32KB of memory on language->strings[...].description
+    // Load up language2 file (OpenOMF)
+    str_append_c(&filename_str, "2");
+    if(!lang_load(&language2, str_c(&filename_str), LANG2_STR_COUNT)) {
+        goto error_0;
+    }
 
+    str_free(&filename_str);
     return true;
 
 error_0:
@@ -100,24 +160,65 @@ error_0:
 }
 
 void lang_close(void) {
-    sd_language_free(language);
-    omf_free(language);
-    sd_language_free(language2);
-    omf_free(language2);
+    lang_free(&language);
+    lang_free(&language2);
+}
+
+static bool lang_bake_file(asset_pack_writer *writer, const char *filename, unsigned int count) {
+    lang_table lang;
+    if(!lang_load_file(&lang, filename, count)) {
+        return false;
+    }
+    size_t len = (count + 1) * sizeof(uint32_t);
+    for(unsigned int i = 0; i < count; i++) {
+        const char *text = lang_table_get(&lang, i);
+        if(text != NULL) {
+            len += strlen(text) + 1;
+        }
+    }
+    char *data = omf_calloc(len, 1);
+    uint32_t *table = (uint32_t *)data;
+    size_t offset = (count + 1) * sizeof(uint32_t);
+    table[0] = count;
+    for(unsigned int i = 0; i < count; i++) {
+        const char *text = lang_table_get(&lang, i);
+        if(text == NULL) {
+            table[i + 1] = PACKED_NO_STRING;
+            continue;
+        }
+        size_t size = strlen(text) + 1;
+        table[i + 1] = offset;
+        memcpy(data + offset, text, size);
+        offset += size;
+    }
+    lang_free(&lang);
+    return asset_pack_writer_add(writer, filename, data, len);
+}
+
+bool lang_bake(asset_pack_writer *writer, const char *language_file) {
+    str filename;
+    str_from_format(&filename, "%s%s", pm_get_local_path(RESOURCE_PATH), language_file);
+    bool ok = lang_bake_file(writer, str_c(&filename), LANG_STR_COUNT);
+    str_append_c(&filename, "2");
+    ok = ok && lang_bake_file(writer, str_c(&filename), LANG2_STR_COUNT);
+    str_free(&filename);
+    return ok;
 }
 
 const char *lang_get(unsigned int id) {
-    if(id > language->count || !language->strings[id].data) {
+    const char *text = lang_table_get(&language, id);
+    if(text == NULL) {
         log_error("unsupported lang id %u!", id);
         return "!INVALID!";
     }
-    return language->strings[id].data;
+    return text;
 }
 
 const char *lang_get2(unsigned int id) {
-    if(id > language2->count || !language2->strings[id].data) {
+    const char *text = lang_table_get(&language2, id);
+    if(text == NULL) {
         log_error("unsupported lang2 id %u!", id);
         return "!INVALID2!";
     }
-    return language2->strings[id].data;
+    return text;
 }
@@ -1,6 +1,7 @@
 #ifndef LANGUAGES_H
 #define LANGUAGES_H
 
+#include "resources/asset_pack.h"
 #include <stdbool.h>
 
 /*
@@ -12,6 +13,12 @@
 bool lang_init(void);
 void lang_close(void);
 
+// Loads a language file (eg. resources/ENGLISH.DAT) and its OpenOMF strings, instead of the one from the settings
+bool lang_load_language(const char *filename);
+
+// Adds a language file (eg. ENGLISH.DAT) and its OpenOMF strings to an asset pack
+bool lang_bake(asset_pack_writer *writer, const char *language_file);
+
 /*! \brief OMF 2097 String ID
  *
  * These string IDs match OMFv2.1 (Epic Challenge Arena)
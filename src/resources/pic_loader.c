@@ -0,0 +1,163 @@
+#include "resources/pic_loader.h"
+#include "formats/error.h"
+#include "formats/palette.h"
+#include "formats/pic.h"
+#include "resources/pathmanager.h"
+#include "utils/allocator.h"
+#include "utils/log.h"
+#include <stdint.h>
+#include <string.h>
+
+// Baked PIC file is this header and a table of the photos, followed by the encoded and decoded sprites
+typedef struct packed_pic {
+    uint32_t photo_count;
+    uint32_t reserved;
+} packed_pic;
+
+typedef struct packed_photo {
+    vga_palette pal;
+    int16_t pos_x;
+    int16_t pos_y;
+    uint16_t width;
+    uint16_t height;
+    uint32_t offset; // of the encoded sprite, from the start of the data
+    uint32_t len;
+    uint32_t pixels_offset; // of the decoded sprite, in sprite_bake format
+    uint32_t pixels_len;
+} packed_photo;
+
+static int load_packed_photo(sd_sprite *s, vga_palette *pal, sprite_bake *bake, const char *filename,
+                             int photo_id) {
+    size_t len;
+    const char *data = asset_pack_get(filename, &len);
+    if(data == NULL || len < sizeof(packed_pic)) {
+        return SD_FILE_OPEN_ERROR;
+    }
+    const packed_pic *header = (const packed_pic *)data;
+    const packed_photo *photos = (const packed_photo *)(data + sizeof(packed_pic));
+    if(header->photo_count > (len - sizeof(packed_pic)) / sizeof(packed_photo)) {
+        log_error("Baked PIC file '%s' is corrupt!", filename);
+        return SD_FILE_PARSE_ERROR;
+    }
+    if(photo_id < 0 || (uint32_t)photo_id >= header->photo_count) {
+        return SD_INVALID_INPUT;
+    }
+    const packed_photo *photo = &photos[photo_id];
+    if(photo->offset > len || photo->len > len - photo->offset || photo->pixels_offset > len ||
+       photo->pixels_len > len - photo->pixels_offset) {
+        log_error("Baked PIC file '%s' is corrupt!", filename);
+        return SD_FILE_PARSE_ERROR;
+    }
+
+    // The encoded sprite is copied out of the pack, as the caller owns it
+    sd_sprite packed;
+    sd_sprite_create(&packed);
+    packed.pos_x = photo->pos_x;
+    packed.pos_y = photo->pos_y;
+    packed.width = photo->width;
+    packed.height = photo->height;
+    packed.len = photo->len;
+    packed.data = photo->len > 0 ? (char *)data + photo->offset : NULL;
+    sd_sprite_free(s);
+    sd_sprite_copy(s, &packed);
+    palette_copy(pal, &photo->pal, 0, 48);
+    if(bake != NULL) {
+        sprite_bake_create(bake, data + photo->pixels_offset, photo->pixels_len);
+    }
+    return SD_SUCCESS;
+}
+
+int load_pic_photo(sd_sprite *s, vga_palette *pal, sprite_bake *bake, int pic_id, int photo_id) {
+    if(bake != NULL) {
+        sprite_bake_create(bake, NULL, 0);
+    }
+    const char *filename = pm_get_resource_path(pic_id);
+    if(filename == NULL) {
+        log_error("Could not find requested PIC file handle.");
+        return SD_FILE_OPEN_ERROR;
+    }
+    if(load_packed_photo(s, pal, bake, filename, photo_id) == SD_SUCCESS) {
+        log_debug("PIC file %s loaded from the asset pack, selecting picture %d.", get_resource_name(pic_id),
+                  photo_id);
+        return SD_SUCCESS;
+    }
+
+    // Load PIC file and make a surface
+    sd_pic_file pics;
+    sd_pic_create(&pics);
+    int ret = sd_pic_load(&pics, filename);
+    if(ret != SD_SUCCESS) {
+        log_error("Could not load PIC file %s: %s", filename, sd_get_error(ret));
+        return ret;
+    } else {
+        log_debug("PIC file %s loaded, selecting picture %d.", get_resource_name(pic_id), photo_id);
+    }
+
+    const sd_pic_photo *photo = sd_pic_get(&pics, photo_id);
+    if(photo == NULL) {
+        log_error("PIC file %s has no picture %d.", filename, photo_id);
+        sd_pic_free(&pics);
+        return SD_INVALID_INPUT;
+    }
+    sd_sprite_free(s);
+    // Create new
+    sd_sprite_copy(s, photo->sprite);
+    palette_copy(pal, &photo->pal, 0, 48);
+    // Free pics
+    sd_pic_free(&pics);
+
+    return SD_SUCCESS;
+}
+
+bool pic_bake(asset_pack_writer *writer, int pic_id) {
+    const char *filename = pm_get_resource_path(pic_id);
+    sd_pic_file pics;
+    sd_pic_create(&pics);
+    int ret = sd_pic_load(&pics, filename);
+    if(ret != SD_SUCCESS) {
+        log_error("Could not load PIC file %s: %s", filename, sd_get_error(ret));
+        return false;
+    }
+
+    // Decode the photos first, to know the size of the data
+    sprite_bake *decoded = omf_calloc(pics.photo_count + 1, sizeof(sprite_bake));
+    size_t len = sizeof(packed_pic) + pics.photo_count * sizeof(packed_photo);
+    for(int i = 0; i < pics.photo_count; i++) {
+        sprite tmp;
+        sprite_bake_create_recorder(&decoded[i]);
+        sprite_create_baked(&tmp, pics.photos[i]->sprite, -1, &decoded[i]);
+        sprite_free(&tmp);
+        len += pics.photos[i]->sprite->len + decoded[i].out_len;
+    }
+
+    char *data = omf_calloc(len, 1);
+    packed_pic *header = (packed_pic *)data;
+    packed_photo *photos = (packed_photo *)(data + sizeof(packed_pic));
+    header->photo_count = pics.photo_count;
+    size_t offset = sizeof(packed_pic) + pics.photo_count * sizeof(packed_photo);
+    for(int i = 0; i < pics.photo_count; i++) {
+        const sd_sprite *spr = pics.photos[i]->sprite;
+        packed_photo *photo = &photos[i];
+        memcpy(&photo->pal, &pics.photos[i]->pal, sizeof(vga_palette));
+        photo->pos_x = spr->pos_x;
+        photo->pos_y = spr->pos_y;
+        photo->width = spr->width;
+        photo->height = spr->height;
+        photo->offset = offset;
+        photo->len = spr->len;
+        if(spr->len > 0) {
+            memcpy(data + offset, spr->data, spr->len);
+        }
+        offset += spr->len;
+        photo->pixels_offset = offset;
+        photo->pixels_len = decoded[i].out_len;
+        if(decoded[i].out_len > 0) {
+            memcpy(data + offset, decoded[i].out, decoded[i].out_len);
+        }
+        offset += decoded[i].out_len;
+        sprite_bake_free(&decoded[i]);
+    }
+    omf_free(decoded);
+    sd_pic_free(&pics);
+    return asset_pack_writer_add(writer, filename, data, len);
+}
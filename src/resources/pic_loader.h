@@ -0,0 +1,24 @@
+#ifndef PIC_LOADER_H
+#define PIC_LOADER_H
+
+#include "formats/sprite.h"
+#include "resources/asset_pack.h"
+#include "resources/sprite.h"
+#include "video/vga_palette.h"
+
+/**
+ * Loads a photo of a PIC file, from the asset pack if it has the file.
+ *
+ * @param s Sprite to replace with the photo
+ * @param pal Palette to copy the first 48 colors of the photo into
+ * @param bake If not NULL, set up with the decoded pixels of the photo for sprite_create_baked()
+ * @param pic_id Resource ID of the PIC file
+ * @param photo_id Number of the photo in the file
+ * @return SD_SUCCESS or an error code
+ */
+int load_pic_photo(sd_sprite *s, vga_palette *pal, sprite_bake *bake, int pic_id, int photo_id);
+
+// Adds the photos of a PIC file to an asset pack
+bool pic_bake(asset_pack_writer *writer, int pic_id);
+
+#endif // PIC_LOADER_H
@@ -100,16 +100,21 @@ list *sg_load_all(void) {
     list_iter_begin(&dirlist, &it);
     char *chrfile;
     char *ext;
+    char tmp[1024];
     foreach(it, chrfile) {
         if(strcmp(".", chrfile) == 0 || strcmp("..", chrfile) == 0) {
             continue;
         }
         if((ext = strrchr(chrfile, '.')) && strcmp(".CHR", ext) == 0) {
+            // Only the pilot data is needed for listing; the full savegame is loaded with sg_load() when picked.
             sd_chr_file *chr = omf_calloc(1, sizeof(sd_chr_file));
-            ext[0] = 0;
             log_debug("%s", chrfile);
-            if(sg_load(chr, chrfile) == SD_SUCCESS) {
+            snprintf(tmp, sizeof(tmp), "%s%s", dirname, chrfile);
+            sd_chr_create(chr);
+            if(sd_chr_load_summary(chr, tmp) == SD_SUCCESS) {
                 list_append(chrlist, chr, sizeof(sd_chr_file));
+            } else {
+                log_error("Unable to load savegame file '%s'.", tmp);
             }
             omf_free(chr);
         }
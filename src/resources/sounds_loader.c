@@ -5,12 +5,42 @@
 #include "resources/pathmanager.h"
 #include "utils/allocator.h"
 #include "utils/log.h"
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+
+// Baked SOUNDS.DAT is a table of these, followed by the samples
+typedef struct packed_sound {
+    uint32_t offset; // from the start of the table
+    uint32_t len;
+} packed_sound;
 
 static sd_sound_file *sound_data = NULL;
+static const char *packed_data = NULL;
+
+static bool sounds_loader_init_packed(const char *filename) {
+    size_t len;
+    const char *data = asset_pack_get(filename, &len);
+    if(data == NULL || len < sizeof(packed_sound) * SD_SOUNDS_MAX) {
+        return false;
+    }
+    const packed_sound *table = (const packed_sound *)data;
+    for(int i = 0; i < SD_SOUNDS_MAX; i++) {
+        if(table[i].offset > len || table[i].len > len - table[i].offset) {
+            log_error("Baked sounds file '%s' is corrupt!", filename);
+            return false;
+        }
+    }
+    packed_data = data;
+    log_info("Loaded sounds file '%s' from the asset pack.", filename);
+    return true;
+}
 
 bool sounds_loader_init(void) {
     const char *filename = pm_get_resource_path(DAT_SOUNDS);
+    if(sounds_loader_init_packed(filename)) {
+        return true;
+    }
 
     // Load sounds
     sound_data = omf_calloc(1, sizeof(sd_sound_file));
@@ -31,7 +61,18 @@ error_0:
     return false;
 }
 
-bool sounds_loader_get(int id, char **buffer, int *len) {
+bool sounds_loader_get(int id, const char **buffer, int *len) {
+    if(packed_data != NULL) {
+        if(id < 0 || id >= SD_SOUNDS_MAX) {
+            log_error("Requested sound %d does not exist!", id);
+            return false;
+        }
+        const packed_sound *sample = &((const packed_sound *)packed_data)[id];
+        *buffer = packed_data + sample->offset;
+        *len = sample->len;
+        return true;
+    }
+
     // Make sure the data is ok and sound exists
     if(sound_data == NULL)
         return false;
@@ -51,4 +92,36 @@ void sounds_loader_close(void) {
         sd_sounds_free(sound_data);
         omf_free(sound_data);
     }
+    packed_data = NULL;
+}
+
+bool sounds_loader_bake(asset_pack_writer *writer) {
+    const char *filename = pm_get_resource_path(DAT_SOUNDS);
+    sd_sound_file sf;
+    if(sd_sounds_create(&sf) != SD_SUCCESS) {
+        return false;
+    }
+    if(sd_sounds_load(&sf, filename)) {
+        log_error("Unable to load sounds file '%s'!", filename);
+        sd_sounds_free(&sf);
+        return false;
+    }
+
+    size_t len = sizeof(packed_sound) * SD_SOUNDS_MAX;
+    for(int i = 0; i < SD_SOUNDS_MAX; i++) {
+        len += sf.sounds[i].len;
+    }
+    char *data = omf_calloc(len, 1);
+    packed_sound *table = (packed_sound *)data;
+    size_t offset = sizeof(packed_sound) * SD_SOUNDS_MAX;
+    for(int i = 0; i < SD_SOUNDS_MAX; i++) {
+        table[i].offset = offset;
+        table[i].len = sf.sounds[i].len;
+        if(sf.sounds[i].len > 0) {
+            memcpy(data + offset, sf.sounds[i].data, sf.sounds[i].len);
+        }
+        offset += sf.sounds[i].len;
+    }
+    sd_sounds_free(&sf);
+    return asset_pack_writer_add(writer, filename, data, len);
 }
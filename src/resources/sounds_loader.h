@@ -1,10 +1,14 @@
 #ifndef SOUNDS_LOADER_H
 #define SOUNDS_LOADER_H
 
+#include "resources/asset_pack.h"
 #include <stdbool.h>
 
 bool sounds_loader_init(void);
-bool sounds_loader_get(int id, char **buffer, int *len);
+bool sounds_loader_get(int id, const char **buffer, int *len);
 void sounds_loader_close(void);
 
+// Adds SOUNDS.DAT to an asset pack
+bool sounds_loader_bake(asset_pack_writer *writer);
+
 #endif // SOUNDS_LOADER_H
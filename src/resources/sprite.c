@@ -1,7 +1,65 @@
 #include "formats/sprite.h"
 #include "resources/sprite.h"
 #include "utils/allocator.h"
+#include "utils/log.h"
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+
+#define BAKED_HEADER_LEN 4
+
+void sprite_bake_create(sprite_bake *bake, const void *data, size_t len) {
+    memset(bake, 0, sizeof(sprite_bake));
+    bake->data = data;
+    bake->len = len;
+}
+
+void sprite_bake_create_recorder(sprite_bake *bake) {
+    memset(bake, 0, sizeof(sprite_bake));
+    bake->recording = true;
+}
+
+void sprite_bake_free(sprite_bake *bake) {
+    omf_free(bake->out);
+    bake->out_len = 0;
+    bake->out_size = 0;
+}
+
+static void bake_record(sprite_bake *bake, const sd_vga_image *img) {
+    size_t len = BAKED_HEADER_LEN + (size_t)img->w * img->h;
+    if(bake->out_len + len > bake->out_size) {
+        bake->out_size = (bake->out_len + len) * 2;
+        bake->out = omf_realloc(bake->out, bake->out_size);
+    }
+    uint16_t size[2] = {img->w, img->h};
+    memcpy(bake->out + bake->out_len, size, BAKED_HEADER_LEN);
+    memcpy(bake->out + bake->out_len + BAKED_HEADER_LEN, img->data, len - BAKED_HEADER_LEN);
+    bake->out_len += len;
+}
+
+// Returns the baked pixels of the next sprite, or NULL if there are none for it.
+static const unsigned char *bake_next(sprite_bake *bake, int w, int h) {
+    if(bake == NULL || bake->data == NULL) {
+        return NULL;
+    }
+    uint16_t size[2];
+    if(bake->len - bake->pos < BAKED_HEADER_LEN) {
+        goto mismatch;
+    }
+    memcpy(size, bake->data + bake->pos, BAKED_HEADER_LEN);
+    size_t len = (size_t)size[0] * size[1];
+    if(size[0] != w || size[1] != h || bake->len - bake->pos - BAKED_HEADER_LEN < len) {
+        goto mismatch;
+    }
+    const unsigned char *pixels = (const unsigned char *)bake->data + bake->pos + BAKED_HEADER_LEN;
+    bake->pos += BAKED_HEADER_LEN + len;
+    return pixels;
+
+mismatch:
+    log_error("Baked sprites do not match their file, decoding the rest");
+    bake->data = NULL;
+    return NULL;
+}
 
 void sprite_create_custom(sprite *sp, vec2i pos, surface *data) {
     sp->id = -1;
@@ -10,6 +68,10 @@ void sprite_create_custom(sprite *sp, vec2i pos, surface *data) {
 }
 
 void sprite_create(sprite *sp, void *src, int id) {
+    sprite_create_baked(sp, src, id, NULL);
+}
+
+void sprite_create_baked(sprite *sp, void *src, int id, sprite_bake *bake) {
     sd_sprite *sdsprite = (sd_sprite *)src;
     sp->id = id;
     sp->pos = vec2i_create(sdsprite->pos_x, sdsprite->pos_y);
@@ -23,9 +85,22 @@ void sprite_create(sprite *sp, void *src, int id) {
     // Load data
     sp->data = omf_calloc(1, sizeof(surface));
     sp->owned = true;
+
+    // Sprites without packed data decode to a single pixel
+    int w = sdsprite->len > 0 ? sdsprite->width : 1;
+    int h = sdsprite->len > 0 ? sdsprite->height : 1;
+    const unsigned char *pixels = bake != NULL && !bake->recording ? bake_next(bake, w, h) : NULL;
+    if(pixels != NULL) {
+        surface_create_interned(sp->data, w, h, pixels);
+        return;
+    }
     sd_vga_image raw;
     sd_sprite_vga_decode(&raw, sdsprite);
-    surface_create_from_data(sp->data, raw.w, raw.h, (unsigned char *)raw.data);
+    if(bake != NULL && bake->recording) {
+        bake_record(bake, &raw);
+    }
+    // Animations reuse the same images a lot, so identical sprites share their pixels
+    surface_create_interned(sp->data, raw.w, raw.h, (unsigned char *)raw.data);
     sd_vga_image_free(&raw);
 }
 
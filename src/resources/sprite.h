@@ -11,7 +11,29 @@ typedef struct sprite_t {
     bool owned; // if we own the surface data
 } sprite;
 
+/*
+ * Decoded sprite pixels, in the order the sprites of a file are created. Each sprite is stored as its width and
+ * height (16 bits each) followed by its pixels. When recording, the sprites decoded by sprite_create_baked() are
+ * appended to out. Otherwise they are taken from data, and once data runs out or does not match a sprite, the
+ * rest of the sprites are decoded as usual.
+ */
+typedef struct sprite_bake {
+    const char *data;
+    size_t len;
+    size_t pos;
+    bool recording;
+    char *out;
+    size_t out_len;
+    size_t out_size;
+} sprite_bake;
+
+// Takes the pixels from data. Data may be NULL, in which case all sprites are decoded.
+void sprite_bake_create(sprite_bake *bake, const void *data, size_t len);
+void sprite_bake_create_recorder(sprite_bake *bake);
+void sprite_bake_free(sprite_bake *bake);
+
 void sprite_create(sprite *sp, void *src, int id);
+void sprite_create_baked(sprite *sp, void *src, int id, sprite_bake *bake);
 void sprite_create_custom(sprite *sp, vec2i pos, surface *sur);
 void sprite_create_reference(sprite *sp, void *src, int id, void *data);
 int sprite_clone(sprite *src, sprite *dst);
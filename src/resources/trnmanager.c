@@ -25,7 +25,7 @@ list *trnlist_init(void) {
         return NULL;
     }
 
-    // Seek all files
+    // Seek all files. Only the parts shown in the selection menu are loaded here, see trn_load_full().
     list_create(&dirlist);
     ret = scan_directory_suffix(&dirlist, dirname, ".TRN");
     if(ret != 0) {
@@ -46,7 +46,7 @@ list *trnlist_init(void) {
         sd_tournament_file trn;
         sd_tournament_create(&trn);
         snprintf(tmp, 1024, "%s%s", dirname, trn_file);
-        if(SD_SUCCESS == sd_tournament_load(&trn, tmp)) {
+        if(SD_SUCCESS == sd_tournament_load_summary(&trn, tmp)) {
             list_append(trnlist, &trn, sizeof(sd_tournament_file));
         } else {
             log_error("Could not load tournament %s", trn_file);
@@ -81,3 +81,18 @@ int trn_load(sd_tournament_file *trn, const char *trnname) {
 
     return 0;
 }
+
+int trn_load_full(sd_tournament_file *trn) {
+    // Enemy pilots are only loaded by a full load, and every tournament has at least one.
+    if(trn->enemies[0] != NULL) {
+        return 0;
+    }
+    sd_tournament_file full;
+    if(trn_load(&full, trn->filename)) {
+        sd_tournament_free(&full);
+        return 1;
+    }
+    sd_tournament_free(trn);
+    memcpy(trn, &full, sizeof(sd_tournament_file));
+    return 0;
+}
@@ -6,5 +6,7 @@
 
 list *trnlist_init(void);
 int trn_load(sd_tournament_file *trn, const char *trnname);
+// Replaces a tournament listed by trnlist_init() with the fully loaded file, if it isn't already.
+int trn_load_full(sd_tournament_file *trn);
 
 #endif // TRNMANAGER_H
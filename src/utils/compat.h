@@ -12,4 +12,11 @@ typedef uint_least32_t char32_t;
 #include <uchar.h>
 #endif
 
+// MSVC does not implement the C11 _Thread_local keyword
+#if defined(_MSC_VER)
+#define OMF_THREAD_LOCAL __declspec(thread)
+#else
+#define OMF_THREAD_LOCAL _Thread_local
+#endif
+
 #endif // COMPAT_H
@@ -6,10 +6,9 @@
 
 #define FNV_32_PRIME ((uint32_t)0x01000193)
 #define FNV1_32_INIT ((uint32_t)2166136261)
-#define ENLARGE_LIMIT 1024
 #define INITIAL_SIZE 4
 
-uint32_t fnv_32a_buf(const void *buf, unsigned int len, unsigned int max_size) {
+static uint32_t fnv_32a_buf(const void *buf, unsigned int len) {
     unsigned char *bp = (unsigned char *)buf;
     unsigned char *be = bp + len;
     uint32_t val = FNV1_32_INIT;
@@ -17,7 +16,117 @@ uint32_t fnv_32a_buf(const void *buf, unsigned int len, unsigned int max_size) {
         val ^= (uint32_t)*bp++;
         val *= FNV_32_PRIME;
     }
-    return val % max_size;
+    return val;
+}
+
+static inline uint32_t hash_key(const void *key, unsigned int key_len) {
+    if(key_len == sizeof(uint32_t)) {
+        // Integer keys are the common case; mix the bits instead of looping over bytes, so that
+        // sequential keys spread out over the table.
+        uint32_t k;
+        memcpy(&k, key, sizeof(uint32_t));
+        k ^= k >> 16;
+        k *= 0x7feb352d;
+        k ^= k >> 15;
+        k *= 0x846ca68b;
+        k ^= k >> 16;
+        return k;
+    }
+    return fnv_32a_buf(key, key_len);
+}
+
+/**
+ * How far the entry in the given slot is from the slot its hash points to.
+ */
+static inline unsigned int slot_distance(const hashmap *hm, unsigned int index) {
+    return (index - hm->buckets[index].hash) & (hm->capacity - 1);
+}
+
+/**
+ * Finds the slot that holds the given key. Returns the slot index, or -1 if the key is not in the hashmap.
+ */
+static int find_slot(const hashmap *hm, const void *key, unsigned int key_len, uint32_t hash) {
+    if(hm->capacity == 0)
+        return -1;
+    unsigned int mask = hm->capacity - 1;
+    unsigned int index = hash & mask;
+    for(unsigned int dist = 0;; dist++) {
+        const hashmap_slot *slot = &hm->buckets[index];
+
+        // Entries are kept ordered by their distance, so we can stop as soon as we see one
+        // that is closer to home than the key we are looking for would be.
+        if(slot->pair.key == NULL || slot_distance(hm, index) < dist)
+            return -1;
+        if(slot->hash == hash && slot->pair.key_len == key_len && memcmp(slot->pair.key, key, key_len) == 0)
+            return index;
+        index = (index + 1) & mask;
+    }
+}
+
+/**
+ * Places an entry into the table. The key must not be in the hashmap yet, and there must be a free slot.
+ *
+ * Entries that are further away from their own slot take over the place of ones that are closer, which
+ * keeps the probe sequences short (Robin Hood hashing).
+ */
+static void insert_slot(hashmap *hm, hashmap_slot entry) {
+    unsigned int mask = hm->capacity - 1;
+    unsigned int index = entry.hash & mask;
+    unsigned int dist = 0;
+    while(hm->buckets[index].pair.key != NULL) {
+        unsigned int existing = slot_distance(hm, index);
+        if(existing < dist) {
+            hashmap_slot tmp = hm->buckets[index];
+            hm->buckets[index] = entry;
+            entry = tmp;
+            dist = existing;
+        }
+        index = (index + 1) & mask;
+        dist++;
+    }
+    hm->buckets[index] = entry;
+}
+
+/**
+ * Frees the memory held by a pair. Key and value share a single allocation, with the value first.
+ */
+static void free_pair(hashmap *hm, hashmap_pair *pair) {
+    if(hm->free_cb != NULL) {
+        hm->free_cb(pair->value);
+    }
+    omf_free(pair->value);
+    pair->key = NULL;
+}
+
+/**
+ * Empties a slot and shifts the entries after it back, so that there are no gaps in the probe sequences.
+ */
+static void remove_slot(hashmap *hm, unsigned int index) {
+    unsigned int mask = hm->capacity - 1;
+    free_pair(hm, &hm->buckets[index].pair);
+    unsigned int next = (index + 1) & mask;
+    while(hm->buckets[next].pair.key != NULL && slot_distance(hm, next) > 0) {
+        hm->buckets[index] = hm->buckets[next];
+        index = next;
+        next = (next + 1) & mask;
+    }
+    memset(&hm->buckets[index], 0, sizeof(hashmap_slot));
+    hm->reserved--;
+}
+
+/**
+ * Allocates the memory for a key and a value, and points the pair to it.
+ */
+static void alloc_pair(hashmap_pair *pair, const void *key, unsigned int key_len, const void *val,
+                       unsigned int value_len) {
+    size_t size = (size_t)key_len + value_len;
+    char *block = omf_malloc(size > 0 ? size : 1);
+    memcpy(block, val, value_len);
+    memcpy(block + value_len, key, key_len);
+    pair->value = block;
+    pair->key = block + value_len;
+    pair->key_len = key_len;
+    pair->value_len = value_len;
 }
 
 /** \brief Creates a new hashmap
@@ -26,7 +135,7 @@ uint32_t fnv_32a_buf(const void *buf, unsigned int len, unsigned int max_size) {
  * \param initial_capacity Size of the hashmap.
  */
 void hashmap_create(hashmap *hm) {
-    hm->buckets = omf_calloc(INITIAL_SIZE, sizeof(hashmap_node *));
+    hm->buckets = omf_calloc(INITIAL_SIZE, sizeof(hashmap_slot));
     hm->reserved = 0;
     hm->capacity = INITIAL_SIZE;
     hm->free_cb = NULL;
@@ -48,43 +157,28 @@ void hashmap_create_cb(hashmap *hm, hashmap_free_cb free_cb) {
 /**
  * Resizes the hashmap to a new capacity.
  *
- * All existing key-value pairs are rehashed, so this has some CPU impact.
+ * All existing entries are placed again, so this has some CPU impact. Keys and values are not reallocated.
  */
 static void hashmap_resize(hashmap *hm, unsigned int new_size) {
     if(new_size <= hm->capacity)
         return;
 
-    // Allocate and zero out a new memory blocks for the resized bucket list
-    size_t new_bytes = new_size * sizeof(hashmap_node *);
-    hm->buckets = omf_realloc(hm->buckets, new_bytes);
-    memset(&hm->buckets[hm->capacity], 0, (new_size - hm->capacity) * sizeof(hashmap_node *));
-
-    // Rehash
-    hashmap_node *node = NULL;
-    hashmap_node *this = NULL;
-    unsigned int index;
-    for(unsigned int i = 0; i < hm->capacity; i++) {
-        node = hm->buckets[i];
-        hm->buckets[i] = NULL;
-        while(node != NULL) {
-            this = node;
-            node = node->next;
-
-            // Recalculate index, and prepend the new index to the bucket list
-            index = fnv_32a_buf(this->pair.key, this->pair.key_len, new_size);
-            this->next = hm->buckets[index];
-            hm->buckets[index] = this;
+    hashmap_slot *old = hm->buckets;
+    unsigned int old_size = hm->capacity;
+    hm->buckets = omf_calloc(new_size, sizeof(hashmap_slot));
+    hm->capacity = new_size;
+    for(unsigned int i = 0; i < old_size; i++) {
+        if(old[i].pair.key != NULL) {
+            insert_slot(hm, old[i]);
         }
     }
-    hm->capacity = new_size;
+    omf_free(old);
 }
 
 /**
  * Check if hashmap pressure is high enough for automatic resize, and resize if yes.
  */
 static void hashmap_enlarge_check(hashmap *hm) {
-    if(hm->capacity >= ENLARGE_LIMIT)
-        return;
     unsigned int q = hm->capacity - (hm->capacity >> 2);
     if(hm->reserved > q) {
         hashmap_resize(hm, hm->capacity << 1);
@@ -99,23 +193,15 @@ static void hashmap_enlarge_check(hashmap *hm) {
  * \param hm Hashmap to clear
  */
 void hashmap_clear(hashmap *hm) {
-    hashmap_node *node = NULL;
-    hashmap_node *tmp = NULL;
     for(unsigned int i = 0; i < hashmap_size(hm); i++) {
-        node = hm->buckets[i];
-        while(node != NULL) {
-            tmp = node;
-            node = node->next;
-            if(hm->free_cb != NULL) {
-                hm->free_cb(tmp->pair.value);
-            }
-            omf_free(tmp->pair.key);
-            omf_free(tmp->pair.value);
-            omf_free(tmp);
-            hm->reserved--;
+        if(hm->buckets[i].pair.key != NULL) {
+            free_pair(hm, &hm->buckets[i].pair);
         }
-        hm->buckets[i] = NULL;
     }
+    if(hm->buckets != NULL) {
+        memset(hm->buckets, 0, hm->capacity * sizeof(hashmap_slot));
+    }
+    hm->reserved = 0;
 }
 
 /** \brief Free hashmap
@@ -138,6 +224,9 @@ void hashmap_free(hashmap *hm) {
  * contents of the value memory block will be copied. However,
  * any memory _pointed to_ by it will NOT be copied. So be careful!
  *
+ * The returned value pointer stays valid until the key is removed or its value replaced,
+ * regardless of other insertions.
+ *
  * \param hm Hashmap
  * \param key Pointer to key memory block
  * \param key_len Length of the key memory block
@@ -146,46 +235,28 @@ void hashmap_free(hashmap *hm) {
  * \return Returns a pointer to the newly reserved hashmap pair.
  */
 void *hashmap_put(hashmap *hm, const void *key, unsigned int key_len, const void *val, unsigned int value_len) {
-    unsigned int index = fnv_32a_buf(key, key_len, hm->capacity);
-    hashmap_node *root = hm->buckets[index];
-    hashmap_node *seek = root;
-
-    // See if the key already exists in the buckets list
-    int found = 0;
-    while(seek) {
-        if(seek->pair.key_len == key_len && memcmp(seek->pair.key, key, key_len) == 0) {
-            found = 1;
-            break;
-        }
-        seek = seek->next;
+    uint32_t hash = hash_key(key, key_len);
+    int index = find_slot(hm, key, key_len, hash);
+
+    if(index >= 0) {
+        // The key is already in the hashmap, so just reallocate and reset the contents.
+        hashmap_pair *pair = &hm->buckets[index].pair;
+        void *old = pair->value;
+        alloc_pair(pair, key, key_len, val, value_len);
+        omf_free(old);
+        return pair->value;
     }
 
-    if(found) {
-        // The key is already in the hashmap, so just realloc and reset the contents.
-        seek->pair.value = omf_realloc(seek->pair.value, value_len);
-        memcpy(seek->pair.value, val, value_len);
-        seek->pair.value_len = value_len;
-
-        hashmap_enlarge_check(hm);
-        return seek->pair.value;
-    } else {
-        // Key is not yet in the hashmap, so create a new node and set it
-        // as the first entry in the buckets list.
-        hashmap_node *node = omf_calloc(1, sizeof(hashmap_node));
-        node->pair.key_len = key_len;
-        node->pair.value_len = value_len;
-        node->pair.key = omf_calloc(1, key_len);
-        node->pair.value = omf_calloc(1, value_len);
-        memcpy(node->pair.key, key, key_len);
-        memcpy(node->pair.value, val, value_len);
+    // Key is not yet in the hashmap, so create a new entry. There is always at least one free
+    // slot, as the table grows right after it gets more than 3/4 full.
+    hashmap_slot entry;
+    entry.hash = hash;
+    alloc_pair(&entry.pair, key, key_len, val, value_len);
+    insert_slot(hm, entry);
+    hm->reserved++;
 
-        node->next = root;
-        hm->buckets[index] = node;
-        hm->reserved++;
-
-        hashmap_enlarge_check(hm);
-        return node->pair.value;
-    }
+    hashmap_enlarge_check(hm);
+    return entry.pair.value;
 }
 
 /** \brief Deletes an item from the hashmap
@@ -200,44 +271,11 @@ void *hashmap_put(hashmap *hm, const void *key, unsigned int key_len, const void
  * \return Returns 0 on success, 1 on error (not found).
  */
 int hashmap_del(hashmap *hm, const void *key, unsigned int key_len) {
-    unsigned int index = fnv_32a_buf(key, key_len, hm->capacity);
-
-    // Get node
-    hashmap_node *node = hm->buckets[index];
-    hashmap_node *prev = NULL;
-    if(node == NULL)
+    int index = find_slot(hm, key, key_len, hash_key(key, key_len));
+    if(index < 0)
         return 1;
-
-    // Find the node we want to delete
-    int found = 0;
-    while(node) {
-        if(node->pair.key_len == key_len && memcmp(node->pair.key, key, key_len) == 0) {
-            found = 1;
-            break;
-        }
-        prev = node;
-        node = node->next;
-    }
-
-    // If node was found, handle delete
-    if(found) {
-        if(prev != NULL) {
-            // If node is not first in chain, set correct links
-            prev->next = node->next;
-        } else {
-            // If node is first in chain, set possible next entry as first
-            hm->buckets[index] = node->next;
-        }
-        if(hm->free_cb != NULL) {
-            hm->free_cb(node->pair.value);
-        }
-        omf_free(node->pair.key);
-        omf_free(node->pair.value);
-        omf_free(node);
-        hm->reserved--;
-        return 0;
-    }
-    return 1;
+    remove_slot(hm, index);
+    return 0;
 }
 
 /** \brief Gets an item from the hashmap
@@ -250,30 +288,18 @@ int hashmap_del(hashmap *hm, const void *key, unsigned int key_len) {
  * \return Returns 0 on success, 1 on error (not found).
  */
 int hashmap_get(hashmap *hm, const void *key, unsigned int key_len, void **value, unsigned int *value_len) {
-    unsigned int index = fnv_32a_buf(key, key_len, hm->capacity);
-
-    // Set defaults for error cases
-    *value = NULL;
-    if(value_len != NULL)
-        *value_len = 0;
-
-    // Get node
-    hashmap_node *node = hm->buckets[index];
-    if(node == NULL)
+    int index = find_slot(hm, key, key_len, hash_key(key, key_len));
+    if(index < 0) {
+        *value = NULL;
+        if(value_len != NULL)
+            *value_len = 0;
         return 1;
-
-    // Find the node we want
-    while(node) {
-        if(node->pair.key_len == key_len && memcmp(node->pair.key, key, key_len) == 0) {
-            *value = node->pair.value;
-            if(value_len != NULL)
-                *value_len = node->pair.value_len;
-            return 0;
-        }
-        node = node->next;
     }
 
-    return 1;
+    *value = hm->buckets[index].pair.value;
+    if(value_len != NULL)
+        *value_len = hm->buckets[index].pair.value_len;
+    return 0;
 }
 
 /** \brief Deletes an item from the hashmap by iterator key
@@ -287,97 +313,40 @@ int hashmap_get(hashmap *hm, const void *key, unsigned int key_len, void **value
  * \return Returns 0 on success, 1 on error (not found).
  */
 int hashmap_delete(hashmap *hm, iterator *iter) {
-    int index = iter->inow - 1;
-
-    if(iter->ended) {
+    if(iter->ended || iter->vnow == NULL) {
         return 1;
     }
 
-    // Find correct node
-    hashmap_node *node = hm->buckets[index];
-    hashmap_node *prev = NULL;
-    hashmap_node *seek = iter->vnow;
-    if(node == NULL || seek == NULL)
+    hashmap_slot *slot = iter->vnow;
+    if(slot->pair.key == NULL) {
         return 1;
-
-    // Find the node we want to delete
-    int found = 0;
-    while(node) {
-        if(node == seek) {
-            found = 1;
-            break;
-        }
-        prev = node;
-        node = node->next;
-    }
-
-    // If node was found, handle delete
-    if(found) {
-        // If node is not first in chain, set correct links
-        // Otherwise set possible next entry as first
-        if(prev != NULL) {
-            prev->next = node->next;
-            iter->vnow = prev;
-        } else {
-            hm->buckets[index] = node->next;
-            iter->vnow = NULL;
-            iter->inow--;
-        }
-
-        // Got one, free up memory.
-        if(hm->free_cb != NULL) {
-            hm->free_cb(node->pair.value);
-        }
-        omf_free(node->pair.key);
-        omf_free(node->pair.value);
-        omf_free(node);
-        hm->reserved--;
-        return 0;
     }
-    return 1;
-}
 
-static void _hashmap_seek_next(hashmap *hm, iterator *iter) {
-    if(iter->inow >= (int)hashmap_size(hm)) {
-        iter->vnow = NULL;
-        iter->ended = 1;
-        return;
-    }
-    do {
-        iter->vnow = hm->buckets[iter->inow++];
-    } while(iter->vnow == NULL && iter->inow < (int)hashmap_size(hm));
+    // Removing shifts the following entries back by one, so the iterator has to look at this slot again.
+    // Iteration starts right after an empty slot, and entries never move across one, so nothing that
+    // was already visited can end up in front of the iterator.
+    unsigned int index = slot - hm->buckets;
+    remove_slot(hm, index);
+    iter->vnow = &hm->buckets[(index - 1) & (hm->capacity - 1)];
+    iter->inow--;
+    return 0;
 }
 
 void *hashmap_iter_next(iterator *iter) {
-    hashmap_node *tmp = NULL;
-    hashmap *hm = (hashmap *)iter->data;
-
-    // Find next non-empty bucket
-    if(iter->vnow == NULL) {
-        _hashmap_seek_next(hm, iter);
-        if(iter->vnow == NULL) {
-            return NULL;
+    const hashmap *hm = iter->data;
+    hashmap_slot *slot = iter->vnow;
+
+    // Walk one full round over the table, starting after the slot we began from.
+    while(iter->inow < (int)hashmap_size(hm)) {
+        slot = &hm->buckets[(slot - hm->buckets + 1) & (hm->capacity - 1)];
+        iter->vnow = slot;
+        iter->inow++;
+        if(slot->pair.key != NULL) {
+            return &slot->pair;
         }
-        tmp = (hashmap_node *)iter->vnow;
-        return &tmp->pair;
-    }
-
-    // We already are in a non-empty bucket. See if it has any
-    // other non-empty buckets in list. If it does, return it.
-    tmp = (hashmap_node *)iter->vnow;
-    if(tmp->next != NULL) {
-        iter->vnow = tmp->next;
-        return &tmp->next->pair;
-    }
-
-    // We are in the end of the list for this bucket.
-    // Find next non-empty bucket.
-    _hashmap_seek_next(hm, iter);
-    if(iter->vnow == NULL) {
-        return NULL;
     }
-    tmp = (hashmap_node *)iter->vnow;
-    return &tmp->pair;
+    iter->ended = 1;
+    return NULL;
 }
 
 void hashmap_iter_begin(const hashmap *hm, iterator *iter) {
@@ -388,4 +357,12 @@ void hashmap_iter_begin(const hashmap *hm, iterator *iter) {
     iter->peek = NULL;
     iter->prev = NULL;
     iter->ended = (hm->reserved == 0);
+
+    // Start from an empty slot, see hashmap_delete. The table is never full, so there always is one.
+    for(unsigned int i = 0; !iter->ended && i < hm->capacity; i++) {
+        if(hm->buckets[i].pair.key == NULL) {
+            iter->vnow = &hm->buckets[i];
+            break;
+        }
+    }
 }
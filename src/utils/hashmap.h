@@ -4,8 +4,10 @@
 #include "utils/iterator.h"
 #include <string.h>
 
+#include <stdint.h>
+
 typedef struct hashmap_pair hashmap_pair;
-typedef struct hashmap_node hashmap_node;
+typedef struct hashmap_slot hashmap_slot;
 typedef struct hashmap hashmap;
 typedef void (*hashmap_free_cb)(void *);
 
@@ -16,14 +18,15 @@ struct hashmap_pair {
     void *value;
 };
 
-struct hashmap_node {
+// Buckets are stored inline in one array and probed linearly. A slot is empty if its key is NULL.
+struct hashmap_slot {
     hashmap_pair pair;
-    hashmap_node *next;
+    uint32_t hash;
 };
 
 struct hashmap {
-    hashmap_node **buckets;
-    unsigned int capacity;
+    hashmap_slot *buckets;
+    unsigned int capacity; // Always a power of two
     unsigned int reserved;
     hashmap_free_cb free_cb;
 };
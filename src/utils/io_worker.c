@@ -0,0 +1,118 @@
+#include "utils/io_worker.h"
+#include "utils/allocator.h"
+#include "utils/c_string_util.h"
+#include "utils/log.h"
+#include <SDL.h>
+#include <SDL_mutex.h>
+#include <SDL_thread.h>
+
+#define IO_QUEUE_SIZE 16
+
+typedef struct io_job {
+    char *description;
+    io_job_run run;
+    io_job_free free_fn;
+    void *data;
+} io_job;
+
+typedef struct io_worker {
+    SDL_Thread *thread;
+    SDL_mutex *lock;
+    SDL_cond *changed;
+    io_job queue[IO_QUEUE_SIZE];
+    unsigned int head; // next job to run
+    unsigned int tail; // next free queue slot
+    bool closing;
+} io_worker;
+
+static io_worker *worker = NULL;
+
+static void run_job(io_job *job) {
+    if(job->run(job->data)) {
+        log_info("Saved %s", job->description);
+    } else {
+        log_error("Unable to save %s", job->description);
+    }
+    if(job->free_fn != NULL) {
+        job->free_fn(job->data);
+    }
+    omf_free(job->description);
+}
+
+static int worker_thread(void *userdata) {
+    io_worker *w = userdata;
+    SDL_LockMutex(w->lock);
+    while(true) {
+        while(w->head == w->tail && !w->closing) {
+            SDL_CondWait(w->changed, w->lock);
+        }
+        if(w->head == w->tail) {
+            break;
+        }
+        io_job job = w->queue[w->head % IO_QUEUE_SIZE];
+        w->head++;
+        SDL_UnlockMutex(w->lock);
+        run_job(&job);
+        SDL_LockMutex(w->lock);
+    }
+    SDL_UnlockMutex(w->lock);
+    return 0;
+}
+
+bool io_worker_init(void) {
+    worker = omf_calloc(1, sizeof(io_worker));
+    worker->lock = SDL_CreateMutex();
+    worker->changed = SDL_CreateCond();
+    worker->thread = SDL_CreateThread(worker_thread, "io worker", worker);
+    if(worker->thread == NULL) {
+        log_error("Unable to start I/O worker: %s", SDL_GetError());
+        goto error_0;
+    }
+    return true;
+
+error_0:
+    SDL_DestroyCond(worker->changed);
+    SDL_DestroyMutex(worker->lock);
+    omf_free(worker);
+    return false;
+}
+
+void io_worker_close(void) {
+    if(worker == NULL) {
+        return;
+    }
+    SDL_LockMutex(worker->lock);
+    worker->closing = true;
+    SDL_CondSignal(worker->changed);
+    SDL_UnlockMutex(worker->lock);
+    SDL_WaitThread(worker->thread, NULL);
+    SDL_DestroyCond(worker->changed);
+    SDL_DestroyMutex(worker->lock);
+    omf_free(worker);
+}
+
+bool io_worker_submit(const char *description, io_job_run run, io_job_free free_fn, void *data) {
+    io_job job = {omf_strdup(description), run, free_fn, data};
+    if(worker == NULL) {
+        run_job(&job);
+        return true;
+    }
+
+    SDL_LockMutex(worker->lock);
+    bool queued = worker->tail - worker->head < IO_QUEUE_SIZE && !worker->closing;
+    if(queued) {
+        worker->queue[worker->tail % IO_QUEUE_SIZE] = job;
+        worker->tail++;
+        SDL_CondSignal(worker->changed);
+    }
+    SDL_UnlockMutex(worker->lock);
+
+    if(!queued) {
+        log_warn("I/O queue is full, dropping %s", description);
+        if(free_fn != NULL) {
+            free_fn(data);
+        }
+        omf_free(job.description);
+    }
+    return queued;
+}
@@ -0,0 +1,35 @@
+#ifndef IO_WORKER_H
+#define IO_WORKER_H
+
+#include <stdbool.h>
+
+/*
+ * Background thread for file writes that should not stall the game loop, eg. screenshots and REC saves.
+ * Jobs are run in the order they were submitted. The queue is bounded; when it is full, new jobs are
+ * dropped instead of blocking the caller.
+ */
+
+// Does the work of a job. Returns false on failure.
+typedef bool (*io_job_run)(void *data);
+
+// Frees the data of a job. May be NULL.
+typedef void (*io_job_free)(void *data);
+
+bool io_worker_init(void);
+
+// Runs all queued jobs, and stops the worker thread.
+void io_worker_close(void);
+
+/**
+ * Queue a job for the worker. The worker takes ownership of data, and frees it once the job has run,
+ * or right away if the job could not be queued. If the worker is not running, the job is run right away.
+ *
+ * @param description What the job writes, eg. the filename. Used for logging.
+ * @param run Job function
+ * @param free_fn Frees data after the job has run. May be NULL.
+ * @param data Data for the job
+ * @return False if the job was dropped
+ */
+bool io_worker_submit(const char *description, io_job_run run, io_job_free free_fn, void *data);
+
+#endif // IO_WORKER_H
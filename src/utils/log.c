@@ -105,9 +105,15 @@ void log_add_file(const char *filename, log_level level) {
 }
 
 static void format_timestamp(char *buffer, size_t len) {
+    // Use the reentrant variants, messages may be logged from several threads at once.
     time_t t = time(NULL);
-    struct tm *tm = localtime(&t);
-    strftime(buffer, len, "%H:%M:%S", tm);
+    struct tm tm;
+#if defined(_WIN32)
+    localtime_s(&tm, &t);
+#else
+    localtime_r(&t, &tm);
+#endif
+    strftime(buffer, len, "%H:%M:%S", &tm);
     buffer[len - 1] = 0;
 }
 
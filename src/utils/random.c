@@ -1,9 +1,11 @@
 #include "utils/random.h"
+#include "utils/compat.h"
 #include <limits.h>
 
 // A simple psuedorandom number generator
 
-static struct random_t rand_state = {1};
+// Each thread gets its own state, so that headless matches running in parallel do not disturb each other.
+static OMF_THREAD_LOCAL struct random_t rand_state = {1};
 
 void random_seed(struct random_t *r, uint32_t seed) {
     r->seed = seed;
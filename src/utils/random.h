@@ -21,7 +21,7 @@ uint32_t random_intmax(struct random_t *r);
 /* Return a random float in 0 <= r <= 1.0f */
 float random_float(struct random_t *r);
 
-/* Same as the above but keeps an internal state
+/* Same as the above but keeps an internal per-thread state
  * Use as a replacement for rand()
  */
 void rand_seed(uint32_t seed);
@@ -0,0 +1,168 @@
+#include "utils/range_coder.h"
+#include "utils/allocator.h"
+#include <stdint.h>
+
+#define PROB_BITS 11
+#define PROB_ONE (1 << PROB_BITS)
+#define PROB_SHIFT 5 // adaptation speed
+#define RANGE_TOP (1u << 24)
+
+// One bit tree per context byte, each node holds the chance of the next bit being 0
+typedef struct {
+    uint16_t probs[256][256];
+} byte_model;
+
+static void model_init(byte_model *model) {
+    for(int i = 0; i < 256; i++) {
+        for(int j = 0; j < 256; j++) {
+            model->probs[i][j] = PROB_ONE / 2;
+        }
+    }
+}
+
+typedef struct {
+    uint64_t low;
+    uint32_t range;
+    uint8_t cache;
+    uint64_t cache_size;
+    char *out;
+    size_t len;
+    size_t capacity;
+} encoder;
+
+static void put_byte(encoder *enc, uint8_t byte) {
+    if(enc->len == enc->capacity) {
+        enc->capacity *= 2;
+        enc->out = omf_realloc(enc->out, enc->capacity);
+    }
+    enc->out[enc->len++] = byte;
+}
+
+// Carries are held back in cache until it is known whether they ripple into the bytes already pending
+static void shift_low(encoder *enc) {
+    if((uint32_t)enc->low < 0xFF000000u || (enc->low >> 32) != 0) {
+        uint8_t carry = enc->low >> 32;
+        uint8_t byte = enc->cache;
+        do {
+            put_byte(enc, byte + carry);
+            byte = 0xFF;
+        } while(--enc->cache_size != 0);
+        enc->cache = (enc->low >> 24) & 0xFF;
+    }
+    enc->cache_size++;
+    enc->low = (enc->low & 0x00FFFFFFu) << 8;
+}
+
+static void encode_bit(encoder *enc, uint16_t *prob, int bit) {
+    uint32_t bound = (enc->range >> PROB_BITS) * *prob;
+    if(bit == 0) {
+        enc->range = bound;
+        *prob += (PROB_ONE - *prob) >> PROB_SHIFT;
+    } else {
+        enc->low += bound;
+        enc->range -= bound;
+        *prob -= *prob >> PROB_SHIFT;
+    }
+    while(enc->range < RANGE_TOP) {
+        enc->range <<= 8;
+        shift_low(enc);
+    }
+}
+
+size_t range_compress(const char *src, size_t len, char **dst) {
+    byte_model *model = omf_malloc(sizeof(byte_model));
+    model_init(model);
+
+    encoder enc;
+    enc.low = 0;
+    enc.range = 0xFFFFFFFFu;
+    enc.cache = 0;
+    enc.cache_size = 1;
+    enc.capacity = len / 2 + 16;
+    enc.len = 0;
+    enc.out = omf_malloc(enc.capacity);
+
+    uint8_t context = 0;
+    for(size_t i = 0; i < len; i++) {
+        uint8_t byte = src[i];
+        unsigned node = 1;
+        for(int b = 7; b >= 0; b--) {
+            int bit = (byte >> b) & 1;
+            encode_bit(&enc, &model->probs[context][node], bit);
+            node = (node << 1) | bit;
+        }
+        context = byte;
+    }
+    for(int i = 0; i < 5; i++) {
+        shift_low(&enc);
+    }
+
+    omf_free(model);
+    *dst = enc.out;
+    return enc.len;
+}
+
+typedef struct {
+    uint32_t code;
+    uint32_t range;
+    const uint8_t *in;
+    size_t pos;
+    size_t len;
+} decoder;
+
+static uint8_t get_byte(decoder *dec) {
+    // Running off the end is only reported at the end, reading zeros is harmless until then
+    if(dec->pos < dec->len) {
+        return dec->in[dec->pos++];
+    }
+    dec->pos++;
+    return 0;
+}
+
+static int decode_bit(decoder *dec, uint16_t *prob) {
+    uint32_t bound = (dec->range >> PROB_BITS) * *prob;
+    int bit;
+    if(dec->code < bound) {
+        dec->range = bound;
+        *prob += (PROB_ONE - *prob) >> PROB_SHIFT;
+        bit = 0;
+    } else {
+        dec->code -= bound;
+        dec->range -= bound;
+        *prob -= *prob >> PROB_SHIFT;
+        bit = 1;
+    }
+    while(dec->range < RANGE_TOP) {
+        dec->range <<= 8;
+        dec->code = (dec->code << 8) | get_byte(dec);
+    }
+    return bit;
+}
+
+bool range_decompress(const char *src, size_t src_len, char *dst, size_t len) {
+    byte_model *model = omf_malloc(sizeof(byte_model));
+    model_init(model);
+
+    decoder dec;
+    dec.code = 0;
+    dec.range = 0xFFFFFFFFu;
+    dec.in = (const uint8_t *)src;
+    dec.pos = 0;
+    dec.len = src_len;
+    for(int i = 0; i < 5; i++) {
+        dec.code = (dec.code << 8) | get_byte(&dec);
+    }
+
+    uint8_t context = 0;
+    for(size_t i = 0; i < len; i++) {
+        unsigned node = 1;
+        while(node < 256) {
+            node = (node << 1) | decode_bit(&dec, &model->probs[context][node]);
+        }
+        context = node & 0xFF;
+        dst[i] = context;
+    }
+
+    omf_free(model);
+    return dec.pos <= dec.len;
+}
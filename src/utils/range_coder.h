@@ -0,0 +1,34 @@
+#ifndef RANGE_CODER_H
+#define RANGE_CODER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Small general purpose compressor: an adaptive binary range coder, with every byte predicted from the
+ * byte before it. There is no dictionary, so it works best on short, repetitive data like encoded inputs,
+ * and every call starts from a fresh model, so blocks compressed separately can be decoded separately.
+ */
+
+/**
+ * Compresses a buffer.
+ *
+ * @param src Data to compress
+ * @param len Length of the data
+ * @param dst Set to a new buffer holding the compressed data, free it with omf_free()
+ * @return Length of the compressed data
+ */
+size_t range_compress(const char *src, size_t len, char **dst);
+
+/**
+ * Decompresses a buffer made by range_compress().
+ *
+ * @param src Compressed data
+ * @param src_len Length of the compressed data
+ * @param dst Buffer for the decompressed data
+ * @param len Length of the decompressed data, as given to range_compress()
+ * @return False if the compressed data ended early
+ */
+bool range_decompress(const char *src, size_t src_len, char *dst, size_t len);
+
+#endif // RANGE_CODER_H
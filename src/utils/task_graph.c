@@ -0,0 +1,211 @@
+#include "utils/task_graph.h"
+#include "utils/log.h"
+#include <SDL.h>
+#include <SDL_mutex.h>
+#include <SDL_thread.h>
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+// Which tasks a thread may pick
+enum
+{
+    PICK_WORKER,
+    PICK_MAIN,
+    PICK_ANY
+};
+
+typedef struct graph_run {
+    task_graph *graph;
+    SDL_mutex *lock;
+    SDL_cond *changed;
+} graph_run;
+
+void task_graph_create(task_graph *graph) {
+    memset(graph, 0, sizeof(task_graph));
+}
+
+int task_graph_add(task_graph *graph, const char *name, task_run_fn run, task_close_fn close, void *userdata,
+                   unsigned int deps, bool main_thread) {
+    int id = graph->count;
+    assert(id < TASK_GRAPH_MAX_TASKS);
+    assert((deps >> id) == 0);
+    graph_task *task = &graph->tasks[id];
+    task->name = name;
+    task->run = run;
+    task->close = close;
+    task->userdata = userdata;
+    task->deps = deps;
+    task->main_thread = main_thread;
+    task->state = TASK_PENDING;
+    graph->count++;
+    return id;
+}
+
+static bool deps_done(const task_graph *graph, const graph_task *task) {
+    for(int i = 0; i < graph->count; i++) {
+        if((task->deps & TASK_DEP(i)) && graph->tasks[i].state != TASK_DONE) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Finds a task the calling thread can start. Must be called with the lock held. Returns -1 if there is none
+// right now; finished is then set if there will be no more either.
+static int next_task(task_graph *graph, int pick, bool *finished) {
+    *finished = true;
+    for(int i = 0; i < graph->count; i++) {
+        graph_task *task = &graph->tasks[i];
+        if(task->state == TASK_RUNNING) {
+            *finished = false;
+        }
+        if(task->state != TASK_PENDING) {
+            continue;
+        }
+        if(graph->failed) {
+            task->state = TASK_SKIPPED;
+            continue;
+        }
+        *finished = false;
+        if(pick != PICK_ANY && task->main_thread != (pick == PICK_MAIN)) {
+            continue;
+        }
+        if(deps_done(graph, task)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void run_tasks(graph_run *run, int pick) {
+    task_graph *graph = run->graph;
+    SDL_LockMutex(run->lock);
+    while(true) {
+        bool finished;
+        int id = next_task(graph, pick, &finished);
+        if(finished) {
+            break;
+        }
+        if(id < 0) {
+            SDL_CondWait(run->changed, run->lock);
+            continue;
+        }
+
+        graph_task *task = &graph->tasks[id];
+        task->state = TASK_RUNNING;
+        SDL_UnlockMutex(run->lock);
+        task->start = SDL_GetPerformanceCounter();
+        bool ok = task->run(task->userdata);
+        task->end = SDL_GetPerformanceCounter();
+        SDL_LockMutex(run->lock);
+        if(ok) {
+            task->state = TASK_DONE;
+        } else {
+            log_error("Task '%s' failed", task->name);
+            task->state = TASK_FAILED;
+            graph->failed = true;
+        }
+        SDL_CondBroadcast(run->changed);
+    }
+    SDL_UnlockMutex(run->lock);
+}
+
+static int worker_thread(void *userdata) {
+    run_tasks(userdata, PICK_WORKER);
+    return 0;
+}
+
+bool task_graph_run(task_graph *graph, int max_workers) {
+    SDL_Thread *workers[TASK_GRAPH_MAX_TASKS];
+    int worker_count = 0;
+    int worker_tasks = 0;
+    for(int i = 0; i < graph->count; i++) {
+        if(!graph->tasks[i].main_thread) {
+            worker_tasks++;
+        }
+    }
+    if(max_workers > worker_tasks) {
+        max_workers = worker_tasks;
+    }
+
+    graph_run run;
+    run.graph = graph;
+    run.lock = SDL_CreateMutex();
+    run.changed = SDL_CreateCond();
+    graph->start = SDL_GetPerformanceCounter();
+    for(int i = 0; i < max_workers; i++) {
+        workers[worker_count] = SDL_CreateThread(worker_thread, "task worker", &run);
+        if(workers[worker_count] == NULL) {
+            log_warn("Unable to start task worker: %s", SDL_GetError());
+            break;
+        }
+        worker_count++;
+    }
+
+    // Without workers, this thread runs everything
+    run_tasks(&run, worker_count > 0 ? PICK_MAIN : PICK_ANY);
+    for(int i = 0; i < worker_count; i++) {
+        SDL_WaitThread(workers[i], NULL);
+    }
+    graph->end = SDL_GetPerformanceCounter();
+    SDL_DestroyCond(run.changed);
+    SDL_DestroyMutex(run.lock);
+    return !graph->failed;
+}
+
+void task_graph_close(task_graph *graph) {
+    for(int i = graph->count - 1; i >= 0; i--) {
+        graph_task *task = &graph->tasks[i];
+        if(task->state == TASK_DONE && task->close != NULL) {
+            task->close(task->userdata);
+        }
+        task->state = TASK_PENDING;
+    }
+}
+
+void task_graph_log_profile(const task_graph *graph, const char *title) {
+    double ms = SDL_GetPerformanceFrequency() / 1000.0;
+    int last = -1;
+    for(int i = 0; i < graph->count; i++) {
+        const graph_task *task = &graph->tasks[i];
+        if(task->state != TASK_DONE && task->state != TASK_FAILED) {
+            continue;
+        }
+        log_debug("%s: %-12s %7.2f ms, started at %7.2f ms%s", title, task->name, (task->end - task->start) / ms,
+                  (task->start - graph->start) / ms, task->main_thread ? " (main thread)" : "");
+        if(last < 0 || task->end > graph->tasks[last].end) {
+            last = i;
+        }
+    }
+
+    // Walk back from the task that finished last, always through the task it waited for the longest. That is
+    // one of its dependencies, or for main thread tasks, also the main thread task that ended before it started.
+    // Either way the path only goes back in time, so it cannot visit a task twice.
+    int path[TASK_GRAPH_MAX_TASKS];
+    int length = 0;
+    while(last >= 0 && length < graph->count) {
+        const graph_task *task = &graph->tasks[last];
+        path[length++] = last;
+        int next = -1;
+        for(int i = 0; i < graph->count; i++) {
+            const graph_task *prev = &graph->tasks[i];
+            bool waited = (task->deps & TASK_DEP(i)) ||
+                          (task->main_thread && prev->main_thread && i != last && prev->state == TASK_DONE &&
+                           prev->end < task->start);
+            if(waited && (next < 0 || prev->end > graph->tasks[next].end)) {
+                next = i;
+            }
+        }
+        last = next;
+    }
+
+    char buf[256] = "";
+    size_t pos = 0;
+    for(int i = length - 1; i >= 0 && pos < sizeof(buf); i--) {
+        const graph_task *task = &graph->tasks[path[i]];
+        pos += snprintf(buf + pos, sizeof(buf) - pos, "%s%s (%.2f ms)", i < length - 1 ? " -> " : "", task->name,
+                        (task->end - task->start) / ms);
+    }
+    log_info("%s took %.2f ms, critical path: %s", title, (graph->end - graph->start) / ms, buf);
+}
@@ -0,0 +1,86 @@
+#ifndef TASK_GRAPH_H
+#define TASK_GRAPH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Runs a set of tasks with dependencies between them, eg. the subsystem loaders at startup. Each task runs as
+ * soon as the tasks it depends on are done; worker tasks on a pool of threads, main thread tasks on the thread
+ * that called task_graph_run(). Once a task fails, tasks that have not started yet are skipped, and the ones
+ * that did run can be undone with task_graph_close().
+ */
+
+#define TASK_GRAPH_MAX_TASKS 16
+
+// Dependency mask for task_graph_add()
+#define TASK_DEP(id) (1u << (id))
+
+// Does the work of a task. Returns false on failure.
+typedef bool (*task_run_fn)(void *userdata);
+
+// Undoes the work of a task that succeeded. May be NULL.
+typedef void (*task_close_fn)(void *userdata);
+
+typedef enum graph_task_state
+{
+    TASK_PENDING,
+    TASK_RUNNING,
+    TASK_DONE,
+    TASK_FAILED,
+    TASK_SKIPPED
+} graph_task_state;
+
+typedef struct graph_task {
+    const char *name;
+    task_run_fn run;
+    task_close_fn close;
+    void *userdata;
+    unsigned int deps;
+    bool main_thread;
+    graph_task_state state;
+    uint64_t start;
+    uint64_t end;
+} graph_task;
+
+typedef struct task_graph {
+    graph_task tasks[TASK_GRAPH_MAX_TASKS];
+    int count;
+    bool failed;
+    uint64_t start;
+    uint64_t end;
+} task_graph;
+
+void task_graph_create(task_graph *graph);
+
+/**
+ * Add a task to the graph. A task can only depend on tasks added before it.
+ *
+ * @param graph Graph to add to
+ * @param name Name of the task, for the profile
+ * @param run Task function
+ * @param close Undoes the task, may be NULL
+ * @param userdata Passed to run and close
+ * @param deps Tasks this one depends on, as TASK_DEP(id) | TASK_DEP(id2) ...
+ * @param main_thread Run the task on the thread calling task_graph_run(), eg. for window creation
+ * @return ID of the task
+ */
+int task_graph_add(task_graph *graph, const char *name, task_run_fn run, task_close_fn close, void *userdata,
+                   unsigned int deps, bool main_thread);
+
+/**
+ * Run all tasks, and wait for them to finish.
+ *
+ * @param graph Graph to run
+ * @param max_workers Maximum number of worker threads. With none, all tasks run on the calling thread.
+ * @return False if any task failed
+ */
+bool task_graph_run(task_graph *graph, int max_workers);
+
+// Closes the tasks that succeeded, in the reverse order they were added in.
+void task_graph_close(task_graph *graph);
+
+// Logs how long each task took, and the chain of dependencies that the whole run had to wait for.
+void task_graph_log_profile(const task_graph *graph, const char *title);
+
+#endif // TASK_GRAPH_H
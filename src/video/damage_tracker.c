@@ -26,3 +26,23 @@ void damage_set_range(damage_tracker *tracker, vga_index start, vga_index end) {
     tracker->dirty_range_start = min2(tracker->dirty_range_start, start);
     tracker->dirty_range_end = max2(tracker->dirty_range_end, end);
 }
+
+void damage_narrow(damage_tracker *tracker, const vga_palette *a, const vga_palette *b) {
+    if(!tracker->dirty) {
+        return;
+    }
+    int start = tracker->dirty_range_start;
+    int end = tracker->dirty_range_end;
+    while(start <= end && memcmp(&a->colors[start], &b->colors[start], sizeof(vga_color)) == 0) {
+        start++;
+    }
+    while(end >= start && memcmp(&a->colors[end], &b->colors[end], sizeof(vga_color)) == 0) {
+        end--;
+    }
+    if(start > end) {
+        damage_reset(tracker);
+        return;
+    }
+    tracker->dirty_range_start = start;
+    tracker->dirty_range_end = end;
+}
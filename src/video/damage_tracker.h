@@ -15,4 +15,7 @@ void damage_copy(damage_tracker *dst, const damage_tracker *src);
 void damage_combine(damage_tracker *dst, const damage_tracker *src);
 void damage_set_range(damage_tracker *tracker, vga_index start, vga_index end);
 
+// Shrink the damaged range to the colors that really differ between the two palettes.
+void damage_narrow(damage_tracker *tracker, const vga_palette *a, const vga_palette *b);
+
 #endif // DAMAGE_TRACKER_H
@@ -0,0 +1,264 @@
+#include "video/frame_writer.h"
+#include "resources/pathmanager.h"
+#include "utils/allocator.h"
+#include "utils/c_string_util.h"
+#include "utils/log.h"
+#include "utils/miscmath.h"
+#include "utils/png_writer.h"
+#include <SDL.h>
+#include <SDL_mutex.h>
+#include <SDL_thread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define MAX_ENCODERS 8
+
+// Frames that may be waiting for an encoder, per encoder
+#define SLOTS_PER_ENCODER 2
+
+enum
+{
+    FRAMES_PNG,
+    FRAMES_Y4M,
+};
+
+enum
+{
+    SLOT_FREE,
+    SLOT_QUEUED,
+    SLOT_BUSY,
+};
+
+typedef struct frame_slot {
+    int state;
+    unsigned int number;
+    unsigned char *pixels;
+    vga_palette palette;
+} frame_slot;
+
+struct frame_writer {
+    int format;
+    char *path;
+    FILE *stream;
+    int w;
+    int h;
+
+    SDL_mutex *lock;
+    SDL_cond *changed;
+    SDL_Thread *encoders[MAX_ENCODERS];
+    int encoder_count;
+    frame_slot *slots;
+    int slot_count;
+    unsigned int pushed;  // frames queued
+    unsigned int started; // frames picked up by an encoder
+    unsigned int written; // frames written to the stream, in order
+    bool closing;
+    bool failed;
+};
+
+static bool ends_with(const char *str, const char *suffix) {
+    size_t len = strlen(str);
+    size_t suffix_len = strlen(suffix);
+    return len >= suffix_len && strcmp(str + len - suffix_len, suffix) == 0;
+}
+
+// Full range BT.601, as used by the C420jpeg colorspace
+static void palette_to_yuv(const vga_palette *palette, uint8_t *y, uint8_t *u, uint8_t *v) {
+    for(int i = 0; i < 256; i++) {
+        int r = palette->colors[i].r;
+        int g = palette->colors[i].g;
+        int b = palette->colors[i].b;
+        y[i] = (77 * r + 150 * g + 29 * b + 128) >> 8;
+        u[i] = (-43 * r - 85 * g + 128 * b + 32896) >> 8;
+        v[i] = (128 * r - 107 * g - 21 * b + 32896) >> 8;
+    }
+}
+
+// Converts a frame to planar YUV 4:2:0, averaging the chroma of each 2x2 block.
+static void frame_to_yuv(const frame_writer *writer, const frame_slot *slot, uint8_t *dst) {
+    uint8_t y_lut[256], u_lut[256], v_lut[256];
+    palette_to_yuv(&slot->palette, y_lut, u_lut, v_lut);
+
+    int w = writer->w;
+    int h = writer->h;
+    int cw = (w + 1) / 2;
+    int ch = (h + 1) / 2;
+    uint8_t *dst_y = dst;
+    uint8_t *dst_u = dst_y + w * h;
+    uint8_t *dst_v = dst_u + cw * ch;
+    for(int i = 0; i < w * h; i++) {
+        dst_y[i] = y_lut[slot->pixels[i]];
+    }
+    for(int cy = 0; cy < ch; cy++) {
+        for(int cx = 0; cx < cw; cx++) {
+            int u = 0, v = 0, n = 0;
+            for(int y = cy * 2; y < min2(cy * 2 + 2, h); y++) {
+                for(int x = cx * 2; x < min2(cx * 2 + 2, w); x++) {
+                    u += u_lut[slot->pixels[y * w + x]];
+                    v += v_lut[slot->pixels[y * w + x]];
+                    n++;
+                }
+            }
+            dst_u[cy * cw + cx] = (u + n / 2) / n;
+            dst_v[cy * cw + cx] = (v + n / 2) / n;
+        }
+    }
+}
+
+static int encoder_thread(void *userdata) {
+    frame_writer *writer = userdata;
+    size_t yuv_size = writer->w * writer->h + 2 * ((writer->w + 1) / 2) * ((writer->h + 1) / 2);
+    uint8_t *yuv = writer->format == FRAMES_Y4M ? omf_malloc(yuv_size) : NULL;
+    char filename[1024];
+
+    SDL_LockMutex(writer->lock);
+    while(true) {
+        // Pick up the oldest queued frame
+        while(writer->started == writer->pushed && !writer->closing) {
+            SDL_CondWait(writer->changed, writer->lock);
+        }
+        if(writer->started == writer->pushed) {
+            break;
+        }
+        frame_slot *slot = &writer->slots[writer->started % writer->slot_count];
+        writer->started++;
+        slot->state = SLOT_BUSY;
+        SDL_UnlockMutex(writer->lock);
+
+        bool ok = true;
+        if(writer->format == FRAMES_PNG) {
+            snprintf(filename, sizeof(filename), "%s/%06u.png", writer->path, slot->number);
+            ok = write_paletted_png(filename, writer->w, writer->h, &slot->palette, slot->pixels);
+        } else {
+            frame_to_yuv(writer, slot, yuv);
+        }
+
+        SDL_LockMutex(writer->lock);
+        if(writer->format == FRAMES_Y4M) {
+            // The stream has to stay in order; wait for the frames before this one
+            while(writer->written != slot->number) {
+                SDL_CondWait(writer->changed, writer->lock);
+            }
+            ok = fputs("FRAME\n", writer->stream) >= 0 && fwrite(yuv, yuv_size, 1, writer->stream) == 1;
+            writer->written++;
+        }
+        if(!ok && !writer->failed) {
+            log_error("Unable to write video frame %u", slot->number);
+            writer->failed = true;
+        }
+        slot->state = SLOT_FREE;
+        SDL_CondBroadcast(writer->changed);
+    }
+    SDL_UnlockMutex(writer->lock);
+    omf_free(yuv);
+    return 0;
+}
+
+frame_writer *frame_writer_open(const char *path, int w, int h, int fps) {
+    frame_writer *writer = omf_calloc(1, sizeof(frame_writer));
+    writer->w = w;
+    writer->h = h;
+    writer->path = omf_strdup(path);
+    if(strcmp(path, "-") == 0) {
+        writer->format = FRAMES_Y4M;
+        writer->stream = stdout;
+    } else if(ends_with(path, ".y4m")) {
+        writer->format = FRAMES_Y4M;
+        if((writer->stream = fopen(path, "wb")) == NULL) {
+            log_error("Unable to open %s for writing video", path);
+            goto error_0;
+        }
+    } else {
+        // Frames go into the directory, which is created if needed
+        struct stat info;
+        writer->format = FRAMES_PNG;
+        if(stat(path, &info) != 0 && pm_create_dir(path) != 0) {
+            goto error_0;
+        }
+    }
+    if(writer->format == FRAMES_Y4M) {
+        fprintf(writer->stream, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", w, h, fps);
+    }
+
+    // Leave a core for the simulation
+    writer->encoder_count = clamp(SDL_GetCPUCount() - 1, 1, MAX_ENCODERS);
+    writer->slot_count = writer->encoder_count * SLOTS_PER_ENCODER;
+    writer->slots = omf_calloc(writer->slot_count, sizeof(frame_slot));
+    for(int i = 0; i < writer->slot_count; i++) {
+        writer->slots[i].pixels = omf_malloc(w * h);
+    }
+    writer->lock = SDL_CreateMutex();
+    writer->changed = SDL_CreateCond();
+    int started = 0;
+    for(int i = 0; i < writer->encoder_count; i++) {
+        writer->encoders[i] = SDL_CreateThread(encoder_thread, "frame encoder", writer);
+        if(writer->encoders[i] == NULL) {
+            log_error("Unable to start video encoder: %s", SDL_GetError());
+            break;
+        }
+        started++;
+    }
+    writer->encoder_count = started;
+    if(started == 0) {
+        frame_writer_close(&writer);
+        return NULL;
+    }
+    log_info("Writing video to %s with %d encoders", path, writer->encoder_count);
+    return writer;
+
+error_0:
+    omf_free(writer->path);
+    omf_free(writer);
+    return NULL;
+}
+
+void frame_writer_push(frame_writer *writer, const unsigned char *pixels, const vga_palette *palette) {
+    SDL_LockMutex(writer->lock);
+    frame_slot *slot = &writer->slots[writer->pushed % writer->slot_count];
+    while(slot->state != SLOT_FREE) {
+        SDL_CondWait(writer->changed, writer->lock);
+    }
+    SDL_UnlockMutex(writer->lock);
+
+    // Encoders do not touch free slots, so this can be filled in without the lock
+    memcpy(slot->pixels, pixels, writer->w * writer->h);
+    memcpy(&slot->palette, palette, sizeof(vga_palette));
+
+    SDL_LockMutex(writer->lock);
+    slot->number = writer->pushed++;
+    slot->state = SLOT_QUEUED;
+    SDL_CondBroadcast(writer->changed);
+    SDL_UnlockMutex(writer->lock);
+}
+
+bool frame_writer_close(frame_writer **_writer) {
+    frame_writer *writer = *_writer;
+    SDL_LockMutex(writer->lock);
+    writer->closing = true;
+    SDL_CondBroadcast(writer->changed);
+    SDL_UnlockMutex(writer->lock);
+    for(int i = 0; i < writer->encoder_count; i++) {
+        SDL_WaitThread(writer->encoders[i], NULL);
+    }
+
+    bool ok = !writer->failed;
+    if(writer->stream != NULL) {
+        ok = fflush(writer->stream) == 0 && ok;
+        if(writer->stream != stdout) {
+            ok = fclose(writer->stream) == 0 && ok;
+        }
+    }
+    log_info("Wrote %u video frames to %s", writer->pushed, writer->path);
+
+    for(int i = 0; i < writer->slot_count; i++) {
+        omf_free(writer->slots[i].pixels);
+    }
+    omf_free(writer->slots);
+    SDL_DestroyCond(writer->changed);
+    SDL_DestroyMutex(writer->lock);
+    omf_free(writer->path);
+    omf_free(writer);
+    *_writer = NULL;
+    return ok;
+}
@@ -0,0 +1,24 @@
+#ifndef FRAME_WRITER_H
+#define FRAME_WRITER_H
+
+#include "video/vga_palette.h"
+#include <stdbool.h>
+
+/*
+ * Writes a stream of indexed frames out as video. Frames are encoded by a pool of background threads, so
+ * the caller only pays for a copy of each frame. Output format is picked by the path:
+ * - "-" or a path ending in ".y4m": YUV4MPEG2 stream, eg. to pipe into an encoder
+ * - anything else: directory to write a numbered PNG sequence into (000000.png, 000001.png, ...)
+ */
+typedef struct frame_writer frame_writer;
+
+// Returns NULL if the output could not be opened.
+frame_writer *frame_writer_open(const char *path, int w, int h, int fps);
+
+// Queues a frame of w * h color indexes. Blocks while all encoders are busy.
+void frame_writer_push(frame_writer *writer, const unsigned char *pixels, const vga_palette *palette);
+
+// Waits for the queued frames to be written, and closes the output. Returns false if any frame failed.
+bool frame_writer_close(frame_writer **writer);
+
+#endif // FRAME_WRITER_H
@@ -54,11 +54,7 @@ static void move_target(void *userdata, int x, int y) {
 static void render_prepare(void *userdata) {
 }
 
-static void render_finish(void *userdata) {
-}
-static void render_area_prepare(void *userdata, const SDL_Rect *area) {
-}
-static void render_area_finish(void *userdata, surface *dst) {
+static void render_finish(void *userdata, vga_state *vga) {
 }
 
 static void capture_screen(void *userdata, video_screenshot_signal screenshot_cb) {
@@ -92,8 +88,6 @@ void null_renderer_set_callbacks(renderer *gl3_renderer) {
     gl3_renderer->move_target = move_target;
     gl3_renderer->render_prepare = render_prepare;
     gl3_renderer->render_finish = render_finish;
-    gl3_renderer->render_area_prepare = render_area_prepare;
-    gl3_renderer->render_area_finish = render_area_finish;
 
     gl3_renderer->capture_screen = capture_screen;
     gl3_renderer->signal_scene_change = signal_scene_change;
@@ -2,6 +2,7 @@
 #include "video/renderers/opengl3/sdl_window.h"
 
 #include "video/renderers/opengl3/helpers/object_array.h"
+#include "video/renderers/opengl3/helpers/pbo.h"
 #include "video/renderers/opengl3/helpers/remaps.h"
 #include "video/renderers/opengl3/helpers/render_target.h"
 #include "video/renderers/opengl3/helpers/shaders.h"
@@ -38,13 +39,19 @@ typedef struct gl3_context {
     int target_move_x;
     int target_move_y;
     bool draw_atlas;
-    SDL_Rect culling_area;
+    bool vga_invalidated;
 
     object_array_blend_mode current_blend_mode;
     GLuint palette_prog_id;
     GLuint rgba_prog_id;
 
     video_screenshot_signal screenshot_cb;
+
+    // Screenshot readback in flight
+    video_screenshot_signal readback_cb;
+    SDL_Rect readback_rect;
+    GLuint readback_pbo;
+    GLsync readback_fence;
 } gl3_context;
 
 static bool is_available(void) {
@@ -103,7 +110,8 @@ static bool setup_context(void *userdata, int window_w, int window_h, bool fulls
     ctx->target = render_target_create(TEX_UNIT_FBO, NATIVE_W, NATIVE_H, GL_RGBA8, GL_RGBA);
     ctx->remaps = remaps_create(TEX_UNIT_REMAPS);
 
-    vga_state_mark_dirty();
+    // Palette and remap textures are empty; request a full upload on the first frame.
+    ctx->vga_invalidated = true;
 
     // Create orthographic projection matrix for 2d stuff.
     GLfloat projection_matrix[16];
@@ -172,12 +180,53 @@ static bool reset_context_with(void *userdata, int window_w, int window_h, bool
     return success;
 }
 
+/**
+ * Start copying the screen to a PBO. The pixels are picked up by finish_screenshot() a few frames later,
+ * once the GPU is done with them, so the main thread does not stall on glReadPixels.
+ */
+static void capture_screenshot(gl3_context *ctx) {
+    ctx->readback_cb = ctx->screenshot_cb;
+    ctx->readback_rect = (SDL_Rect){0, 0, ctx->screen_w, ctx->screen_h};
+    ctx->readback_pbo = pbo_create(ctx->screen_w * ctx->screen_h * 3);
+    pbo_read_pixels(ctx->readback_pbo, 0, 0, ctx->screen_w, ctx->screen_h);
+    ctx->readback_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+/**
+ * Hand the screenshot over to the callback, if the copy is done. With wait set, block until it is.
+ */
+static void finish_screenshot(gl3_context *ctx, bool wait) {
+    GLuint64 timeout = wait ? 1000000000 : 0;
+    GLenum status = glClientWaitSync(ctx->readback_fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+    if(status == GL_TIMEOUT_EXPIRED && !wait) {
+        return;
+    }
+    if(status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED) {
+        const SDL_Rect *r = &ctx->readback_rect;
+        const unsigned char *pixels = pbo_map(ctx->readback_pbo, r->w * r->h * 3);
+        if(pixels != NULL) {
+            ctx->readback_cb(r, pixels, true);
+            pbo_unmap(ctx->readback_pbo);
+        }
+    } else {
+        log_error("Screenshot readback failed");
+    }
+    glDeleteSync(ctx->readback_fence);
+    pbo_free(ctx->readback_pbo);
+    ctx->readback_fence = NULL;
+    ctx->readback_pbo = 0;
+    ctx->readback_cb = NULL;
+}
+
 static void reset_context(void *userdata) {
     return;
 }
 
 static void close_context(void *userdata) {
     gl3_context *ctx = userdata;
+    if(ctx->readback_fence) {
+        finish_screenshot(ctx, true);
+    }
     remaps_free(&ctx->remaps);
     render_target_free(&ctx->target);
     shared_free(&ctx->shared);
@@ -228,16 +277,6 @@ static inline void video_set_blend_mode(gl3_context *ctx, object_array_blend_mod
     ctx->current_blend_mode = request_mode;
 }
 
-// TODO: Use asynchronous capture + PBO here.
-static void capture_screenshot(void *userdata) {
-    gl3_context *ctx = userdata;
-    SDL_Rect r = {0, 0, ctx->screen_w, ctx->screen_h};
-    unsigned char *buffer = omf_malloc(r.w * r.h * 3);
-    glReadPixels(r.x, r.y, r.w, r.h, GL_RGB, GL_UNSIGNED_BYTE, buffer);
-    ctx->screenshot_cb(&r, buffer, true); // TODO: should preferably happen in a thread.
-    omf_free(buffer);
-}
-
 /**
  * Set the viewport, and do screen-shakes here.
  */
@@ -268,23 +307,23 @@ static inline void set_screen_viewport(const gl3_context *ctx) {
 /**
  * If palette is dirty, flush it to the texture. Note that the range is inclusive (dirty area is start <= x <= end).
  */
-static inline void flush_palettes(gl3_context *ctx) {
+static inline void flush_palettes(gl3_context *ctx, vga_state *vga) {
     vga_index range_start, range_end;
     vga_palette *palette;
-    if(vga_state_is_palette_dirty(&palette, &range_start, &range_end)) {
+    if(vga_state_is_palette_dirty(vga, &palette, &range_start, &range_end)) {
         shared_set_palette(ctx->shared, palette, range_start, range_end);
-        vga_state_mark_palette_flushed();
+        vga_state_mark_palette_flushed(vga);
     }
 }
 
 /**
  * If remaps are dirty, do the flush. This should be pretty rare (once per scene change)
  */
-static inline void flush_remaps(gl3_context *ctx) {
+static inline void flush_remaps(gl3_context *ctx, vga_state *vga) {
     vga_remap_tables *tables;
-    if(vga_state_is_remap_dirty(&tables)) {
+    if(vga_state_is_remap_dirty(vga, &tables)) {
         remaps_update(ctx->remaps, tables);
-        vga_state_mark_remaps_flushed();
+        vga_state_mark_remaps_flushed(vga);
     }
 }
 
@@ -322,15 +361,22 @@ static inline void finish_onscreen(gl3_context *ctx) {
     glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
 }
 
-static void render_finish(void *userdata) {
+static void render_finish(void *userdata, vga_state *vga) {
     gl3_context *ctx = userdata;
-    flush_palettes(ctx);
-    flush_remaps(ctx);
+    if(ctx->vga_invalidated) {
+        vga_state_mark_dirty(vga);
+        ctx->vga_invalidated = false;
+    }
+    flush_palettes(ctx, vga);
+    flush_remaps(ctx, vga);
     finish_offscreen(ctx);
     finish_onscreen(ctx);
 
-    // Snap screenshot from the freshly rendered state.
-    if(ctx->screenshot_cb) {
+    // Snap screenshot from the freshly rendered state. Only one readback is kept in flight.
+    if(ctx->readback_fence) {
+        finish_screenshot(ctx, false);
+    }
+    if(ctx->screenshot_cb && !ctx->readback_fence) {
         capture_screenshot(ctx);
         ctx->screenshot_cb = NULL;
     }
@@ -340,23 +386,6 @@ static void render_finish(void *userdata) {
     SDL_GL_SwapWindow(ctx->window);
 }
 
-static void render_area_prepare(void *userdata, const SDL_Rect *area) {
-    gl3_context *ctx = userdata;
-    object_array_prepare(ctx->objects);
-    ctx->culling_area = *area;
-}
-
-static void render_area_finish(void *userdata, surface *dst) {
-    gl3_context *ctx = userdata;
-    finish_offscreen(ctx);
-    SDL_Rect *r = &ctx->culling_area;
-    unsigned char *buffer = omf_malloc(r->w * r->h);
-    glReadPixels(r->x, r->y, r->w, r->h, GL_RED, GL_UNSIGNED_BYTE, buffer);
-    surface_create_from_data_flip(dst, r->w, r->h, buffer);
-    surface_set_transparency(dst, -1);
-    omf_free(buffer);
-}
-
 static void capture_screen(void *userdata, video_screenshot_signal screenshot_cb) {
     gl3_context *ctx = userdata;
     ctx->screenshot_cb = screenshot_cb;
@@ -398,8 +427,6 @@ void gl3_renderer_set_callbacks(renderer *gl3_renderer) {
     gl3_renderer->move_target = move_target;
     gl3_renderer->render_prepare = render_prepare;
     gl3_renderer->render_finish = render_finish;
-    gl3_renderer->render_area_prepare = render_area_prepare;
-    gl3_renderer->render_area_finish = render_area_finish;
 
     gl3_renderer->capture_screen = capture_screen;
     gl3_renderer->signal_scene_change = signal_scene_change;
@@ -0,0 +1,36 @@
+#include "video/renderers/opengl3/helpers/pbo.h"
+
+GLuint pbo_create(GLsizeiptr size) {
+    GLuint id;
+    glGenBuffers(1, &id);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, id);
+    glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return id;
+}
+
+/**
+ * Start copying the pixels of the current framebuffer to the PBO as packed RGB. This returns without
+ * waiting for the GPU; map the buffer once the copy is done.
+ */
+void pbo_read_pixels(GLuint id, GLint x, GLint y, GLsizei w, GLsizei h) {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, id);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(x, y, w, h, GL_RGB, GL_UNSIGNED_BYTE, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+const void *pbo_map(GLuint id, GLsizeiptr size) {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, id);
+    return glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+}
+
+void pbo_unmap(GLuint id) {
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, id);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void pbo_free(GLuint id) {
+    glDeleteBuffers(1, &id);
+}
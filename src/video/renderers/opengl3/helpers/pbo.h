@@ -0,0 +1,12 @@
+#ifndef PBO_H
+#define PBO_H
+
+#include <epoxy/gl.h>
+
+GLuint pbo_create(GLsizeiptr size);
+void pbo_read_pixels(GLuint id, GLint x, GLint y, GLsizei w, GLsizei h);
+const void *pbo_map(GLuint id, GLsizeiptr size);
+void pbo_unmap(GLuint id);
+void pbo_free(GLuint id);
+
+#endif // PBO_H
@@ -2,11 +2,12 @@
 #define RENDERER_H
 
 #include "video/surface.h"
+#include "video/vga_state.h"
 
 typedef struct renderer renderer;
 
 // Asynchronous screenshot signal, renderer must call this when it has the screenshot data.
-typedef void (*video_screenshot_signal)(const SDL_Rect *rect, unsigned char *data, bool flipped);
+typedef void (*video_screenshot_signal)(const SDL_Rect *rect, const unsigned char *data, bool flipped);
 
 // Metadata functions, all must be implemented. These must NOT require context or renderer state to be initialized!
 typedef bool (*is_available_fn)(void);
@@ -33,11 +34,7 @@ typedef void (*move_target_fn)(void *ctx, int x, int y);
 
 // Onscreen rendering state management, these must be implemented
 typedef void (*render_prepare_fn)(void *ctx);
-typedef void (*render_finish_fn)(void *ctx);
-
-// Offscreen rendering state management, these must be implemented
-typedef void (*render_area_prepare_fn)(void *ctx, const SDL_Rect *area);
-typedef void (*render_area_finish_fn)(void *ctx, surface *dst);
+typedef void (*render_finish_fn)(void *ctx, vga_state *vga);
 
 // Screenshotting, this /should/ be implemented (but is not required).
 typedef void (*capture_screen_fn)(void *ctx, video_screenshot_signal screenshot_cb);
@@ -65,8 +62,6 @@ struct renderer {
 
     render_prepare_fn render_prepare;
     render_finish_fn render_finish;
-    render_area_prepare_fn render_area_prepare;
-    render_area_finish_fn render_area_finish;
 
     capture_screen_fn capture_screen;
 
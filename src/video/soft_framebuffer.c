@@ -0,0 +1,110 @@
+#include "video/soft_framebuffer.h"
+#include "utils/allocator.h"
+#include "utils/miscmath.h"
+#include "video/enums.h"
+#include <string.h>
+
+// Ordered dither thresholds for partially opaque sprites. The shader uses noise for this.
+static const uint8_t dither[4][4] = {
+    {8,   136, 40,  168},
+    {200, 72,  232, 104},
+    {56,  184, 24,  152},
+    {248, 120, 216, 88 },
+};
+
+void soft_framebuffer_create(soft_framebuffer *fb, int w, int h) {
+    fb->w = w;
+    fb->h = h;
+    fb->pixels = omf_calloc(w * h, sizeof(soft_pixel));
+    vga_remaps_init(&fb->remaps);
+}
+
+void soft_framebuffer_free(soft_framebuffer *fb) {
+    omf_free(fb->pixels);
+}
+
+void soft_framebuffer_clear(soft_framebuffer *fb) {
+    memset(fb->pixels, 0, fb->w * fb->h * sizeof(soft_pixel));
+}
+
+void soft_framebuffer_draw(soft_framebuffer *fb, const surface *src, const SDL_Rect *dst, int remap_offset,
+                           int remap_rounds, int palette_offset, int palette_limit, int opacity, unsigned int flip_mode,
+                           unsigned int options) {
+    if(dst->w <= 0 || dst->h <= 0 || src->w <= 0 || src->h <= 0) {
+        return;
+    }
+    const vga_remap_table *sprite_remap = &fb->remaps.tables[clamp(remap_offset, 0, VGA_REMAP_COUNT - 1)];
+    int x0 = max2(0, dst->x);
+    int y0 = max2(0, dst->y);
+    int x1 = min2(fb->w, dst->x + dst->w);
+    int y1 = min2(fb->h, dst->y + dst->h);
+    for(int y = y0; y < y1; y++) {
+        // Sprites may be drawn scaled; sample the nearest source pixel.
+        int sy = (y - dst->y) * src->h / dst->h;
+        if(flip_mode & FLIP_VERTICAL) {
+            sy = src->h - sy - 1;
+        }
+        const unsigned char *src_row = src->data + sy * src->w;
+        soft_pixel *dst_row = fb->pixels + y * fb->w;
+        for(int x = x0; x < x1; x++) {
+            int sx = (x - dst->x) * src->w / dst->w;
+            if(flip_mode & FLIP_HORIZONTAL) {
+                sx = src->w - sx - 1;
+            }
+            int index = src_row[sx];
+            if(index == src->transparent) {
+                continue;
+            }
+            if(opacity < 255 && dither[y & 3][x & 3] > opacity) {
+                continue;
+            }
+
+            // Same order of operations as shaders/palette.frag
+            if(index <= palette_limit) {
+                index = clamp(index + palette_offset, 0, palette_limit);
+            }
+            if(options & REMAP_SPRITE) {
+                index = sprite_remap->data[index];
+            }
+            if(options & SPRITE_MASK) {
+                index = 1;
+            }
+
+            soft_pixel *p = &dst_row[x];
+            if(remap_rounds > 0) {
+                // Remap whatever is already in the framebuffer
+                p->table = min2(remap_offset + index, VGA_REMAP_COUNT - 1);
+                p->rounds = min2(remap_rounds, 255);
+                p->add = 0;
+            } else if(options & SPRITE_INDEX_ADD) {
+                p->add = min2(index * 60, 255);
+            } else {
+                p->index = index;
+                p->table = 0;
+                p->rounds = 0;
+                p->add = 0;
+            }
+        }
+    }
+}
+
+void soft_framebuffer_resolve(soft_framebuffer *fb, const vga_state *vga, int offset_x, int offset_y,
+                              unsigned char *dst) {
+    memcpy(&fb->remaps, vga_state_get_remaps(vga), sizeof(vga_remap_tables));
+    for(int y = 0; y < fb->h; y++) {
+        int sy = y + offset_y; // Y offset is applied to a bottom-up viewport in the renderers
+        for(int x = 0; x < fb->w; x++) {
+            int sx = x - offset_x;
+            if(sx < 0 || sy < 0 || sx >= fb->w || sy >= fb->h) {
+                dst[y * fb->w + x] = 0;
+                continue;
+            }
+            const soft_pixel *p = &fb->pixels[sy * fb->w + sx];
+            int index = min2(p->index + p->add, 255);
+            for(int i = 0; i < p->rounds; i++) {
+                index = fb->remaps.tables[p->table].data[index];
+            }
+            dst[y * fb->w + x] = index;
+        }
+    }
+}
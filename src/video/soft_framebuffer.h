@@ -0,0 +1,51 @@
+#ifndef SOFT_FRAMEBUFFER_H
+#define SOFT_FRAMEBUFFER_H
+
+#include "video/surface.h"
+#include "video/vga_remap.h"
+#include "video/vga_state.h"
+#include <SDL.h>
+#include <stdint.h>
+
+/*
+ * CPU version of the indexed framebuffer the OpenGL3 renderer draws into. Each pixel keeps the same
+ * channels as the GPU one (color index, remap table, remap rounds and added index), and the resolve step
+ * applies them like the palette shader does. This gives the exact indexed frame, without a window or
+ * a readback, eg. for exporting video.
+ */
+typedef struct soft_pixel {
+    uint8_t index;
+    uint8_t table;
+    uint8_t rounds;
+    uint8_t add;
+} soft_pixel;
+
+typedef struct soft_framebuffer {
+    int w;
+    int h;
+    soft_pixel *pixels;
+    vga_remap_tables remaps; // remaps of the previous frame, used by REMAP_SPRITE draws
+} soft_framebuffer;
+
+void soft_framebuffer_create(soft_framebuffer *fb, int w, int h);
+void soft_framebuffer_free(soft_framebuffer *fb);
+void soft_framebuffer_clear(soft_framebuffer *fb);
+
+// Same arguments as the draw_surface renderer callback.
+void soft_framebuffer_draw(soft_framebuffer *fb, const surface *src, const SDL_Rect *dst, int remap_offset,
+                           int remap_rounds, int palette_offset, int palette_limit, int opacity, unsigned int flip_mode,
+                           unsigned int options);
+
+/**
+ * Resolve the framebuffer into final color indexes, and pick up the remaps of vga for the next frame.
+ *
+ * @param fb Framebuffer to resolve
+ * @param vga VGA state the frame was rendered with
+ * @param offset_x Screen shake offset, as given to video_move_target()
+ * @param offset_y Screen shake offset
+ * @param dst Output buffer of w * h color indexes
+ */
+void soft_framebuffer_resolve(soft_framebuffer *fb, const vga_state *vga, int offset_x, int offset_y,
+                              unsigned char *dst);
+
+#endif // SOFT_FRAMEBUFFER_H
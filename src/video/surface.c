@@ -1,21 +1,154 @@
 #include "video/surface.h"
 #include "utils/allocator.h"
+#include "utils/hashmap.h"
 #include "utils/miscmath.h"
 #include "utils/png_writer.h"
+#include <SDL.h>
 #include <stdlib.h>
 
 // Each surface is tagged with a unique key. This is then used for texture atlas.
-// This keeps track of the last index used.
-static unsigned int guid = 0;
+// This keeps track of the last index used. Surfaces may be created from several
+// simulation threads at once, so this is updated atomically.
+static SDL_atomic_t guid = {0};
+
+static unsigned int next_guid(void) {
+    return (unsigned int)SDL_AtomicAdd(&guid, 1);
+}
+
+// Pixel buffer shared by interned surfaces. The buffers are found by a hash of their size and content. Refs
+// and the table are guarded by intern_lock, as sprites may be loaded from several threads at once.
+struct surface_pixels {
+    uint64_t hash;
+    unsigned int guid;
+    int refs;
+    int w;
+    int h;
+    unsigned char data[];
+};
+
+static SDL_SpinLock intern_lock = 0;
+static hashmap intern_table;
+static bool intern_table_ready = false;
+static surface_intern_stats intern_stats;
+
+static uint64_t content_hash(int w, int h, const unsigned char *src) {
+    // 64-bit FNV-1a, over the size and then the pixels
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    int size[2] = {w, h};
+    const unsigned char *bytes = (const unsigned char *)size;
+    for(size_t i = 0; i < sizeof(size); i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+    }
+    for(int i = 0; i < w * h; i++) {
+        hash = (hash ^ src[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static void surface_set_shared(surface *sur, surface_pixels *pixels) {
+    sur->data = pixels->data;
+    sur->shared = pixels;
+    sur->guid = pixels->guid;
+    sur->w = pixels->w;
+    sur->h = pixels->h;
+}
+
+// Drops the reference to the interned buffer, and frees the buffer if it was the last one.
+static void surface_release_shared(surface *sur) {
+    surface_pixels *pixels = sur->shared;
+    size_t len = (size_t)pixels->w * pixels->h;
+    SDL_AtomicLock(&intern_lock);
+    intern_stats.surfaces--;
+    if(--pixels->refs > 0) {
+        intern_stats.bytes_saved -= len;
+        pixels = NULL;
+    } else {
+        hashmap_del(&intern_table, &pixels->hash, sizeof(uint64_t));
+        intern_stats.buffers--;
+        intern_stats.bytes -= len;
+        if(intern_stats.buffers == 0) {
+            hashmap_free(&intern_table);
+            intern_table_ready = false;
+        }
+    }
+    SDL_AtomicUnlock(&intern_lock);
+    if(pixels != NULL) {
+        omf_free(pixels);
+    }
+    sur->shared = NULL;
+    sur->data = NULL;
+}
+
+// Gives the surface a copy of its own before it gets modified.
+static void surface_make_private(surface *sur) {
+    if(sur->shared == NULL) {
+        return;
+    }
+    unsigned char *data = omf_malloc(sur->w * sur->h);
+    memcpy(data, sur->data, sur->w * sur->h);
+    surface_release_shared(sur);
+    sur->data = data;
+    sur->guid = next_guid();
+}
 
 void surface_create(surface *sur, int w, int h) {
     sur->data = omf_calloc(1, w * h);
-    sur->guid = guid++;
+    sur->shared = NULL;
+    sur->guid = next_guid();
     sur->w = w;
     sur->h = h;
     sur->transparent = 0;
 }
 
+void surface_create_interned(surface *sur, int w, int h, const unsigned char *src) {
+    size_t len = (size_t)w * h;
+    uint64_t hash = content_hash(w, h, src);
+    surface_pixels *pixels = NULL;
+    void *value;
+
+    SDL_AtomicLock(&intern_lock);
+    if(!intern_table_ready) {
+        hashmap_create(&intern_table);
+        intern_table_ready = true;
+    }
+    if(hashmap_get(&intern_table, &hash, sizeof(hash), &value, NULL) == 0) {
+        surface_pixels *found = *(surface_pixels **)value;
+        if(found->w == w && found->h == h && memcmp(found->data, src, len) == 0) {
+            pixels = found;
+            pixels->refs++;
+            intern_stats.surfaces++;
+            intern_stats.bytes_saved += len;
+        }
+    } else {
+        pixels = omf_malloc(sizeof(surface_pixels) + len);
+        pixels->hash = hash;
+        pixels->guid = next_guid();
+        pixels->refs = 1;
+        pixels->w = w;
+        pixels->h = h;
+        memcpy(pixels->data, src, len);
+        hashmap_put(&intern_table, &hash, sizeof(hash), &pixels, sizeof(surface_pixels *));
+        intern_stats.buffers++;
+        intern_stats.surfaces++;
+        intern_stats.bytes += len;
+    }
+    SDL_AtomicUnlock(&intern_lock);
+
+    // On the off chance that the hash collides with a different image, this one gets a buffer of its own.
+    if(pixels == NULL) {
+        surface_create_from_data(sur, w, h, src);
+        return;
+    }
+    surface_set_shared(sur, pixels);
+    sur->transparent = 0;
+}
+
+void surface_get_intern_stats(surface_intern_stats *stats) {
+    SDL_AtomicLock(&intern_lock);
+    *stats = intern_stats;
+    SDL_AtomicUnlock(&intern_lock);
+}
+
 void surface_create_from_data(surface *sur, int w, int h, const unsigned char *src) {
     surface_create(sur, w, h);
     memcpy(sur->data, src, w * h);
@@ -57,15 +190,31 @@ void surface_set_transparency(surface *sur, int index) {
 }
 
 void surface_free(surface *sur) {
+    if(sur->shared != NULL) {
+        surface_release_shared(sur);
+        return;
+    }
     omf_free(sur->data);
 }
 
 void surface_clear(surface *sur) {
+    surface_make_private(sur);
     memset(sur->data, 0, sur->w * sur->h);
-    sur->guid = guid++;
+    sur->guid = next_guid();
 }
 
 void surface_create_from(surface *dst, const surface *src) {
+    if(src->shared != NULL) {
+        size_t len = (size_t)src->w * src->h;
+        SDL_AtomicLock(&intern_lock);
+        src->shared->refs++;
+        intern_stats.surfaces++;
+        intern_stats.bytes_saved += len;
+        SDL_AtomicUnlock(&intern_lock);
+        surface_set_shared(dst, src->shared);
+        dst->transparent = src->transparent;
+        return;
+    }
     surface_create(dst, src->w, src->h);
     memcpy(dst->data, src->data, src->w * src->h);
     dst->transparent = src->transparent;
@@ -74,6 +223,7 @@ void surface_create_from(surface *dst, const surface *src) {
 // Copies a an area of old surface to an entirely new surface
 void surface_sub(surface *dst, const surface *src, int dst_x, int dst_y, int src_x, int src_y, int w, int h,
                  int method) {
+    surface_make_private(dst);
     int src_offset, dst_offset;
     for(int y = 0; y < h; y++) {
         for(int x = 0; x < w; x++) {
@@ -89,7 +239,7 @@ void surface_sub(surface *dst, const surface *src, int dst_x, int dst_y, int src
             dst->data[dst_offset] = src->data[src_offset];
         }
     }
-    dst->guid = guid++;
+    dst->guid = next_guid();
 }
 
 static uint8_t find_closest_gray(const vga_palette *pal, int range_start, int range_end, int ref) {
@@ -116,6 +266,7 @@ static uint8_t find_closest_gray(const vga_palette *pal, int range_start, int ra
 }
 
 void surface_flatten_to_mask(surface *sur, uint8_t value) {
+    surface_make_private(sur);
     uint8_t idx;
     for(int i = 0; i < sur->w * sur->h; i++) {
         idx = sur->data[i];
@@ -123,11 +274,12 @@ void surface_flatten_to_mask(surface *sur, uint8_t value) {
             continue;
         sur->data[i] = value;
     }
-    sur->guid = guid++;
+    sur->guid = next_guid();
 }
 
 void surface_convert_to_grayscale(surface *sur, const vga_palette *pal, int range_start, int range_end,
                                   int ignore_below) {
+    surface_make_private(sur);
     float r, g, b;
     uint8_t idx;
     unsigned char mapping[256];
@@ -151,10 +303,11 @@ void surface_convert_to_grayscale(surface *sur, const vga_palette *pal, int rang
             continue;
         sur->data[i] = mapping[idx];
     }
-    sur->guid = guid++;
+    sur->guid = next_guid();
 }
 
 void surface_convert_har_to_grayscale(surface *sur, uint8_t brightness) {
+    surface_make_private(sur);
     uint8_t idx;
     for(int i = 0; i < sur->w * sur->h; i++) {
         idx = sur->data[i];
@@ -162,10 +315,11 @@ void surface_convert_har_to_grayscale(surface *sur, uint8_t brightness) {
             sur->data[i] = 0xD0 + brightness * (idx % 0x10) / 0x0F;
         }
     }
-    sur->guid = guid++;
+    sur->guid = next_guid();
 }
 
 void surface_compress_index_blocks(surface *sur, int range_start, int range_end, int block_size, int amount) {
+    surface_make_private(sur);
     uint8_t idx, real_start, old_idx, new_idx;
     for(int i = 0; i < sur->w * sur->h; i++) {
         idx = sur->data[i];
@@ -176,10 +330,11 @@ void surface_compress_index_blocks(surface *sur, int range_start, int range_end,
             sur->data[i] = idx - old_idx + new_idx;
         }
     }
-    sur->guid = guid++;
+    sur->guid = next_guid();
 }
 
 void surface_compress_remap(surface *sur, int range_start, int range_end, int remap_to, int amount) {
+    surface_make_private(sur);
     uint8_t idx, real_start, d;
     for(int i = 0; i < sur->w * sur->h; i++) {
         idx = sur->data[i];
@@ -191,7 +346,7 @@ void surface_compress_remap(surface *sur, int range_start, int range_end, int re
             }
         }
     }
-    sur->guid = guid++;
+    sur->guid = next_guid();
 }
 
 bool surface_write_png(const surface *sur, const vga_palette *pal, const char *filename) {
@@ -6,14 +6,24 @@
 #include "video/vga_palette.h"
 #include <SDL.h>
 
+typedef struct surface_pixels surface_pixels;
+
 typedef struct surface {
     unsigned int guid;
     int w;
     int h;
     int transparent;
     unsigned char *data;
+    surface_pixels *shared; // Set if data is an interned buffer, see surface_create_interned()
 } surface;
 
+typedef struct surface_intern_stats {
+    unsigned int buffers;  // Interned buffers alive
+    unsigned int surfaces; // Surfaces using them
+    size_t bytes;          // Size of the interned buffers
+    size_t bytes_saved;    // Size of the copies the sharing surfaces would have made
+} surface_intern_stats;
+
 enum
 {
     SUB_METHOD_NONE,
@@ -26,6 +36,20 @@ void surface_create_from_vga(surface *sur, const sd_vga_image *src);
 void surface_create_from_image(surface *sur, image *img);
 void surface_create_from_data(surface *sur, int w, int h, const unsigned char *src);
 void surface_create_from_data_flip(surface *sur, int w, int h, const unsigned char *src);
+
+/**
+ * Create a surface from pixel data, sharing the pixels with any other interned surface of the same content.
+ * Interned buffers are refcounted, and every surface sharing one has the same guid, so the renderers only
+ * upload it once. Functions that modify a surface give it a private copy of the pixels first, and
+ * surface_create_from() shares the buffer instead of copying it.
+ *
+ * @param sur Surface to create
+ * @param w Width of the data
+ * @param h Height of the data
+ * @param src Pixel data, w * h color indexes
+ */
+void surface_create_interned(surface *sur, int w, int h, const unsigned char *src);
+void surface_get_intern_stats(surface_intern_stats *stats);
 void surface_create_from_surface(surface *sur, int w, int h, int src_x, int src_y, const surface *src);
 int surface_to_image(const surface *sur, image *img);
 void surface_free(surface *sur);
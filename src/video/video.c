@@ -1,8 +1,11 @@
 #include <SDL.h>
 
+#include "utils/allocator.h"
 #include "utils/c_array_util.h"
 #include "utils/log.h"
+#include "utils/miscmath.h"
 #include "video/renderers/renderer.h"
+#include "video/soft_framebuffer.h"
 #include "video/video.h"
 
 // If-def the includes here
@@ -40,6 +43,25 @@ static int renderer_count = 0;
 // Currently selected renderer
 static renderer current_renderer;
 
+// Frame capture, see video_capture_frames()
+static struct frame_capture {
+    video_frame_signal callback;
+    void *userdata;
+    soft_framebuffer fb;
+    unsigned char *pixels;
+    int move_x;
+    int move_y;
+} capture;
+
+// Draw recording, see video_record_begin()
+#define VIDEO_RECORD_DEPTH 8
+static struct draw_recording {
+    video_draw_list *lists[VIDEO_RECORD_DEPTH];
+    int depth;
+} recording;
+
+static unsigned int draw_count = 0;
+
 /**
  * This is run at start to hunt the available renderers.
  */
@@ -163,27 +185,41 @@ void video_signal_scene_change(void) {
 
 void video_render_prepare(void) {
     current_renderer.render_prepare(current_renderer.ctx);
+    if(capture.callback != NULL) {
+        soft_framebuffer_clear(&capture.fb);
+    }
 }
 
-void video_render_finish(void) {
-    current_renderer.render_finish(current_renderer.ctx);
-}
-
-void video_render_area_prepare(const SDL_Rect *area) {
-    current_renderer.render_area_prepare(current_renderer.ctx, area);
+void video_render_finish(vga_state *vga) {
+    if(capture.callback != NULL) {
+        soft_framebuffer_resolve(&capture.fb, vga, capture.move_x, capture.move_y, capture.pixels);
+        capture.callback(capture.pixels, vga_state_get_palette(vga), capture.userdata);
+    }
+    current_renderer.render_finish(current_renderer.ctx, vga);
 }
 
-void video_render_area_finish(surface *dst) {
-    current_renderer.render_area_finish(current_renderer.ctx, dst);
+void video_capture_frames(video_frame_signal callback, void *userdata) {
+    if(callback != NULL && capture.callback == NULL) {
+        soft_framebuffer_create(&capture.fb, NATIVE_W, NATIVE_H);
+        capture.pixels = omf_calloc(1, NATIVE_W * NATIVE_H);
+    } else if(callback == NULL && capture.callback != NULL) {
+        soft_framebuffer_free(&capture.fb);
+        omf_free(capture.pixels);
+    }
+    capture.callback = callback;
+    capture.userdata = userdata;
 }
 
 void video_close(void) {
+    video_capture_frames(NULL, NULL);
     current_renderer.close_context(current_renderer.ctx);
     current_renderer.destroy(&current_renderer);
 }
 
 void video_move_target(int x, int y) {
     current_renderer.move_target(current_renderer.ctx, x, y);
+    capture.move_x = x;
+    capture.move_y = y;
 }
 
 void video_get_state(int *w, int *h, bool *fs, bool *vsync, int *aspect) {
@@ -194,10 +230,65 @@ void video_schedule_screenshot(video_screenshot_signal callback) {
     current_renderer.capture_screen(current_renderer.ctx, callback);
 }
 
+bool video_record_begin(video_draw_list *list) {
+    if(recording.depth == VIDEO_RECORD_DEPTH) {
+        return false;
+    }
+    list->count = 0;
+    recording.lists[recording.depth++] = list;
+    return true;
+}
+
+void video_record_end(void) {
+    if(recording.depth > 0) {
+        recording.depth--;
+    }
+}
+
+void video_draw_list_free(video_draw_list *list) {
+    omf_free(list->cmds);
+    list->count = 0;
+    list->capacity = 0;
+}
+
+unsigned int video_get_draw_count(void) {
+    return draw_count;
+}
+
+static void record_draw(const surface *sur, const SDL_Rect *dst, int remap_offset, int remap_rounds,
+                        int palette_offset, int palette_limit, int opacity, unsigned int flip_mode,
+                        unsigned int options) {
+    for(int i = 0; i < recording.depth; i++) {
+        video_draw_list *list = recording.lists[i];
+        if(list->count == list->capacity) {
+            list->capacity = max2(list->capacity * 2, 16);
+            list->cmds = omf_realloc(list->cmds, list->capacity * sizeof(video_draw_cmd));
+        }
+        video_draw_cmd *cmd = &list->cmds[list->count++];
+        cmd->src = sur;
+        cmd->dst = *dst;
+        cmd->remap_offset = remap_offset;
+        cmd->remap_rounds = remap_rounds;
+        cmd->palette_offset = palette_offset;
+        cmd->palette_limit = palette_limit;
+        cmd->opacity = opacity;
+        cmd->flip_mode = flip_mode;
+        cmd->options = options;
+    }
+}
+
 static inline void draw_args(const surface *sur, SDL_Rect *dst, int remap_offset, int remap_rounds, int palette_offset,
                              int palette_limit, int opacity, unsigned int flip_mode, unsigned int options) {
+    if(recording.depth > 0) {
+        record_draw(sur, dst, remap_offset, remap_rounds, palette_offset, palette_limit, opacity, flip_mode, options);
+    }
+    draw_count++;
     current_renderer.draw_surface(current_renderer.ctx, sur, dst, remap_offset, remap_rounds, palette_offset,
                                   palette_limit, opacity, flip_mode, options);
+    if(capture.callback != NULL) {
+        soft_framebuffer_draw(&capture.fb, sur, dst, remap_offset, remap_rounds, palette_offset, palette_limit, opacity,
+                              flip_mode, options);
+    }
 }
 
 void video_draw_full(const surface *src_surface, int x, int y, int w, int h, int remap_offset, int remap_rounds,
@@ -211,6 +302,15 @@ void video_draw_full(const surface *src_surface, int x, int y, int w, int h, int
               options);
 }
 
+void video_draw_batch(const video_draw_cmd *cmds, int count) {
+    for(int i = 0; i < count; i++) {
+        const video_draw_cmd *cmd = &cmds[i];
+        SDL_Rect dst = cmd->dst;
+        draw_args(cmd->src, &dst, cmd->remap_offset, cmd->remap_rounds, cmd->palette_offset, cmd->palette_limit,
+                  cmd->opacity, cmd->flip_mode, cmd->options);
+    }
+}
+
 void video_draw_offset(const surface *src_surface, int x, int y, int offset, int limit) {
     SDL_Rect dst;
     dst.w = src_surface->w;
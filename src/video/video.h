@@ -2,18 +2,47 @@
 #define VIDEO_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "formats/palette.h"
 #include "video/color.h"
 #include "video/enums.h"
 #include "video/image.h"
 #include "video/surface.h"
+#include "video/vga_state.h"
 
 #define NATIVE_W 320
 #define NATIVE_H 200
 
-typedef void (*video_screenshot_signal)(const SDL_Rect *rect, unsigned char *data,
+/**
+ * A single sprite draw, with the same parameters as video_draw_full(). Draws can be collected into an array
+ * and submitted at once with video_draw_batch().
+ */
+typedef struct video_draw_cmd {
+    const surface *src;
+    SDL_Rect dst;
+    int16_t remap_offset;
+    int16_t remap_rounds;
+    int16_t palette_offset;
+    int16_t palette_limit;
+    uint8_t opacity;
+    uint8_t flip_mode;
+    uint8_t options;
+} video_draw_cmd;
+
+/**
+ * Draws recorded with video_record_begin(), for submitting them again later with video_draw_batch().
+ */
+typedef struct video_draw_list {
+    video_draw_cmd *cmds;
+    int count;
+    int capacity;
+} video_draw_list;
+
+typedef void (*video_screenshot_signal)(const SDL_Rect *rect, const unsigned char *data,
                                         bool flipped); // Asynchronous screenshot signal
+typedef void (*video_frame_signal)(const unsigned char *pixels, const vga_palette *palette,
+                                   void *userdata); // Captured frame signal
 
 void video_scan_renderers(void);
 int video_get_renderer_count(void);
@@ -92,16 +121,53 @@ void video_draw_size(const surface *src_surface, int x, int y, int w, int h);
 void video_draw_full(const surface *src_surface, int x, int y, int w, int h, int remap_offset, int remap_rounds,
                      int palette_offset, int palette_limit, int opacity, unsigned int flip_mode, unsigned int options);
 
+/**
+ * Render a list of sprites, in order.
+ *
+ * @param cmds Draw commands
+ * @param count Number of draw commands
+ */
+void video_draw_batch(const video_draw_cmd *cmds, int count);
+
+/**
+ * Start recording draws into a list. The list is emptied first, and the draws are still made as usual.
+ * Recordings may nest, in which case a draw is added to every open list.
+ *
+ * @param list List to record to
+ * @return False if too many recordings are already open; nothing is recorded then
+ */
+bool video_record_begin(video_draw_list *list);
+
+/**
+ * Stop the recording started last with video_record_begin().
+ */
+void video_record_end(void);
+
+void video_draw_list_free(video_draw_list *list);
+
+/**
+ * Number of draws made since start, including the ones in batches.
+ */
+unsigned int video_get_draw_count(void);
+
 void video_signal_scene_change(void);
 
 void video_render_prepare(void);
-void video_render_finish(void);
-void video_render_area_prepare(const SDL_Rect *area);
-void video_render_area_finish(surface *dst);
+void video_render_finish(vga_state *vga);
 
 void video_close(void);
 void video_schedule_screenshot(video_screenshot_signal callback);
 
 void video_draw_atlas(bool draw_atlas);
 
+/**
+ * Capture every rendered frame. Frames are composited on the CPU alongside the renderer, so this works with
+ * any renderer, including the NULL one. The callback gets the NATIVE_W x NATIVE_H color indexes and the
+ * palette of each frame at video_render_finish(); the data is only valid during the call.
+ *
+ * @param callback Function to pass the frames to, or NULL to stop capturing
+ * @param userdata Passed to the callback
+ */
+void video_capture_frames(video_frame_signal callback, void *userdata);
+
 #endif // VIDEO_H
@@ -0,0 +1,145 @@
+#include "formats/error.h"
+#include "formats/sprite.h"
+#include "resources/asset_pack.h"
+#include "resources/sprite.h"
+#include "utils/allocator.h"
+#include "utils/log.h"
+#include <CUnit/Basic.h>
+#include <CUnit/CUnit.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TESTSOURCE1 "test_source1.dat"
+#define TESTSOURCE2 "test_source2.dat"
+#define TESTPACK "test.pak"
+
+static void write_source(const char *filename, const char *content) {
+    FILE *fp = fopen(filename, "wb");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(fp);
+    fputs(content, fp);
+    fclose(fp);
+}
+
+static void *copy_data(const char *src, size_t len) {
+    void *data = omf_malloc(len);
+    memcpy(data, src, len);
+    return data;
+}
+
+void test_asset_pack_roundtrip(void) {
+    log_init();
+    write_source(TESTSOURCE1, "original file 1");
+    write_source(TESTSOURCE2, "original file 2");
+
+    asset_pack_writer writer;
+    asset_pack_writer_create(&writer);
+    CU_ASSERT(asset_pack_writer_add(&writer, "./" TESTSOURCE1, copy_data("baked 1", 8), 8));
+    CU_ASSERT(asset_pack_writer_add(&writer, TESTSOURCE2, copy_data("baked data 2", 13), 13));
+    CU_ASSERT_FALSE(asset_pack_writer_add(&writer, "nonesuchfile.dat", copy_data("x", 1), 1));
+    CU_ASSERT(asset_pack_writer_save(&writer, TESTPACK));
+    asset_pack_writer_free(&writer);
+
+    // Entries are found by file name, and are aligned
+    size_t len = 0;
+    CU_ASSERT_FATAL(asset_pack_open(TESTPACK));
+    const char *data = asset_pack_get(TESTSOURCE1, &len);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(data);
+    CU_ASSERT_EQUAL(len, 8);
+    CU_ASSERT_STRING_EQUAL(data, "baked 1");
+    CU_ASSERT_EQUAL((uintptr_t)data % 16, 0);
+    data = asset_pack_get("some/dir/" TESTSOURCE2, &len);
+    CU_ASSERT_PTR_NULL(data); // no such source file
+    data = asset_pack_get(TESTSOURCE2, &len);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(data);
+    CU_ASSERT_EQUAL(len, 13);
+    CU_ASSERT_STRING_EQUAL(data, "baked data 2");
+    CU_ASSERT_PTR_NULL(asset_pack_get("nonesuchfile.dat", &len));
+
+    // A changed source file makes its entry stale
+    write_source(TESTSOURCE2, "changed original file 2");
+    CU_ASSERT_PTR_NULL(asset_pack_get(TESTSOURCE2, &len));
+    CU_ASSERT_PTR_NOT_NULL(asset_pack_get(TESTSOURCE1, &len));
+    asset_pack_close();
+    CU_ASSERT_PTR_NULL(asset_pack_get(TESTSOURCE1, &len));
+
+    // Not a pack at all
+    CU_ASSERT_FALSE(asset_pack_open(TESTSOURCE1));
+    CU_ASSERT_FALSE(asset_pack_open("nonesuchfile.pak"));
+
+    remove(TESTSOURCE1);
+    remove(TESTSOURCE2);
+    remove(TESTPACK);
+    log_close();
+}
+
+static void encode_sprite(sd_sprite *spr, int w, int h, int seed) {
+    sd_vga_image img;
+    sd_vga_image_create(&img, w, h);
+    for(int i = 0; i < w * h; i++) {
+        img.data[i] = (i * seed) % 7 == 0 ? 0 : (char)(i + seed);
+    }
+    sd_sprite_create(spr);
+    CU_ASSERT_EQUAL(sd_sprite_vga_encode(spr, &img), SD_SUCCESS);
+    sd_vga_image_free(&img);
+}
+
+static void check_sprites(sd_sprite *sprites, int count, sprite_bake *bake) {
+    for(int i = 0; i < count; i++) {
+        sprite decoded, baked;
+        sprite_create(&decoded, &sprites[i], i);
+        sprite_create_baked(&baked, &sprites[i], i, bake);
+        CU_ASSERT_EQUAL(baked.data->w, decoded.data->w);
+        CU_ASSERT_EQUAL(baked.data->h, decoded.data->h);
+        CU_ASSERT(memcmp(baked.data->data, decoded.data->data, decoded.data->w * decoded.data->h) == 0);
+        sprite_free(&decoded);
+        sprite_free(&baked);
+    }
+}
+
+void test_asset_pack_sprites(void) {
+    log_init();
+    sd_sprite sprites[3];
+    encode_sprite(&sprites[0], 12, 5, 3);
+    encode_sprite(&sprites[1], 7, 9, 5);
+    encode_sprite(&sprites[2], 12, 5, 11);
+
+    sprite_bake recorder;
+    sprite_bake_create_recorder(&recorder);
+    for(int i = 0; i < 3; i++) {
+        sprite tmp;
+        sprite_create_baked(&tmp, &sprites[i], i, &recorder);
+        sprite_free(&tmp);
+    }
+    CU_ASSERT_EQUAL(recorder.out_len, 3 * 4 + 12 * 5 * 2 + 7 * 9);
+
+    // Replayed in the same order, all sprites come from the bake
+    sprite_bake bake;
+    sprite_bake_create(&bake, recorder.out, recorder.out_len);
+    check_sprites(sprites, 3, &bake);
+    CU_ASSERT_EQUAL(bake.pos, recorder.out_len);
+    CU_ASSERT_PTR_NOT_NULL(bake.data);
+
+    // A bake that does not match the sprites is given up, and the sprites decoded instead
+    sprite_bake_create(&bake, recorder.out, recorder.out_len);
+    check_sprites(&sprites[1], 2, &bake);
+    CU_ASSERT_PTR_NULL(bake.data);
+    sprite_bake_create(&bake, recorder.out, recorder.out_len - 1);
+    check_sprites(sprites, 3, &bake);
+    CU_ASSERT_PTR_NULL(bake.data);
+
+    sprite_bake_free(&recorder);
+    for(int i = 0; i < 3; i++) {
+        sd_sprite_free(&sprites[i]);
+    }
+    log_close();
+}
+
+void asset_pack_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "Test for asset pack round trip", test_asset_pack_roundtrip) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for baked sprites", test_asset_pack_sprites) == NULL) {
+        return;
+    }
+}
@@ -0,0 +1,110 @@
+#include <CUnit/Basic.h>
+#include <CUnit/CUnit.h>
+#include <game/gui/component.h>
+#include <game/gui/xysizer.h>
+
+static int layouts = 0;
+static int renders = 0;
+
+static void count_layout(component *c, int x, int y, int w, int h) {
+    layouts++;
+}
+
+static void count_render(component *c) {
+    renders++;
+}
+
+static component *leaf_create(void) {
+    component *c = component_create();
+    component_set_layout_cb(c, count_layout);
+    component_set_render_cb(c, count_render);
+    return c;
+}
+
+void test_component_layout_cache(void) {
+    component *root = xysizer_create();
+    component *a = leaf_create();
+    component *b = leaf_create();
+    xysizer_attach(root, a, 10, 10, 50, 8);
+    xysizer_attach(root, b, 10, 20, 50, 8);
+
+    layouts = 0;
+    component_layout(root, 0, 0, 320, 200);
+    CU_ASSERT_EQUAL(layouts, 2);
+
+    // Nothing changed, nothing is laid out
+    layouts = 0;
+    component_layout(root, 0, 0, 320, 200);
+    CU_ASSERT_EQUAL(layouts, 0);
+
+    // Only the resized component is laid out again
+    component_set_size_hints(a, 60, 8);
+    CU_ASSERT_TRUE(root->layout_dirty);
+    component_layout(root, 0, 0, 320, 200);
+    CU_ASSERT_EQUAL(layouts, 1);
+    CU_ASSERT_EQUAL(a->w, 60);
+    CU_ASSERT_FALSE(root->layout_dirty);
+
+    // Same hints are not a change
+    layouts = 0;
+    component_set_size_hints(a, 60, 8);
+    component_layout(root, 0, 0, 320, 200);
+    CU_ASSERT_EQUAL(layouts, 0);
+
+    component_set_retained_mode(false);
+    component_layout(root, 0, 0, 320, 200);
+    CU_ASSERT_EQUAL(layouts, 2);
+    component_set_retained_mode(true);
+
+    component_free(root);
+}
+
+void test_component_render_cache(void) {
+    component *c = leaf_create();
+    component_layout(c, 0, 0, 10, 10);
+
+    // Not retained, always rendered
+    renders = 0;
+    component_render(c);
+    component_render(c);
+    CU_ASSERT_EQUAL(renders, 2);
+
+    unsigned int rendered, replayed, rendered2, replayed2;
+    component_set_retained(c, true);
+    component_get_render_counts(&rendered, &replayed);
+    renders = 0;
+    component_render(c);
+    component_render(c);
+    component_render(c);
+    CU_ASSERT_EQUAL(renders, 1);
+    component_get_render_counts(&rendered2, &replayed2);
+    CU_ASSERT_EQUAL(rendered2 - rendered, 1);
+    CU_ASSERT_EQUAL(replayed2 - replayed, 2);
+
+    // State changes render again
+    component_mark_dirty(c);
+    component_render(c);
+    CU_ASSERT_EQUAL(renders, 2);
+    component_layout(c, 5, 0, 10, 10);
+    component_render(c);
+    CU_ASSERT_EQUAL(renders, 3);
+    component_layout(c, 5, 0, 10, 10);
+    component_render(c);
+    CU_ASSERT_EQUAL(renders, 3);
+
+    component_set_retained_mode(false);
+    component_render(c);
+    CU_ASSERT_EQUAL(renders, 4);
+    component_set_retained_mode(true);
+
+    component_free(c);
+}
+
+void component_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "Test for component layout caching", test_component_layout_cache) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for component render caching", test_component_render_cache) == NULL) {
+        return;
+    }
+}
@@ -0,0 +1,634 @@
+#include <CUnit/Basic.h>
+#include <CUnit/CUnit.h>
+#include <SDL.h>
+#include <formats/af.h>
+#include <game/common_defines.h>
+#include <game/game_player.h>
+#include <game/game_state.h>
+#include <game/objects/har.h>
+#include <game/objects/projectile.h>
+#include <game/protos/object.h>
+#include <game/protos/scene.h>
+#include <game/utils/rec_keyframes.h>
+#include <resources/animation.h>
+#include <resources/sprite.h>
+#include <utils/allocator.h>
+#include <utils/log.h>
+#include <utils/miscmath.h>
+#include <utils/random.h>
+#include <video/vga_state.h>
+#include <string.h>
+
+#define SIM_OBJECTS 16
+#define SIM_TICKS 2000
+
+// Screen shakes and palette tricks, so that the host outputs and the palette state get exercised.
+// Palette state takes only a few transformers per frame, so just some of the objects use those.
+static const char *sim_shake_string = "bl4-A8-bb4-A8";
+static const char *sim_palette_string = "bpd1-bpn16-bps16-bpp20-A8-A8";
+
+typedef struct sim_run {
+    uint32_t seed;
+    uint32_t tick;
+    uint32_t checksum;
+} sim_run;
+
+// An empty game state, with what it needs around it
+typedef struct fixture {
+    engine_init_flags init_flags;
+    vga_state *vga;
+    game_state *gs;
+} fixture;
+
+static void fixture_setup(fixture *f, uint32_t seed) {
+    memset(&f->init_flags, 0, sizeof(f->init_flags));
+    f->init_flags.speed = 10;
+    f->vga = vga_state_create();
+    f->gs = omf_calloc(1, sizeof(game_state));
+    game_state_create_empty(f->gs, &f->init_flags, f->vga, seed);
+}
+
+static void fixture_teardown(fixture *f) {
+    game_state_free(&f->gs);
+    vga_state_free(&f->vga);
+}
+
+static void sim_tick(game_state *gs, int ticks) {
+    for(int i = 0; i < ticks; i++) {
+        game_state_static_tick(gs, false);
+        game_state_dynamic_tick(gs, false);
+    }
+}
+
+static void sim_object_move(object *obj) {
+    // Wander about using the match random state
+    obj->vel.x = clampf(obj->vel.x + random_float(&obj->gs->rand) - 0.5f, -3.0f, 3.0f);
+    obj->vel.y = clampf(obj->vel.y + random_float(&obj->gs->rand) - 0.5f, -3.0f, 3.0f);
+    obj->pos.x = clampf(obj->pos.x + obj->vel.x, 0.0f, 320.0f);
+    obj->pos.y = clampf(obj->pos.y + obj->vel.y, 0.0f, 200.0f);
+}
+
+static void sim_add_object(game_state *gs, int i) {
+    // The animation takes ownership of the sprite, and the sprite of the surface.
+    surface *sur = omf_calloc(1, sizeof(surface));
+    surface_create(sur, 8, 8);
+    sprite *spr = omf_calloc(1, sizeof(sprite));
+    sprite_create_custom(spr, vec2i_create(0, 0), sur);
+    spr->owned = true;
+
+    object *obj = omf_calloc(1, sizeof(object));
+    object_create(obj, gs, vec2i_create(i * 20, 100), vec2f_create(0, 0));
+    object_set_animation(obj, create_animation_from_single(spr, vec2i_create(0, 0)));
+    object_set_animation_owner(obj, OWNER_OBJECT);
+    object_set_custom_string(obj, i % 4 == 0 ? sim_palette_string : sim_shake_string);
+    object_set_repeat(obj, 1);
+    object_set_move_cb(obj, sim_object_move);
+    game_state_add_object(gs, obj, RENDER_LAYER_MIDDLE, 0, 0);
+}
+
+static void sim_add_objects(game_state *gs) {
+    for(int i = 0; i < SIM_OBJECTS; i++) {
+        sim_add_object(gs, i);
+    }
+}
+
+static uint32_t sim_positions(game_state *gs) {
+    uint32_t checksum = 0;
+    for(int i = 0; i < SIM_OBJECTS; i++) {
+        object *obj = game_state_find_object(gs, i + 1);
+        if(obj != NULL) {
+            vec2i pos = object_get_pos(obj);
+            checksum = checksum * 31 + pos.x * 320 + pos.y;
+        }
+    }
+    return checksum;
+}
+
+static void sim_run_match(sim_run *run) {
+    fixture f;
+    fixture_setup(&f, run->seed);
+    game_state *gs = f.gs;
+    sim_add_objects(gs);
+
+    // Same order of operations as the engine loop, minus the rendering
+    for(int i = 0; i < SIM_TICKS; i++) {
+        game_state_static_tick(gs, false);
+        game_state_dynamic_tick(gs, false);
+        game_state_palette_transform(gs);
+        vga_state_render(gs->vga);
+    }
+
+    run->tick = gs->tick;
+    run->checksum = random_intmax(&gs->rand);
+    run->checksum = run->checksum * 31 + sim_positions(gs);
+    run->checksum = run->checksum * 31 + gs->host.screen_offset_x * 16 + gs->host.screen_offset_y;
+
+    fixture_teardown(&f);
+}
+
+static int sim_thread(void *userdata) {
+    sim_run_match(userdata);
+    return 0;
+}
+
+void test_game_state_concurrent_tick(void) {
+    // Reference results, one game state at a time
+    sim_run expected[2] = {{.seed = 1234}, {.seed = 5678}};
+    sim_run_match(&expected[0]);
+    sim_run_match(&expected[1]);
+    CU_ASSERT_EQUAL(expected[0].tick, SIM_TICKS);
+    CU_ASSERT_NOT_EQUAL(expected[0].checksum, expected[1].checksum);
+
+    // Then both at once on separate threads. Neither may disturb the other.
+    sim_run runs[2] = {{.seed = 1234}, {.seed = 5678}};
+    SDL_Thread *threads[2];
+    for(int i = 0; i < 2; i++) {
+        threads[i] = SDL_CreateThread(sim_thread, "sim", &runs[i]);
+        CU_ASSERT_PTR_NOT_NULL_FATAL(threads[i]);
+    }
+    for(int i = 0; i < 2; i++) {
+        SDL_WaitThread(threads[i], NULL);
+        CU_ASSERT_EQUAL(runs[i].tick, expected[i].tick);
+        CU_ASSERT_EQUAL(runs[i].checksum, expected[i].checksum);
+    }
+}
+
+void test_game_state_object_ids(void) {
+    // Object IDs are allocated per game state, so separate game states hand out the same sequence.
+    fixture a, b;
+    fixture_setup(&a, 1);
+    fixture_setup(&b, 1);
+
+    object obj_a, obj_b;
+    object_create(&obj_a, a.gs, vec2i_create(0, 0), vec2f_create(0, 0));
+    object_create(&obj_b, b.gs, vec2i_create(0, 0), vec2f_create(0, 0));
+    CU_ASSERT_EQUAL(obj_a.id, obj_b.id);
+    object_free(&obj_a);
+    object_free(&obj_b);
+
+    fixture_teardown(&a);
+    fixture_teardown(&b);
+}
+
+static object *add_solid_object(game_state *gs, int x, int y, int color, int layer) {
+    surface *sur = omf_calloc(1, sizeof(surface));
+    surface_create(sur, 16, 16);
+    memset(sur->data, color, 16 * 16);
+    sprite *spr = omf_calloc(1, sizeof(sprite));
+    sprite_create_custom(spr, vec2i_create(0, 0), sur);
+    spr->owned = true;
+
+    object *obj = omf_calloc(1, sizeof(object));
+    object_create(obj, gs, vec2i_create(x, y), vec2f_create(0, 0));
+    object_set_animation(obj, create_animation_from_single(spr, vec2i_create(0, 0)));
+    object_set_animation_owner(obj, OWNER_OBJECT);
+    game_state_add_object(gs, obj, layer, 0, 0);
+    return obj;
+}
+
+static int surface_pixel(const surface *sur, int x, int y) {
+    return sur->data[y * sur->w + x];
+}
+
+void test_game_state_render_to_surface(void) {
+    fixture f;
+    fixture_setup(&f, 1);
+    game_state *gs = f.gs;
+
+    // Top layer object is added first, but still ends up above the overlapping bottom layer one
+    object *top = add_solid_object(gs, 108, 100, 9, RENDER_LAYER_TOP);
+    object *bottom = add_solid_object(gs, 100, 100, 5, RENDER_LAYER_BOTTOM);
+    sim_tick(gs, 1);
+    video_draw_cmd top_cmd, bottom_cmd;
+    CU_ASSERT_FATAL(object_draw_cmd(top, &top_cmd));
+    CU_ASSERT_FATAL(object_draw_cmd(bottom, &bottom_cmd));
+
+    surface sur;
+    game_state_render_to_surface(gs, &sur, 50, 20, 120, 160);
+    CU_ASSERT_EQUAL(sur.w, 120);
+    CU_ASSERT_EQUAL(sur.h, 160);
+    CU_ASSERT_EQUAL(surface_pixel(&sur, bottom_cmd.dst.x - 50, bottom_cmd.dst.y - 20), 5);
+    CU_ASSERT_EQUAL(surface_pixel(&sur, top_cmd.dst.x - 50, top_cmd.dst.y - 20), 9);
+    CU_ASSERT_EQUAL(surface_pixel(&sur, top_cmd.dst.x + 15 - 50, top_cmd.dst.y - 20), 9);
+    CU_ASSERT_EQUAL(surface_pixel(&sur, 0, 0), 0);
+    surface_free(&sur);
+
+    fixture_teardown(&f);
+}
+
+static void har_af_create(af *a);
+
+// An arena without its resources, with a HAR for each player. Keyframes are only taken in arenas.
+static void fixture_setup_arena(fixture *f, uint32_t seed, af *har_af) {
+    fixture_setup(f, seed);
+    f->gs->this_id = SCENE_ARENA0;
+    f->gs->next_id = SCENE_ARENA0;
+    f->gs->sc->id = SCENE_ARENA0;
+    har_af_create(har_af);
+    for(int i = 0; i < 2; i++) {
+        object *obj = omf_calloc(1, sizeof(object));
+        object_create(obj, f->gs, vec2i_create(80 + i * 160, 190), vec2f_create(0, 0));
+        har_create(obj, har_af, i == 0 ? OBJECT_FACE_RIGHT : OBJECT_FACE_LEFT, 0, 0, i);
+        game_state_add_object(f->gs, obj, RENDER_LAYER_MIDDLE, 0, 0);
+        game_player_set_har(game_state_get_player(f->gs, i), obj);
+    }
+}
+
+// Whether the objects of a and b are in the same state, HARs included
+static bool same_object_state(game_state *a, game_state *b) {
+    serial sa, sb;
+    serial_create(&sa);
+    serial_create(&sb);
+    game_state_serialize_objects(a, &sa);
+    game_state_serialize_objects(b, &sb);
+    bool same = serial_len(&sa) == serial_len(&sb) && memcmp(sa.data, sb.data, serial_len(&sa)) == 0;
+    serial_free(&sa);
+    serial_free(&sb);
+    return same;
+}
+
+// Seeks a match with at most max_frames keyframes. If add_tick is set, an object is added at that tick, so that
+// the keyframes after it have to start over from a full snapshot. The replays do not add it, so no seek may
+// simulate across that tick.
+static void check_keyframe_seek(unsigned int max_frames, int add_tick) {
+    // Seek backwards, onto a keyframe, between keyframes and forward from the current tick
+    static const uint32_t targets[] = {0, 1, 100, 1234, 99, 1100, 1101, SIM_TICKS - 1, SIM_TICKS};
+    enum
+    {
+        TARGET_COUNT = sizeof(targets) / sizeof(targets[0])
+    };
+    af har_af;
+    fixture f;
+    game_state *expected[TARGET_COUNT];
+    fixture_setup_arena(&f, 4321, &har_af);
+    game_state *gs = f.gs;
+    sim_add_objects(gs);
+    game_state_enable_keyframes(gs, 100);
+    gs->keyframes->max_frames = max_frames;
+
+    // Clones of the straight run at each target
+    for(int i = 0; i <= SIM_TICKS; i++) {
+        if(i == add_tick && i > 0) {
+            sim_add_object(gs, SIM_OBJECTS);
+        }
+        if(i > 0) {
+            sim_tick(gs, 1);
+        }
+        for(int t = 0; t < TARGET_COUNT; t++) {
+            if(targets[t] == gs->int_tick) {
+                expected[t] = omf_calloc(1, sizeof(game_state));
+                game_state_clone(gs, expected[t]);
+            }
+        }
+    }
+
+    // Deltas always have their base at hand
+    unsigned int count = vector_size(&gs->keyframes->frames);
+    CU_ASSERT(count <= max_frames);
+    for(unsigned int i = 0; i < count; i++) {
+        rec_keyframe *frame = vector_get(&gs->keyframes->frames, i);
+        bool found = false;
+        for(unsigned int k = 0; k <= i; k++) {
+            rec_keyframe *base = vector_get(&gs->keyframes->frames, k);
+            found = found || (base->tick == frame->base_tick && base->base_tick == base->tick);
+        }
+        CU_ASSERT(found);
+    }
+
+    for(int t = 0; t < TARGET_COUNT; t++) {
+        game_state *dst = rec_keyframes_seek(gs->keyframes, gs, targets[t]);
+        CU_ASSERT_PTR_NOT_NULL_FATAL(dst);
+        CU_ASSERT_EQUAL(dst->int_tick, targets[t]);
+        CU_ASSERT(same_object_state(dst, expected[t]));
+        CU_ASSERT_EQUAL(sim_positions(dst), sim_positions(expected[t]));
+        game_state_clone_free(dst);
+        omf_free(dst);
+        game_state_clone_free(expected[t]);
+        omf_free(expected[t]);
+    }
+
+    fixture_teardown(&f);
+    af_free(&har_af);
+}
+
+void test_game_state_keyframe_seek(void) {
+    check_keyframe_seek(REC_KEYFRAME_MAX, 1050);
+
+    // Keyframes are every interval, and turn into deltas while the objects stay the same
+    af har_af;
+    fixture f;
+    fixture_setup_arena(&f, 4321, &har_af);
+    sim_add_objects(f.gs);
+    game_state_enable_keyframes(f.gs, 100);
+    sim_tick(f.gs, 1049);
+    sim_add_object(f.gs, SIM_OBJECTS);
+    sim_tick(f.gs, 151);
+    rec_keyframes *kf = f.gs->keyframes;
+    CU_ASSERT_EQUAL(vector_size(&kf->frames), 13);
+    rec_keyframe *frame = vector_get(&kf->frames, 1);
+    CU_ASSERT_EQUAL(frame->base_tick, 0);
+    CU_ASSERT_NOT_EQUAL(serial_len(&frame->objects), 0);
+    frame = vector_get(&kf->frames, 11);
+    CU_ASSERT_EQUAL(frame->base_tick, frame->tick);
+    frame = vector_get(&kf->frames, 12);
+    CU_ASSERT_EQUAL(frame->base_tick, 1100);
+    fixture_teardown(&f);
+    af_free(&har_af);
+}
+
+void test_game_state_keyframe_thinning(void) {
+    check_keyframe_seek(6, 0);
+
+    // Only every other keyframe is kept once there are too many, and they are taken less often
+    af har_af;
+    fixture f;
+    fixture_setup_arena(&f, 4321, &har_af);
+    game_state_enable_keyframes(f.gs, 100);
+    rec_keyframes *kf = f.gs->keyframes;
+    kf->max_frames = 4;
+    sim_tick(f.gs, 400);
+    CU_ASSERT_EQUAL(vector_size(&kf->frames), 3);
+    CU_ASSERT_EQUAL(kf->interval, 200);
+    CU_ASSERT_EQUAL(((rec_keyframe *)vector_get(&kf->frames, 1))->tick, 200);
+    CU_ASSERT_EQUAL(((rec_keyframe *)vector_get(&kf->frames, 2))->tick, 400);
+    fixture_teardown(&f);
+    af_free(&har_af);
+}
+
+void test_game_state_keyframe_scenes(void) {
+    // Scenes other than arenas are not snapshotted, and can not be seeked
+    fixture f;
+    fixture_setup(&f, 4321);
+    sim_add_objects(f.gs);
+    game_state_enable_keyframes(f.gs, 100);
+    sim_tick(f.gs, 500);
+    CU_ASSERT_EQUAL(vector_size(&f.gs->keyframes->frames), 0);
+    CU_ASSERT_PTR_NULL(rec_keyframes_seek(f.gs->keyframes, f.gs, 100));
+    fixture_teardown(&f);
+}
+
+void test_game_state_reclone(void) {
+    fixture f;
+    fixture_setup(&f, 1357);
+    game_state *gs = f.gs;
+    sim_add_objects(gs);
+    sim_tick(gs, 50);
+
+    game_state *old = omf_calloc(1, sizeof(game_state));
+    game_state_clone(gs, old);
+    object *kept = game_state_find_object(old, 1);
+    sim_tick(gs, 100);
+
+    // Same objects: the objects of the old clone are kept, and catch up with the state
+    game_state_reclone(gs, old);
+    CU_ASSERT_PTR_EQUAL(game_state_find_object(old, 1), kept);
+    CU_ASSERT_PTR_EQUAL(kept->gs, old);
+    CU_ASSERT_EQUAL(old->int_tick, gs->int_tick);
+    CU_ASSERT_EQUAL(sim_positions(old), sim_positions(gs));
+    sim_tick(gs, 100);
+    sim_tick(old, 100);
+    CU_ASSERT_EQUAL(sim_positions(old), sim_positions(gs));
+
+    // New objects: cloned anew
+    sim_add_object(gs, SIM_OBJECTS);
+    game_state_reclone(gs, old);
+    CU_ASSERT_TRUE(game_state_same_objects(gs, old));
+    sim_tick(gs, 100);
+    sim_tick(old, 100);
+    CU_ASSERT_EQUAL(sim_positions(old), sim_positions(gs));
+
+    game_state_clone_free(old);
+    omf_free(old);
+    fixture_teardown(&f);
+}
+
+void test_game_state_object_serialize(void) {
+    fixture f;
+    fixture_setup(&f, 2468);
+    game_state *gs = f.gs;
+    sim_add_objects(gs);
+    sim_tick(gs, 300);
+
+    // Save all objects into one buffer, and play on for a while
+    serial ser;
+    serial_create(&ser);
+    for(int i = 0; i < SIM_OBJECTS; i++) {
+        object_serialize(game_state_find_object(gs, i + 1), &ser);
+    }
+    uint32_t seed = random_get_seed(&gs->rand);
+    uint32_t expected[100];
+    for(int i = 0; i < 100; i++) {
+        sim_tick(gs, 1);
+        expected[i] = sim_positions(gs);
+    }
+
+    // Restore the objects, and the same ticks must play out again
+    for(int i = 0; i < SIM_OBJECTS; i++) {
+        CU_ASSERT_EQUAL(object_unserialize(game_state_find_object(gs, i + 1), &ser), 0);
+    }
+    CU_ASSERT_EQUAL(ser.rpos, serial_len(&ser));
+    random_seed(&gs->rand, seed);
+    for(int i = 0; i < 100; i++) {
+        sim_tick(gs, 1);
+        CU_ASSERT_EQUAL(sim_positions(gs), expected[i]);
+    }
+
+    // State of one object can not be restored into another
+    serial_read_reset(&ser);
+    CU_ASSERT_EQUAL(object_unserialize(game_state_find_object(gs, 2), &ser), 1);
+
+    serial_free(&ser);
+    fixture_teardown(&f);
+}
+
+// A HAR file with a few moves, no sprites
+static void har_af_create(af *a) {
+    static const struct {
+        int id;
+        const char *anim;
+    } moves[] = {
+        {ANIM_WALKING, "A5-B5-C5"},
+        {ANIM_IDLE, "A10-B10"},
+        {30, "A3-B3-C3-D3"},
+        {31, "E4-F4"},
+    };
+    sd_af_file sdaf;
+    sd_af_create(&sdaf);
+    sdaf.health = 100;
+    sdaf.endurance = 50;
+    sdaf.fall_speed = 2;
+    for(unsigned i = 0; i < sizeof(moves) / sizeof(moves[0]); i++) {
+        sd_move move;
+        sd_animation ani;
+        sd_move_create(&move);
+        sd_animation_create(&ani);
+        sd_move_set_animation(&move, &ani);
+        sd_af_set_move(&sdaf, moves[i].id, &move);
+        sd_animation_set_anim_string(sdaf.moves[moves[i].id]->animation, moves[i].anim);
+        sd_animation_free(&ani);
+        sd_move_free(&move);
+    }
+    af_create(a, &sdaf, NULL);
+    sd_af_free(&sdaf);
+}
+
+// Serializes the objects of src into dst, and checks that dst then serializes the same
+static void check_round_trip(game_state *src, game_state *dst) {
+    serial a, b;
+    serial_create(&a);
+    serial_create(&b);
+    game_state_serialize_objects(src, &a);
+    CU_ASSERT_EQUAL(game_state_unserialize_objects(dst, &a), 0);
+    CU_ASSERT_EQUAL(a.rpos, serial_len(&a));
+    game_state_serialize_objects(dst, &b);
+    CU_ASSERT_EQUAL_FATAL(serial_len(&a), serial_len(&b));
+    CU_ASSERT(memcmp(a.data, b.data, serial_len(&a)) == 0);
+    serial_free(&a);
+    serial_free(&b);
+}
+
+void test_game_state_har_serialize(void) {
+    fixture f;
+    fixture_setup(&f, 1);
+    af har_af;
+    har_af_create(&har_af);
+
+    object *obj = omf_calloc(1, sizeof(object));
+    object_create(obj, f.gs, vec2i_create(100, 190), vec2f_create(0, 0));
+    CU_ASSERT_EQUAL(har_create(obj, &har_af, OBJECT_FACE_RIGHT, 0, 0, 0), 0);
+    game_state_add_object(f.gs, obj, RENDER_LAYER_MIDDLE, 0, 0);
+    game_player_set_har(game_state_get_player(f.gs, 0), obj);
+
+    game_state *clone = omf_calloc(1, sizeof(game_state));
+    game_state_clone(f.gs, clone);
+
+    // Move the HAR on to another move and change its match state
+    har *h = object_get_userdata(obj);
+    object_set_animation(obj, &af_get_move(&har_af, ANIM_WALKING)->ani);
+    player_next_frame(obj);
+    object_set_pos(obj, vec2i_create(140, 150));
+    object_set_vel(obj, vec2f_create(3.5f, -2.0f));
+    object_set_direction(obj, OBJECT_FACE_LEFT);
+    h->state = STATE_WALKTO;
+    h->health = 42;
+    h->endurance = 12.5f;
+    h->executing_move = 1;
+    memcpy(h->inputs, "6523K", 6);
+    h->rehits[0] = 30;
+
+    check_round_trip(f.gs, clone);
+    object *cobj = game_state_find_object(clone, obj->id);
+    har *ch = object_get_userdata(cobj);
+    CU_ASSERT_PTR_EQUAL(cobj->cur_animation, obj->cur_animation);
+    CU_ASSERT_EQUAL(player_get_frame(cobj), player_get_frame(obj));
+    CU_ASSERT_EQUAL(cobj->pos.x, 140);
+    CU_ASSERT_EQUAL(cobj->direction, OBJECT_FACE_LEFT);
+    CU_ASSERT_EQUAL(ch->state, STATE_WALKTO);
+    CU_ASSERT_EQUAL(ch->health, 42);
+    CU_ASSERT_STRING_EQUAL(ch->inputs, "6523K");
+    CU_ASSERT_EQUAL(ch->rehits[0], 30);
+    // Set-up time data stays with the clone
+    CU_ASSERT_PTR_NOT_EQUAL(ch, h);
+    CU_ASSERT_EQUAL(ch->health_max, h->health_max);
+
+    // A move the HAR does not have can not be restored
+    serial ser;
+    serial_create(&ser);
+    cobj->cur_animation->id = 99;
+    object_serialize(cobj, &ser);
+    cobj->cur_animation->id = ANIM_WALKING;
+    CU_ASSERT_EQUAL(object_unserialize(cobj, &ser), 1);
+    serial_free(&ser);
+
+    game_state_clone_free(clone);
+    omf_free(clone);
+    fixture_teardown(&f);
+    af_free(&har_af);
+}
+
+void test_game_state_projectile_serialize(void) {
+    fixture f;
+    fixture_setup(&f, 1);
+    af har_af;
+    har_af_create(&har_af);
+
+    object *har_obj = omf_calloc(1, sizeof(object));
+    object_create(har_obj, f.gs, vec2i_create(100, 190), vec2f_create(0, 0));
+    har_create(har_obj, &har_af, OBJECT_FACE_RIGHT, 0, 0, 0);
+    game_state_add_object(f.gs, har_obj, RENDER_LAYER_MIDDLE, 0, 0);
+    game_player_set_har(game_state_get_player(f.gs, 0), har_obj);
+
+    object *obj = omf_calloc(1, sizeof(object));
+    object_create(obj, f.gs, vec2i_create(120, 170), vec2f_create(4, 0));
+    projectile_create(obj, object_get_userdata(har_obj));
+    object_set_animation(obj, &af_get_move(&har_af, 30)->ani);
+    game_state_add_object(f.gs, obj, RENDER_LAYER_MIDDLE, 0, 0);
+
+    game_state *clone = omf_calloc(1, sizeof(game_state));
+    game_state_clone(f.gs, clone);
+
+    // The projectile moves on to its successor, and hits
+    object_set_animation(obj, &af_get_move(&har_af, 31)->ani);
+    object_set_pos(obj, vec2i_create(200, 170));
+    object_set_vel(obj, vec2f_create(-4, 1));
+    obj->animation_state.finished = 1;
+    projectile_set_wall_bounce(obj, 1);
+    projectile_mark_hit(obj);
+
+    check_round_trip(f.gs, clone);
+    object *cobj = game_state_find_object(clone, obj->id);
+    CU_ASSERT_PTR_EQUAL(cobj->cur_animation, obj->cur_animation);
+    CU_ASSERT_EQUAL(cobj->pos.x, 200);
+    CU_ASSERT_EQUAL(cobj->animation_state.finished, 1);
+    CU_ASSERT_TRUE(projectile_did_hit(cobj));
+    CU_ASSERT_NOT_EQUAL(object_get_userdata(cobj), object_get_userdata(obj));
+
+    game_state_clone_free(clone);
+    omf_free(clone);
+    fixture_teardown(&f);
+    af_free(&har_af);
+}
+
+int game_state_suite_init(void) {
+    log_init();
+    log_set_level(LOG_ERROR);
+    return 0;
+}
+
+int game_state_suite_cleanup(void) {
+    log_close();
+    return 0;
+}
+
+void game_state_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "Test for object ID allocation", test_game_state_object_ids) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for ticking game states concurrently", test_game_state_concurrent_tick) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for rendering into a surface", test_game_state_render_to_surface) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for seeking through keyframes", test_game_state_keyframe_seek) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for thinning out keyframes", test_game_state_keyframe_thinning) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for keyframes outside arenas", test_game_state_keyframe_scenes) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for recloning a game state", test_game_state_reclone) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for object serialization", test_game_state_object_serialize) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for HAR serialization", test_game_state_har_serialize) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for projectile serialization", test_game_state_projectile_serialize) == NULL) {
+        return;
+    }
+}
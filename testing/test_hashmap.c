@@ -2,6 +2,8 @@
 #include <utils/hashmap.h>
 #include <utils/iterator.h>
 
+#define INT_KEYS 1000
+
 void test_hashmap_create(void) {
     hashmap test_map;
     hashmap_create(&test_map);
@@ -116,6 +118,81 @@ void hashmap_test_autoresize(void) {
     hashmap_free(&test_map);
 }
 
+void test_hashmap_iter_del_many(void) {
+    hashmap test_map;
+    hashmap_create(&test_map);
+    for(unsigned int i = 0; i < 1000; i++) {
+        hashmap_put_int(&test_map, i, &i, sizeof(unsigned int));
+    }
+
+    // Delete every other entry while iterating; every entry must still be seen exactly once.
+    unsigned int seen = 0;
+    iterator it;
+    hashmap_iter_begin(&test_map, &it);
+    hashmap_pair *pair;
+    foreach(it, pair) {
+        seen++;
+        if(*(unsigned int *)pair->value % 2 == 0) {
+            CU_ASSERT(hashmap_delete(&test_map, &it) == 0);
+        }
+    }
+    CU_ASSERT_EQUAL(seen, 1000);
+    CU_ASSERT_EQUAL(hashmap_reserved(&test_map), 500);
+
+    unsigned int *val;
+    for(unsigned int i = 0; i < 1000; i++) {
+        int ret = hashmap_get_int(&test_map, i, (void **)&val, NULL);
+        CU_ASSERT_EQUAL(ret, i % 2 == 0 ? 1 : 0);
+        if(ret == 0) {
+            CU_ASSERT_EQUAL(*val, i);
+        }
+    }
+
+    hashmap_free(&test_map);
+}
+
+void test_hashmap_value_stable(void) {
+    hashmap test_map;
+    hashmap_create(&test_map);
+
+    // Callers keep value pointers around, so they must survive the table growing.
+    unsigned int key = 0;
+    unsigned int first = 1234;
+    unsigned int *ptr = hashmap_put(&test_map, &key, sizeof(unsigned int), &first, sizeof(unsigned int));
+    for(unsigned int i = 1; i < 1000; i++) {
+        hashmap_put_int(&test_map, i, &i, sizeof(unsigned int));
+    }
+    void *val;
+    CU_ASSERT(hashmap_get_int(&test_map, 0, &val, NULL) == 0);
+    CU_ASSERT_PTR_EQUAL(val, ptr);
+    CU_ASSERT_EQUAL(*ptr, 1234);
+
+    hashmap_free(&test_map);
+}
+
+void test_hashmap_int_keys(void) {
+    hashmap test_map;
+    hashmap_create(&test_map);
+
+    // Keys laid out like the recording lookup table, tick * 10 + slot
+    for(unsigned int i = 0; i < INT_KEYS; i++) {
+        hashmap_put_int(&test_map, i * 10, &i, sizeof(unsigned int));
+    }
+    CU_ASSERT_EQUAL(hashmap_reserved(&test_map), INT_KEYS);
+
+    // Half of the lookups miss, as they do when probing for moves on ticks without any
+    unsigned int found = 0;
+    void *val;
+    for(unsigned int i = 0; i < INT_KEYS * 2; i++) {
+        if(hashmap_get_int(&test_map, i * 5, &val, NULL) == 0) {
+            CU_ASSERT_EQUAL(*(unsigned int *)val, i / 2);
+            found++;
+        }
+    }
+    CU_ASSERT_EQUAL(found, INT_KEYS);
+    hashmap_free(&test_map);
+}
+
 void hashmap_test_suite(CU_pSuite suite) {
     // Add tests
     if(CU_add_test(suite, "Test for hashmap create", test_hashmap_create) == NULL) {
@@ -136,4 +213,13 @@ void hashmap_test_suite(CU_pSuite suite) {
     if(CU_add_test(suite, "Test for hashmap auto resize", hashmap_test_autoresize) == NULL) {
         return;
     }
+    if(CU_add_test(suite, "Test for hashmap delete while iterating", test_hashmap_iter_del_many) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for hashmap value pointer stability", test_hashmap_value_stable) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for hashmap integer keys", test_hashmap_int_keys) == NULL) {
+        return;
+    }
 }
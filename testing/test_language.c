@@ -0,0 +1,121 @@
+#include <CUnit/Basic.h>
+#include <CUnit/CUnit.h>
+#include <formats/error.h>
+#include <formats/language.h>
+#include <resources/languages.h>
+#include <stdio.h>
+#include <string.h>
+#include <utils/allocator.h>
+#include <utils/log.h>
+
+static const char *strings[] = {"ENGLISH", "", "Two lines\nof text", "Last one"};
+
+static void write_language(const char *filename) {
+    sd_language lang;
+    CU_ASSERT(sd_language_create(&lang) == SD_SUCCESS);
+    for(unsigned i = 0; i < sizeof(strings) / sizeof(strings[0]); i++) {
+        sd_language_append(&lang, "description", strings[i]);
+    }
+    CU_ASSERT(sd_language_save(&lang, filename) == SD_SUCCESS);
+    sd_language_free(&lang);
+}
+
+void test_lang_table_load(void) {
+    write_language("test_lang.dat");
+
+    sd_lang_table table;
+    CU_ASSERT(sd_lang_table_load(&table, "test_lang.dat") == SD_SUCCESS);
+    CU_ASSERT(table.count == 4);
+    for(unsigned i = 0; i < table.count && i < 4; i++) {
+        CU_ASSERT_STRING_EQUAL(table.data + table.offsets[i], strings[i]);
+    }
+    sd_lang_table_free(&table);
+
+    CU_ASSERT(sd_lang_table_load(&table, "test_missing.dat") == SD_FILE_OPEN_ERROR);
+
+    // A catalog without a single entry is not a language file
+    FILE *f = fopen("test_lang.dat", "wb");
+    uint32_t header[2] = {0, 0};
+    fwrite(header, sizeof(header), 1, f);
+    fclose(f);
+    CU_ASSERT(sd_lang_table_load(&table, "test_lang.dat") == SD_FILE_INVALID_TYPE);
+    remove("test_lang.dat");
+}
+
+void test_language_read_string(void) {
+    write_language("test_lang.dat");
+
+    char *data;
+    unsigned int count;
+    CU_ASSERT(sd_language_read_string("test_lang.dat", 2, &count, &data) == SD_SUCCESS);
+    CU_ASSERT(count == 4);
+    CU_ASSERT_STRING_EQUAL(data, strings[2]);
+    omf_free(data);
+
+    // Out of range still tells the count
+    CU_ASSERT(sd_language_read_string("test_lang.dat", 4, &count, &data) == SD_INVALID_INPUT);
+    CU_ASSERT(count == 4);
+    CU_ASSERT(data == NULL);
+    remove("test_lang.dat");
+}
+
+static void write_numbered_language(const char *filename, unsigned int count) {
+    sd_language lang;
+    CU_ASSERT(sd_language_create(&lang) == SD_SUCCESS);
+    char text[16];
+    for(unsigned int i = 0; i < count; i++) {
+        snprintf(text, sizeof(text), "string %u", i);
+        sd_language_append(&lang, "description", text);
+    }
+    CU_ASSERT(sd_language_save(&lang, filename) == SD_SUCCESS);
+    sd_language_free(&lang);
+}
+
+void test_lang_old_numbering(void) {
+    log_init();
+    write_numbered_language("test_lang.dat", 990);
+    write_numbered_language("test_lang.dat2", LANG2_STR_COUNT);
+
+    // Old files lack the 23 netplay strings of OMF 2.1, and the strings after them are moved up
+    CU_ASSERT_FATAL(lang_load_language("test_lang.dat"));
+    CU_ASSERT_STRING_EQUAL(lang_get(0), "string 0");
+    CU_ASSERT_STRING_EQUAL(lang_get(148), "string 148");
+    CU_ASSERT_STRING_EQUAL(lang_get(149), "!INVALID!");
+    CU_ASSERT_STRING_EQUAL(lang_get(150), "!INVALID!");
+    CU_ASSERT_STRING_EQUAL(lang_get(151), "string 149");
+    CU_ASSERT_STRING_EQUAL(lang_get(186), "string 170");
+    CU_ASSERT_STRING_EQUAL(lang_get(268), "string 251");
+    CU_ASSERT_STRING_EQUAL(lang_get(305), "!INVALID!");
+    CU_ASSERT_STRING_EQUAL(lang_get(306), "string 283");
+    CU_ASSERT_STRING_EQUAL(lang_get(LANG_STR_COUNT - 1), "string 989");
+    CU_ASSERT_STRING_EQUAL(lang_get(LANG_STR_COUNT), "!INVALID!");
+    CU_ASSERT_STRING_EQUAL(lang_get2(LANG2_STR_LANGUAGE), "string 0");
+    lang_close();
+
+    // Current files are used as they are
+    write_numbered_language("test_lang.dat", LANG_STR_COUNT);
+    CU_ASSERT_FATAL(lang_load_language("test_lang.dat"));
+    CU_ASSERT_STRING_EQUAL(lang_get(149), "string 149");
+    CU_ASSERT_STRING_EQUAL(lang_get(LANG_STR_COUNT - 1), "string 1012");
+    lang_close();
+
+    // Any other count is refused
+    write_numbered_language("test_lang.dat", 991);
+    CU_ASSERT_FALSE(lang_load_language("test_lang.dat"));
+
+    remove("test_lang.dat");
+    remove("test_lang.dat2");
+    log_close();
+}
+
+void language_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "test of sd_lang_table_load", test_lang_table_load) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of sd_language_read_string", test_language_read_string) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of old language file numbering", test_lang_old_numbering) == NULL) {
+        return;
+    }
+}
@@ -14,6 +14,20 @@ void list_test_suite(CU_pSuite suite);
 void array_test_suite(CU_pSuite suite);
 void text_render_test_suite(CU_pSuite suite);
 void cp437_test_suite(CU_pSuite suite);
+void game_state_test_suite(CU_pSuite suite);
+int game_state_suite_init(void);
+int game_state_suite_cleanup(void);
+void soft_framebuffer_test_suite(CU_pSuite suite);
+void surface_test_suite(CU_pSuite suite);
+void asset_pack_test_suite(CU_pSuite suite);
+void render_queue_test_suite(CU_pSuite suite);
+void task_graph_test_suite(CU_pSuite suite);
+void net_sim_test_suite(CU_pSuite suite);
+void net_pacing_test_suite(CU_pSuite suite);
+void range_coder_test_suite(CU_pSuite suite);
+void component_test_suite(CU_pSuite suite);
+void language_test_suite(CU_pSuite suite);
+void spectator_test_suite(CU_pSuite suite);
 
 int main(int argc, char **argv) {
     CU_pSuite suite = NULL;
@@ -89,6 +103,66 @@ int main(int argc, char **argv) {
         goto end;
     script_test_suite(suite);
 
+    suite = CU_add_suite("Game state", game_state_suite_init, game_state_suite_cleanup);
+    if(suite == NULL)
+        goto end;
+    game_state_test_suite(suite);
+
+    suite = CU_add_suite("Soft framebuffer", NULL, NULL);
+    if(suite == NULL)
+        goto end;
+    soft_framebuffer_test_suite(suite);
+
+    suite = CU_add_suite("Surfaces", NULL, NULL);
+    if(suite == NULL)
+        goto end;
+    surface_test_suite(suite);
+
+    suite = CU_add_suite("Asset packs", NULL, NULL);
+    if(suite == NULL)
+        goto end;
+    asset_pack_test_suite(suite);
+
+    suite = CU_add_suite("Render queue", NULL, NULL);
+    if(suite == NULL)
+        goto end;
+    render_queue_test_suite(suite);
+
+    suite = CU_add_suite("Task graph", NULL, NULL);
+    if(suite == NULL)
+        goto end;
+    task_graph_test_suite(suite);
+
+    suite = CU_add_suite("Network simulator", NULL, NULL);
+    if(suite == NULL)
+        goto end;
+    net_sim_test_suite(suite);
+
+    suite = CU_add_suite("Netplay pacing", NULL, NULL);
+    if(suite == NULL)
+        goto end;
+    net_pacing_test_suite(suite);
+
+    suite = CU_add_suite("Range coder", NULL, NULL);
+    if(suite == NULL)
+        goto end;
+    range_coder_test_suite(suite);
+
+    suite = CU_add_suite("GUI component", NULL, NULL);
+    if(suite == NULL)
+        goto end;
+    component_test_suite(suite);
+
+    suite = CU_add_suite("Language", NULL, NULL);
+    if(suite == NULL)
+        goto end;
+    language_test_suite(suite);
+
+    suite = CU_add_suite("Spectator", NULL, NULL);
+    if(suite == NULL)
+        goto end;
+    spectator_test_suite(suite);
+
     // Run tests
     CU_basic_set_mode(CU_BRM_VERBOSE);
     CU_basic_run_tests();
@@ -0,0 +1,97 @@
+#include "game/utils/net_pacing.h"
+#include <CUnit/Basic.h>
+#include <CUnit/CUnit.h>
+
+void test_net_rtt_percentile(void) {
+    int samples[] = {7, 1, 10, 3, 5, 2, 9, 4, 8, 6};
+    CU_ASSERT_EQUAL(net_rtt_percentile(samples, 0, 90), 0);
+    CU_ASSERT_EQUAL(net_rtt_percentile(samples, 10, 0), 1);
+    CU_ASSERT_EQUAL(net_rtt_percentile(samples, 10, 50), 5);
+    CU_ASSERT_EQUAL(net_rtt_percentile(samples, 10, 90), 9);
+    CU_ASSERT_EQUAL(net_rtt_percentile(samples, 10, 100), 10);
+    CU_ASSERT_EQUAL(net_rtt_percentile(samples, 3, 100), 10);
+
+    // The samples are left as they were
+    CU_ASSERT_EQUAL(samples[0], 7);
+}
+
+void test_net_input_delay(void) {
+    int samples[100];
+    for(int i = 0; i < 100; i++) {
+        samples[i] = 4;
+    }
+
+    // Half of the round trip covers the way to the peer
+    CU_ASSERT_EQUAL(net_input_delay_target(samples, 100, 8), 2);
+    CU_ASSERT_EQUAL(net_input_delay_target(samples, 0, 8), 1);
+
+    // One slow trip in ten does not count, one more does
+    for(int i = 0; i < 10; i++) {
+        samples[i] = 40;
+    }
+    CU_ASSERT_EQUAL(net_input_delay_target(samples, 100, 8), 2);
+    samples[10] = 40;
+    CU_ASSERT_EQUAL(net_input_delay_target(samples, 100, 8), 8);
+    CU_ASSERT_EQUAL(net_input_delay_target(samples, 100, 30), 20);
+
+    // Never less than a tick, never more than allowed
+    for(int i = 0; i < 100; i++) {
+        samples[i] = 0;
+    }
+    CU_ASSERT_EQUAL(net_input_delay_target(samples, 100, 8), 1);
+
+    // The delay moves a tick at a time
+    CU_ASSERT_EQUAL(net_input_delay_step(2, 8), 3);
+    CU_ASSERT_EQUAL(net_input_delay_step(3, 1), 2);
+    CU_ASSERT_EQUAL(net_input_delay_step(4, 4), 4);
+}
+
+void test_net_advantage_pace(void) {
+    // The side that is ahead slows down, the other speeds up by as much
+    float ahead = 0.0f;
+    float behind = 0.0f;
+    for(int i = 0; i < 200; i++) {
+        ahead = net_advantage_sample(ahead, 3, -3);
+        behind = net_advantage_sample(behind, -3, 3);
+    }
+    CU_ASSERT_DOUBLE_EQUAL(ahead, 3.0, 0.01);
+    CU_ASSERT_DOUBLE_EQUAL(behind, -3.0, 0.01);
+    float copy = ahead;
+    int pace = net_advantage_pace(&copy);
+    CU_ASSERT(pace > 0);
+    CU_ASSERT_EQUAL(pace, -net_advantage_pace(&behind));
+
+    // A single sample only moves the advantage a little
+    float advantage = net_advantage_sample(0.0f, 4, 0);
+    CU_ASSERT(advantage > 0.0f && advantage < 2.0f);
+
+    // Sides that run level need no pace
+    advantage = 0.0f;
+    CU_ASSERT_EQUAL(net_advantage_pace(&advantage), 0);
+    CU_ASSERT_EQUAL(net_advantage_sample(0.0f, 2, 2), 0.0f);
+
+    // The pace is limited, however far ahead a side is
+    advantage = 100.0f;
+    CU_ASSERT_EQUAL(net_advantage_pace(&advantage), 800);
+    advantage = -100.0f;
+    CU_ASSERT_EQUAL(net_advantage_pace(&advantage), -800);
+
+    // Without new samples, the advantage is forgotten
+    advantage = 3.0f;
+    for(int i = 0; i < 1000; i++) {
+        pace = net_advantage_pace(&advantage);
+    }
+    CU_ASSERT_EQUAL(pace, 0);
+}
+
+void net_pacing_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "Test for round trip percentiles", test_net_rtt_percentile) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for adaptive input delay", test_net_input_delay) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for frame advantage pacing", test_net_advantage_pace) == NULL) {
+        return;
+    }
+}
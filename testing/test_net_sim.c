@@ -0,0 +1,127 @@
+#include "game/utils/net_sim.h"
+#include <CUnit/Basic.h>
+#include <CUnit/CUnit.h>
+#include <string.h>
+
+#define PUSHES 400
+
+// Pushes a numbered datagram every 5 ms and records the numbers in the order they come out
+static int run_link(const net_sim_config *config, uint32_t seed, uint32_t *delivered, net_link_stats *stats) {
+    net_link link;
+    net_link_create(&link, config, seed);
+    int count = 0;
+    for(uint32_t now = 0; now < PUSHES * 5 + 1000; now++) {
+        if(now % 5 == 0 && now / 5 < PUSHES) {
+            uint32_t number = now / 5;
+            net_link_push(&link, now, &number, sizeof(number));
+        }
+        uint32_t number;
+        size_t len;
+        while(net_link_pop(&link, now, &number, sizeof(number), &len)) {
+            CU_ASSERT_EQUAL(len, sizeof(number));
+            delivered[count++] = number;
+        }
+    }
+    CU_ASSERT_EQUAL(net_link_pending(&link), 0);
+    *stats = link.stats;
+    net_link_free(&link);
+    return count;
+}
+
+void test_net_link_latency(void) {
+    net_sim_config config = {20, 0, 0.0f, 0.0f, 0.0f};
+    net_link link;
+    net_link_create(&link, &config, 1);
+
+    char buf[8];
+    size_t len;
+    net_link_push(&link, 100, "hello", 6);
+    CU_ASSERT_FALSE(net_link_pop(&link, 119, buf, sizeof(buf), &len));
+    CU_ASSERT_TRUE(net_link_pop(&link, 120, buf, sizeof(buf), &len));
+    CU_ASSERT_EQUAL(len, 6);
+    CU_ASSERT_STRING_EQUAL(buf, "hello");
+    CU_ASSERT_FALSE(net_link_pop(&link, 120, buf, sizeof(buf), &len));
+
+    // Truncated to the buffer
+    net_link_push(&link, 200, "hello", 6);
+    CU_ASSERT_TRUE(net_link_pop(&link, 220, buf, 2, &len));
+    CU_ASSERT_EQUAL(len, 2);
+    CU_ASSERT_EQUAL(net_link_pending(&link), 0);
+    net_link_free(&link);
+}
+
+void test_net_link_determinism(void) {
+    net_sim_config config = {30, 40, 0.1f, 0.1f, 0.1f};
+    static uint32_t first[PUSHES * 2];
+    static uint32_t second[PUSHES * 2];
+    net_link_stats first_stats, second_stats;
+
+    int count = run_link(&config, 1234, first, &first_stats);
+    CU_ASSERT_EQUAL(run_link(&config, 1234, second, &second_stats), count);
+    CU_ASSERT_EQUAL(memcmp(first, second, count * sizeof(uint32_t)), 0);
+    CU_ASSERT_EQUAL(memcmp(&first_stats, &second_stats, sizeof(net_link_stats)), 0);
+
+    // Everything pushed is accounted for
+    CU_ASSERT_EQUAL(first_stats.pushed, PUSHES);
+    CU_ASSERT_EQUAL(first_stats.delivered, first_stats.pushed - first_stats.dropped + first_stats.duplicated);
+    CU_ASSERT_EQUAL((uint32_t)count, first_stats.delivered);
+
+    // A different seed gives different decisions
+    int other = run_link(&config, 4321, second, &second_stats);
+    CU_ASSERT(other != count || memcmp(first, second, count * sizeof(uint32_t)) != 0);
+}
+
+void test_net_link_ordering(void) {
+    static uint32_t delivered[PUSHES * 2];
+    net_link_stats stats;
+
+    // Jitter alone keeps the order
+    net_sim_config config = {10, 50, 0.0f, 0.0f, 0.0f};
+    int count = run_link(&config, 99, delivered, &stats);
+    CU_ASSERT_EQUAL(count, PUSHES);
+    for(int i = 0; i < count; i++) {
+        CU_ASSERT_EQUAL(delivered[i], (uint32_t)i);
+    }
+
+    // Reordered datagrams overtake the ones in flight
+    config.reorder = 0.2f;
+    count = run_link(&config, 99, delivered, &stats);
+    CU_ASSERT_EQUAL(count, PUSHES);
+    CU_ASSERT(stats.reordered > 0);
+    int overtaken = 0;
+    for(int i = 1; i < count; i++) {
+        overtaken += delivered[i] < delivered[i - 1];
+    }
+    CU_ASSERT(overtaken > 0);
+}
+
+void test_net_link_loss(void) {
+    static uint32_t delivered[PUSHES * 2];
+    net_link_stats stats;
+    net_sim_config config = {0, 0, 0.25f, 0.0f, 0.0f};
+    int count = run_link(&config, 7, delivered, &stats);
+    CU_ASSERT(stats.dropped > PUSHES / 8 && stats.dropped < PUSHES / 2);
+    CU_ASSERT_EQUAL((uint32_t)count, PUSHES - stats.dropped);
+    CU_ASSERT_EQUAL(stats.duplicated, 0);
+
+    config.loss = 0.0f;
+    config.duplicate = 0.25f;
+    count = run_link(&config, 7, delivered, &stats);
+    CU_ASSERT(stats.duplicated > PUSHES / 8 && stats.duplicated < PUSHES / 2);
+    CU_ASSERT_EQUAL((uint32_t)count, PUSHES + stats.duplicated);
+}
+
+void net_sim_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "Test for network link latency", test_net_link_latency) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for network link determinism", test_net_link_determinism) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for network link ordering", test_net_link_ordering) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for network link loss", test_net_link_loss) == NULL) {
+        return;
+    }
+}
@@ -1,5 +1,6 @@
 #include "formats/error.h"
 #include "formats/palette.h"
+#include "video/vga_state.h"
 #include <CUnit/Basic.h>
 #include <CUnit/CUnit.h>
 #include <stdio.h>
@@ -72,6 +73,56 @@ void test_gimp_roundtrip(void) {
     CU_ASSERT_NSTRING_EQUAL(pal.colors, new.colors, 256 * 3);
 }
 
+typedef struct {
+    int player;
+    uint8_t step;
+} flash;
+
+// HAR-style flash on the colors of one player
+static void flash_transform(damage_tracker *damage, vga_palette *pal, void *userdata) {
+    flash *f = userdata;
+    vga_palette_mix_range(pal, 0, 48 * f->player + 1, 48 * f->player + 48, f->step);
+    damage_set_range(damage, 48 * f->player + 1, 48 * f->player + 48);
+}
+
+static bool is_palette_dirty(vga_state *vga, vga_index *start, vga_index *end) {
+    vga_palette *tmp;
+    bool dirty = vga_state_is_palette_dirty(vga, &tmp, start, end);
+    vga_state_mark_palette_flushed(vga);
+    return dirty;
+}
+
+void test_palette_damage(void) {
+    vga_index start, end;
+    flash f = {0, 128};
+    vga_state *vga = vga_state_create();
+    vga_state_set_base_palette_from(vga, &pal);
+    vga_state_render(vga);
+    CU_ASSERT(is_palette_dirty(vga, &start, &end));
+
+    // A new transform is reported, but holding it does not change any colors
+    vga_state_enable_palette_transform(vga, flash_transform, &f);
+    vga_state_render(vga);
+    CU_ASSERT(is_palette_dirty(vga, &start, &end));
+    CU_ASSERT(start >= 1 && end <= 48);
+    vga_state_enable_palette_transform(vga, flash_transform, &f);
+    vga_state_render(vga);
+    CU_ASSERT_FALSE(is_palette_dirty(vga, &start, &end));
+
+    // Stepping it, or letting it end, does
+    f.step = 255;
+    vga_state_enable_palette_transform(vga, flash_transform, &f);
+    vga_state_render(vga);
+    CU_ASSERT(is_palette_dirty(vga, &start, &end));
+    vga_state_render(vga);
+    CU_ASSERT(is_palette_dirty(vga, &start, &end));
+    CU_ASSERT(start >= 1 && end <= 48);
+    vga_state_render(vga);
+    CU_ASSERT_FALSE(is_palette_dirty(vga, &start, &end));
+
+    vga_state_free(&vga);
+}
+
 void palette_test_suite(CU_pSuite suite) {
     if(CU_add_test(suite, "test of palette_create", test_palette_create) == NULL) {
         return;
@@ -85,4 +136,7 @@ void palette_test_suite(CU_pSuite suite) {
     if(CU_add_test(suite, "test of palette roundtripping", test_gimp_roundtrip) == NULL) {
         return;
     }
+    if(CU_add_test(suite, "test of palette damage tracking", test_palette_damage) == NULL) {
+        return;
+    }
 }
@@ -0,0 +1,65 @@
+#include "utils/allocator.h"
+#include "utils/range_coder.h"
+#include <CUnit/Basic.h>
+#include <CUnit/CUnit.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DATA_LEN 20000
+
+static void roundtrip(const char *data, size_t len, size_t *packed_len) {
+    char *packed = NULL;
+    *packed_len = range_compress(data, len, &packed);
+    char *unpacked = omf_calloc(len + 1, 1);
+    CU_ASSERT(range_decompress(packed, *packed_len, unpacked, len));
+    CU_ASSERT(memcmp(data, unpacked, len) == 0);
+    omf_free(unpacked);
+    omf_free(packed);
+}
+
+void test_range_coder_roundtrip(void) {
+    char *data = omf_malloc(DATA_LEN);
+    size_t packed_len;
+
+    // Noise does not compress, but must still come back intact
+    srand(42);
+    for(int i = 0; i < DATA_LEN; i++) {
+        data[i] = rand();
+    }
+    roundtrip(data, DATA_LEN, &packed_len);
+    CU_ASSERT(packed_len < DATA_LEN + DATA_LEN / 50);
+
+    // Inputs held for a while, like a recorded match
+    for(int i = 0; i < DATA_LEN; i++) {
+        data[i] = (i / 37) % 5 == 0 ? 0x31 : (i % 3 ? 0 : 1);
+    }
+    roundtrip(data, DATA_LEN, &packed_len);
+    CU_ASSERT(packed_len < DATA_LEN / 4);
+
+    // Short buffers
+    roundtrip(data, 1, &packed_len);
+    roundtrip(data, 0, &packed_len);
+    omf_free(data);
+}
+
+void test_range_coder_truncated(void) {
+    char data[4096];
+    for(unsigned i = 0; i < sizeof(data); i++) {
+        data[i] = (i * 7) ^ (i >> 3);
+    }
+    char *packed = NULL;
+    size_t packed_len = range_compress(data, sizeof(data), &packed);
+    char unpacked[sizeof(data)];
+    CU_ASSERT(range_decompress(packed, packed_len, unpacked, sizeof(data)));
+    CU_ASSERT_FALSE(range_decompress(packed, packed_len / 2, unpacked, sizeof(data)));
+    omf_free(packed);
+}
+
+void range_coder_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "Test for range coder roundtrip", test_range_coder_roundtrip) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for range coder truncated input", test_range_coder_truncated) == NULL) {
+        return;
+    }
+}
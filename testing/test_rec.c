@@ -1,9 +1,12 @@
 #include "formats/error.h"
 #include "formats/rec.h"
+#include "formats/rec2.h"
+#include "utils/allocator.h"
 #include <CUnit/Basic.h>
 #include <CUnit/CUnit.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 sd_rec_file rec;
 
@@ -64,12 +67,287 @@ void test_rec_roundtrip(void) {
     sd_rec_free(&loaded);
 }
 
+static void make_move(sd_rec_move *mv, uint32_t tick, uint8_t player_id, sd_action action) {
+    memset(mv, 0, sizeof(sd_rec_move));
+    mv->tick = tick;
+    mv->lookup_id = 2;
+    mv->player_id = player_id;
+    mv->action = action;
+}
+
+void test_rec_insert_actions(void) {
+    sd_rec_file r;
+    sd_rec_move mv;
+    CU_ASSERT(sd_rec_create(&r) == SD_SUCCESS);
+
+    // Append one at a time
+    for(unsigned i = 0; i < 1000; i++) {
+        make_move(&mv, i * 2, 0, SD_ACT_PUNCH);
+        CU_ASSERT(sd_rec_insert_action(&r, r.move_count, &mv) == SD_SUCCESS);
+    }
+    CU_ASSERT(r.move_count == 1000);
+    CU_ASSERT(r.move_capacity >= r.move_count);
+
+    // Insert a tick worth of moves in the middle
+    sd_rec_move batch[2];
+    make_move(&batch[0], 11, 0, SD_ACT_KICK);
+    make_move(&batch[1], 11, 1, SD_ACT_UP);
+    CU_ASSERT(sd_rec_insert_actions(&r, 6, batch, 2) == SD_SUCCESS);
+    CU_ASSERT(sd_rec_insert_actions(&r, r.move_count + 1, batch, 2) == SD_INVALID_INPUT);
+    CU_ASSERT(r.move_count == 1002);
+    CU_ASSERT(r.moves[5].tick == 10);
+    CU_ASSERT(r.moves[6].tick == 11 && r.moves[6].action == SD_ACT_KICK);
+    CU_ASSERT(r.moves[7].tick == 11 && r.moves[7].player_id == 1);
+    CU_ASSERT(r.moves[8].tick == 12);
+    CU_ASSERT(r.moves[1001].tick == 1998);
+
+    // And take them out again
+    CU_ASSERT(sd_rec_delete_action(&r, 6) == SD_SUCCESS);
+    CU_ASSERT(sd_rec_delete_action(&r, 6) == SD_SUCCESS);
+    CU_ASSERT(r.move_count == 1000);
+    for(unsigned i = 0; i < r.move_count; i++) {
+        CU_ASSERT(r.moves[i].tick == i * 2);
+    }
+    sd_rec_free(&r);
+}
+
+void test_rec_stream(void) {
+    sd_rec_file r;
+    sd_rec_file loaded;
+    sd_rec_move mv;
+    CU_ASSERT(sd_rec_create(&r) == SD_SUCCESS);
+    r.arena_id = 3;
+    r.vitality = 150;
+
+    sd_rec_stream *stream = sd_rec_stream_open(&r, "test_stream.rec");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(stream);
+    for(unsigned i = 0; i < 300; i++) {
+        make_move(&mv, i, i % 2, (i % 3) ? SD_ACT_LEFT : SD_ACT_NONE);
+        sd_rec_insert_action(&r, r.move_count, &mv);
+        if(i % 50 == 0) {
+            CU_ASSERT(sd_rec_stream_flush(stream, &r) == SD_SUCCESS);
+        }
+    }
+
+    // What has been flushed can be read back before the stream is closed
+    CU_ASSERT(sd_rec_create(&loaded) == SD_SUCCESS);
+    CU_ASSERT(sd_rec_load(&loaded, "test_stream.rec") == SD_SUCCESS);
+    CU_ASSERT(loaded.move_count == 251);
+    CU_ASSERT(loaded.arena_id == 3);
+    sd_rec_free(&loaded);
+
+    sd_rec_finish(&r, 300);
+    CU_ASSERT(sd_rec_stream_close(stream, &r) == SD_SUCCESS);
+    CU_ASSERT(sd_rec_create(&loaded) == SD_SUCCESS);
+    CU_ASSERT(sd_rec_load(&loaded, "test_stream.rec") == SD_SUCCESS);
+    CU_ASSERT(loaded.move_count == r.move_count);
+    CU_ASSERT(loaded.vitality == 150);
+    for(unsigned i = 0; i < r.move_count && i < loaded.move_count; i++) {
+        CU_ASSERT(r.moves[i].tick == loaded.moves[i].tick);
+        CU_ASSERT(r.moves[i].player_id == loaded.moves[i].player_id);
+        CU_ASSERT(r.moves[i].action == loaded.moves[i].action);
+    }
+    sd_rec_free(&loaded);
+    sd_rec_free(&r);
+}
+
 void test_crystal_shirro_load(void) {
     CU_ASSERT(sd_rec_create(&rec) == SD_SUCCESS);
     CU_ASSERT(sd_rec_load(&rec, TESTS_ROOT_DIR "/recs/crystal-shirro.rec") == SD_SUCCESS);
     sd_rec_free(&rec);
 }
 
+void test_rec_copy(void) {
+    sd_rec_file src, copy;
+    CU_ASSERT(sd_rec_create(&src) == SD_SUCCESS);
+    CU_ASSERT(sd_rec_load(&src, TESTS_ROOT_DIR "/recs/crystal-shirro.rec") == SD_SUCCESS);
+    CU_ASSERT(sd_rec_copy(NULL, &src) == SD_INVALID_INPUT);
+    CU_ASSERT(sd_rec_copy(&copy, &src) == SD_SUCCESS);
+
+    // Copy owns its own moves and extra data
+    CU_ASSERT(copy.move_count == src.move_count);
+    CU_ASSERT(copy.moves != src.moves);
+    for(unsigned i = 0; i < src.move_count; i++) {
+        CU_ASSERT(copy.moves[i].tick == src.moves[i].tick);
+        CU_ASSERT(copy.moves[i].lookup_id == src.moves[i].lookup_id);
+        int unknown_len = sd_rec_extra_len(src.moves[i].lookup_id) - 1;
+        if(src.moves[i].extra_data != NULL && unknown_len > 0) {
+            CU_ASSERT(copy.moves[i].extra_data != src.moves[i].extra_data);
+            CU_ASSERT(memcmp(copy.moves[i].extra_data, src.moves[i].extra_data, unknown_len) == 0);
+        }
+    }
+
+    // Finishing the copy leaves the source alone
+    unsigned int count = src.move_count;
+    sd_rec_finish(&copy, 1000);
+    CU_ASSERT(copy.move_count == count + 1);
+    CU_ASSERT(src.move_count == count);
+
+    sd_rec_free(&copy);
+    sd_rec_free(&src);
+}
+
+static long file_size(const char *filename) {
+    FILE *f = fopen(filename, "rb");
+    if(f == NULL) {
+        return -1;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fclose(f);
+    return size;
+}
+
+void test_rec2_roundtrip(void) {
+    sd_rec_file src, loaded;
+    CU_ASSERT(sd_rec_create(&src) == SD_SUCCESS);
+    CU_ASSERT(sd_rec_load(&src, TESTS_ROOT_DIR "/recs/crystal-shirro.rec") == SD_SUCCESS);
+    CU_ASSERT(sd_rec2_save(&src, "test_v2.rec") == SD_SUCCESS);
+    CU_ASSERT(sd_rec2_is_compact("test_v2.rec"));
+    CU_ASSERT(!sd_rec2_is_compact(TESTS_ROOT_DIR "/recs/crystal-shirro.rec"));
+    CU_ASSERT(file_size("test_v2.rec") < file_size(TESTS_ROOT_DIR "/recs/crystal-shirro.rec"));
+
+    // Compact files load through the normal loader
+    CU_ASSERT(sd_rec_create(&loaded) == SD_SUCCESS);
+    CU_ASSERT(sd_rec_load(&loaded, "test_v2.rec") == SD_SUCCESS);
+    CU_ASSERT(loaded.move_count == src.move_count);
+    for(unsigned i = 0; i < src.move_count && i < loaded.move_count; i++) {
+        CU_ASSERT(loaded.moves[i].tick == src.moves[i].tick);
+        CU_ASSERT(loaded.moves[i].lookup_id == src.moves[i].lookup_id);
+        CU_ASSERT(loaded.moves[i].player_id == src.moves[i].player_id);
+        CU_ASSERT(loaded.moves[i].action == src.moves[i].action);
+        int unknown_len = sd_rec_extra_len(src.moves[i].lookup_id) - 1;
+        if(unknown_len > 0) {
+            CU_ASSERT(loaded.moves[i].raw_action == src.moves[i].raw_action);
+            CU_ASSERT(memcmp(loaded.moves[i].extra_data, src.moves[i].extra_data, unknown_len) == 0);
+        }
+    }
+
+    // Header
+    for(int i = 0; i < 2; i++) {
+        CU_ASSERT_STRING_EQUAL(loaded.pilots[i].info.name, src.pilots[i].info.name);
+        CU_ASSERT(loaded.pilots[i].info.har_id == src.pilots[i].info.har_id);
+        CU_ASSERT(loaded.pilots[i].unknown_b == src.pilots[i].unknown_b);
+        CU_ASSERT(memcmp(&loaded.pilots[i].info.palette, &src.pilots[i].info.palette, 48 * 3) == 0);
+        CU_ASSERT((loaded.pilots[i].info.photo == NULL) == (src.pilots[i].info.photo == NULL));
+        for(int m = 0; m < 10; m++) {
+            CU_ASSERT((loaded.pilots[i].info.quotes[m] == NULL) == (src.pilots[i].info.quotes[m] == NULL));
+        }
+    }
+    CU_ASSERT(loaded.arena_id == src.arena_id);
+    CU_ASSERT(loaded.vitality == src.vitality);
+    CU_ASSERT(loaded.round_type == src.round_type);
+    CU_ASSERT(loaded.p2_controller_ == src.p2_controller_);
+    CU_ASSERT(loaded.unknown_m == src.unknown_m);
+
+    // And back to the legacy format
+    CU_ASSERT(sd_rec_save(&loaded, "test_v1.rec") == SD_SUCCESS);
+    CU_ASSERT(file_size("test_v1.rec") == file_size(TESTS_ROOT_DIR "/recs/crystal-shirro.rec"));
+
+    sd_rec_free(&loaded);
+    sd_rec_free(&src);
+}
+
+void test_rec2_stream(void) {
+    sd_rec_file r, loaded;
+    sd_rec_move mv;
+    CU_ASSERT(sd_rec_create(&r) == SD_SUCCESS);
+    r.hit_pause = 7;
+
+    // Enough moves for several blocks, with a keyframe in between
+    sd_rec2_writer *writer = sd_rec2_writer_open(&r, "test_v2_stream.rec");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(writer);
+    for(unsigned i = 0; i < 20000; i++) {
+        make_move(&mv, i / 2, i % 2, (i % 7) ? SD_ACT_RIGHT | SD_ACT_PUNCH : SD_ACT_NONE);
+        CU_ASSERT(sd_rec2_writer_add(writer, &mv, 1) == SD_SUCCESS);
+        if(i == 999) {
+            CU_ASSERT(sd_rec2_writer_keyframe(writer, 500, "state", 6) == SD_SUCCESS);
+        }
+    }
+    CU_ASSERT(sd_rec2_writer_flush(writer) == SD_SUCCESS);
+
+    // Flushed moves can be read while the writer is still open
+    CU_ASSERT(sd_rec_create(&loaded) == SD_SUCCESS);
+    CU_ASSERT(sd_rec_load(&loaded, "test_v2_stream.rec") == SD_SUCCESS);
+    CU_ASSERT(loaded.move_count == 20000);
+    CU_ASSERT(loaded.hit_pause == 7);
+    sd_rec_free(&loaded);
+    CU_ASSERT(sd_rec2_writer_close(writer) == SD_SUCCESS);
+
+    CU_ASSERT(sd_rec_create(&loaded) == SD_SUCCESS);
+    int error;
+    sd_rec2_reader *reader = sd_rec2_reader_open(&loaded, "test_v2_stream.rec", &error);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(reader);
+    CU_ASSERT(error == SD_SUCCESS);
+    sd_rec2_keyframe keyframe;
+    sd_rec2_item item;
+    unsigned moves = 0;
+    int keyframes = 0;
+    while((item = sd_rec2_reader_next(reader, &mv, &keyframe)) != SD_REC2_END) {
+        if(item == SD_REC2_KEYFRAME) {
+            CU_ASSERT(moves == 1000);
+            CU_ASSERT(keyframe.tick == 500);
+            CU_ASSERT(keyframe.len == 6);
+            CU_ASSERT_STRING_EQUAL(keyframe.data, "state");
+            omf_free(keyframe.data);
+            keyframes++;
+            continue;
+        }
+        CU_ASSERT(mv.tick == moves / 2);
+        CU_ASSERT(mv.player_id == moves % 2);
+        CU_ASSERT(mv.action == ((moves % 7) ? (SD_ACT_RIGHT | SD_ACT_PUNCH) : SD_ACT_NONE));
+        moves++;
+    }
+    CU_ASSERT(moves == 20000);
+    CU_ASSERT(keyframes == 1);
+    sd_rec2_reader_close(reader);
+    sd_rec_free(&loaded);
+    sd_rec_free(&r);
+
+    // A recording that was cut short loads up to the last whole block
+    long size = file_size("test_v2_stream.rec");
+    FILE *f = fopen("test_v2_stream.rec", "r+b");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(f);
+    char *buf = malloc(size);
+    CU_ASSERT(fread(buf, 1, size, f) == (size_t)size);
+    fclose(f);
+    f = fopen("test_v2_stream.rec", "wb");
+    fwrite(buf, 1, size - 3, f);
+    fclose(f);
+    free(buf);
+    CU_ASSERT(sd_rec_create(&loaded) == SD_SUCCESS);
+    CU_ASSERT(sd_rec_load(&loaded, "test_v2_stream.rec") == SD_SUCCESS);
+    CU_ASSERT(loaded.move_count > 0 && loaded.move_count < 20000);
+    sd_rec_free(&loaded);
+}
+
+// Overwrites the raw length of the first chunk, the header
+static void patch_header_len(const char *filename, uint32_t raw_len) {
+    FILE *f = fopen(filename, "r+b");
+    CU_ASSERT_PTR_NOT_NULL_FATAL(f);
+    fseek(f, 4 + 1 + 1, SEEK_SET);
+    uint8_t buf[4] = {raw_len & 0xFF, (raw_len >> 8) & 0xFF, (raw_len >> 16) & 0xFF, raw_len >> 24};
+    fwrite(buf, 1, sizeof(buf), f);
+    fclose(f);
+}
+
+void test_rec2_damaged_length(void) {
+    sd_rec_file src, loaded;
+    CU_ASSERT(sd_rec_create(&src) == SD_SUCCESS);
+    CU_ASSERT(sd_rec_load(&src, TESTS_ROOT_DIR "/recs/crystal-shirro.rec") == SD_SUCCESS);
+    CU_ASSERT(sd_rec2_save(&src, "test_v2_damaged.rec") == SD_SUCCESS);
+    sd_rec_free(&src);
+
+    // Lengths no chunk can have are refused before anything is allocated for them
+    uint32_t lengths[] = {0xFFFFFFF0u, 17 * 1024 * 1024, 1024 * 1024};
+    for(unsigned i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+        patch_header_len("test_v2_damaged.rec", lengths[i]);
+        CU_ASSERT(sd_rec_create(&loaded) == SD_SUCCESS);
+        CU_ASSERT(sd_rec_load(&loaded, "test_v2_damaged.rec") == SD_FILE_PARSE_ERROR);
+        sd_rec_free(&loaded);
+    }
+}
+
 void rec_test_suite(CU_pSuite suite) {
     if(CU_add_test(suite, "test of sd_rec_create", test_sd_rec_create) == NULL) {
         return;
@@ -83,4 +361,22 @@ void rec_test_suite(CU_pSuite suite) {
     if(CU_add_test(suite, "test loading crystal-shirro.rec", test_crystal_shirro_load) == NULL) {
         return;
     }
+    if(CU_add_test(suite, "test of sd_rec_insert_actions", test_rec_insert_actions) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of REC streaming", test_rec_stream) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of sd_rec_copy", test_rec_copy) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of compact REC roundtripping", test_rec2_roundtrip) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of compact REC chunk lengths", test_rec2_damaged_length) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "test of compact REC streaming", test_rec2_stream) == NULL) {
+        return;
+    }
 }
@@ -0,0 +1,58 @@
+#include "game/utils/render_queue.h"
+#include <CUnit/Basic.h>
+#include <CUnit/CUnit.h>
+#include <string.h>
+
+static void add_cmd(render_queue *queue, render_slot slot, int x) {
+    video_draw_cmd cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.dst.x = x;
+    render_queue_add(queue, slot, &cmd, 1);
+}
+
+void test_render_queue_sort(void) {
+    render_queue queue;
+    render_queue_create(&queue);
+
+    // Enough commands to make the queue grow a few times
+    for(int i = 0; i < 300; i++) {
+        add_cmd(&queue, RENDER_SLOT_COUNT - 1 - (i % RENDER_SLOT_COUNT), i);
+    }
+    CU_ASSERT_EQUAL_FATAL(queue.count, 300);
+
+    // Slots come out in order, and commands keep their order within a slot
+    const video_draw_cmd *cmds = render_queue_sort(&queue);
+    int prev = -1;
+    int prev_slot = -1;
+    for(int i = 0; i < queue.count; i++) {
+        int slot = RENDER_SLOT_COUNT - 1 - (cmds[i].dst.x % RENDER_SLOT_COUNT);
+        CU_ASSERT(slot >= prev_slot);
+        if(slot == prev_slot) {
+            CU_ASSERT(cmds[i].dst.x > prev);
+        }
+        prev_slot = slot;
+        prev = cmds[i].dst.x;
+    }
+
+    // Clearing keeps the memory
+    render_queue_clear(&queue);
+    CU_ASSERT_EQUAL(queue.count, 0);
+    add_cmd(&queue, RENDER_SLOT_TOP, 1);
+    add_cmd(&queue, RENDER_SLOT_SHADOWS, 2);
+    add_cmd(&queue, RENDER_SLOT_ACTIVE_HAR1, 3);
+    add_cmd(&queue, RENDER_SLOT_BOTTOM, 4);
+    cmds = render_queue_sort(&queue);
+    CU_ASSERT_EQUAL(cmds[0].dst.x, 4);
+    CU_ASSERT_EQUAL(cmds[1].dst.x, 2);
+    CU_ASSERT_EQUAL(cmds[2].dst.x, 3);
+    CU_ASSERT_EQUAL(cmds[3].dst.x, 1);
+
+    render_queue_free(&queue);
+    CU_ASSERT_PTR_NULL(queue.cmds);
+}
+
+void render_queue_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "Test for render queue sorting", test_render_queue_sort) == NULL) {
+        return;
+    }
+}
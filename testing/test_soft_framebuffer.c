@@ -0,0 +1,100 @@
+#include "video/enums.h"
+#include "video/soft_framebuffer.h"
+#include <CUnit/Basic.h>
+#include <CUnit/CUnit.h>
+
+#define FB_W 8
+#define FB_H 4
+
+static void draw_sprite(soft_framebuffer *fb, const surface *sur, int x, int y, int remap_offset, int remap_rounds,
+                        int palette_offset, unsigned int flip_mode, unsigned int options) {
+    SDL_Rect dst = {x, y, sur->w, sur->h};
+    soft_framebuffer_draw(fb, sur, &dst, remap_offset, remap_rounds, palette_offset, 255, 255, flip_mode, options);
+}
+
+void test_soft_framebuffer_draw(void) {
+    const unsigned char data[] = {0, 5, 6, 7};
+    unsigned char out[FB_W * FB_H];
+    soft_framebuffer fb;
+    surface sur;
+    vga_state *vga = vga_state_create();
+    soft_framebuffer_create(&fb, FB_W, FB_H);
+    surface_create_from_data(&sur, 2, 2, data);
+
+    // Transparent pixels are skipped, and flipping mirrors the sprite
+    draw_sprite(&fb, &sur, 0, 0, 0, 0, 0, FLIP_NONE, 0);
+    draw_sprite(&fb, &sur, 2, 0, 0, 0, 0, FLIP_HORIZONTAL, 0);
+    draw_sprite(&fb, &sur, 7, 3, 0, 0, 0, FLIP_NONE, 0); // clipped
+    soft_framebuffer_resolve(&fb, vga, 0, 0, out);
+    CU_ASSERT_EQUAL(out[0], 0);
+    CU_ASSERT_EQUAL(out[1], 5);
+    CU_ASSERT_EQUAL(out[FB_W + 0], 6);
+    CU_ASSERT_EQUAL(out[FB_W + 1], 7);
+    CU_ASSERT_EQUAL(out[2], 5);
+    CU_ASSERT_EQUAL(out[3], 0);
+    CU_ASSERT_EQUAL(out[FB_W + 2], 7);
+    CU_ASSERT_EQUAL(out[FB_W + 3], 6);
+    CU_ASSERT_EQUAL(out[FB_W * 3 + 7], 0);
+
+    // Palette offset, and indexes added on top
+    const unsigned char add_data[] = {0, 1};
+    surface add_sur;
+    surface_create_from_data(&add_sur, 2, 1, add_data);
+    soft_framebuffer_clear(&fb);
+    draw_sprite(&fb, &sur, 0, 0, 0, 0, 10, FLIP_NONE, 0);
+    draw_sprite(&fb, &add_sur, 0, 0, 0, 0, 0, FLIP_NONE, SPRITE_INDEX_ADD);
+    soft_framebuffer_resolve(&fb, vga, 0, 0, out);
+    CU_ASSERT_EQUAL(out[0], 0);
+    CU_ASSERT_EQUAL(out[1], 15 + 60);
+    CU_ASSERT_EQUAL(out[FB_W + 0], 16);
+
+    surface_free(&add_sur);
+    surface_free(&sur);
+    soft_framebuffer_free(&fb);
+    vga_state_free(&vga);
+}
+
+void test_soft_framebuffer_remap(void) {
+    const unsigned char base[] = {10, 10};
+    const unsigned char shadow[] = {1, 0};
+    unsigned char out[FB_W * FB_H];
+    vga_remap_tables remaps;
+    soft_framebuffer fb;
+    surface base_sur, shadow_sur;
+    vga_state *vga = vga_state_create();
+    soft_framebuffer_create(&fb, FB_W, FB_H);
+    surface_create_from_data(&base_sur, 2, 1, base);
+    surface_create_from_data(&shadow_sur, 2, 1, shadow);
+
+    vga_remaps_init(&remaps);
+    for(int i = 0; i < 256; i++) {
+        remaps.tables[3].data[i] = i / 2;
+    }
+    vga_state_set_remaps_from(vga, &remaps);
+
+    // Remap sprites apply their table to what is already in the framebuffer, at resolve
+    draw_sprite(&fb, &base_sur, 0, 0, 0, 0, 0, FLIP_NONE, 0);
+    draw_sprite(&fb, &shadow_sur, 0, 0, 2, 2, 0, FLIP_NONE, 0);
+    soft_framebuffer_resolve(&fb, vga, 0, 0, out);
+    CU_ASSERT_EQUAL(out[0], 2);
+    CU_ASSERT_EQUAL(out[1], 10);
+
+    // Screen shake moves the whole frame
+    soft_framebuffer_resolve(&fb, vga, 1, 0, out);
+    CU_ASSERT_EQUAL(out[0], 0);
+    CU_ASSERT_EQUAL(out[1], 2);
+
+    surface_free(&base_sur);
+    surface_free(&shadow_sur);
+    soft_framebuffer_free(&fb);
+    vga_state_free(&vga);
+}
+
+void soft_framebuffer_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "Test for drawing sprites", test_soft_framebuffer_draw) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for remapping sprites", test_soft_framebuffer_remap) == NULL) {
+        return;
+    }
+}
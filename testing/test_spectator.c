@@ -0,0 +1,140 @@
+#include "game/utils/spectator.h"
+#include <CUnit/Basic.h>
+#include <CUnit/CUnit.h>
+#include <string.h>
+
+void test_spectator_header(void) {
+    sd_rec_file src, dst;
+    sd_rec_create(&src);
+    sd_rec_create(&dst);
+    for(int i = 0; i < 2; i++) {
+        strncpy(src.pilots[i].info.name, i == 0 ? "Crystal" : "Shirro", sizeof(src.pilots[i].info.name) - 1);
+        src.pilots[i].info.pilot_id = 3 + i;
+        src.pilots[i].info.har_id = 7 - i;
+        src.pilots[i].info.color_1 = 10 + i;
+        src.pilots[i].info.power = 5;
+        src.pilots[i].info.stun_resistance = 2 + i;
+        src.scores[i] = 100000 * (i + 1);
+    }
+    src.game_mode = 2;
+    src.vitality = 150;
+    src.p2_controller = REC_CONTROLLER_NETWORK;
+    src.arena_id = 4;
+    src.power[1] = 7;
+    src.hazards = 1;
+    src.round_type = 2;
+    src.hyper_mode = 1;
+    src.seed = 0xDEADBEEF;
+
+    serial ser;
+    serial_create(&ser);
+    spectator_write_header(&ser, &src);
+    serial_read_reset(&ser);
+    spectator_read_header(&ser, &dst);
+    CU_ASSERT_EQUAL(ser.rpos, serial_len(&ser));
+    serial_free(&ser);
+
+    for(int i = 0; i < 2; i++) {
+        CU_ASSERT_STRING_EQUAL(dst.pilots[i].info.name, src.pilots[i].info.name);
+        CU_ASSERT_EQUAL(dst.pilots[i].info.pilot_id, src.pilots[i].info.pilot_id);
+        CU_ASSERT_EQUAL(dst.pilots[i].info.har_id, src.pilots[i].info.har_id);
+        CU_ASSERT_EQUAL(dst.pilots[i].info.color_1, src.pilots[i].info.color_1);
+        CU_ASSERT_EQUAL(dst.pilots[i].info.power, src.pilots[i].info.power);
+        CU_ASSERT_EQUAL(dst.pilots[i].info.stun_resistance, src.pilots[i].info.stun_resistance);
+        CU_ASSERT_EQUAL(dst.scores[i], src.scores[i]);
+    }
+    CU_ASSERT_EQUAL(dst.game_mode, src.game_mode);
+    CU_ASSERT_EQUAL(dst.vitality, src.vitality);
+    CU_ASSERT_EQUAL(dst.p2_controller, src.p2_controller);
+    CU_ASSERT_EQUAL(dst.arena_id, src.arena_id);
+    CU_ASSERT_EQUAL(dst.power[1], src.power[1]);
+    CU_ASSERT_EQUAL(dst.hazards, src.hazards);
+    CU_ASSERT_EQUAL(dst.round_type, src.round_type);
+    CU_ASSERT_EQUAL(dst.hyper_mode, src.hyper_mode);
+    CU_ASSERT_EQUAL(dst.seed, src.seed);
+
+    sd_rec_free(&src);
+    sd_rec_free(&dst);
+}
+
+void test_spectator_moves(void) {
+    sd_rec_move moves[3];
+    memset(moves, 0, sizeof(moves));
+    moves[0].tick = 0;
+    moves[0].action = SD_ACT_PUNCH | SD_ACT_UP;
+    moves[1].tick = 70000;
+    moves[1].player_id = 1;
+    moves[1].action = SD_ACT_KICK | SD_ACT_LEFT;
+    moves[2].tick = 70001;
+    moves[2].action = SD_ACT_NONE;
+
+    serial ser;
+    serial_create(&ser);
+    for(int i = 0; i < 3; i++) {
+        moves[i].lookup_id = 2;
+        spectator_write_move(&ser, &moves[i]);
+    }
+    CU_ASSERT_EQUAL(serial_len(&ser), 3 * 6);
+    serial_read_reset(&ser);
+    for(int i = 0; i < 3; i++) {
+        sd_rec_move move;
+        spectator_read_move(&ser, &move);
+        CU_ASSERT_EQUAL(move.tick, moves[i].tick);
+        CU_ASSERT_EQUAL(move.lookup_id, 2);
+        CU_ASSERT_EQUAL(move.player_id, moves[i].player_id);
+        CU_ASSERT_EQUAL(move.action, moves[i].action);
+        CU_ASSERT_PTR_NULL(move.extra_data);
+    }
+    serial_free(&ser);
+}
+
+void test_spectator_packet_length(void) {
+    sd_rec_file rec;
+    sd_rec_create(&rec);
+    serial ser;
+    serial_create(&ser);
+
+    // A match header is only taken whole
+    serial_write_int8(&ser, 1);
+    spectator_write_header(&ser, &rec);
+    CU_ASSERT_TRUE(spectator_packet_is_valid(ser.data, serial_len(&ser)));
+    CU_ASSERT_FALSE(spectator_packet_is_valid(ser.data, serial_len(&ser) - 1));
+    CU_ASSERT_FALSE(spectator_packet_is_valid(ser.data, 1));
+    serial_free(&ser);
+
+    // Moves need the watermark, and whole moves after it
+    sd_rec_move move;
+    memset(&move, 0, sizeof(move));
+    serial_create(&ser);
+    serial_write_int8(&ser, 2);
+    serial_write_uint32(&ser, 100);
+    CU_ASSERT_TRUE(spectator_packet_is_valid(ser.data, serial_len(&ser)));
+    spectator_write_move(&ser, &move);
+    spectator_write_move(&ser, &move);
+    CU_ASSERT_TRUE(spectator_packet_is_valid(ser.data, serial_len(&ser)));
+    for(size_t len = 1; len < serial_len(&ser); len++) {
+        if(len != 1 + 4 && len != 1 + 4 + 6) {
+            CU_ASSERT_FALSE(spectator_packet_is_valid(ser.data, len));
+        }
+    }
+    serial_free(&ser);
+
+    // Empty and unknown packets
+    CU_ASSERT_FALSE(spectator_packet_is_valid("", 0));
+    CU_ASSERT_FALSE(spectator_packet_is_valid("\x7f", 1));
+    CU_ASSERT_TRUE(spectator_packet_is_valid("\x03", 1));
+
+    sd_rec_free(&rec);
+}
+
+void spectator_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "Test for spectator match header", test_spectator_header) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for spectator moves", test_spectator_moves) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for spectator packet lengths", test_spectator_packet_length) == NULL) {
+        return;
+    }
+}
@@ -0,0 +1,60 @@
+#include "video/surface.h"
+#include <CUnit/Basic.h>
+#include <CUnit/CUnit.h>
+
+void test_surface_interned(void) {
+    const unsigned char data_a[] = {1, 2, 3, 4, 5, 6};
+    const unsigned char data_b[] = {1, 2, 3, 4, 5, 7};
+    surface_intern_stats stats;
+    surface a1, a2, b, wide, copy;
+
+    // Same content shares the pixels and the guid; different content or size does not
+    surface_create_interned(&a1, 3, 2, data_a);
+    surface_create_interned(&a2, 3, 2, data_a);
+    surface_create_interned(&b, 3, 2, data_b);
+    surface_create_interned(&wide, 6, 1, data_a);
+    CU_ASSERT_PTR_EQUAL(a1.data, a2.data);
+    CU_ASSERT_EQUAL(a1.guid, a2.guid);
+    CU_ASSERT_PTR_NOT_EQUAL(a1.data, b.data);
+    CU_ASSERT_NOT_EQUAL(a1.guid, b.guid);
+    CU_ASSERT_PTR_NOT_EQUAL(a1.data, wide.data);
+
+    // Copies share too
+    surface_create_from(&copy, &a1);
+    CU_ASSERT_PTR_EQUAL(copy.data, a1.data);
+    surface_get_intern_stats(&stats);
+    CU_ASSERT_EQUAL(stats.buffers, 3);
+    CU_ASSERT_EQUAL(stats.surfaces, 5);
+    CU_ASSERT_EQUAL(stats.bytes, 18);
+    CU_ASSERT_EQUAL(stats.bytes_saved, 12);
+
+    // Modifying a surface gives it a copy of its own
+    surface_flatten_to_mask(&copy, 9);
+    CU_ASSERT_PTR_NULL(copy.shared);
+    CU_ASSERT_PTR_NOT_EQUAL(copy.data, a1.data);
+    CU_ASSERT_NOT_EQUAL(copy.guid, a1.guid);
+    CU_ASSERT_EQUAL(copy.data[5], 9);
+    CU_ASSERT_EQUAL(a1.data[5], 6);
+    surface_get_intern_stats(&stats);
+    CU_ASSERT_EQUAL(stats.surfaces, 4);
+    CU_ASSERT_EQUAL(stats.bytes_saved, 6);
+
+    // Buffers go away with their last surface
+    surface_free(&copy);
+    surface_free(&a1);
+    CU_ASSERT_EQUAL(a2.data[0], 1);
+    surface_free(&a2);
+    surface_free(&b);
+    surface_free(&wide);
+    surface_get_intern_stats(&stats);
+    CU_ASSERT_EQUAL(stats.buffers, 0);
+    CU_ASSERT_EQUAL(stats.surfaces, 0);
+    CU_ASSERT_EQUAL(stats.bytes, 0);
+    CU_ASSERT_EQUAL(stats.bytes_saved, 0);
+}
+
+void surface_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "Test for interned surfaces", test_surface_interned) == NULL) {
+        return;
+    }
+}
@@ -0,0 +1,131 @@
+#include "utils/log.h"
+#include "utils/task_graph.h"
+#include <CUnit/Basic.h>
+#include <CUnit/CUnit.h>
+#include <SDL.h>
+
+typedef struct test_task {
+    int id;
+    bool fail;
+    bool closed;
+    int *order;
+    SDL_atomic_t *step;
+    int *close_order;
+    int *closes;
+} test_task;
+
+static bool run_test_task(void *userdata) {
+    test_task *t = userdata;
+    t->order[t->id] = SDL_AtomicAdd(t->step, 1);
+    return !t->fail;
+}
+
+static void close_test_task(void *userdata) {
+    test_task *t = userdata;
+    t->closed = true;
+    t->close_order[(*t->closes)++] = t->id;
+}
+
+static void add_tasks(task_graph *graph, test_task *tasks, int fail_id, int *order, SDL_atomic_t *step,
+                      int *close_order, int *closes) {
+    // 0 (main) <- 2; 1 <- 3 (main) <- 4; 1 and 2 <- 5
+    unsigned int deps[6] = {0, 0, TASK_DEP(0), TASK_DEP(1), TASK_DEP(3), TASK_DEP(1) | TASK_DEP(2)};
+    bool main_thread[6] = {true, false, false, true, false, false};
+    task_graph_create(graph);
+    for(int i = 0; i < 6; i++) {
+        tasks[i] = (test_task){i, i == fail_id, false, order, step, close_order, closes};
+        order[i] = -1;
+        int id = task_graph_add(graph, "test", run_test_task, close_test_task, &tasks[i], deps[i], main_thread[i]);
+        CU_ASSERT_EQUAL(id, i);
+    }
+}
+
+void test_task_graph_run(void) {
+    log_init();
+    for(int workers = 0; workers < 4; workers++) {
+        task_graph graph;
+        test_task tasks[6];
+        int order[6], close_order[6], closes = 0;
+        SDL_atomic_t step = {0};
+        add_tasks(&graph, tasks, -1, order, &step, close_order, &closes);
+        CU_ASSERT(task_graph_run(&graph, workers));
+
+        // Everything ran, and after its dependencies
+        for(int i = 0; i < 6; i++) {
+            CU_ASSERT(order[i] >= 0);
+        }
+        CU_ASSERT(order[2] > order[0]);
+        CU_ASSERT(order[3] > order[1]);
+        CU_ASSERT(order[4] > order[3]);
+        CU_ASSERT(order[5] > order[1]);
+        CU_ASSERT(order[5] > order[2]);
+
+        task_graph_log_profile(&graph, "Test");
+
+        // Closed in reverse order
+        task_graph_close(&graph);
+        CU_ASSERT_EQUAL_FATAL(closes, 6);
+        for(int i = 0; i < 6; i++) {
+            CU_ASSERT_EQUAL(close_order[i], 5 - i);
+        }
+    }
+    log_close();
+}
+
+void test_task_graph_failure(void) {
+    task_graph graph;
+    test_task tasks[6];
+    int order[6], close_order[6], closes = 0;
+    SDL_atomic_t step = {0};
+    log_init();
+
+    // Task 0 fails, so task 2 and 5 that depend on it never run. The rest may or may not have started.
+    add_tasks(&graph, tasks, 0, order, &step, close_order, &closes);
+    CU_ASSERT_FALSE(task_graph_run(&graph, 2));
+    CU_ASSERT_EQUAL(graph.tasks[0].state, TASK_FAILED);
+    CU_ASSERT_EQUAL(order[2], -1);
+    CU_ASSERT_EQUAL(order[5], -1);
+    CU_ASSERT_EQUAL(graph.tasks[2].state, TASK_SKIPPED);
+
+    // Only the tasks that succeeded are closed
+    task_graph_close(&graph);
+    for(int i = 0; i < 6; i++) {
+        CU_ASSERT_EQUAL(tasks[i].closed, order[i] >= 0 && i != 0);
+    }
+    log_close();
+}
+
+static bool run_nothing(void *userdata) {
+    return true;
+}
+
+void test_task_graph_profile_ties(void) {
+    log_init();
+    // Main thread tasks that took no time, and so start and end at the same counter value
+    task_graph graph;
+    task_graph_create(&graph);
+    for(int i = 0; i < 3; i++) {
+        task_graph_add(&graph, "instant", run_nothing, NULL, NULL, 0, true);
+        graph.tasks[i].state = TASK_DONE;
+        graph.tasks[i].start = 1000;
+        graph.tasks[i].end = 1000;
+    }
+    graph.start = 1000;
+    graph.end = 1000;
+
+    // None counts as waiting for another, so the walk ends after the first
+    task_graph_log_profile(&graph, "Test");
+    log_close();
+}
+
+void task_graph_test_suite(CU_pSuite suite) {
+    if(CU_add_test(suite, "Test for task graph ordering", test_task_graph_run) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for task graph failure", test_task_graph_failure) == NULL) {
+        return;
+    }
+    if(CU_add_test(suite, "Test for task graph profile with tied tasks", test_task_graph_profile_ties) == NULL) {
+        return;
+    }
+}
@@ -55,6 +55,35 @@ void test_sd_trn_roundtripping(void) {
     sd_tournament_free(&l_trn);
 }
 
+void test_sd_trn_load_summary(void) {
+    sd_tournament_file n_trn;
+    sd_tournament_file l_trn;
+
+    CU_ASSERT(sd_tournament_create(&n_trn) == SD_SUCCESS);
+    CU_ASSERT(sd_tournament_create(&l_trn) == SD_SUCCESS);
+
+    n_trn.registration_fee = 1000;
+    n_trn.tournament_id = 2;
+    sd_tournament_set_bk_name(&n_trn, "test.bk");
+    sd_tournament_set_pic_name(&n_trn, "pilots.pic");
+    n_trn.enemies[0] = omf_calloc(1, sizeof(sd_pilot));
+    n_trn.enemy_count = 1;
+
+    CU_ASSERT(sd_tournament_save(&n_trn, "test.trn") == SD_SUCCESS);
+    CU_ASSERT(sd_tournament_load_summary(&l_trn, "test.trn") == SD_SUCCESS);
+
+    // Header fields are there, enemy pilots are not
+    CU_ASSERT(n_trn.enemy_count == l_trn.enemy_count);
+    CU_ASSERT(n_trn.registration_fee == l_trn.registration_fee);
+    CU_ASSERT(n_trn.tournament_id == l_trn.tournament_id);
+    CU_ASSERT_STRING_EQUAL(n_trn.pic_file, l_trn.pic_file);
+    CU_ASSERT_PTR_NOT_NULL(l_trn.locales[0]);
+    CU_ASSERT_PTR_NULL(l_trn.enemies[0]);
+
+    sd_tournament_free(&n_trn);
+    sd_tournament_free(&l_trn);
+}
+
 void test_sd_trn_free(void) {
     sd_tournament_free(&trn);
 }
@@ -66,6 +95,9 @@ void trn_test_suite(CU_pSuite suite) {
     if(CU_add_test(suite, "test roundtripping", test_sd_trn_roundtripping) == NULL) {
         return;
     }
+    if(CU_add_test(suite, "test of sd_trn_load_summary", test_sd_trn_load_summary) == NULL) {
+        return;
+    }
     if(CU_add_test(suite, "test of sd_trn_free", test_sd_trn_free) == NULL) {
         return;
     }
@@ -0,0 +1,180 @@
+/** @file main.c
+ * @brief Micro-benchmarks
+ * @details Times hot paths of the core library on synthetic data, so that optimizations can be checked again
+ *          on any machine. These are kept out of the unit tests, as their results depend on the machine and
+ *          they take a while to run.
+ * @license MIT
+ */
+
+#include "../shared/headless.h"
+#include "utils/c_array_util.h"
+#include "utils/hashmap.h"
+#include "video/damage_tracker.h"
+#include "video/vga_palette.h"
+#include "video/vga_state.h"
+#include <SDL.h>
+#if defined(ARGTABLE2_FOUND)
+#include <argtable2.h>
+#elif defined(ARGTABLE3_FOUND)
+#include <argtable3.h>
+#endif
+#include <stdio.h>
+#include <string.h>
+
+#define HASHMAP_KEYS 100000
+#define HASHMAP_ROUNDS 10
+#define PALETTE_ROUNDS 100000
+
+typedef struct benchmark {
+    const char *name;
+    bool (*run)(void);
+} benchmark;
+
+static double bench_seconds(uint64_t start) {
+    return (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+}
+
+static bool bench_hashmap(void) {
+    hashmap map;
+    hashmap_create(&map);
+
+    // Keys laid out like the recording lookup table, tick * 10 + slot
+    uint64_t start = SDL_GetPerformanceCounter();
+    for(unsigned int i = 0; i < HASHMAP_KEYS; i++) {
+        hashmap_put_int(&map, i * 10, &i, sizeof(unsigned int));
+    }
+    double put_time = bench_seconds(start);
+
+    // Half of the lookups miss, as they do when probing for moves on ticks without any
+    unsigned int found = 0;
+    void *val;
+    start = SDL_GetPerformanceCounter();
+    for(int r = 0; r < HASHMAP_ROUNDS; r++) {
+        for(unsigned int i = 0; i < HASHMAP_KEYS * 2; i++) {
+            found += hashmap_get_int(&map, i * 5, &val, NULL) == 0;
+        }
+    }
+    double get_time = bench_seconds(start);
+
+    start = SDL_GetPerformanceCounter();
+    for(unsigned int i = 0; i < HASHMAP_KEYS; i++) {
+        hashmap_put_str(&map, "key", &i, sizeof(unsigned int));
+        hashmap_get_str(&map, "key", &val, NULL);
+    }
+    double str_time = bench_seconds(start);
+
+    printf("hashmap: put %.1f Mops/s, get %.1f Mops/s, string put+get %.1f Mops/s\n", HASHMAP_KEYS / put_time / 1e6,
+           HASHMAP_KEYS * 2.0 * HASHMAP_ROUNDS / get_time / 1e6, HASHMAP_KEYS / str_time / 1e6);
+    hashmap_free(&map);
+    return found == HASHMAP_KEYS * HASHMAP_ROUNDS;
+}
+
+typedef struct {
+    int player;
+    uint8_t step;
+} flash;
+
+// HAR-style flash on the colors of one player
+static void flash_transform(damage_tracker *damage, vga_palette *pal, void *userdata) {
+    flash *f = userdata;
+    vga_palette_mix_range(pal, 0, 48 * f->player + 1, 48 * f->player + 48, f->step);
+    damage_set_range(damage, 48 * f->player + 1, 48 * f->player + 48);
+}
+
+static bool bench_palette(void) {
+    vga_palette pal;
+    for(int i = 0; i < 256; i++) {
+        pal.colors[i].r = i;
+        pal.colors[i].g = 255 - i;
+        pal.colors[i].b = 128;
+    }
+
+    // A full pass of the mixing kernel, the largest a transform does
+    uint64_t start = SDL_GetPerformanceCounter();
+    for(int i = 0; i < PALETTE_ROUNDS; i++) {
+        vga_palette_mix_range(&pal, 0, 1, 255, i);
+    }
+    double mix_time = bench_seconds(start);
+
+    // Both HARs flashing and holding, as the renderer sees it every tick
+    flash f[2] = {
+        {0, 200},
+        {1, 200},
+    };
+    unsigned int uploads = 0;
+    vga_palette *dirty;
+    vga_index first, last;
+    vga_state *vga = vga_state_create();
+    vga_state_set_base_palette_from(vga, &pal);
+    start = SDL_GetPerformanceCounter();
+    for(int i = 0; i < PALETTE_ROUNDS; i++) {
+        vga_state_enable_palette_transform(vga, flash_transform, &f[0]);
+        vga_state_enable_palette_transform(vga, flash_transform, &f[1]);
+        vga_state_render(vga);
+        uploads += vga_state_is_palette_dirty(vga, &dirty, &first, &last);
+        vga_state_mark_palette_flushed(vga);
+    }
+    double render_time = bench_seconds(start);
+    vga_state_free(&vga);
+
+    printf("palette: %.2f us per 255 color mix, %.2f us per render, %u uploads in %d renders\n",
+           mix_time * 1e6 / PALETTE_ROUNDS, render_time * 1e6 / PALETTE_ROUNDS, uploads, PALETTE_ROUNDS);
+    return uploads == 1;
+}
+
+static const benchmark benchmarks[] = {
+    {"hashmap", bench_hashmap},
+    {"palette", bench_palette},
+};
+
+int main(int argc, char *argv[]) {
+    struct arg_lit *help = arg_lit0("h", "help", "print this help and exit");
+    struct arg_lit *vers = arg_lit0("v", "version", "print version information and exit");
+    struct arg_str *names = arg_strn("b", "bench", "<name>", 0, 16, "Benchmark to run (default: all)");
+    struct arg_lit *list = arg_lit0("l", "list", "list the benchmarks and exit");
+    struct arg_end *end = arg_end(20);
+    void *argtable[] = {help, vers, names, list, end};
+    int ret;
+    if(!headless_parse_args(argc, argv, argtable, N_ELEMENTS(argtable), "benchtool",
+                            "Micro-benchmarks for OpenOMF.", &ret)) {
+        goto exit_0;
+    }
+
+    if(list->count > 0) {
+        for(unsigned int i = 0; i < N_ELEMENTS(benchmarks); i++) {
+            printf("%s\n", benchmarks[i].name);
+        }
+        ret = 0;
+        goto exit_0;
+    }
+
+    // Unknown names are an error, so that a typo does not look like a passing run
+    for(int n = 0; n < names->count; n++) {
+        unsigned int i = 0;
+        while(i < N_ELEMENTS(benchmarks) && strcmp(benchmarks[i].name, names->sval[n]) != 0) {
+            i++;
+        }
+        if(i == N_ELEMENTS(benchmarks)) {
+            fprintf(stderr, "Error: No benchmark named '%s'.\n", names->sval[n]);
+            ret = 1;
+            goto exit_0;
+        }
+    }
+
+    ret = 0;
+    for(unsigned int i = 0; i < N_ELEMENTS(benchmarks); i++) {
+        bool selected = names->count == 0;
+        for(int n = 0; n < names->count; n++) {
+            selected = selected || strcmp(benchmarks[i].name, names->sval[n]) == 0;
+        }
+        if(selected && !benchmarks[i].run()) {
+            // The results are checked as well, a fast but wrong run does not count
+            fprintf(stderr, "Error: Benchmark '%s' gave wrong results.\n", benchmarks[i].name);
+            ret = 1;
+        }
+    }
+
+exit_0:
+    arg_freetable(argtable, N_ELEMENTS(argtable));
+    return ret;
+}
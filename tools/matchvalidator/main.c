@@ -0,0 +1,243 @@
+/** @file main.c
+ * @brief Headless match validator
+ * @details Replays recorded matches without video or audio, and prints the winner, the final arena state hash
+ *          and per-round statistics for each. Recordings are validated in parallel on a pool of worker threads;
+ *          every replay runs in its own game state and palette state, so results do not depend on thread count.
+ *          With --seek, each replay is also seeked to random ticks through its keyframes, and the arena state
+ *          after every seek is checked against the straight playback. Recordings with assertions that do not
+ *          hold are reported, and do not count as verified.
+ * @license MIT
+ */
+
+#include "../shared/headless.h"
+#include "controller/rec_controller.h"
+#include "game/game_player.h"
+#include "game/game_state.h"
+#include "game/scenes/arena.h"
+#include "game/utils/rec_keyframes.h"
+#include "utils/allocator.h"
+#include "utils/c_array_util.h"
+#include "utils/log.h"
+#include "utils/miscmath.h"
+#include "utils/random.h"
+#include "utils/vector.h"
+#include "video/vga_state.h"
+#include <SDL.h>
+#if defined(ARGTABLE2_FOUND)
+#include <argtable2.h>
+#elif defined(ARGTABLE3_FOUND)
+#include <argtable3.h>
+#endif
+#include <stdio.h>
+#include <string.h>
+
+typedef struct replay_result {
+    const char *filename;
+    bool failed;
+    int winner; // 0 or 1, -1 if the replay hit the tick limit
+    uint32_t ticks;
+    uint32_t hash;
+    int rounds;
+    arena_round_stats round_stats[ARENA_MAX_ROUNDS];
+    int failed_assertions;
+    int seek_mismatches;
+    double seek_avg_ms;
+    double seek_max_ms;
+} replay_result;
+
+typedef struct replay_queue {
+    replay_result *results;
+    int count;
+    uint32_t seed;
+    uint32_t max_ticks;
+    int seeks;
+    SDL_atomic_t next;
+} replay_queue;
+
+// Seeks to random ticks of the finished replay, and compares the arena state against the hashes of the straight run.
+static void run_seeks(replay_result *result, game_state *gs, const vector *hashes, uint32_t seed, int seeks) {
+    struct random_t rand;
+    random_seed(&rand, seed);
+    double total_ms = 0;
+    for(int i = 0; i < seeks; i++) {
+        uint32_t tick = random_int(&rand, vector_size(hashes));
+        uint64_t start = SDL_GetPerformanceCounter();
+        game_state *dst = rec_keyframes_seek(gs->keyframes, gs, tick);
+        double ms = (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+        total_ms += ms;
+        if(ms > result->seek_max_ms) {
+            result->seek_max_ms = ms;
+        }
+        if(dst == NULL || dst->int_tick != tick || arena_state_hash(dst) != *(uint32_t *)vector_get(hashes, tick)) {
+            log_error("%s: seek to tick %u does not match the playback", result->filename, tick);
+            result->seek_mismatches++;
+        }
+        if(dst != NULL) {
+            game_state_clone_free(dst);
+            omf_free(dst);
+        }
+    }
+    result->seek_avg_ms = total_ms / seeks;
+}
+
+static void run_replay(replay_result *result, uint32_t seed, uint32_t max_ticks, int seeks) {
+    engine_init_flags init_flags;
+    memset(&init_flags, 0, sizeof(init_flags));
+    init_flags.speed = 10;
+    init_flags.playback = 1;
+    strncpy(init_flags.rec_file, result->filename, sizeof(init_flags.rec_file) - 1);
+
+    // The legacy generator is per-thread; reseed it so results do not depend on what ran before.
+    rand_seed(seed);
+
+    vga_state *vga = vga_state_create();
+    game_state *gs = omf_calloc(1, sizeof(game_state));
+    if(game_state_create_replay(gs, &init_flags, vga, seed)) {
+        log_error("Unable to replay %s", result->filename);
+        result->failed = true;
+        omf_free(gs);
+        goto exit_0;
+    }
+
+    // Arena state hash for every tick of the playback, indexed by int_tick
+    vector hashes;
+    vector_create(&hashes, sizeof(uint32_t));
+    if(seeks > 0) {
+        game_state_enable_keyframes(gs, REC_KEYFRAME_INTERVAL);
+        uint32_t hash = arena_state_hash(gs);
+        vector_append(&hashes, &hash);
+    }
+
+    // Same tick pattern as the self-play harness; playback input is keyed by tick, not by wall time.
+    result->winner = -1;
+    while(game_state_is_running(gs) && gs->tick < max_ticks) {
+        game_state_static_tick(gs, false);
+        game_state_dynamic_tick(gs, false);
+        if(seeks > 0) {
+            uint32_t hash = arena_state_hash(gs);
+            vector_append(&hashes, &hash);
+        }
+        if((result->winner = arena_is_over(game_state_get_scene(gs))) >= 0) {
+            break;
+        }
+    }
+    result->ticks = gs->tick;
+    result->hash = arena_state_hash(gs);
+    for(int i = 0; i < 2; i++) {
+        controller *ctrl = game_player_get_ctrl(game_state_get_player(gs, i));
+        if(ctrl != NULL && ctrl->type == CTRL_TYPE_REC) {
+            result->failed_assertions += rec_controller_failed_assertions(ctrl);
+        }
+    }
+    result->rounds = arena_get_round_stats(game_state_get_scene(gs), result->round_stats, ARENA_MAX_ROUNDS);
+    if(seeks > 0) {
+        run_seeks(result, gs, &hashes, seed, seeks);
+    }
+    vector_free(&hashes);
+    game_state_free(&gs);
+
+exit_0:
+    vga_state_free(&vga);
+}
+
+static int worker_main(void *userdata) {
+    replay_queue *queue = userdata;
+    int index;
+    while((index = SDL_AtomicAdd(&queue->next, 1)) < queue->count) {
+        run_replay(&queue->results[index], queue->seed, queue->max_ticks, queue->seeks);
+    }
+    return 0;
+}
+
+static int print_results(const replay_queue *queue, double seconds) {
+    uint64_t total_ticks = 0;
+    int unverified = 0;
+
+    for(int m = 0; m < queue->count; m++) {
+        const replay_result *r = &queue->results[m];
+        if(r->failed) {
+            printf("%s: failed to load\n", r->filename);
+            unverified++;
+            continue;
+        }
+        total_ticks += r->ticks;
+        if(r->failed_assertions > 0) {
+            printf("%s: %d assertions failed after %u ticks, hash %08x\n", r->filename, r->failed_assertions,
+                   r->ticks, r->hash);
+            unverified++;
+            continue;
+        }
+        if(r->winner < 0) {
+            printf("%s: no winner after %u ticks, hash %08x\n", r->filename, r->ticks, r->hash);
+            unverified++;
+            continue;
+        }
+        printf("%s: player %d wins after %u ticks, hash %08x\n", r->filename, r->winner + 1, r->ticks, r->hash);
+        if(queue->seeks > 0) {
+            printf("  %d seeks, %d mismatched, %.2f ms average, %.2f ms max\n", queue->seeks, r->seek_mismatches,
+                   r->seek_avg_ms, r->seek_max_ms);
+            if(r->seek_mismatches > 0) {
+                unverified++;
+            }
+        }
+        for(int i = 0; i < r->rounds; i++) {
+            const arena_round_stats *s = &r->round_stats[i];
+            printf("  round %d: player %d wins at tick %u, health %d/%d, hits %u/%u, attacks %u/%u\n", i + 1,
+                   s->winner + 1, s->end_tick, s->health[0], s->health[1], s->hits_landed[0], s->hits_landed[1],
+                   s->total_attacks[0], s->total_attacks[1]);
+        }
+    }
+
+    printf("Replayed %d matches, %d unverified, %llu ticks in %.2f s (%.0f ticks/s)\n", queue->count, unverified,
+           (unsigned long long)total_ticks, seconds, seconds > 0 ? total_ticks / seconds : 0.0);
+    return unverified;
+}
+
+int main(int argc, char *argv[]) {
+    struct arg_lit *help = arg_lit0("h", "help", "print this help and exit");
+    struct arg_lit *vers = arg_lit0("v", "version", "print version information and exit");
+    struct arg_int *threads = arg_int0("j", "threads", "<int>", "Threads to run on (default: CPU count)");
+    struct arg_int *seed = arg_int0("s", "seed", "<int>", "Seed for recordings that do not store one (default 0)");
+    struct arg_int *max_ticks = arg_int0(NULL, "max-ticks", "<int>", "Tick limit per match (default 50000)");
+    struct arg_int *seeks = arg_int0(NULL, "seek", "<int>", "Random seeks to verify per match (default 0)");
+    struct arg_file *files = arg_filen(NULL, NULL, "<file>", 1, 1024, "Recording files to validate");
+    struct arg_end *end = arg_end(20);
+    void *argtable[] = {help, vers, threads, seed, max_ticks, seeks, files, end};
+    int ret;
+    if(!headless_parse_args(argc, argv, argtable, N_ELEMENTS(argtable), "matchvalidator",
+                            "Headless match validator for OpenOMF.", &ret)) {
+        goto exit_0;
+    }
+
+    replay_queue queue;
+    queue.count = files->count;
+    queue.seed = seed->count > 0 ? (uint32_t)seed->ival[0] : 0;
+    queue.max_ticks = max_ticks->count > 0 ? (uint32_t)max2(max_ticks->ival[0], 1) : 50000;
+    queue.seeks = seeks->count > 0 ? max2(seeks->ival[0], 0) : 0;
+    SDL_AtomicSet(&queue.next, 0);
+    int thread_count = threads->count > 0 ? max2(threads->ival[0], 1) : SDL_GetCPUCount();
+    thread_count = min2(thread_count, queue.count);
+
+    if(!headless_init()) {
+        ret = 1;
+        goto exit_0;
+    }
+
+    queue.results = omf_calloc(queue.count, sizeof(replay_result));
+    for(int i = 0; i < queue.count; i++) {
+        queue.results[i].filename = files->filename[i];
+    }
+
+    uint64_t start = SDL_GetPerformanceCounter();
+    headless_run_workers("matchvalidator", thread_count, worker_main, &queue);
+    double seconds = (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+
+    // Non-zero exit status if any of the matches could not be verified
+    ret = print_results(&queue, seconds) > 0 ? 1 : 0;
+
+    omf_free(queue.results);
+    headless_close();
+exit_0:
+    arg_freetable(argtable, N_ELEMENTS(argtable));
+    return ret;
+}
@@ -0,0 +1,492 @@
+/** @file main.c
+ * @brief Headless netplay harness with a simulated network
+ * @details Plays an AI match between two net controllers in one process. The peers talk over ENet on
+ *          localhost, through a UDP shim that delays, drops, reorders and duplicates their datagrams as
+ *          decided by a seeded generator. Reports how much rollback the match needed on each side, so that
+ *          changes to the netcode can be measured on a single machine.
+ * @license MIT
+ */
+
+#include "../shared/headless.h"
+#include "controller/ai_controller.h"
+#include "controller/controller.h"
+#include "controller/net_controller.h"
+#include "engine.h"
+#include "game/common_defines.h"
+#include "game/game_player.h"
+#include "game/game_state.h"
+#include "game/protos/scene.h"
+#include "game/scenes/arena.h"
+#include "game/utils/net_sim.h"
+#include "game/utils/settings.h"
+#include "utils/allocator.h"
+#include "utils/c_array_util.h"
+#include "utils/log.h"
+#include "utils/miscmath.h"
+#include "utils/random.h"
+#include "video/vga_state.h"
+#include <SDL.h>
+#include <enet/enet.h>
+#if defined(ARGTABLE2_FOUND)
+#include <argtable2.h>
+#elif defined(ARGTABLE3_FOUND)
+#include <argtable3.h>
+#endif
+#include <stdio.h>
+#include <string.h>
+
+// Simulated milliseconds per step of the harness
+#define STEP_MS 1
+
+// Limits for the phases before and after the match, in simulated milliseconds
+#define CONNECT_TIMEOUT_MS 5000
+#define SYNC_TIMEOUT_MS 30000
+#define DISCONNECT_TIMEOUT_MS 5000
+
+// Sits between the two ENet hosts. The client connects to the front socket, and the back socket
+// forwards its traffic to the server.
+typedef struct udp_shim {
+    ENetSocket front;
+    ENetSocket back;
+    ENetAddress server;
+    ENetAddress client; // learned from the first datagram of the client
+    bool has_client;
+    net_link up;   // client to server
+    net_link down; // server to client
+} udp_shim;
+
+typedef struct sim_peer {
+    const char *name;
+    ENetHost *host;
+    ENetPeer *peer;
+    game_state *gs;
+    vga_state *vga;
+    controller *net_ctrl;
+    int static_wait;
+    int dynamic_wait;
+    uint32_t frames; // dynamic ticks of the live game state
+    bool in_match;
+    bool done;
+    int winner;
+} sim_peer;
+
+static ENetSocket shim_socket(const ENetAddress *address) {
+    ENetSocket sock = enet_socket_create(ENET_SOCKET_TYPE_DATAGRAM);
+    if(sock == ENET_SOCKET_NULL) {
+        return sock;
+    }
+    enet_socket_set_option(sock, ENET_SOCKOPT_NONBLOCK, 1);
+    if(enet_socket_bind(sock, address) < 0) {
+        enet_socket_destroy(sock);
+        return ENET_SOCKET_NULL;
+    }
+    return sock;
+}
+
+static bool shim_create(udp_shim *shim, uint16_t port, const ENetAddress *server, uint32_t seed) {
+    net_sim_config clean;
+    memset(&clean, 0, sizeof(clean));
+    memset(shim, 0, sizeof(udp_shim));
+    ENetAddress address;
+    enet_address_set_host(&address, "127.0.0.1");
+    address.port = port;
+    shim->server = *server;
+    shim->front = shim_socket(&address);
+    if(shim->front == ENET_SOCKET_NULL) {
+        log_error("Unable to bind the shim to port %u", port);
+        goto error_0;
+    }
+    shim->back = shim_socket(NULL);
+    if(shim->back == ENET_SOCKET_NULL) {
+        log_error("Unable to create the shim socket");
+        goto error_1;
+    }
+    net_link_create(&shim->up, &clean, seed);
+    net_link_create(&shim->down, &clean, seed ^ 0x9E3779B9u);
+    return true;
+
+error_1:
+    enet_socket_destroy(shim->front);
+error_0:
+    return false;
+}
+
+static void shim_free(udp_shim *shim) {
+    net_link_free(&shim->up);
+    net_link_free(&shim->down);
+    enet_socket_destroy(shim->back);
+    enet_socket_destroy(shim->front);
+}
+
+static void shim_set_config(udp_shim *shim, const net_sim_config *config) {
+    net_link_set_config(&shim->up, config);
+    net_link_set_config(&shim->down, config);
+}
+
+// Moves the datagrams that have arrived into the links, and sends out the ones that are due
+static void shim_update(udp_shim *shim, uint32_t now) {
+    char data[ENET_PROTOCOL_MAXIMUM_MTU];
+    ENetBuffer buf;
+    ENetAddress from;
+    size_t len;
+    int received;
+
+    buf.data = data;
+    buf.dataLength = sizeof(data);
+    while((received = enet_socket_receive(shim->front, &from, &buf, 1)) > 0) {
+        shim->client = from;
+        shim->has_client = true;
+        net_link_push(&shim->up, now, data, received);
+    }
+    while((received = enet_socket_receive(shim->back, &from, &buf, 1)) > 0) {
+        net_link_push(&shim->down, now, data, received);
+    }
+
+    while(net_link_pop(&shim->up, now, data, sizeof(data), &len)) {
+        buf.dataLength = len;
+        enet_socket_send(shim->back, &shim->server, &buf, 1);
+    }
+    while(net_link_pop(&shim->down, now, data, sizeof(data), &len)) {
+        if(shim->has_client) {
+            buf.dataLength = len;
+            enet_socket_send(shim->front, &shim->client, &buf, 1);
+        }
+    }
+}
+
+// Same roles and players as the listen and connect menus: the server plays player 1, the client player 2
+static void peer_create(sim_peer *p, engine_init_flags *init_flags, const ai_match_setup *setup, int role,
+                        uint32_t start_seed, const char *telemetry) {
+    int local = role == ROLE_SERVER ? 0 : 1;
+    p->vga = vga_state_create();
+    p->gs = omf_calloc(1, sizeof(game_state));
+    game_state_create_empty(p->gs, init_flags, p->vga, setup->seed);
+    game_state_setup_match_players(p->gs, setup);
+
+    game_player *local_player = game_state_get_player(p->gs, local);
+    controller *local_ctrl = omf_calloc(1, sizeof(controller));
+    controller_init(local_ctrl, p->gs);
+    ai_controller_create(local_ctrl, setup->difficulty, local_player->pilot, setup->pilot_id[local]);
+    game_player_set_ctrl(local_player, local_ctrl);
+
+    p->net_ctrl = omf_calloc(1, sizeof(controller));
+    controller_init(p->net_ctrl, p->gs);
+    net_controller_create(p->net_ctrl, p->host, p->peer, NULL, role);
+    net_controller_set_start_seed(p->net_ctrl, start_seed);
+    if(telemetry != NULL) {
+        char filename[256];
+        snprintf(filename, sizeof(filename), "%s-%s.csv", telemetry, p->name);
+        net_controller_set_telemetry_file(p->net_ctrl, filename);
+    }
+    game_player_set_ctrl(game_state_get_player(p->gs, !local), p->net_ctrl);
+
+    // Local inputs go out through the net controller, as set up by the melee scene
+    controller_add_hook(local_ctrl, p->net_ctrl, p->net_ctrl->controller_hook);
+    p->winner = -1;
+}
+
+static void peer_free(sim_peer *p) {
+    if(p->gs != NULL) {
+        game_state_free(&p->gs);
+    } else if(p->host != NULL) {
+        enet_host_destroy(p->host);
+    }
+    vga_state_free(&p->vga);
+}
+
+// Runs the ticks that are due after ms milliseconds, the same way the engine main loop does
+static void peer_step(sim_peer *p, int ms) {
+    bool has_static, has_dynamic;
+    if(p->done) {
+        return;
+    }
+    p->static_wait += ms;
+    p->dynamic_wait += ms;
+    do {
+        // Leaving the arena means the match ended or the connection was lost. Stop before loading the next scene.
+        if(p->in_match && p->gs->next_id != p->gs->this_id) {
+            p->done = true;
+            return;
+        }
+        has_static = p->static_wait > STATIC_TICKS;
+        if(has_static) {
+            game_state_static_tick(p->gs, false);
+            if(p->gs->new_state) {
+                // the net controller rolled back, and replaced the game state with the replayed one
+                game_state *old_gs = p->gs;
+                p->gs = old_gs->new_state;
+                game_state_clone_free(old_gs);
+                omf_free(old_gs);
+            }
+            p->static_wait -= STATIC_TICKS;
+        }
+        int dyntick_wait = game_state_dyntick_wait(p->gs);
+        has_dynamic = p->dynamic_wait > dyntick_wait;
+        if(has_dynamic) {
+            game_state_dynamic_tick(p->gs, false);
+            p->dynamic_wait -= dyntick_wait;
+            p->frames++;
+            if(p->gs->delay > 0) {
+                // the stall the engine puts on the side that is ahead when inputs are not delayed
+                p->gs->delay--;
+                p->dynamic_wait -= 4;
+            }
+        }
+    } while(has_static || has_dynamic);
+}
+
+static void peer_check_winner(sim_peer *p) {
+    scene *sc = game_state_get_scene(p->gs);
+    if(!p->done && scene_is_arena(sc) && (p->winner = arena_is_over(sc)) >= 0) {
+        p->done = true;
+    }
+}
+
+typedef struct sim_clock {
+    uint32_t now;
+    uint64_t start;
+    bool realtime;
+} sim_clock;
+
+// Advances the simulated clock by one step. In real time mode, waits for the wall clock to catch up, so that
+// the timers inside ENet see the same time as the game.
+static void clock_step(sim_clock *clock) {
+    clock->now += STEP_MS;
+    if(clock->realtime && clock->now % 10 == 0) {
+        uint64_t elapsed = SDL_GetTicks64() - clock->start;
+        if(clock->now > elapsed) {
+            SDL_Delay(clock->now - elapsed);
+        }
+    }
+}
+
+static bool connect_hosts(sim_peer *peers, udp_shim *shim, sim_clock *clock) {
+    ENetEvent event;
+    for(uint32_t end = clock->now + CONNECT_TIMEOUT_MS; clock->now < end; clock_step(clock)) {
+        for(int i = 0; i < 2; i++) {
+            while(enet_host_service(peers[i].host, &event, 0) > 0) {
+                if(event.type == ENET_EVENT_TYPE_CONNECT) {
+                    peers[i].peer = event.peer;
+                } else if(event.type == ENET_EVENT_TYPE_RECEIVE) {
+                    enet_packet_destroy(event.packet);
+                }
+            }
+        }
+        shim_update(shim, clock->now);
+        if(peers[0].peer != NULL && peers[1].peer != NULL) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void print_stats(sim_peer *peers, udp_shim *shim, const net_sim_config *config, uint32_t seed) {
+    const net_link *links[2] = {&shim->up, &shim->down};
+    const char *link_names[2] = {"client to server", "server to client"};
+
+    printf("Link: latency %u ms, jitter %u ms, loss %.1f%%, reorder %.1f%%, duplicate %.1f%%, seed %u\n",
+           config->latency_ms, config->jitter_ms, config->loss * 100.0f, config->reorder * 100.0f,
+           config->duplicate * 100.0f, seed);
+    for(int i = 0; i < 2; i++) {
+        const net_link_stats *s = &links[i]->stats;
+        printf("  %-17s %6u datagrams, %5u dropped, %5u duplicated, %5u reordered\n", link_names[i], s->pushed,
+               s->dropped, s->duplicated, s->reordered);
+    }
+
+    printf("\n%-8s %8s %6s %9s %9s %10s %16s %8s %8s\n", "Peer", "Frames", "Delay", "Rollbacks", "Max depth",
+           "Avg depth", "Replay ms/frame", "Desyncs", "Winner");
+    for(int i = 0; i < 2; i++) {
+        net_controller_stats stats;
+        net_controller_get_stats(peers[i].net_ctrl, &stats);
+        printf("%-8s %8u %6d %9u %9u %10.1f %16.3f %8u %8d\n", peers[i].name, peers[i].frames, stats.input_delay,
+               stats.rollbacks, stats.max_depth,
+               stats.rollbacks > 0 ? (double)stats.replayed_ticks / stats.rollbacks : 0.0,
+               peers[i].frames > 0 ? stats.replay_ms / peers[i].frames : 0.0, stats.desyncs, peers[i].winner);
+    }
+    if(peers[0].winner != peers[1].winner) {
+        printf("\nThe peers disagree on the winner!\n");
+    }
+}
+
+static bool run_match(sim_peer *peers, udp_shim *shim, sim_clock *clock, const net_sim_config *config,
+                      int arena_id, uint32_t max_ticks) {
+    // The start handshake wants a steady link, so the conditions only apply once both sides agree to start.
+    // Heartbeats and inputs during the match are affected as usual.
+    for(uint32_t end = clock->now + SYNC_TIMEOUT_MS;
+        !net_controller_ready(peers[0].net_ctrl) || !net_controller_ready(peers[1].net_ctrl); clock_step(clock)) {
+        if(clock->now >= end) {
+            log_error("Peers did not synchronize within %d ms", SYNC_TIMEOUT_MS);
+            return false;
+        }
+        peer_step(&peers[0], STEP_MS);
+        peer_step(&peers[1], STEP_MS);
+        shim_update(shim, clock->now);
+    }
+    shim_set_config(shim, config);
+
+    for(int i = 0; i < 2; i++) {
+        game_state_match_settings_defaults(peers[i].gs);
+        game_state_set_next(peers[i].gs, SCENE_ARENA0 + arena_id);
+        peers[i].in_match = true;
+        peers[i].frames = 0;
+    }
+    while(!peers[0].done || !peers[1].done) {
+        if(peers[0].frames >= max_ticks && peers[1].frames >= max_ticks) {
+            log_error("Match hit the tick limit");
+            break;
+        }
+        peer_step(&peers[0], STEP_MS);
+        peer_step(&peers[1], STEP_MS);
+        peer_check_winner(&peers[0]);
+        peer_check_winner(&peers[1]);
+        shim_update(shim, clock->now);
+        clock_step(clock);
+    }
+
+    // Hang up, and keep both sides running until their net controllers have seen it. Otherwise freeing
+    // them waits for a reply that nobody is around to send.
+    enet_peer_disconnect(peers[1].peer, 0);
+    for(int i = 0; i < 2; i++) {
+        peers[i].done = false;
+    }
+    for(uint32_t end = clock->now + DISCONNECT_TIMEOUT_MS; clock->now < end; clock_step(clock)) {
+        if(peers[0].done && peers[1].done) {
+            break;
+        }
+        peer_step(&peers[0], STEP_MS);
+        peer_step(&peers[1], STEP_MS);
+        shim_update(shim, clock->now);
+    }
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    struct arg_lit *help = arg_lit0("h", "help", "print this help and exit");
+    struct arg_lit *vers = arg_lit0("v", "version", "print version information and exit");
+    struct arg_int *seed = arg_int0("s", "seed", "<int>", "Seed for the match and the network (default 1)");
+    struct arg_int *latency = arg_int0("l", "latency", "<ms>", "One way latency (default 40)");
+    struct arg_int *jitter = arg_int0("j", "jitter", "<ms>", "Extra random delay, up to this (default 10)");
+    struct arg_dbl *loss = arg_dbl0(NULL, "loss", "<%>", "Chance of losing a datagram (default 2)");
+    struct arg_dbl *reorder = arg_dbl0(NULL, "reorder", "<%>", "Chance of a datagram skipping the queue (default 1)");
+    struct arg_dbl *duplicate = arg_dbl0(NULL, "duplicate", "<%>", "Chance of duplicating a datagram (default 1)");
+    struct arg_int *difficulty = arg_int0("d", "difficulty", "<0-6>", "AI difficulty (default 4)");
+    struct arg_int *arena = arg_int0("a", "arena", "<0-4>", "Arena to use (default random)");
+    struct arg_int *har1 = arg_int0(NULL, "har1", "<id>", "HAR for player 1 (default random)");
+    struct arg_int *har2 = arg_int0(NULL, "har2", "<id>", "HAR for player 2 (default random)");
+    struct arg_int *max_ticks = arg_int0(NULL, "max-ticks", "<int>", "Tick limit for the match (default 20000)");
+    struct arg_int *port = arg_int0("p", "port", "<port>", "Server port, the shim uses the next one (default 2197)");
+    struct arg_lit *fast = arg_lit0("f", "fast", "do not pace the match to the wall clock");
+    struct arg_int *input_delay =
+        arg_int0("i", "input-delay", "<ticks>", "Most input delay, 0 to apply inputs at once (default from settings)");
+    struct arg_str *telemetry =
+        arg_str0("t", "telemetry", "<prefix>", "Write netplay telemetry of each peer to <prefix>-<peer>.csv");
+    struct arg_end *end = arg_end(20);
+    void *argtable[] = {help, vers, seed,      latency, jitter, loss,        reorder,   duplicate, difficulty, arena,
+                        har1, har2, max_ticks, port,    fast,   input_delay, telemetry, end};
+    int ret;
+    if(!headless_parse_args(argc, argv, argtable, N_ELEMENTS(argtable), "netsim",
+                            "Headless netplay harness with a simulated network for OpenOMF.", &ret)) {
+        goto exit_0;
+    }
+    ret = 1;
+
+    uint32_t match_seed = seed->count > 0 ? (uint32_t)seed->ival[0] : 1;
+    net_sim_config config;
+    config.latency_ms = latency->count > 0 ? (uint32_t)max2(latency->ival[0], 0) : 40;
+    config.jitter_ms = jitter->count > 0 ? (uint32_t)max2(jitter->ival[0], 0) : 10;
+    config.loss = (loss->count > 0 ? clampf(loss->dval[0], 0.0f, 100.0f) : 2.0f) / 100.0f;
+    config.reorder = (reorder->count > 0 ? clampf(reorder->dval[0], 0.0f, 100.0f) : 1.0f) / 100.0f;
+    config.duplicate = (duplicate->count > 0 ? clampf(duplicate->dval[0], 0.0f, 100.0f) : 1.0f) / 100.0f;
+    uint16_t server_port = port->count > 0 ? (uint16_t)clamp(port->ival[0], 1, 65534) : 2197;
+    uint32_t tick_limit = max_ticks->count > 0 ? (uint32_t)max2(max_ticks->ival[0], 1) : 20000;
+
+    // The match is picked from the seed the same way as in selfplay
+    ai_match_setup setup;
+    struct random_t r;
+    random_seed(&r, match_seed);
+    setup.seed = random_intmax(&r);
+    setup.difficulty = AI_DIFFICULTY_CHAMPION;
+    if(difficulty->count > 0) {
+        setup.difficulty = clamp(difficulty->ival[0], 0, NUMBER_OF_AI_DIFFICULTY_TYPES - 1);
+    }
+    setup.arena_id = arena->count > 0 ? clamp(arena->ival[0], 0, 4) : (int)random_int(&r, 5);
+    setup.har_id[0] = har1->count > 0 ? clamp(har1->ival[0], 0, NUMBER_OF_HAR_TYPES - 1)
+                                      : (int)random_int(&r, NUMBER_OF_HAR_TYPES);
+    setup.har_id[1] = har2->count > 0 ? clamp(har2->ival[0], 0, NUMBER_OF_HAR_TYPES - 1)
+                                      : (int)random_int(&r, NUMBER_OF_HAR_TYPES);
+    setup.pilot_id[0] = random_int(&r, NUMBER_OF_PLAYABLE_PILOT_TYPES);
+    setup.pilot_id[1] = random_int(&r, NUMBER_OF_PLAYABLE_PILOT_TYPES);
+
+    if(!headless_init()) {
+        goto exit_0;
+    }
+    if(enet_initialize() != 0) {
+        fprintf(stderr, "Error: Failed to initialize ENet.\n");
+        goto exit_1;
+    }
+
+    sim_peer peers[2];
+    memset(peers, 0, sizeof(peers));
+    peers[0].name = "server";
+    peers[1].name = "client";
+    ENetAddress server_address;
+    enet_address_set_host(&server_address, "127.0.0.1");
+    server_address.port = server_port;
+    udp_shim shim;
+    if(!shim_create(&shim, server_port + 1, &server_address, match_seed)) {
+        goto exit_2;
+    }
+    peers[0].host = enet_host_create(&server_address, 1, 3, 0, 0);
+    peers[1].host = enet_host_create(NULL, 1, 3, 0, 0);
+    if(peers[0].host == NULL || peers[1].host == NULL) {
+        fprintf(stderr, "Error: Failed to create ENet hosts.\n");
+        goto exit_3;
+    }
+    ENetAddress shim_address;
+    enet_address_set_host(&shim_address, "127.0.0.1");
+    shim_address.port = server_port + 1;
+    if(enet_host_connect(peers[1].host, &shim_address, 3, 0) == NULL) {
+        fprintf(stderr, "Error: Failed to connect to the shim.\n");
+        goto exit_3;
+    }
+
+    sim_clock clock;
+    clock.now = 0;
+    clock.start = SDL_GetTicks64();
+    clock.realtime = fast->count == 0;
+    if(!connect_hosts(peers, &shim, &clock)) {
+        fprintf(stderr, "Error: Peers did not connect.\n");
+        goto exit_3;
+    }
+
+    // Both sides pick the moves of their AI from the legacy generator, so seed it for a repeatable match
+    rand_seed(setup.seed);
+    engine_init_flags init_flags;
+    memset(&init_flags, 0, sizeof(init_flags));
+    init_flags.speed = 10;
+    // Both peers would write to the same file from the settings, --telemetry gives each its own
+    omf_free(settings_get()->net.telemetry_file);
+    if(input_delay->count > 0) {
+        settings_get()->net.net_max_input_delay = max2(input_delay->ival[0], 0);
+    }
+    const char *telemetry_prefix = telemetry->count > 0 ? telemetry->sval[0] : NULL;
+    peer_create(&peers[0], &init_flags, &setup, ROLE_SERVER, setup.seed, telemetry_prefix);
+    peer_create(&peers[1], &init_flags, &setup, ROLE_CLIENT, setup.seed, telemetry_prefix);
+
+    if(run_match(peers, &shim, &clock, &config, setup.arena_id, tick_limit)) {
+        print_stats(peers, &shim, &config, match_seed);
+        ret = 0;
+    }
+
+exit_3:
+    peer_free(&peers[1]);
+    peer_free(&peers[0]);
+    shim_free(&shim);
+exit_2:
+    enet_deinitialize();
+exit_1:
+    headless_close();
+exit_0:
+    arg_freetable(argtable, N_ELEMENTS(argtable));
+    return ret;
+}
@@ -0,0 +1,141 @@
+/** @file main.c
+ * @brief Asset pack builder
+ * @details Decodes the resource files of an OMF installation and writes them out as a single asset pack, which
+ *          the game maps into memory at startup instead of parsing the original files. Sounds, fonts, language
+ *          strings and PIC photos are baked whole; of the BK and AF files only the decoded sprites are baked, as
+ *          the animations are still read from the files. The installation is found the same way the game finds
+ *          it, and must pass the same resource check.
+ * @license MIT
+ */
+
+#include "game/utils/settings.h"
+#include "resources/af_loader.h"
+#include "resources/asset_pack.h"
+#include "resources/bk_loader.h"
+#include "resources/fonts.h"
+#include "resources/ids.h"
+#include "resources/languages.h"
+#include "resources/pathmanager.h"
+#include "resources/pic_loader.h"
+#include "resources/sounds_loader.h"
+#include "utils/c_array_util.h"
+#include "utils/log.h"
+#include <SDL.h>
+#if defined(ARGTABLE2_FOUND)
+#include <argtable2.h>
+#elif defined(ARGTABLE3_FOUND)
+#include <argtable3.h>
+#endif
+#include <stdio.h>
+
+int main(int argc, char *argv[]) {
+    struct arg_lit *help = arg_lit0("h", "help", "print this help and exit");
+    struct arg_lit *vers = arg_lit0("v", "version", "print version information and exit");
+    struct arg_file *output = arg_file0("o", "output", "<file>", "Pack file to write (default: " ASSET_PACK_FILE
+                                                                 " in the resource directory)");
+    struct arg_str *languages =
+        arg_strn("l", "language", "<file>", 0, 8, "Language file to include (default: the configured language)");
+    struct arg_end *end = arg_end(20);
+    void *argtable[] = {help, vers, output, languages, end};
+    const char *progname = "packtool";
+    int ret = 1;
+
+    // Make sure everything got allocated
+    if(arg_nullcheck(argtable) != 0) {
+        printf("%s: insufficient memory\n", progname);
+        goto exit_0;
+    }
+
+    // Parse arguments
+    int nerrors = arg_parse(argc, argv, argtable);
+
+    // Handle help
+    if(help->count > 0) {
+        printf("Usage: %s", progname);
+        arg_print_syntax(stdout, argtable, "\n");
+        printf("\nArguments:\n");
+        arg_print_glossary(stdout, argtable, "%-25s %s\n");
+        ret = 0;
+        goto exit_0;
+    }
+
+    // Handle version
+    if(vers->count > 0) {
+        printf("%s v0.1\n", progname);
+        printf("Asset pack builder for OpenOMF.\n");
+        printf("Source code is available at https://github.com/omf2097 under MIT license.\n");
+        ret = 0;
+        goto exit_0;
+    }
+
+    // Handle errors
+    if(nerrors > 0) {
+        arg_print_errors(stdout, end, progname);
+        printf("Try '%s --help' for more information.\n", progname);
+        goto exit_0;
+    }
+
+    // pm_init() also checks that all resource files are present
+    if(pm_init() != 0) {
+        fprintf(stderr, "Error: %s.\n", pm_get_errormsg());
+        goto exit_0;
+    }
+    log_init();
+    log_add_stderr(LOG_INFO, false);
+    if(settings_init(pm_get_local_path(CONFIG_PATH))) {
+        fprintf(stderr, "Error: Failed to initialize settings.\n");
+        goto exit_1;
+    }
+    settings_load();
+
+    char filename[256];
+    if(output->count > 0) {
+        snprintf(filename, sizeof(filename), "%s", output->filename[0]);
+    } else {
+        snprintf(filename, sizeof(filename), "%s%s", pm_get_local_path(RESOURCE_PATH), ASSET_PACK_FILE);
+    }
+
+    uint64_t start = SDL_GetPerformanceCounter();
+    asset_pack_writer writer;
+    asset_pack_writer_create(&writer);
+    if(!sounds_loader_bake(&writer) || !fonts_bake(&writer)) {
+        goto exit_3;
+    }
+    for(int i = 0; i < NUMBER_OF_RESOURCES; i++) {
+        if(is_scene(i) && !bk_bake(&writer, i)) {
+            goto exit_3;
+        }
+        if(is_har(i) && !af_bake(&writer, i)) {
+            goto exit_3;
+        }
+        if(is_pic(i) && !pic_bake(&writer, i)) {
+            goto exit_3;
+        }
+    }
+    if(languages->count == 0) {
+        if(!lang_bake(&writer, settings_get()->language.language)) {
+            goto exit_3;
+        }
+    }
+    for(int i = 0; i < languages->count; i++) {
+        if(!lang_bake(&writer, languages->sval[i])) {
+            goto exit_3;
+        }
+    }
+    if(!asset_pack_writer_save(&writer, filename)) {
+        goto exit_3;
+    }
+    double seconds = (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+    printf("Wrote %s in %.2f seconds\n", filename, seconds);
+    ret = 0;
+
+exit_3:
+    asset_pack_writer_free(&writer);
+    settings_free();
+exit_1:
+    log_close();
+    pm_free();
+exit_0:
+    arg_freetable(argtable, N_ELEMENTS(argtable));
+    return ret;
+}
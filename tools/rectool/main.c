@@ -5,7 +5,9 @@
 
 #include "../shared/pilot.h"
 #include "formats/error.h"
+#include "formats/internal/reader.h"
 #include "formats/rec.h"
+#include "formats/rec2.h"
 #include "formats/rec_assertion.h"
 #include "utils/c_array_util.h"
 #if defined(ARGTABLE2_FOUND)
@@ -224,39 +226,7 @@ void rec_entry_set_key(sd_rec_file *rec, int entry_id, const char *key, const ch
             rec->moves[entry_id].player_id = atoi(value);
             break;
         case 3:
-            rec->moves[entry_id].action = SD_ACT_NONE;
-            if(action & SD_ACT_PUNCH) {
-                rec->moves[entry_id].action |= SD_ACT_PUNCH;
-            }
-            if(action & SD_ACT_KICK) {
-                rec->moves[entry_id].action |= SD_ACT_KICK;
-            }
-            switch(action & 0xF0) {
-                case 16:
-                    rec->moves[entry_id].action |= SD_ACT_UP;
-                    break;
-                case 32:
-                    rec->moves[entry_id].action |= (SD_ACT_UP | SD_ACT_RIGHT);
-                    break;
-                case 48:
-                    rec->moves[entry_id].action |= SD_ACT_RIGHT;
-                    break;
-                case 64:
-                    rec->moves[entry_id].action |= (SD_ACT_DOWN | SD_ACT_RIGHT);
-                    break;
-                case 80:
-                    rec->moves[entry_id].action |= SD_ACT_DOWN;
-                    break;
-                case 96:
-                    rec->moves[entry_id].action |= (SD_ACT_DOWN | SD_ACT_LEFT);
-                    break;
-                case 112:
-                    rec->moves[entry_id].action |= SD_ACT_LEFT;
-                    break;
-                case 128:
-                    rec->moves[entry_id].action |= (SD_ACT_UP | SD_ACT_LEFT);
-                    break;
-            }
+            rec->moves[entry_id].action = sd_rec_unpack_action(action);
             break;
         default:
             printf("Invalid record entry key!\n");
@@ -356,12 +326,23 @@ void rec_get_key(sd_rec_file *rec, const char **key, int kcount) {
     }
 }
 
+static long rec_file_size(const char *filename) {
+    sd_reader *r = sd_reader_open(filename);
+    if(r == NULL) {
+        return -1;
+    }
+    long size = sd_reader_filesize(r);
+    sd_reader_close(r);
+    return size;
+}
+
 int main(int argc, char *argv[]) {
     // commandline argument parser options
     struct arg_lit *help = arg_lit0("h", "help", "print this help and exit");
     struct arg_lit *vers = arg_lit0("v", "version", "print version information and exit");
     struct arg_file *file = arg_file1("f", "file", "<file>", "Input .REC file");
     struct arg_file *output = arg_file0("o", "output", "<file>", "Output .REC file");
+    struct arg_lit *compact = arg_lit0("c", "compact", "Write the output file in the compact format");
     struct arg_str *key = arg_strn("k", "key", "<key>", 0, 3, "Select key");
     struct arg_int *pilot = arg_int0(NULL, "pilot", "<int>", "Only print pilot information");
     struct arg_str *value = arg_str0("s", "set", "<value>", "Set value (requires --key)");
@@ -381,9 +362,9 @@ int main(int argc, char *argv[]) {
                  "Assertion operand 1; har 1 or 2 or literal");
     struct arg_int *delete = arg_intn("d", "delete", "<number>", 0, 10, "Delete an existing element");
     struct arg_end *end = arg_end(20);
-    void *argtable[] = {help,       vers,        file,       output,      pilot,       key,
-                        value,      delete,      insert,     assert,      assert_tick, assert_op,
-                        assert_op1, assert_val1, assert_op2, assert_val2, end};
+    void *argtable[] = {help,        vers,       file,        output,     compact,     pilot,
+                        key,         value,      delete,      insert,     assert,      assert_tick,
+                        assert_op,   assert_op1, assert_val1, assert_op2, assert_val2, end};
     const char *progname = "rectool";
 
     // Make sure everything got allocated
@@ -551,10 +532,26 @@ int main(int argc, char *argv[]) {
         print_rec_root_info(&rec);
     }
 
-    // Write output file
+    // Write output file. Input format is detected on load, output format is picked with --compact.
     if(output->count > 0) {
-        if(sd_rec_save(&rec, output->filename[0]) != SD_SUCCESS) {
+        int ret;
+        if(compact->count > 0) {
+            ret = sd_rec2_save(&rec, output->filename[0]);
+        } else {
+            ret = sd_rec_save(&rec, output->filename[0]);
+        }
+        if(ret != SD_SUCCESS) {
             printf("Save didn't succeed!");
+        } else if(file->count > 0) {
+            long in_size = rec_file_size(file->filename[0]);
+            long out_size = rec_file_size(output->filename[0]);
+            printf("%s (%s, %ld bytes) -> %s (%s, %ld bytes)", file->filename[0],
+                   sd_rec2_is_compact(file->filename[0]) ? "compact" : "legacy", in_size, output->filename[0],
+                   compact->count > 0 ? "compact" : "legacy", out_size);
+            if(in_size > 0 && out_size > 0) {
+                printf(", ratio %.2f", (double)in_size / out_size);
+            }
+            printf("\n");
         }
     }
 
@@ -0,0 +1,244 @@
+/** @file main.c
+ * @brief Headless AI vs. AI self-play harness
+ * @details Runs a batch of AI matches on a pool of worker threads and prints aggregate statistics.
+ *          Every match runs in its own game state and palette state, and is seeded from the match index,
+ *          so a given --seed always reproduces the same set of matches regardless of thread count.
+ * @license MIT
+ */
+
+#include "../shared/headless.h"
+#include "controller/ai_controller.h"
+#include "controller/controller.h"
+#include "game/common_defines.h"
+#include "game/game_player.h"
+#include "game/game_state.h"
+#include "game/scenes/arena.h"
+#include "utils/allocator.h"
+#include "utils/c_array_util.h"
+#include "utils/log.h"
+#include "utils/miscmath.h"
+#include "utils/random.h"
+#include "video/vga_state.h"
+#include <SDL.h>
+#if defined(ARGTABLE2_FOUND)
+#include <argtable2.h>
+#elif defined(ARGTABLE3_FOUND)
+#include <argtable3.h>
+#endif
+#include <stdio.h>
+#include <string.h>
+
+// Size of the AI move statistics table
+#define MAX_MOVE_ID 70
+
+typedef struct match_result {
+    ai_match_setup setup;
+    bool failed;
+    int winner; // 0 or 1, -1 if the match hit the tick limit
+    uint32_t ticks;
+    int move_attempts[2][MAX_MOVE_ID];
+} match_result;
+
+typedef struct match_queue {
+    match_result *results;
+    int count;
+    uint32_t max_ticks;
+    SDL_atomic_t next;
+} match_queue;
+
+static void match_setup_create(ai_match_setup *setup, uint32_t base_seed, int index, int difficulty, int arena,
+                               int har1, int har2) {
+    // Derive an independent seed for each match, then use it to pick the random parts of the setup.
+    struct random_t r;
+    random_seed(&r, base_seed ^ ((uint32_t)index * 2654435761u));
+    setup->seed = random_intmax(&r);
+    setup->difficulty = difficulty;
+    setup->arena_id = arena >= 0 ? arena : (int)random_int(&r, 5);
+    setup->har_id[0] = har1 >= 0 ? har1 : (int)random_int(&r, NUMBER_OF_HAR_TYPES);
+    setup->har_id[1] = har2 >= 0 ? har2 : (int)random_int(&r, NUMBER_OF_HAR_TYPES);
+    setup->pilot_id[0] = random_int(&r, NUMBER_OF_PLAYABLE_PILOT_TYPES);
+    setup->pilot_id[1] = random_int(&r, NUMBER_OF_PLAYABLE_PILOT_TYPES);
+}
+
+static void run_match(match_result *result, uint32_t max_ticks) {
+    engine_init_flags init_flags;
+    memset(&init_flags, 0, sizeof(init_flags));
+    init_flags.speed = 10;
+
+    // The legacy generator is per-thread; reseed it so results do not depend on what ran before.
+    rand_seed(result->setup.seed);
+
+    vga_state *vga = vga_state_create();
+    game_state *gs = omf_calloc(1, sizeof(game_state));
+    if(game_state_create_ai_match(gs, &init_flags, vga, &result->setup)) {
+        log_error("Unable to create match with seed %u", result->setup.seed);
+        result->failed = true;
+        omf_free(gs);
+        goto exit_0;
+    }
+
+    // Drive the simulation as fast as possible. One static tick per dynamic tick keeps the arena
+    // timers in the same relation as at the fastest game speed.
+    result->winner = -1;
+    while(game_state_is_running(gs) && gs->tick < max_ticks) {
+        game_state_static_tick(gs, false);
+        game_state_dynamic_tick(gs, false);
+        if((result->winner = arena_is_over(game_state_get_scene(gs))) >= 0) {
+            break;
+        }
+    }
+    result->ticks = gs->tick;
+
+    for(int i = 0; i < 2; i++) {
+        controller *ctrl = game_player_get_ctrl(game_state_get_player(gs, i));
+        if(ctrl != NULL && ctrl->type == CTRL_TYPE_AI) {
+            ai_controller_get_move_attempts(ctrl, result->move_attempts[i], MAX_MOVE_ID);
+        }
+    }
+    game_state_free(&gs);
+
+exit_0:
+    vga_state_free(&vga);
+}
+
+static int worker_main(void *userdata) {
+    match_queue *queue = userdata;
+    int index;
+    while((index = SDL_AtomicAdd(&queue->next, 1)) < queue->count) {
+        run_match(&queue->results[index], queue->max_ticks);
+    }
+    return 0;
+}
+
+static void print_summary(const match_queue *queue, int threads, double seconds) {
+    int played[NUMBER_OF_HAR_TYPES] = {0};
+    int wins[NUMBER_OF_HAR_TYPES] = {0};
+    uint64_t moves[NUMBER_OF_HAR_TYPES][MAX_MOVE_ID];
+    memset(moves, 0, sizeof(moves));
+    uint64_t total_ticks = 0;
+    uint64_t finished_ticks = 0;
+    uint32_t min_ticks = UINT32_MAX;
+    uint32_t max_ticks = 0;
+    int finished = 0;
+    int timeouts = 0;
+    int failures = 0;
+
+    for(int m = 0; m < queue->count; m++) {
+        const match_result *r = &queue->results[m];
+        if(r->failed) {
+            failures++;
+            continue;
+        }
+        total_ticks += r->ticks;
+        if(r->winner < 0) {
+            timeouts++;
+            continue;
+        }
+        // Timed out matches stopped at the tick limit, so only finished ones tell how long a match is
+        finished++;
+        finished_ticks += r->ticks;
+        min_ticks = umin2(min_ticks, r->ticks);
+        max_ticks = umax2(max_ticks, r->ticks);
+        for(int i = 0; i < 2; i++) {
+            int har_id = r->setup.har_id[i];
+            played[har_id]++;
+            if(r->winner == i) {
+                wins[har_id]++;
+            }
+            for(int k = 0; k < MAX_MOVE_ID; k++) {
+                moves[har_id][k] += r->move_attempts[i][k];
+            }
+        }
+    }
+
+    printf("Matches: %d finished, %d timed out, %d failed (%d threads)\n", finished, timeouts, failures, threads);
+    printf("Simulated %llu ticks in %.2f s (%.0f ticks/s)\n", (unsigned long long)total_ticks, seconds,
+           seconds > 0 ? total_ticks / seconds : 0.0);
+    if(finished > 0) {
+        printf("Match length: avg %llu, min %u, max %u ticks\n", (unsigned long long)(finished_ticks / finished),
+               min_ticks, max_ticks);
+    }
+
+    printf("\n%-10s %8s %8s %8s  %s\n", "HAR", "Played", "Wins", "Win %", "Most attempted moves (id:count)");
+    for(int h = 0; h < NUMBER_OF_HAR_TYPES; h++) {
+        if(played[h] == 0) {
+            continue;
+        }
+        printf("%-10s %8d %8d %7.1f%% ", har_get_name(h), played[h], wins[h], 100.0f * wins[h] / played[h]);
+
+        // Print the top few moves; selection is fine for tables this small.
+        bool used[MAX_MOVE_ID] = {false};
+        for(int n = 0; n < 5; n++) {
+            int best = -1;
+            for(int k = 0; k < MAX_MOVE_ID; k++) {
+                if(!used[k] && moves[h][k] > 0 && (best < 0 || moves[h][k] > moves[h][best])) {
+                    best = k;
+                }
+            }
+            if(best < 0) {
+                break;
+            }
+            used[best] = true;
+            printf(" %d:%llu", best, (unsigned long long)moves[h][best]);
+        }
+        printf("\n");
+    }
+}
+
+int main(int argc, char *argv[]) {
+    struct arg_lit *help = arg_lit0("h", "help", "print this help and exit");
+    struct arg_lit *vers = arg_lit0("v", "version", "print version information and exit");
+    struct arg_int *matches = arg_int0("m", "matches", "<int>", "Number of matches to run (default 100)");
+    struct arg_int *threads = arg_int0("j", "threads", "<int>", "Threads to run on (default: CPU count)");
+    struct arg_int *seed = arg_int0("s", "seed", "<int>", "Base seed for the match set (default 1)");
+    struct arg_int *difficulty = arg_int0("d", "difficulty", "<0-6>", "AI difficulty (default 4)");
+    struct arg_int *arena = arg_int0("a", "arena", "<0-4>", "Arena to use (default random)");
+    struct arg_int *har1 = arg_int0(NULL, "har1", "<id>", "HAR for player 1 (default random)");
+    struct arg_int *har2 = arg_int0(NULL, "har2", "<id>", "HAR for player 2 (default random)");
+    struct arg_int *max_ticks = arg_int0(NULL, "max-ticks", "<int>", "Tick limit per match (default 20000)");
+    struct arg_end *end = arg_end(20);
+    void *argtable[] = {help, vers, matches, threads, seed, difficulty, arena, har1, har2, max_ticks, end};
+    int ret;
+    if(!headless_parse_args(argc, argv, argtable, N_ELEMENTS(argtable), "selfplay",
+                            "Headless AI self-play harness for OpenOMF.", &ret)) {
+        goto exit_0;
+    }
+
+    match_queue queue;
+    queue.count = matches->count > 0 ? max2(matches->ival[0], 1) : 100;
+    queue.max_ticks = max_ticks->count > 0 ? (uint32_t)max2(max_ticks->ival[0], 1) : 20000;
+    SDL_AtomicSet(&queue.next, 0);
+    int thread_count = threads->count > 0 ? max2(threads->ival[0], 1) : SDL_GetCPUCount();
+    thread_count = min2(thread_count, queue.count);
+    uint32_t base_seed = seed->count > 0 ? (uint32_t)seed->ival[0] : 1;
+    int ai_difficulty = AI_DIFFICULTY_CHAMPION;
+    if(difficulty->count > 0) {
+        ai_difficulty = clamp(difficulty->ival[0], 0, NUMBER_OF_AI_DIFFICULTY_TYPES - 1);
+    }
+    int arena_id = arena->count > 0 ? clamp(arena->ival[0], 0, 4) : -1;
+    int har1_id = har1->count > 0 ? clamp(har1->ival[0], 0, NUMBER_OF_HAR_TYPES - 1) : -1;
+    int har2_id = har2->count > 0 ? clamp(har2->ival[0], 0, NUMBER_OF_HAR_TYPES - 1) : -1;
+
+    if(!headless_init()) {
+        ret = 1;
+        goto exit_0;
+    }
+
+    queue.results = omf_calloc(queue.count, sizeof(match_result));
+    for(int i = 0; i < queue.count; i++) {
+        match_setup_create(&queue.results[i].setup, base_seed, i, ai_difficulty, arena_id, har1_id, har2_id);
+    }
+
+    uint64_t start = SDL_GetPerformanceCounter();
+    headless_run_workers("selfplay", thread_count, worker_main, &queue);
+    double seconds = (double)(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+
+    print_summary(&queue, thread_count, seconds);
+    ret = 0;
+
+    omf_free(queue.results);
+    headless_close();
+exit_0:
+    arg_freetable(argtable, N_ELEMENTS(argtable));
+    return ret;
+}
@@ -0,0 +1,143 @@
+#include "headless.h"
+#include "formats/altpal.h"
+#include "game/utils/settings.h"
+#include "resources/fonts.h"
+#include "resources/languages.h"
+#include "resources/pathmanager.h"
+#include "resources/sounds_loader.h"
+#include "utils/allocator.h"
+#include "utils/log.h"
+#if defined(ARGTABLE2_FOUND)
+#include <argtable2.h>
+#elif defined(ARGTABLE3_FOUND)
+#include <argtable3.h>
+#endif
+#include <stdio.h>
+
+bool headless_parse_args(int argc, char *argv[], void **argtable, size_t count, const char *progname,
+                         const char *description, int *ret) {
+    struct arg_lit *help = argtable[0];
+    struct arg_lit *vers = argtable[1];
+    struct arg_end *end = argtable[count - 1];
+    *ret = 1;
+
+    // Make sure everything got allocated
+    if(arg_nullcheck(argtable) != 0) {
+        printf("%s: insufficient memory\n", progname);
+        return false;
+    }
+
+    // Parse arguments
+    int nerrors = arg_parse(argc, argv, argtable);
+
+    // Handle help
+    if(help->count > 0) {
+        printf("Usage: %s", progname);
+        arg_print_syntax(stdout, argtable, "\n");
+        printf("\nArguments:\n");
+        arg_print_glossary(stdout, argtable, "%-25s %s\n");
+        *ret = 0;
+        return false;
+    }
+
+    // Handle version
+    if(vers->count > 0) {
+        printf("%s v0.1\n", progname);
+        printf("%s\n", description);
+        printf("Source code is available at https://github.com/omf2097 under MIT license.\n");
+        *ret = 0;
+        return false;
+    }
+
+    // Handle errors
+    if(nerrors > 0) {
+        arg_print_errors(stdout, end, progname);
+        printf("Try '%s --help' for more information.\n", progname);
+        return false;
+    }
+    return true;
+}
+
+static bool init_resources(void) {
+    if(!sounds_loader_init())
+        goto exit_0;
+    if(!lang_init())
+        goto exit_1;
+    if(!fonts_init())
+        goto exit_2;
+    if(altpals_init())
+        goto exit_3;
+    return true;
+
+exit_3:
+    fonts_close();
+exit_2:
+    lang_close();
+exit_1:
+    sounds_loader_close();
+exit_0:
+    return false;
+}
+
+static void close_resources(void) {
+    altpals_close();
+    fonts_close();
+    lang_close();
+    sounds_loader_close();
+}
+
+bool headless_init(void) {
+    // Shared, read-only resources are loaded once on the main thread before any worker starts.
+    if(pm_init() != 0) {
+        fprintf(stderr, "Error: %s.\n", pm_get_errormsg());
+        goto exit_0;
+    }
+    log_init();
+    log_add_stderr(LOG_ERROR, false);
+    log_set_level(LOG_ERROR);
+    if(settings_init(pm_get_local_path(CONFIG_PATH))) {
+        fprintf(stderr, "Error: Failed to initialize settings.\n");
+        goto exit_1;
+    }
+    settings_load();
+    if(!init_resources()) {
+        fprintf(stderr, "Error: Failed to load game resources.\n");
+        goto exit_2;
+    }
+    return true;
+
+exit_2:
+    settings_free();
+exit_1:
+    log_close();
+    pm_free();
+exit_0:
+    return false;
+}
+
+void headless_close(void) {
+    close_resources();
+    settings_free();
+    log_close();
+    pm_free();
+}
+
+void headless_run_workers(const char *name, int thread_count, SDL_ThreadFunction fn, void *userdata) {
+    // The calling thread is one of the threads
+    int worker_count = thread_count - 1;
+    SDL_Thread **workers = worker_count > 0 ? omf_calloc(worker_count, sizeof(SDL_Thread *)) : NULL;
+    for(int i = 0; i < worker_count; i++) {
+        workers[i] = SDL_CreateThread(fn, name, userdata);
+        if(workers[i] == NULL) {
+            log_error("Unable to start worker thread: %s", SDL_GetError());
+        }
+    }
+    // Always pitch in from the main thread, so that we finish even if no worker could be started.
+    fn(userdata);
+    for(int i = 0; i < worker_count; i++) {
+        if(workers[i] != NULL) {
+            SDL_WaitThread(workers[i], NULL);
+        }
+    }
+    omf_free(workers);
+}
@@ -0,0 +1,25 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <SDL.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Setup shared by the tools that run the game without video or audio (selfplay, matchvalidator, netsim).
+ */
+
+// Handles the options every headless tool has. The argtable must start with the --help and --version options, and
+// end with arg_end(). Returns true if the tool should go on; otherwise the tool should exit with *ret.
+bool headless_parse_args(int argc, char *argv[], void **argtable, size_t count, const char *progname,
+                         const char *description, int *ret);
+
+// Loads the settings and the data files the game needs without a renderer or audio backend. Errors are printed.
+bool headless_init(void);
+void headless_close(void);
+
+// Runs fn on thread_count threads, the calling thread and thread_count - 1 workers, and waits for all of them. fn must
+// take its work from a shared queue, so that everything gets done even if no worker thread could be started.
+void headless_run_workers(const char *name, int thread_count, SDL_ThreadFunction fn, void *userdata);
+
+#endif // HEADLESS_H